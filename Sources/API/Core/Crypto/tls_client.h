@@ -58,7 +58,15 @@ namespace clan
 		/// \brief Returns how much encrypted data is available.
 		int get_encrypted_data_available() const;
 
+		/// \brief Returns true when the handshake has completed and application data can flow.
+		bool is_handshake_complete() const;
+
+		/// \brief Returns true when the close_notify alert has been added to the encrypted data.
+		bool is_closed() const;
+
 		/// \brief Adds data to be encrypted.
+		///
+		/// Encrypting zero bytes starts the handshake without sending any application data.
 		int encrypt(const void *data, int size);
 
 		/// \brief Adds data to be decrypted.
@@ -70,6 +78,11 @@ namespace clan
 		/// \brief Marks encrypted data as consumed.
 		void encrypted_data_consumed(int size);
 
+		/// \brief Sends a close_notify alert once all data added to be encrypted has been sent.
+		///
+		/// No more data can be encrypted after this call.
+		void close();
+
 	private:
 		std::shared_ptr<TLSClient_Impl> impl;
 	};
@@ -30,6 +30,7 @@
 #pragma once
 
 #include "connection_site.h"	// TODO: Remove
+#include "statistics.h"
 #include "../../Core/Signals/signal.h"
 
 namespace clan
@@ -52,9 +53,12 @@ namespace clan
 		///
 		/// \param server = String
 		/// \param port = String
-		void connect(const std::string &server, const std::string &port);
+		/// \param use_tls = Encrypt the connection with TLS. The server end must be a TLS terminating proxy in front of a NetGameServer.
+		void connect(const std::string &server, const std::string &port, bool use_tls = false);
 
 		/// \brief Disconnect
+		///
+		/// Events sent before the call are still sent. Waits up to five seconds for the server to take them.
 		void disconnect();
 
 		/// \brief Process events
@@ -64,6 +68,10 @@ namespace clan
 		///
 		/// \param game_event = Net Game Event
 		void send_event(const NetGameEvent &game_event);
+
+		/// \brief Returns a snapshot of the traffic counters for the connection to the server
+		NetGameConnectionStatistics get_statistics() const;
+
 		Signal<void(const NetGameEvent &)> &sig_event_received();
 
 		/// \brief Sig connected
@@ -31,6 +31,7 @@
 #include <vector>
 #include <string>
 #include "event.h"
+#include "statistics.h"
 
 namespace clan
 {
@@ -51,7 +52,13 @@ namespace clan
 		/// \param site = Net Game Connection Site
 		/// \param connection = TCPConnection
 		NetGameConnection(NetGameConnectionSite *site, const TCPConnection &connection);
-		NetGameConnection(NetGameConnectionSite *site, const SocketName &socket_name);
+
+		/// \brief Constructs a NetGameConnection that connects to a server
+		///
+		/// \param site = Net Game Connection Site
+		/// \param socket_name = Address of the server
+		/// \param use_tls = Encrypt the connection using TLSConnection
+		NetGameConnection(NetGameConnectionSite *site, const SocketName &socket_name, bool use_tls = false);
 
 		~NetGameConnection();
 
@@ -73,6 +80,16 @@ namespace clan
 		/// \param game_event = Net Game Event
 		void send_event(const NetGameEvent &game_event);
 
+		/// \brief Send several events at once
+		///
+		/// Cheaper than calling send_event for each of them as the connection thread is only woken up once.
+		void send_events(const std::vector<NetGameEvent> &game_events);
+
+		/// \brief Returns the number of events waiting to be written to the socket
+		///
+		/// Includes events already encoded into the send buffer that the socket has not accepted yet.
+		int get_send_queue_length() const;
+
 		/// \brief Disconnects a client
 		void disconnect();
 
@@ -81,6 +98,9 @@ namespace clan
 		/// \return remote_name
 		SocketName get_remote_name() const;
 
+		/// \brief Returns a snapshot of the traffic counters for this connection
+		NetGameConnectionStatistics get_statistics() const;
+
 	private:
 		/// \brief Disallow copy constructors
 		NetGameConnection(NetGameConnection &other) = delete;
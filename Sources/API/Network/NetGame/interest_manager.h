@@ -0,0 +1,124 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include <memory>
+#include "../../Core/Math/point.h"
+
+namespace clan
+{
+	/// \addtogroup clanNetwork_NetGame clanNetwork NetGame
+	/// \{
+
+	class NetGameEvent;
+	class NetGameConnection;
+	class NetGameInterestManager_Impl;
+
+	/// \brief Decides which connections receive which game events
+	///
+	/// Each connection registered as an observer has a position and a view radius in a 2D world.
+	/// Events sent for an entity only go to the observers that can see the position of the entity,
+	/// which are found through a uniform grid so that the cost of a send depends on the number of
+	/// observers nearby rather than on the number of connections. Observers can also subscribe to
+	/// channels for events that are not tied to a position.
+	///
+	/// Events are not sent right away. They are queued per observer and tick() sends at most the
+	/// budget of each observer, highest priority first. An event that does not fit within the budget
+	/// stays queued with its priority added up every tick, so that low priority events still get sent
+	/// eventually. A newer event for the same entity replaces the queued one. Events a connection has
+	/// not yet written to its socket count against its budget, so slow connections receive fewer and
+	/// more up-to-date events.
+	///
+	/// The interest manager is not thread safe. Call it from the thread that calls NetGameServer::process_events.
+	class NetGameInterestManager
+	{
+	public:
+		/// \brief Constructs an interest manager
+		///
+		/// \param cell_size = Size of the grid cells. A good value is about the typical view radius.
+		/// \param default_budget = Number of events each observer can receive per tick
+		NetGameInterestManager(float cell_size = 64.0f, int default_budget = 64);
+		~NetGameInterestManager();
+
+		/// \brief Starts sending events to a connection
+		///
+		/// The observer must be removed before the connection is destroyed, for example from NetGameServer::sig_client_disconnected.
+		void add_observer(NetGameConnection *connection, const Pointf &position, float view_radius);
+
+		/// \brief Stops sending events to a connection and discards the events queued for it
+		void remove_observer(NetGameConnection *connection);
+
+		/// \brief Moves the view area of an observer
+		void set_observer_position(NetGameConnection *connection, const Pointf &position);
+
+		/// \brief Changes the view radius of an observer
+		void set_observer_radius(NetGameConnection *connection, float view_radius);
+
+		/// \brief Sets the number of events an observer can receive per tick
+		void set_observer_budget(NetGameConnection *connection, int budget);
+
+		/// \brief Subscribes an observer to a channel
+		void subscribe(NetGameConnection *connection, int channel);
+
+		/// \brief Unsubscribes an observer from a channel
+		void unsubscribe(NetGameConnection *connection, int channel);
+
+		/// \brief Queues an event for every observer that can see the given position
+		///
+		/// \param entity_id = Identifies the entity the event is about. Replaces any queued event with the same id. Use -1 to never replace.
+		/// \param position = Position of the entity
+		/// \param game_event = Event to send
+		/// \param priority = Added to the priority of the event each tick until it is sent
+		void send_event(int entity_id, const Pointf &position, const NetGameEvent &game_event, float priority = 1.0f);
+
+		/// \brief Queues an event for every observer subscribed to a channel
+		void send_channel_event(int channel, const NetGameEvent &game_event, float priority = 1.0f);
+
+		/// \brief Queues an event for one observer
+		void send_observer_event(NetGameConnection *connection, const NetGameEvent &game_event, float priority = 1.0f);
+
+		/// \brief Sends the highest priority events of each observer, up to its budget
+		void tick();
+
+		/// \brief Returns the number of observers
+		int get_observer_count() const;
+
+		/// \brief Returns the number of events queued for an observer
+		int get_queued_event_count(NetGameConnection *connection) const;
+
+	private:
+		NetGameInterestManager(const NetGameInterestManager &) = delete;
+		NetGameInterestManager &operator=(const NetGameInterestManager &) = delete;
+
+		std::unique_ptr<NetGameInterestManager_Impl> impl;
+	};
+
+	/// \}
+}
@@ -31,6 +31,7 @@
 
 
 #include "connection_site.h"	// TODO: Remove
+#include "statistics.h"
 #include "../../Core/Signals/signal.h"
 
 namespace clan
@@ -71,6 +72,9 @@ namespace clan
 		/// \param game_event = Net Game Event
 		void send_event(const NetGameEvent &game_event);
 
+		/// \brief Returns a snapshot of the traffic counters for the server and each of its connections
+		NetGameServerStatistics get_statistics() const;
+
 		Signal<void(NetGameConnection *)> &sig_client_connected();
 		Signal<void(NetGameConnection *, const std::string &)> &sig_client_disconnected();
 		Signal<void(NetGameConnection *, const NetGameEvent &)> &sig_event_received();
@@ -0,0 +1,101 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "../../Core/System/exception.h"
+#include "../../Core/JSON/json_value.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clan
+{
+	/// \addtogroup clanNetwork_NetGame clanNetwork NetGame
+	/// \{
+
+	/// \brief Snapshot of the traffic counters of a NetGameConnection
+	///
+	/// The rates are averaged over a rolling window of the last couple of seconds.
+	class NetGameConnectionStatistics
+	{
+	public:
+		/// \brief Address and port of the remote end point
+		std::string remote_name;
+
+		uint64_t bytes_received = 0;
+		uint64_t bytes_sent = 0;
+		uint64_t events_received = 0;
+		uint64_t events_sent = 0;
+
+		double bytes_received_per_second = 0.0;
+		double bytes_sent_per_second = 0.0;
+		double events_received_per_second = 0.0;
+		double events_sent_per_second = 0.0;
+
+		/// \brief Received events still waiting to be dispatched by process_events()
+		int events_pending = 0;
+
+		/// \brief Events queued by send_event() that have not been encoded yet
+		int send_queue_length = 0;
+
+		/// \brief Encoded bytes waiting for room in the socket send buffer
+		int send_buffer_bytes = 0;
+
+		/// \brief Microseconds spent reading from and writing to the socket
+		uint64_t read_time = 0;
+		uint64_t write_time = 0;
+
+		/// \brief Smoothed round trip time in microseconds as measured by the TCP stack, or -1 if not available
+		int round_trip_time = -1;
+
+		/// \brief Returns the statistics as a JSON object
+		JsonValue to_json() const;
+	};
+
+	/// \brief Snapshot of the traffic counters of a NetGameServer
+	class NetGameServerStatistics
+	{
+	public:
+		/// \brief Number of clients accepted since the server was started
+		uint64_t connections_accepted = 0;
+
+		/// \brief Counters summed over all connections, including the ones that have disconnected
+		///
+		/// Rates and queue sizes only include the current connections. The round trip time is the highest of any current connection.
+		NetGameConnectionStatistics totals;
+
+		/// \brief Statistics for each current connection
+		std::vector<NetGameConnectionStatistics> connections;
+
+		/// \brief Returns the statistics as a JSON object
+		JsonValue to_json() const;
+	};
+
+	/// \}
+}
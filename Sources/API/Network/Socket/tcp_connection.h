@@ -47,6 +47,10 @@ namespace clan
 		/// \return Bytes read, 0 if remote closed connection, or -1 if buffer is empty
 		int read(void *data, int size);
 
+		/// \brief Smoothed round trip time estimated by the TCP stack
+		/// \return Round trip time in microseconds, or -1 if the platform does not provide it
+		int get_round_trip_time();
+
 		/// \internal Constructs a TCPConnection instance based on a socket handle
 		TCPConnection(const std::shared_ptr<TCPSocket> &impl);
 
@@ -55,6 +59,8 @@ namespace clan
 
 	private:
 		std::shared_ptr<TCPSocket> impl;
+
+		friend class TLSConnection;
 	};
 
 	// To do: QOSAddSocketToFlow
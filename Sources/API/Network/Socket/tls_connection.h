@@ -0,0 +1,107 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include "network_condition_variable.h"
+
+#include <memory>
+
+namespace clan
+{
+	class SocketName;
+	class TCPConnection;
+	class TLSConnection_Impl;
+
+	/// \brief TLS encrypted TCP/IP socket connection
+	///
+	/// Wraps a non-blocking TCPConnection and a TLSClient. It can be waited on with a NetworkConditionVariable
+	/// just like a TCPConnection. The handshake runs as part of the read and write calls.
+	///
+	/// The certificate presented by the server is not verified.
+	class TLSConnection : public NetworkEvent
+	{
+	public:
+		/// \brief Create null object
+		TLSConnection();
+
+		/// \brief Blocking connect to end point and begin the TLS handshake
+		TLSConnection(const SocketName &endpoint);
+
+		/// \brief Begin the TLS handshake on an already connected socket
+		TLSConnection(const TCPConnection &connection);
+
+		~TLSConnection();
+
+		/// \brief Returns true if it is a null object
+		bool is_null() const { return !impl; }
+
+		/// \brief Returns true when the handshake has completed
+		bool is_handshake_complete() const;
+
+		/// \brief Returns the socket name of the local end point
+		SocketName get_local_name();
+
+		/// \brief Returns the socket name of the peer end point
+		SocketName get_remote_name();
+
+		/// \brief Close connection
+		///
+		/// Encrypted data still waiting for the socket is lost. Use shutdown to close after all written data.
+		void close();
+
+		/// \brief Send a close_notify alert after all written data and close the socket once everything is sent
+		///
+		/// Encrypted data that does not fit in the socket buffer is kept. Call again when the socket can take more.
+		/// No more data can be written after the first call.
+		/// \return true when the socket has been closed
+		bool shutdown();
+
+		/// \brief Encrypt and write data to the socket
+		///
+		/// Encrypted data that does not fit in the socket buffer is kept and sent by later calls to read or write.
+		/// Writing zero bytes only sends such data.
+		/// \return Bytes accepted, or -1 if the buffer is full
+		int write(const void *data, int size);
+
+		/// \brief Read and decrypt data from the socket
+		/// \return Bytes read, 0 if remote closed connection, or -1 if no decrypted data is available yet
+		int read(void *data, int size);
+
+		/// \brief Smoothed round trip time estimated by the TCP stack
+		/// \return Round trip time in microseconds, or -1 if the platform does not provide it
+		int get_round_trip_time();
+
+	protected:
+		SocketHandle *get_socket_handle() override;
+
+	private:
+		std::shared_ptr<TLSConnection_Impl> impl;
+	};
+}
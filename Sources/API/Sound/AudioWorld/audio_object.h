@@ -48,20 +48,30 @@ namespace clan
 		bool is_null() const { return !impl; }
 
 		Vec3f get_position() const;
+		Vec3f get_velocity() const;
 
 		float get_attenuation_begin() const;
 		float get_attenuation_end() const;
 		float get_volume() const;
+		float get_occlusion() const;
 		bool is_looping() const;
 		bool is_ambience() const;
 		bool is_playing() const;
 
 		void set_position(const Vec3f &position);
 
+		/// \brief Velocity in world units per second, used for the Doppler shift
+		void set_velocity(const Vec3f &velocity);
+
 		void set_attenuation_begin(float distance);
 		void set_attenuation_end(float distance);
 		void set_volume(float volume);
 
+		/// \brief How much of the sound is blocked between the object and the listener, from 0 (none) to 1 (silent)
+		///
+		/// The world does no ray casting itself. Games update this from their own visibility tests.
+		void set_occlusion(float occlusion);
+
 		void set_sound(const std::string &id);
 		void set_sound(const SoundBuffer &buffer);
 
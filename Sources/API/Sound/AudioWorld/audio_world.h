@@ -47,6 +47,17 @@ namespace clan
 
 		void set_listener(const Vec3f &position, const Quaternionf &orientation);
 
+		/// \brief Velocity of the listener in world units per second, used for the Doppler shift
+		void set_listener_velocity(const Vec3f &velocity);
+
+		/// \brief Scales the Doppler shift. The default of 0 disables it.
+		void set_doppler_factor(float factor);
+		float get_doppler_factor() const;
+
+		/// \brief Speed of sound in world units per second. The default is 343.3 (meters).
+		void set_speed_of_sound(float speed);
+		float get_speed_of_sound() const;
+
 		void enable_ambience(bool enable);
 		bool is_ambience_enabled() const;
 
@@ -0,0 +1,104 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "../soundfilter.h"
+
+namespace clan
+{
+	/// \addtogroup clanSound_Filters clanSound Filters
+	/// \{
+
+	class BiquadFilterProvider;
+
+	/// \brief Biquad filter responses
+	enum BiquadFilterType
+	{
+		/// \brief Attenuates frequencies above the cutoff
+		cl_biquad_lowpass,
+
+		/// \brief Attenuates frequencies below the cutoff
+		cl_biquad_highpass,
+
+		/// \brief Passes a band around the center frequency
+		cl_biquad_bandpass,
+
+		/// \brief Removes a band around the center frequency
+		cl_biquad_notch,
+
+		/// \brief Boosts or cuts a band around the center frequency
+		cl_biquad_peaking,
+
+		/// \brief Boosts or cuts frequencies below the cutoff
+		cl_biquad_lowshelf,
+
+		/// \brief Boosts or cuts frequencies above the cutoff
+		cl_biquad_highshelf
+	};
+
+	/// \brief Biquad Filter Class
+	///
+	/// Second order IIR filter for equalizers, using the formulas of the Audio EQ Cookbook.
+	/// The sample rate must match the mixing frequency of the sound output.
+	class BiquadFilter : public SoundFilter
+	{
+	public:
+		/// \brief Biquad Filter Constructor
+		///
+		/// \param type Filter response
+		/// \param frequency Cutoff or center frequency in Hz
+		/// \param q Quality factor. 0.707 gives a flat passband for low and high pass filters
+		/// \param gain_db Boost or cut in decibels. Only used by the peaking and shelf filters
+		/// \param sample_rate Sample rate of the filtered data
+		BiquadFilter(BiquadFilterType type, float frequency, float q = 0.707f, float gain_db = 0.0f, int sample_rate = 44100);
+
+		/// \brief Biquad Filter Destructor
+		virtual ~BiquadFilter();
+
+		/// \brief Retrieves the provider.
+		BiquadFilterProvider *get_provider() const;
+
+		/// \brief Returns the filter response.
+		BiquadFilterType get_type() const;
+
+		/// \brief Returns the cutoff or center frequency in Hz.
+		float get_frequency() const;
+
+		/// \brief Returns the quality factor.
+		float get_q() const;
+
+		/// \brief Returns the boost or cut in decibels.
+		float get_gain() const;
+
+		/// \brief Changes the filter. The mixer picks up the new coefficients at the start of the next block.
+		void set_parameters(BiquadFilterType type, float frequency, float q = 0.707f, float gain_db = 0.0f);
+	};
+
+	/// \}
+}
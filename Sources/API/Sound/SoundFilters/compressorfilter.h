@@ -0,0 +1,107 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "../soundfilter.h"
+
+namespace clan
+{
+	/// \addtogroup clanSound_Filters clanSound Filters
+	/// \{
+
+	class CompressorFilterProvider;
+
+	/// \brief Compressor Filter Class
+	///
+	/// Reduces the volume of everything louder than the threshold. The level is the peak of all
+	/// channels, so the stereo image is kept. With a zero attack time and a very large ratio it
+	/// acts as a limiter that never lets a sample above the threshold.
+	class CompressorFilter : public SoundFilter
+	{
+	public:
+		/// \brief Compressor Filter Constructor
+		///
+		/// \param threshold Level in decibels (relative to full scale) where compression starts
+		/// \param ratio How many decibels the input must rise above the threshold to raise the output one decibel
+		/// \param attack Time in milliseconds to react to a rising level
+		/// \param release Time in milliseconds to recover after the level drops
+		/// \param makeup_gain Gain in decibels applied after compression
+		/// \param sample_rate Sample rate of the filtered data
+		CompressorFilter(float threshold = -12.0f, float ratio = 4.0f, float attack = 10.0f, float release = 100.0f, float makeup_gain = 0.0f, int sample_rate = 44100);
+
+		/// \brief Compressor Filter Destructor
+		virtual ~CompressorFilter();
+
+		/// \brief Retrieves the provider.
+		CompressorFilterProvider *get_provider() const;
+
+		/// \brief Returns the threshold in decibels.
+		float get_threshold() const;
+
+		/// \brief Sets the threshold in decibels.
+		void set_threshold(float threshold);
+
+		/// \brief Returns the compression ratio.
+		float get_ratio() const;
+
+		/// \brief Sets the compression ratio. Infinity makes it a limiter.
+		void set_ratio(float ratio);
+
+		/// \brief Returns the attack time in milliseconds.
+		float get_attack() const;
+
+		/// \brief Sets the attack time in milliseconds.
+		void set_attack(float attack);
+
+		/// \brief Returns the release time in milliseconds.
+		float get_release() const;
+
+		/// \brief Sets the release time in milliseconds.
+		void set_release(float release);
+
+		/// \brief Returns the hold time in milliseconds.
+		float get_hold() const;
+
+		/// \brief Sets how many milliseconds the level is held after a peak before the release starts. Default is 0.
+		///
+		/// A hold time longer than the period of the lowest frequency stops a fast limiter from flattening every wave top.
+		void set_hold(float hold);
+
+		/// \brief Returns the makeup gain in decibels.
+		float get_makeup_gain() const;
+
+		/// \brief Sets the makeup gain in decibels.
+		void set_makeup_gain(float makeup_gain);
+
+		/// \brief Returns the gain reduction of the last processed sample, in decibels.
+		float get_gain_reduction() const;
+	};
+
+	/// \}
+}
@@ -0,0 +1,77 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "../soundfilter.h"
+#include <vector>
+
+namespace clan
+{
+	/// \addtogroup clanSound_Filters clanSound Filters
+	/// \{
+
+	class ConvolutionReverbFilterProvider;
+
+	/// \brief Convolution Reverb Filter Class
+	///
+	/// Convolves every channel with a recorded impulse response, using uniformly partitioned FFT
+	/// convolution so long responses stay cheap. The reverberated signal is delayed by one block.
+	class ConvolutionReverbFilter : public SoundFilter
+	{
+	public:
+		/// \brief Convolution Reverb Filter Constructor
+		///
+		/// \param impulse_response Mono impulse response, at the sample rate of the filtered data
+		/// \param block_size Partition size in samples. Must be a power of two. Smaller blocks lower the latency but cost more CPU.
+		ConvolutionReverbFilter(const std::vector<float> &impulse_response, int block_size = 256);
+
+		/// \brief Convolution Reverb Filter Destructor
+		virtual ~ConvolutionReverbFilter();
+
+		/// \brief Retrieves the provider.
+		ConvolutionReverbFilterProvider *get_provider() const;
+
+		/// \brief Returns how many samples the reverberated signal lags behind the original.
+		int get_latency() const;
+
+		/// \brief Returns the volume of the reverberated signal.
+		float get_wet_level() const;
+
+		/// \brief Sets the volume of the reverberated signal. Default is 1.0f.
+		void set_wet_level(float level);
+
+		/// \brief Returns the volume of the original signal.
+		float get_dry_level() const;
+
+		/// \brief Sets the volume of the original signal. Default is 1.0f.
+		void set_dry_level(float level);
+	};
+
+	/// \}
+}
@@ -0,0 +1,91 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "../soundfilter.h"
+
+namespace clan
+{
+	/// \addtogroup clanSound_Filters clanSound Filters
+	/// \{
+
+	class DelayFilterProvider;
+
+	/// \brief Multi-tap Delay Filter Class
+	///
+	/// Each tap adds the input from a given time ago at its own gain. Delays do not have to be
+	/// a whole number of samples. The sum of the taps can be fed back into the delay line.
+	class DelayFilter : public SoundFilter
+	{
+	public:
+		/// \brief Maximum number of taps
+		static const int max_taps = 16;
+
+		/// \brief Delay Filter Constructor
+		///
+		/// \param max_delay Longest delay a tap can have, in milliseconds
+		/// \param sample_rate Sample rate of the filtered data
+		DelayFilter(float max_delay = 1000.0f, int sample_rate = 44100);
+
+		/// \brief Delay Filter Destructor
+		virtual ~DelayFilter();
+
+		/// \brief Retrieves the provider.
+		DelayFilterProvider *get_provider() const;
+
+		/// \brief Returns the number of taps.
+		int get_tap_count() const;
+
+		/// \brief Adds a tap and returns its index.
+		///
+		/// \param delay Delay in milliseconds
+		/// \param gain Volume of the delayed signal
+		int add_tap(float delay, float gain);
+
+		/// \brief Changes the delay (in milliseconds) and gain of a tap.
+		void set_tap(int index, float delay, float gain);
+
+		/// \brief Removes all taps.
+		void remove_taps();
+
+		/// \brief Returns how much of the delayed signal is fed back into the delay line.
+		float get_feedback() const;
+
+		/// \brief Sets how much of the delayed signal is fed back into the delay line. Default is 0.
+		void set_feedback(float feedback);
+
+		/// \brief Returns the volume of the undelayed signal.
+		float get_dry_level() const;
+
+		/// \brief Sets the volume of the undelayed signal. Default is 1.
+		void set_dry_level(float level);
+	};
+
+	/// \}
+}
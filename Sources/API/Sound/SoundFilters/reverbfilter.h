@@ -0,0 +1,90 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "../soundfilter.h"
+
+namespace clan
+{
+	/// \addtogroup clanSound_Filters clanSound Filters
+	/// \{
+
+	class ReverbFilterProvider;
+
+	/// \brief Reverb Filter Class
+	///
+	/// Algorithmic room reverb in the style of Freeverb: eight parallel comb filters and four
+	/// allpass filters per side. Only the first two channels are processed.
+	class ReverbFilter : public SoundFilter
+	{
+	public:
+		/// \brief Reverb Filter Constructor
+		///
+		/// \param sample_rate Sample rate of the filtered data
+		ReverbFilter(int sample_rate = 44100);
+
+		/// \brief Reverb Filter Destructor
+		virtual ~ReverbFilter();
+
+		/// \brief Retrieves the provider.
+		ReverbFilterProvider *get_provider() const;
+
+		/// \brief Returns the room size, from 0.0f (small) to 1.0f (large).
+		float get_room_size() const;
+
+		/// \brief Sets the room size, from 0.0f (small) to 1.0f (large). Default is 0.5f.
+		void set_room_size(float room_size);
+
+		/// \brief Returns how fast high frequencies die out, from 0.0f to 1.0f.
+		float get_damping() const;
+
+		/// \brief Sets how fast high frequencies die out, from 0.0f to 1.0f. Default is 0.5f.
+		void set_damping(float damping);
+
+		/// \brief Returns the volume of the reverberated signal.
+		float get_wet_level() const;
+
+		/// \brief Sets the volume of the reverberated signal. Default is 1.0f.
+		void set_wet_level(float level);
+
+		/// \brief Returns the volume of the original signal.
+		float get_dry_level() const;
+
+		/// \brief Sets the volume of the original signal. Default is 1.0f.
+		void set_dry_level(float level);
+
+		/// \brief Returns the stereo width of the reverb, from 0.0f (mono) to 1.0f.
+		float get_width() const;
+
+		/// \brief Sets the stereo width of the reverb, from 0.0f (mono) to 1.0f. Default is 1.0f.
+		void set_width(float width);
+	};
+
+	/// \}
+}
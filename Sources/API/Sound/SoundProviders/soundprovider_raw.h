@@ -49,12 +49,14 @@ namespace clan
 		/// \param bytes_per_sample The size of a sample in bytes. This is 2 for 16 bit (signed), and 1 for 8 bit (unsigned).
 		/// \param stereo True if sound is stereo (two channels).
 		/// \param frequency Playback frequency for sample data.
+		/// \param copy_data If false, sessions play straight from sound_data, which must stay valid until the provider is destroyed.
 		SoundProvider_Raw(
 			void *sound_data,
 			int num_samples,
 			int bytes_per_sample,
 			bool stereo,
-			int frequency = 22050);
+			int frequency = 22050,
+			bool copy_data = true);
 
 		virtual ~SoundProvider_Raw();
 
@@ -48,6 +48,9 @@ namespace clan
 		/// \param filename Filename of wave file.
 		/// \param provider Input source provider used to retrieve wave file.
 		/// \param stream If true, will stream from disk. If false, will load it to memory.
+		///
+		/// Streamed files in a plain directory are memory mapped, and sessions play the samples straight
+		/// from the mapping. Files that cannot be mapped, such as files in zip archives, are loaded to memory.
 		SoundProvider_Wave(
 			const std::string &filename,
 			const FileSystem &fs,
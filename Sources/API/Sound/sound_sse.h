@@ -64,15 +64,21 @@ namespace clan
 		/// \brief Packs two float channels into a single 16 bit samples stream
 		static void pack_16bit_stereo(float *input[2], int size, short *output);
 
+		/// \brief Converts float samples to 16 bit samples, keeping their order
+		static void pack_16bit(const float *input, int size, short *output);
+
 		/// \brief Packs two float channels into a single float samples stream
 		static void pack_float_stereo(float *input[2], int size, float *output);
 
 		/// \brief Copy floats from one buffer to another
-		static void copy_float(float *input, int size, float *output);
+		static void copy_float(const float *input, int size, float *output);
 
 		/// \brief Multiplies floats with a float
 		static void multiply_float(float *channel, int size, float volume);
 
+		/// \brief Clamps floats to the range min_value to max_value
+		static void clamp_float(float *channel, int size, float min_value, float max_value);
+
 		/// \brief Sets floats to a specific value
 		static void set_float(float *channel, int size, float value);
 
@@ -84,6 +90,9 @@ namespace clan
 
 		/// \brief Mixes many float channels into one float channel with individual volumes for each channel
 		static void mix_many_to_one(float **input, float *volume, int channels, int size, float *output);
+
+		/// \brief Mixes many float channels into one float channel, fading each channel linearly from start_volume to end_volume
+		static void mix_many_to_one_ramp(float **input, float *start_volume, float *end_volume, int channels, int size, float *output);
 	};
 
 	/// \}
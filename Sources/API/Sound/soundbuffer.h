@@ -156,6 +156,8 @@ namespace clan
 
 	private:
 		std::shared_ptr<SoundBuffer_Impl> impl;
+
+		friend class SoundBuffer_Session_Impl;
 	};
 
 	/// \}
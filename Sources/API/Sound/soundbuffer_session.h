@@ -40,6 +40,23 @@ namespace clan
 	class SoundBuffer;
 	class SoundBuffer_Session_Impl;
 	class SoundOutput;
+	class SoundBus;
+
+	/// \brief Interpolation used when a session is played at another frequency than the mixer.
+	enum SoundResampleQuality
+	{
+		/// \brief Nearest sample. Cheapest, but aliases badly.
+		cl_resample_nearest,
+
+		/// \brief Linear interpolation between the two nearest samples.
+		cl_resample_linear,
+
+		/// \brief Cubic (Catmull-Rom) interpolation over four samples.
+		cl_resample_cubic,
+
+		/// \brief Band-limited 32 tap windowed sinc. Highest quality, highest cost.
+		cl_resample_sinc
+	};
 
 	/// \brief SoundBuffer_Session provides control over a playing soundeffect.
 	///
@@ -91,6 +108,9 @@ namespace clan
 		///   and 1 means the soundeffect is only playing in the right speaker.
 		float get_pan() const;
 
+		/// \brief Returns the front to back position set by set_pan_depth.
+		float get_pan_depth() const;
+
 		/// \brief Returns whether this session loops
 		///
 		/// \return true if session should loop, false otherwise
@@ -146,6 +166,15 @@ namespace clan
 		///    \return Returns true if the operation completed sucecsfully.
 		void set_pan(float new_pan);
 
+		/// \brief Sets the front to back position of the session, -1 in front of the listener and 1 behind.
+		///
+		/// Once set, the session is panned around the listener on speaker layouts with side or
+		///    back speakers, using the pan and depth as a direction. A session with both at 0 is
+		///    heard from all speakers. Stereo outputs only use the pan.
+		///
+		///    \param new_depth New depth of the session played.
+		void set_pan_depth(float new_depth);
+
 		/// \brief Starts playback of the session.
 		void play();
 
@@ -165,12 +194,35 @@ namespace clan
 		/// \brief Remove the sound filter from the session. See SoundFilter for details.
 		void remove_filter(SoundFilter &filter);
 
+		/// \brief Returns the interpolation used when the session frequency differs from the mixing frequency.
+		SoundResampleQuality get_resample_quality() const;
+
+		/// \brief Sets the interpolation used when the session frequency differs from the mixing frequency. Default is cl_resample_linear.
+		void set_resample_quality(SoundResampleQuality quality);
+
+		/// \brief Returns the voice priority of the session.
+		int get_priority() const;
+
+		/// \brief Sets the voice priority of the session. Default is 0.
+		///
+		/// When more sessions are audible than SoundOutput::get_max_voices allows, the sessions with
+		/// the highest priority are mixed, and the loudest among those with equal priority. The rest
+		/// become virtual: they keep their position advancing, but are silent until picked again.
+		void set_priority(int priority);
+
+		/// \brief Returns the bus the session is mixed into, or a null bus for the master bus.
+		SoundBus get_bus() const;
+
+		/// \brief Routes the session to a submix bus. A null bus routes it to the master bus of the output.
+		void set_bus(SoundBus &bus);
+
 	private:
 		SoundBuffer_Session(SoundBuffer &soundbuffer, bool looping, SoundOutput &output);
 		std::shared_ptr<SoundBuffer_Session_Impl> impl;
 
 		friend class SoundBuffer;
 		friend class SoundOutput_Impl;
+		friend class AudioWorld_Impl;
 	};
 
 	/// \}
@@ -0,0 +1,91 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanSound_Audio_Mixing clanSound Audio Mixing
+	/// \{
+
+	class SoundOutput;
+	class SoundFilter;
+	class SoundMixer;
+
+	/// \brief Submix bus in the mixing graph of a sound output.
+	///
+	///   <p>Sessions routed to a bus with SoundBuffer_Session::set_bus are summed
+	///    by the bus before its filters and volume are applied, which allows
+	///    groups of sounds such as music, effects and voice to be controlled as
+	///    a whole. Buses can be nested. A bus is mixed for as long as it or a
+	///    session routed to it exists.</p>
+	class SoundBus
+	{
+	public:
+		/// \brief Constructs a null instance
+		SoundBus();
+
+		/// \brief Constructs a bus mixed into the master bus of a sound output
+		SoundBus(SoundOutput &output);
+
+		/// \brief Constructs a bus mixed into another bus of the sound output
+		SoundBus(SoundOutput &output, SoundBus &parent);
+
+		~SoundBus();
+
+		/// \brief Returns true if this object is invalid.
+		bool is_null() const { return !impl; }
+
+		/// \brief Throw an exception if this object is invalid.
+		void throw_if_null() const;
+
+		/// \brief Returns the volume applied to the bus output.
+		float get_volume() const;
+
+		/// \brief Sets the volume applied to the bus output.
+		void set_volume(float volume);
+
+		/// \brief Adds a sound filter applied to the sum of the bus inputs.
+		void add_filter(SoundFilter &filter);
+
+		/// \brief Removes a sound filter from the bus.
+		void remove_filter(SoundFilter &filter);
+
+		bool operator==(const SoundBus &other) const { return impl == other.impl; }
+		bool operator!=(const SoundBus &other) const { return impl != other.impl; }
+
+	private:
+		std::shared_ptr<SoundMixer> impl;
+
+		friend class SoundBuffer_Session;
+	};
+
+	/// \}
+}
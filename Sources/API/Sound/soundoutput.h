@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include "speaker_position.h"
 
 namespace clan
 {
@@ -78,12 +79,34 @@ namespace clan
 		/// \brief Returns the mixing latency in milliseconds.
 		int get_mixing_latency() const;
 
+		/// \brief Returns the speakers the sound output mixes for.
+		SpeakerPositionMask get_speakers() const;
+
 		/// \brief Returns the main volume of the sound output.
 		float get_global_volume() const;
 
 		/// \brief Returns the main panning position of the sound output.
 		float get_global_pan() const;
 
+		/// \brief Returns the most sessions mixed at once. 0 means no limit.
+		int get_max_voices() const;
+
+		/// \brief Returns the number of sessions mixed in the last fragment.
+		int get_voices_mixed() const;
+
+		/// \brief Returns the number of playing sessions that were virtual in the last fragment.
+		///
+		/// Sessions are virtual when they are inaudible, or when they lost to the max voices budget.
+		int get_voices_virtual() const;
+
+		/// \brief Returns the time in milliseconds from mixing a sample until the device plays it.
+		///
+		/// Backends that cannot measure this return the mixing latency.
+		float get_output_latency() const;
+
+		/// \brief Returns how many times the device ran out of samples to play (xruns).
+		int get_underrun_count() const;
+
 		/// \brief Stops all sample playbacks on the sound output.
 		void stop_all();
 
@@ -93,6 +116,11 @@ namespace clan
 		/// \brief Sets the main panning position on the sound output.
 		void set_global_pan(float pan);
 
+		/// \brief Sets the most sessions mixed at once. 0 means no limit.
+		///
+		/// See SoundBuffer_Session::set_priority for how the mixed sessions are picked.
+		void set_max_voices(int count);
+
 		/// \brief Adds the sound filter to the sound output.
 		///
 		/// \param filter Sound filter to pass sound through.
@@ -101,6 +129,20 @@ namespace clan
 		/// \brief Remove the sound filter from the session.
 		void remove_filter(SoundFilter &filter);
 
+		/// \brief Mixes the next samples of an offline sound output.
+		///
+		/// Only available when the output was created with SoundOutput_Description::set_offline.
+		/// The samples are also written to the wave file and callback of the output, if it has any.
+		/// \param output Receives sample_count samples for each speaker, interleaved in SpeakerPosition bit order.
+		/// \param sample_count Number of samples per speaker to mix.
+		void render(float *output, int sample_count);
+
+		/// \brief Mixes the next samples of an offline sound output, only passing them to its wave file and callback.
+		///
+		/// Mixing runs as fast as the CPU allows, so this can render minutes of audio in seconds.
+		/// \param sample_count Number of samples per speaker to mix.
+		void render(int sample_count);
+
 	private:
 		SoundOutput(const std::weak_ptr<SoundOutput_Impl> impl);
 
@@ -109,6 +151,8 @@ namespace clan
 		friend class SoundBuffer;
 		friend class Sound;
 		friend class SoundBuffer_Session;
+		friend class SoundBus;
+		friend class AudioWorld_Impl;
 	};
 
 	/// \}
@@ -29,6 +29,10 @@
 #pragma once
 
 #include <memory>
+#include <functional>
+#include <string>
+#include "speaker_position.h"
+#include "../Core/IOData/iodevice.h"
 
 namespace clan
 {
@@ -51,12 +55,77 @@ namespace clan
 		/// \brief Returns the mixing latency in milliseconds.
 		int get_mixing_latency() const;
 
+		/// \brief Returns the requested speaker layout.
+		SpeakerPositionMask get_speakers() const;
+
+		/// \brief Returns the name of the sound device to open. Empty means the system default.
+		const std::string &get_device_name() const;
+
+		/// \brief Returns true if the output mixes without a sound device.
+		bool is_offline() const;
+
+		/// \brief Returns the device an offline output writes a wave file to. Null if none.
+		IODevice get_offline_output() const;
+
+		/// \brief Returns true if the offline wave file stores 32 bit float samples.
+		bool is_offline_output_float() const;
+
+		/// \brief Returns the function an offline output hands every mixed block to.
+		std::function<void(const float *, int)> get_offline_callback() const;
+
+		/// \brief Returns the number of threads used for mixing sound sessions.
+		int get_mixing_threads() const;
+
+		/// \brief Returns the most sessions mixed at once. 0 means no limit.
+		int get_max_voices() const;
+
 		/// \brief Sets the mixing frequency for the sound output device.
 		void set_mixing_frequency(int frequency);
 
 		/// \brief Sets the mixing latency in milliseconds.
 		void set_mixing_latency(int latency);
 
+		/// \brief Sets the requested speaker layout.
+		///
+		/// Devices that only support stereo ignore this and mix in stereo. Use SoundOutput::get_speakers to find the layout in use.
+		void set_speakers(SpeakerPositionMask speakers);
+
+		/// \brief Sets the name of the sound device to open.
+		///
+		/// The ALSA backend takes a PCM name such as "hw:0,0", "plughw:1" or "null". The default is
+		/// empty, which opens "default". Other backends ignore the name.
+		void set_device_name(const std::string &name);
+
+		/// \brief Creates an output that mixes without a sound device. Audio is then mixed by calling SoundOutput::render.
+		void set_offline(bool enable = true);
+
+		/// \brief Writes everything an offline output mixes to a wave file.
+		///
+		/// The sizes in the header are filled in when the sound output is destroyed. If the device
+		/// cannot seek, they are left at 0xffffffff, which most tools read as a stream of unknown length.
+		/// \param wave_file Device to write to, for example a File
+		/// \param float_samples Store 32 bit float samples instead of 16 bit integers
+		void set_offline_output(const IODevice &wave_file, bool float_samples = false);
+
+		/// \brief Calls a function with every block an offline output mixes.
+		///
+		/// The function receives sample_count samples per speaker, interleaved in SpeakerPosition bit order.
+		/// It is called on the thread calling SoundOutput::render.
+		void set_offline_callback(const std::function<void(const float *samples, int sample_count)> &callback);
+
+		/// \brief Sets the number of threads used for mixing sound sessions.
+		///
+		/// The default of 1 mixes everything on the mixer thread. With more threads the sessions of
+		/// each bus are spread across a pool of worker threads, which helps when hundreds of sessions
+		/// are playing at once. Filters shared between sessions must be thread safe in this mode.
+		/// Zero picks one thread per CPU core.
+		void set_mixing_threads(int count);
+
+		/// \brief Sets the most sessions mixed at once. The default of 0 means no limit.
+		///
+		/// Sessions beyond the limit, and sessions too quiet to hear, become virtual and cost almost nothing to play.
+		void set_max_voices(int count);
+
 	private:
 		std::shared_ptr<SoundOutput_Description_Impl> impl;
 	};
@@ -30,6 +30,13 @@
 
 namespace clan
 {
+	/// \addtogroup clanSound_Audio_Mixing clanSound Audio Mixing
+	/// \{
+
+	/// \brief Speaker positions
+	///
+	/// The values match the WAVE_FORMAT_EXTENSIBLE channel mask. Interleaved sample data
+	/// always store the channels in the order of these bits.
 	enum SpeakerPosition
 	{
 		cl_speaker_front_left                = 0x1,
@@ -52,5 +59,18 @@ namespace clan
 		cl_speaker_top_back_right            = 0x20000
 	};
 
+	/// \brief Bitmask of SpeakerPosition values
 	typedef unsigned int SpeakerPositionMask;
+
+	/// \brief Common speaker layouts
+	enum SpeakerLayout
+	{
+		cl_speakers_mono = cl_speaker_front_center,
+		cl_speakers_stereo = cl_speaker_front_left | cl_speaker_front_right,
+		cl_speakers_quad = cl_speakers_stereo | cl_speaker_back_left | cl_speaker_back_right,
+		cl_speakers_5_1 = cl_speakers_quad | cl_speaker_front_center | cl_speaker_low_frequency,
+		cl_speakers_7_1 = cl_speakers_5_1 | cl_speaker_side_left | cl_speaker_side_right
+	};
+
+	/// \}
 }
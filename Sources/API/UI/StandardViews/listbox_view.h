@@ -55,6 +55,22 @@ namespace clan
 			set_items(views);
 		}
 		
+		/// Shows item_count items using row views created on demand, instead of a view for each item
+		///
+		/// Only the items within the visible area, plus a few rows of overscan, have a row view. create_row creates an empty
+		/// row view and update_row fills a row view with the data of an item. Row views scrolled out of view are reused for
+		/// other items. All rows must have the same height, which is measured from the first row.
+		void set_items(int item_count, const std::function<std::shared_ptr<View>()> &create_row, const std::function<void(const std::shared_ptr<View> &row, int index)> &update_row);
+
+		/// Changes the number of items shown using on demand rows. The rows in view are updated again.
+		void set_item_count(int item_count);
+
+		/// Number of items in the list box
+		int item_count() const;
+
+		/// Sets the number of rows created beyond each edge of the visible area for on demand rows. Default is 2.
+		void set_overscan(int rows);
+
 		int selected_item() const;
 		void set_selected_item(int index);
 
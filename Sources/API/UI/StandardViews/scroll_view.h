@@ -61,6 +61,12 @@ namespace clan
 		
 		Pointf content_offset() const;
 		void set_content_offset(const Pointf &offset, bool animated = false);
+
+		/// Size of the area the content view is shown in
+		Sizef viewport_size() const;
+
+		/// Emitted when the content offset changes, by the scroll bars or by set_content_offset
+		Signal<void()> &sig_content_offset_changed();
 		
 		void layout_children(Canvas &canvas) override;
 
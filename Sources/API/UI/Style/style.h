@@ -32,6 +32,7 @@
 #include "../../Core/Math/cl_math.h"
 #include "../../Display/2D/color.h"
 #include "style_get_value.h"
+#include "style_property_id.h"
 #include <memory>
 
 namespace clan
@@ -67,6 +68,7 @@ namespace clan
 		/// Retrieve the declared value for a property
 		StyleGetValue declared_value(const char *property_name) const;
 		StyleGetValue declared_value(const std::string &property_name) const { return declared_value(property_name.c_str()); }
+		StyleGetValue declared_value(const StylePropertyId &property) const;
 
 		/// Static helper that generates a "rgba(%1,%2,%3,%4)" string for the given color.
 		static std::string to_rgba(const Colorf &c)
@@ -81,5 +83,7 @@ namespace clan
 
 	private:
 		std::unique_ptr<StyleImpl> impl;
+
+		friend class StyleCascade;
 	};
 }
@@ -31,7 +31,9 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "../../Core/Math/rect.h"
 #include "style_get_value.h"
+#include "style_property_id.h"
 
 namespace clan
 {
@@ -62,6 +64,9 @@ namespace clan
 #endif
 
 	/// Style value resolver
+	///
+	/// Computed values are remembered in a snapshot indexed by StylePropertyId. The snapshot is kept until
+	/// a style in the cascade changes, the cascade or parent is replaced, or the parent snapshot changes.
 	class StyleCascade
 	{
 	public:
@@ -77,16 +82,33 @@ namespace clan
 		/// Find the first declared value in the cascade for the specified property
 		StyleGetValue cascade_value(const char *property_name) const;
 		StyleGetValue cascade_value(const std::string &property_name) const { return cascade_value(property_name.c_str()); }
+		StyleGetValue cascade_value(const StylePropertyId &property) const;
 
 		/// Resolve any inheritance or initial values for the cascade value
 		StyleGetValue specified_value(const char *property_name) const;
 		StyleGetValue specified_value(const std::string &property_name) const { return specified_value(property_name.c_str()); }
+		StyleGetValue specified_value(const StylePropertyId &property) const;
 
 		/// Find the computed value for the specified value
 		///
 		/// The computed value is a simplified value for the property. Lengths are resolved to device independent pixels and so on.
 		StyleGetValue computed_value(const char *property_name) const;
 		StyleGetValue computed_value(const std::string &property_name) const { return computed_value(property_name.c_str()); }
+		StyleGetValue computed_value(const StylePropertyId &property) const;
+
+		/// Discards the computed values of this cascade and the cascades inheriting from it
+		///
+		/// Changes to the styles themselves are detected automatically. Call this after changing cascade or parent.
+		void invalidate();
+
+		/// Number identifying the current computed values. It changes whenever any of them may have changed.
+		unsigned int generation() const;
+
+		/// Number identifying the computed values that can affect layout. Unlike generation, it stays the same when only paint properties change.
+		unsigned int layout_generation() const;
+
+		/// True if the style declares properties that can change the layout, rather than only how a view is rendered
+		static bool affects_layout(const Style *style);
 		
 		/// Convert length into px (device independent pixel) units
 		StyleGetValue compute_length(const StyleGetValue &length) const;
@@ -112,8 +134,37 @@ namespace clan
 
 		/// Render styled border
 		void render_border(Canvas &canvas, const ViewGeometry &geometry) const;
+
+		/// Area drawn into by render_background and render_border, which shadows and border images can extend beyond the border box
+		Rectf render_box(Canvas &canvas, const ViewGeometry &geometry) const;
 		
 		/// Font used by this style cascade
 		Font font(Canvas &canvas) const;
+
+	private:
+		/// Discards the snapshot if anything it was computed from has changed
+		void update_snapshot() const;
+
+		/// Computed values by property index, valid where snapshot_known is set
+		mutable std::vector<StyleGetValue> snapshot_values;
+		mutable std::vector<bool> snapshot_known;
+
+		/// Styles, style versions and parent the snapshot was computed from
+		mutable std::vector<std::pair<const Style *, unsigned int>> snapshot_styles;
+		mutable const StyleCascade *snapshot_parent = nullptr;
+		mutable unsigned int snapshot_parent_generation = 0;
+		mutable unsigned int snapshot_parent_layout_generation = 0;
+
+		/// Which of snapshot_styles declare properties that can affect layout
+		mutable std::vector<bool> snapshot_layout_styles;
+
+		/// Style change counter the snapshot was last found up to date for
+		mutable unsigned int snapshot_checked = 0;
+
+		/// Unique number given to the snapshot each time it is discarded
+		mutable unsigned int snapshot_generation = 0;
+
+		/// Unique number given to the snapshot each time it is discarded because of a layout property
+		mutable unsigned int snapshot_layout_generation = 0;
 	};
 }
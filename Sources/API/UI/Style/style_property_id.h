@@ -0,0 +1,59 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <string>
+
+namespace clan
+{
+	/// Interned style property name
+	///
+	/// Each property name is given a small integer index the first time it is seen. Style cascades
+	/// keep their computed values in arrays using this index, so looking up a property by id avoids
+	/// hashing its name. Create the ids used by a view once, for example as static variables.
+	class StylePropertyId
+	{
+	public:
+		/// Interns the property name
+		explicit StylePropertyId(const char *name);
+		explicit StylePropertyId(const std::string &name) : StylePropertyId(name.c_str()) { }
+
+		/// Index of the property name
+		int index() const { return _index; }
+
+		/// Property name for the id
+		const char *name() const;
+
+		bool operator==(const StylePropertyId &that) const { return _index == that._index; }
+		bool operator!=(const StylePropertyId &that) const { return _index != that._index; }
+
+	private:
+		int _index;
+	};
+}
@@ -33,6 +33,7 @@
 #include <vector>
 #include "../../Display/2D/color.h"
 #include "style_get_value.h"
+#include "style_property_id.h"
 #include "style_set_value.h"
 #include "style_set_image.h"
 #include "style_token.h"
@@ -117,10 +118,12 @@ namespace clan
 		/// Gets the default value for a given property
 		static const StyleGetValue &default_value(const char *name);
 		static const StyleGetValue &default_value(const std::string &name);
+		static const StyleGetValue &default_value(const StylePropertyId &property);
 
 		/// Indicates if this an inherited property or not
 		static bool is_inherited(const char *name);
 		static bool is_inherited(const std::string &name);
+		static bool is_inherited(const StylePropertyId &property);
 
 		/// Parses a string of styles and sets the values
 		static void parse(StylePropertySetter *setter, const std::string &styles);
@@ -30,6 +30,7 @@
 
 #include "../View/view.h"
 #include "../Events/activation_change_event.h"
+#include <functional>
 
 namespace clan
 {
@@ -87,6 +88,12 @@ namespace clan
 		/// Renders view into the specified canvas
 		void render(Canvas &canvas, const Rectf &margin_box);
 
+		/// Renders only the areas changed since the last render
+		///
+		/// Use this when the canvas keeps its contents between renders. Each changed area is passed to clear,
+		/// with the cliprect limited to it, before the views covering it are drawn again.
+		void render_damaged(Canvas &canvas, const Rectf &margin_box, const std::function<void(const Rectf &)> &clear = std::function<void(const Rectf &)>());
+
 		/// Dispatch activation change event to all views
 		void dispatch_activation_change(ActivationChangeType type);
 
@@ -103,6 +110,12 @@ namespace clan
 		ViewTree(const ViewTree &) = delete;
 		ViewTree &operator=(const ViewTree &) = delete;
 
+		/// Marks a canvas area to be drawn again by the next render
+		void add_damage(const Rectf &box);
+
+		/// Calls set_needs_render, unless it was already called since the last render
+		void request_render();
+
 		std::unique_ptr<ViewTreeImpl> impl;
 
 		friend class View;
@@ -188,6 +188,10 @@ namespace clan
 		float last_baseline_offset(Canvas &canvas, float width);
 
 		/// Sets the view geometry for all children of this view
+		///
+		/// Only called when the view needs a new layout. Absolute and fixed positioned children are placed
+		/// after it returns, so an override does not need to handle them. Children whose geometry did not change
+		/// keep their previous layout, unless something inside them changed.
 		virtual void layout_children(Canvas &canvas);
 
 		/// Tree in view hierachy
@@ -44,6 +44,7 @@
 #include "Network/Socket/network_condition_variable.h"
 #include "Network/Socket/tcp_connection.h"
 #include "Network/Socket/tcp_listen.h"
+#include "Network/Socket/tls_connection.h"
 #include "Network/Socket/udp_socket.h"
 
 #include "Network/NetGame/client.h"
@@ -51,7 +52,9 @@
 #include "Network/NetGame/event.h"
 #include "Network/NetGame/event_dispatcher.h"
 #include "Network/NetGame/event_value.h"
+#include "Network/NetGame/interest_manager.h"
 #include "Network/NetGame/server.h"
+#include "Network/NetGame/statistics.h"
 
 #ifdef __cplusplus_cli
 #pragma managed(pop)
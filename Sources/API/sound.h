@@ -50,6 +50,8 @@
 #include "Sound/soundbuffer_session.h"
 #include "Sound/soundfilter.h"
 #include "Sound/sound_sse.h"
+#include "Sound/soundbus.h"
+#include "Sound/speaker_position.h"
 
 #include "Sound/SoundProviders/soundprovider_wave.h"
 #include "Sound/SoundProviders/soundprovider_raw.h"
@@ -59,6 +61,11 @@
 #include "Sound/SoundFilters/echofilter.h"
 #include "Sound/SoundFilters/inverse_echofilter.h"
 #include "Sound/SoundFilters/fadefilter.h"
+#include "Sound/SoundFilters/biquadfilter.h"
+#include "Sound/SoundFilters/delayfilter.h"
+#include "Sound/SoundFilters/reverbfilter.h"
+#include "Sound/SoundFilters/compressorfilter.h"
+#include "Sound/SoundFilters/convolutionreverbfilter.h"
 
 #include "Sound/AudioWorld/audio_definition.h"
 #include "Sound/AudioWorld/audio_object.h"
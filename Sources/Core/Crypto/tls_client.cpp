@@ -57,6 +57,16 @@ namespace clan
 		return impl->get_encrypted_data_available();
 	}
 
+	bool TLSClient::is_handshake_complete() const
+	{
+		return impl->is_handshake_complete();
+	}
+
+	bool TLSClient::is_closed() const
+	{
+		return impl->is_closed();
+	}
+
 	int TLSClient::encrypt(const void *data, int size)
 	{
 		return impl->encrypt(data, size);
@@ -76,4 +86,9 @@ namespace clan
 	{
 		impl->encrypted_data_consumed(size);
 	}
+
+	void TLSClient::close()
+	{
+		impl->close();
+	}
 }
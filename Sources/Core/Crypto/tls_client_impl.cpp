@@ -44,14 +44,21 @@
 namespace clan
 {
 	TLSClient_Impl::TLSClient_Impl() :
-		recv_in_data_read_pos(0), recv_out_data_read_pos(0), send_in_data_read_pos(0), send_out_data_read_pos(0), handshake_in_read_pos(0),
-		conversation_state(cl_tls_state_send_client_hello), security_parameters(), protocol(), is_protocol_chosen()
+		recv_in_data_read_pos(0), direct_in_data(nullptr), direct_in_data_size(0), direct_in_data_read_pos(0), recv_out_data_read_pos(0), send_in_data_read_pos(0), send_out_data_read_pos(0), handshake_in_read_pos(0),
+		conversation_state(cl_tls_state_send_client_hello), send_record_buffer(sizeof(TLS_Record) + max_plaintext_length), security_parameters(), protocol(), is_protocol_chosen()
 	{
 		// Set TLS 3.1
 		protocol.major = 3;
 		protocol.minor = 1;
 		is_protocol_chosen = false;
 
+		// The buffers are compacted before they grow past desired_buffer_size, plus at most one record
+		recv_in_data.set_capacity(desired_buffer_size + sizeof(TLS_Record) + max_record_length);
+		recv_out_data.set_capacity(desired_buffer_size + max_record_length);
+		send_in_data.set_capacity(desired_buffer_size);
+		send_out_data.set_capacity(desired_buffer_size + sizeof(TLS_Record) + max_record_length);
+		record_data_buffer.set_capacity(max_record_length);
+
 		create_security_parameters_client_random();
 	}
 
@@ -81,8 +88,14 @@ namespace clan
 
 	int TLSClient_Impl::encrypt(const void *data, int size)
 	{
+		if (close_requested && size > 0)
+			throw Exception("TLSClient::encrypt called after close");
+
 		if (size == 0)
+		{
+			progress_conversation();
 			return 0;
+		}
 
 		int insert_pos = send_in_data.get_size();
 		int buffer_space_available = desired_buffer_size - insert_pos;
@@ -101,23 +114,73 @@ namespace clan
 		if (size == 0)
 			return 0;
 
+		const unsigned char *input = static_cast<const unsigned char *>(data);
+		int bytes_consumed = 0;
+
+		// Complete the record left over from the previous call first
+		while (bytes_consumed < size && recv_in_data_read_pos < (int)recv_in_data.get_size())
+		{
+			int bytes = clan::min(size - bytes_consumed, get_partial_record_missing());
+			if (bytes == 0)
+				break;
+
+			int insert_pos = recv_in_data.get_size();
+			recv_in_data.set_size(insert_pos + bytes);
+			memcpy(recv_in_data.get_data() + insert_pos, input + bytes_consumed, bytes);
+			bytes_consumed += bytes;
+
+			progress_conversation();
+		}
+
+		if (recv_in_data_read_pos < (int)recv_in_data.get_size())
+			return bytes_consumed;
+
+		// Whole records are decrypted straight from the caller's data
+		direct_in_data = input + bytes_consumed;
+		direct_in_data_size = size - bytes_consumed;
+		direct_in_data_read_pos = 0;
+		try
+		{
+			progress_conversation();
+		}
+		catch (...)
+		{
+			direct_in_data = nullptr;
+			throw;
+		}
+		bytes_consumed += direct_in_data_read_pos;
+		direct_in_data = nullptr;
+
+		// Keep the partial record at the end, or what did not fit in the output, for the next call
 		int insert_pos = recv_in_data.get_size();
 		int buffer_space_available = desired_buffer_size - insert_pos;
-		int bytes_consumed = clan::min(size, buffer_space_available);
+		int bytes = clan::min(size - bytes_consumed, buffer_space_available);
+		if (bytes > 0)
+		{
+			recv_in_data.set_size(insert_pos + bytes);
+			memcpy(recv_in_data.get_data() + insert_pos, input + bytes_consumed, bytes);
+			bytes_consumed += bytes;
+		}
 
-		recv_in_data.set_size(insert_pos + bytes_consumed);
-		memcpy(recv_in_data.get_data() + insert_pos, data, bytes_consumed);
+		return bytes_consumed;
+	}
 
-		progress_conversation();
+	int TLSClient_Impl::get_partial_record_missing() const
+	{
+		int data_available = recv_in_data.get_size() - recv_in_data_read_pos;
+		if (data_available < (int)sizeof(TLS_Record))
+			return sizeof(TLS_Record) - data_available;
 
-		return bytes_consumed;
+		const TLS_Record *record = reinterpret_cast<const TLS_Record *>(recv_in_data.get_data() + recv_in_data_read_pos);
+		int record_length = record->length[0] << 8 | record->length[1];
+		return clan::max(0, (int)sizeof(TLS_Record) + record_length - data_available);
 	}
 
 	void TLSClient_Impl::decrypted_data_consumed(int size)
 	{
 		if (size == 0)
 			return;
-		if (recv_out_data_read_pos + size > recv_out_data.get_size())
+		if (recv_out_data_read_pos + size > (int)recv_out_data.get_size())
 			throw Exception("TLSClient::decrypted_data_consumed misuse");
 
 		recv_out_data_read_pos += size;
@@ -136,7 +199,7 @@ namespace clan
 	{
 		if (size == 0)
 			return;
-		if (send_out_data_read_pos + size > send_out_data.get_size())
+		if (send_out_data_read_pos + size > (int)send_out_data.get_size())
 			throw Exception("TLSClient::encrypted_data_consumed misuse");
 
 		send_out_data_read_pos += size;
@@ -151,6 +214,12 @@ namespace clan
 		progress_conversation();
 	}
 
+	void TLSClient_Impl::close()
+	{
+		close_requested = true;
+		progress_conversation();
+	}
+
 	void TLSClient_Impl::progress_conversation()
 	{
 		try
@@ -186,7 +255,7 @@ namespace clan
 				case cl_tls_state_receive_finished:
 					break;
 				case cl_tls_state_connected:
-					should_continue = send_application_data();
+					should_continue = send_application_data() || send_close_notify();
 					break;
 
 				case cl_tls_state_error:
@@ -210,21 +279,20 @@ namespace clan
 
 	bool TLSClient_Impl::send_application_data()
 	{
-		if (send_in_data.get_size() == send_in_data_read_pos || !can_send_record())
+		if ((int)send_in_data.get_size() == send_in_data_read_pos || !can_send_record())
 			return false;
 
 		const char *data = send_in_data.get_data() + send_in_data_read_pos;
 		int size = send_in_data.get_size() - send_in_data_read_pos;
 
-		unsigned int max_record_length_gcc_fix = max_record_length;
-		unsigned int data_in_record = clan::min((unsigned int)size, max_record_length_gcc_fix);
+		unsigned int max_plaintext_length_gcc_fix = max_plaintext_length;
+		unsigned int data_in_record = clan::min((unsigned int)size, max_plaintext_length_gcc_fix);
 
 		int offset = 0;
 		int offset_tls_record = offset;					offset += sizeof(TLS_Record);
 		int offset_tls_appdata = offset;				offset += data_in_record;
 
-		Secret message(offset);
-		unsigned char *message_ptr = message.get_data();
+		unsigned char *message_ptr = send_record_buffer.get_data();
 
 		set_tls_record(message_ptr + offset_tls_record, cl_tls_content_application_data, offset - offset_tls_record);
 
@@ -245,27 +313,62 @@ namespace clan
 		return true;
 	}
 
+	bool TLSClient_Impl::send_close_notify()
+	{
+		if (!close_requested || close_notify_sent || (int)send_in_data.get_size() != send_in_data_read_pos || !can_send_record())
+			return false;
+
+		int offset = 0;
+		int offset_tls_record = offset;					offset += sizeof(TLS_Record);
+		int offset_tls_alert = offset;					offset += 2;
+
+		unsigned char *message_ptr = send_record_buffer.get_data();
+
+		set_tls_record(message_ptr + offset_tls_record, cl_tls_content_alert, offset - offset_tls_record);
+		message_ptr[offset_tls_alert] = cl_tls_warning;
+		message_ptr[offset_tls_alert + 1] = cl_tls_close_notify;
+
+		send_record(message_ptr, offset);
+
+		close_notify_sent = true;
+		return true;
+	}
+
 	bool TLSClient_Impl::receive_record()
 	{
 		// Do not read more records if our application data output buffer is full
 		if (recv_out_data.get_size() - recv_out_data_read_pos >= desired_buffer_size)
 			return false;
 
-		int data_available = recv_in_data.get_size() - recv_in_data_read_pos;
-		if (data_available < sizeof(TLS_Record))
+		// Read from the data passed to decrypt(), unless an earlier call left a record behind
+		bool direct = direct_in_data && recv_in_data_read_pos == (int)recv_in_data.get_size();
+		const unsigned char *input;
+		int data_available;
+		if (direct)
+		{
+			input = direct_in_data + direct_in_data_read_pos;
+			data_available = direct_in_data_size - direct_in_data_read_pos;
+		}
+		else
+		{
+			input = reinterpret_cast<const unsigned char *>(recv_in_data.get_data()) + recv_in_data_read_pos;
+			data_available = recv_in_data.get_size() - recv_in_data_read_pos;
+		}
+
+		if (data_available < (int)sizeof(TLS_Record))
 			return false;
 
 		TLS_Record record;
-		memcpy(&record, recv_in_data.get_data() + recv_in_data_read_pos, sizeof(TLS_Record));
+		memcpy(&record, input, sizeof(TLS_Record));
 
 		int record_length;
 		record_length = record.length[0] << 8 | record.length[1];
-		if (record_length > max_record_length)
+		if (record_length > (int)max_record_length)
 			throw Exception("Maximum record length exceeded when receieving");
 		if (record_length == 0)	// The TLS Record Layer receives uninterpreted data from higher layers in non-empty blocks of arbitrary size.
 			throw Exception("Received an empty block");
 
-		if (sizeof(TLS_Record) + record_length > data_available)
+		if ((int)sizeof(TLS_Record) + record_length > data_available)
 			return false;
 
 		if (is_protocol_chosen)
@@ -280,23 +383,38 @@ namespace clan
 			// We set the protocol version in ServerHello
 		}
 
-		record_data_buffer.set_size(record_length);
-		memcpy(record_data_buffer.get_data(), recv_in_data.get_data() + recv_in_data_read_pos + sizeof(TLS_Record), record_length);
-
-		recv_in_data_read_pos += sizeof(TLS_Record) + record_length;
-		if (recv_in_data_read_pos > desired_buffer_size / 2)
-		{
-			int available = recv_in_data.get_size() - recv_in_data_read_pos;
-			memmove(recv_in_data.get_data(), recv_in_data.get_data() + recv_in_data_read_pos, available);
-			recv_in_data.set_size(available);
-			recv_in_data_read_pos = 0;
-		}
-
 		DataBuffer plaintext;
 		if (security_parameters.is_receive_encrypted)
-			plaintext = decrypt_record(record, record_data_buffer);
+		{
+			plaintext = decrypt_record(record, input + sizeof(TLS_Record), record_length);
+		}
 		else
+		{
+			record_data_buffer.set_size(record_length);
+			memcpy(record_data_buffer.get_data(), input + sizeof(TLS_Record), record_length);
 			plaintext = record_data_buffer;
+		}
+
+		if (direct)
+		{
+			direct_in_data_read_pos += sizeof(TLS_Record) + record_length;
+		}
+		else
+		{
+			recv_in_data_read_pos += sizeof(TLS_Record) + record_length;
+			if (recv_in_data_read_pos == (int)recv_in_data.get_size())
+			{
+				recv_in_data.set_size(0);
+				recv_in_data_read_pos = 0;
+			}
+			else if (recv_in_data_read_pos > desired_buffer_size / 2)
+			{
+				int available = recv_in_data.get_size() - recv_in_data_read_pos;
+				memmove(recv_in_data.get_data(), recv_in_data.get_data() + recv_in_data_read_pos, available);
+				recv_in_data.set_size(available);
+				recv_in_data_read_pos = 0;
+			}
+		}
 
 		security_parameters.read_sequence_number++;
 		if (security_parameters.read_sequence_number == 0)
@@ -745,8 +863,9 @@ namespace clan
 			// "the encryption and MAC functions convert TLSCompressed.fragment structures to and from block TLSCiphertext.fragment structures."
 			const unsigned char *input_ptr = (const unsigned char *) data_ptr + sizeof(TLS_Record);
 			unsigned int input_size = data_size - sizeof(TLS_Record);
-			Secret mac = calculate_mac(data_ptr, data_size, nullptr, 0, security_parameters.write_sequence_number, security_parameters.client_write_mac_secret);	// MAC includes the header and sequence number
-			DataBuffer encrypted = encrypt_data(input_ptr , input_size, mac.get_data(), mac.get_size());
+			unsigned char mac[max_mac_size];
+			calculate_mac(data_ptr, data_size, nullptr, 0, security_parameters.write_sequence_number, security_parameters.client_write_mac_secret, mac);	// MAC includes the header and sequence number
+			DataBuffer encrypted = encrypt_data(input_ptr , input_size, mac, security_parameters.hash_size);
 
 			// Update the length
 			int new_length = encrypted.get_size();
@@ -954,6 +1073,18 @@ namespace clan
 		{
 			throw Exception("TLS unsupported cipher suite");
 		}
+
+		// Every record is encrypted and decrypted into the same buffers, so allocate them for the largest record up front
+		if (security_parameters.bulk_cipher_algorithm == cl_tls_cipher_algorithm_aes128)
+		{
+			aes128_encrypt.get_data().set_capacity(max_record_length);
+			aes128_decrypt.get_data().set_capacity(max_record_length);
+		}
+		else
+		{
+			aes256_encrypt.get_data().set_capacity(max_record_length);
+			aes256_decrypt.get_data().set_capacity(max_record_length);
+		}
 	}
 
 	bool TLSClient_Impl::send_client_hello()
@@ -1235,7 +1366,7 @@ namespace clan
 		DataBuffer buffer;
 		if (security_parameters.bulk_cipher_algorithm == cl_tls_cipher_algorithm_aes128)
 		{
-			AES128_Encrypt encrypt;
+			AES128_Encrypt &encrypt = aes128_encrypt;
 			encrypt.set_padding(true, false, additional_unpadded_blocks);
 			encrypt.set_iv(security_parameters.client_write_iv.get_data());
 			encrypt.set_key(security_parameters.client_write_key.get_data());
@@ -1246,7 +1377,7 @@ namespace clan
 		}
 		else if (security_parameters.bulk_cipher_algorithm == cl_tls_cipher_algorithm_aes256)
 		{
-			AES256_Encrypt encrypt;
+			AES256_Encrypt &encrypt = aes256_encrypt;
 			encrypt.set_padding(true, false, additional_unpadded_blocks);
 			encrypt.set_iv(security_parameters.client_write_iv.get_data());
 			encrypt.set_key(security_parameters.client_write_key.get_data());
@@ -1264,7 +1395,7 @@ namespace clan
 
 	}
 
-	Secret TLSClient_Impl::calculate_mac(const void *data_ptr, unsigned int data_size, const void *data2_ptr, unsigned int data2_size, uint64_t sequence_number, const Secret &mac_secret)
+	void TLSClient_Impl::calculate_mac(const void *data_ptr, unsigned int data_size, const void *data2_ptr, unsigned int data2_size, uint64_t sequence_number, const Secret &mac_secret, unsigned char *out_mac)
 	{
 		unsigned char sequence_number_buffer[8];
 
@@ -1279,31 +1410,25 @@ namespace clan
 
 		if (security_parameters.mac_algorithm == cl_tls_mac_algorithm_sha)
 		{
-			Secret hash(20);
-			SHA1 sha1;
-			sha1.set_hmac(mac_secret.get_data(), mac_secret.get_size());
-			sha1.add(sequence_number_buffer, 8);
+			mac_sha1.set_hmac(mac_secret.get_data(), mac_secret.get_size());
+			mac_sha1.add(sequence_number_buffer, 8);
 			if (data_ptr)
-				sha1.add(data_ptr, data_size);
+				mac_sha1.add(data_ptr, data_size);
 			if (data2_ptr)
-				sha1.add(data2_ptr, data2_size);
-			sha1.calculate();
-			sha1.get_hash(hash.get_data());
-			return hash;
+				mac_sha1.add(data2_ptr, data2_size);
+			mac_sha1.calculate();
+			mac_sha1.get_hash(out_mac);
 		}
 		else if (security_parameters.mac_algorithm == cl_tls_mac_algorithm_sha256)
 		{
-			Secret hash(32);
-			SHA256 sha256;
-			sha256.set_hmac(mac_secret.get_data(), mac_secret.get_size());
-			sha256.add(sequence_number_buffer, 8);
+			mac_sha256.set_hmac(mac_secret.get_data(), mac_secret.get_size());
+			mac_sha256.add(sequence_number_buffer, 8);
 			if (data_ptr)
-				sha256.add(data_ptr, data_size);
+				mac_sha256.add(data_ptr, data_size);
 			if (data2_ptr)
-				sha256.add(data2_ptr, data2_size);
-			sha256.calculate();
-			sha256.get_hash(hash.get_data());
-			return hash;
+				mac_sha256.add(data2_ptr, data2_size);
+			mac_sha256.calculate();
+			mac_sha256.get_hash(out_mac);
 		}
 		else
 		{
@@ -1324,7 +1449,7 @@ namespace clan
 		DataBuffer buffer;
 		if (security_parameters.bulk_cipher_algorithm == cl_tls_cipher_algorithm_aes128)
 		{
-			AES128_Decrypt decrypt;
+			AES128_Decrypt &decrypt = aes128_decrypt;
 			decrypt.set_padding(true, false);
 			decrypt.set_iv(security_parameters.server_write_iv.get_data());
 			decrypt.set_key(security_parameters.server_write_key.get_data());
@@ -1334,7 +1459,7 @@ namespace clan
 		}
 		else if (security_parameters.bulk_cipher_algorithm == cl_tls_cipher_algorithm_aes256)
 		{
-			AES256_Decrypt decrypt;
+			AES256_Decrypt &decrypt = aes256_decrypt;
 			decrypt.set_padding(true, false);
 			decrypt.set_iv(security_parameters.server_write_iv.get_data());
 			decrypt.set_key(security_parameters.server_write_key.get_data());
@@ -1353,9 +1478,9 @@ namespace clan
 
 	}
 
-	DataBuffer TLSClient_Impl::decrypt_record(TLS_Record &record, const DataBuffer &record_data)
+	DataBuffer TLSClient_Impl::decrypt_record(TLS_Record &record, const void *record_data, unsigned int record_size)
 	{
-		DataBuffer decrypted = decrypt_data(record_data.get_data(), record_data.get_size());
+		DataBuffer decrypted = decrypt_data(record_data, record_size);
 
 		unsigned char *decrypted_data = (unsigned char *) decrypted.get_data();
 
@@ -1367,9 +1492,10 @@ namespace clan
 		record.length[0] = decoded_size >> 8;
 		record.length[1] = decoded_size;
 
-		Secret mac = calculate_mac(&record, sizeof(record), decrypted_data , decoded_size, security_parameters.read_sequence_number, security_parameters.server_write_mac_secret);	// MAC includes the header and sequence number
+		unsigned char mac[max_mac_size];
+		calculate_mac(&record, sizeof(record), decrypted_data , decoded_size, security_parameters.read_sequence_number, security_parameters.server_write_mac_secret, mac);	// MAC includes the header and sequence number
 
-		if (memcmp(mac.get_data(), decrypted_data + decoded_size, mac.get_size()))
+		if (memcmp(mac, decrypted_data + decoded_size, security_parameters.hash_size))
 			throw Exception("HMAC failed");
 
 		decrypted.set_size(decoded_size);
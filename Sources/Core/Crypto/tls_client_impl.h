@@ -35,6 +35,10 @@
 #include "API/Core/Crypto/random.h"
 #include "API/Core/Crypto/rsa.h"
 #include "API/Core/Crypto/hash_functions.h"
+#include "API/Core/Crypto/aes128_encrypt.h"
+#include "API/Core/Crypto/aes128_decrypt.h"
+#include "API/Core/Crypto/aes256_encrypt.h"
+#include "API/Core/Crypto/aes256_decrypt.h"
 #include "x509.h"
 
 namespace clan
@@ -243,12 +247,17 @@ namespace clan
 		const void *get_encrypted_data() const;
 		int get_encrypted_data_available() const;
 
+		bool is_handshake_complete() const { return conversation_state == cl_tls_state_connected; }
+		bool is_closed() const { return close_notify_sent; }
+
 		int encrypt(const void *data, int size);
 		int decrypt(const void *data, int size);
 
 		void decrypted_data_consumed(int size);
 		void encrypted_data_consumed(int size);
 
+		void close();
+
 	private:
 		void progress_conversation();
 
@@ -278,11 +287,15 @@ namespace clan
 		bool send_change_cipher_spec();
 		bool send_finished();
 		bool send_application_data();
+		bool send_close_notify();
 
 		void reset();
 
 		void copy_data(void *out_data, int size, const void *&data, int &data_left);
 
+		/// \brief Returns how many more bytes the record at the start of recv_in_data needs before it is complete
+		int get_partial_record_missing() const;
+
 		void set_tls_record(unsigned char *dest_ptr, TLS_ContentType content_type, unsigned int length);
 		void set_tls_handshake(unsigned char *dest_ptr, TLS_HandshakeType handshake_type, unsigned int length);
 		void set_tls_protocol_version(unsigned char *dest_ptr);
@@ -301,20 +314,29 @@ namespace clan
 		void PRF(void *output_ptr, unsigned int output_size, const Secret &secret, const char *label_ptr, const Secret &seed_part1, const Secret &seed_part2);
 		void hash_handshake(const void *data_ptr, unsigned int data_size);
 
-		DataBuffer decrypt_record(TLS_Record &record, const DataBuffer &record_data);
+		DataBuffer decrypt_record(TLS_Record &record, const void *record_data, unsigned int record_size);
 		DataBuffer decrypt_data(const void *data_ptr, unsigned int data_size);
 
-		Secret calculate_mac(const void *data_ptr, unsigned int data_size, const void *data2_ptr, unsigned int data2_size, uint64_t sequence_number, const Secret &mac_secret);
+		/// \brief Calculates the record MAC into out_mac, which must hold security_parameters.hash_size bytes
+		void calculate_mac(const void *data_ptr, unsigned int data_size, const void *data2_ptr, unsigned int data2_size, uint64_t sequence_number, const Secret &mac_secret, unsigned char *out_mac);
 		DataBuffer encrypt_data(const void *data_ptr, unsigned int data_size, const void *mac_ptr, unsigned int mac_size);
 
 		static const unsigned int max_record_length = 2 << 14;	// RFC 2246 (6.2.1)
+		static const unsigned int max_plaintext_length = 1 << 14;	// RFC 2246 (6.2.1)
 		static const unsigned int max_handshake_length = 2 << 24;	// RFC 2246 (implied by length in7.4)
 
+		static const unsigned int max_mac_size = SHA256::hash_size;
+
 		static const int desired_buffer_size = 64 * 1024;
 
 		DataBuffer recv_in_data;
 		int recv_in_data_read_pos;
 
+		/// \brief Data passed to decrypt() that whole records are read from without copying them into recv_in_data first
+		const unsigned char *direct_in_data;
+		int direct_in_data_size;
+		int direct_in_data_read_pos;
+
 		DataBuffer recv_out_data;
 		int recv_out_data_read_pos;
 
@@ -329,7 +351,19 @@ namespace clan
 
 		TLS_ConversationState conversation_state;
 
+		bool close_requested = false;	// Set by close(). The close_notify alert follows the remaining application data.
+		bool close_notify_sent = false;
+
 		DataBuffer record_data_buffer; // local variable of receive_record(). Placed here to avoid allocating memory each time a record is processed
+		Secret send_record_buffer; // local variable of send_application_data(), for the same reason
+
+		// The record ciphers and MACs are kept for the connection, so their output buffers are only allocated once
+		AES128_Encrypt aes128_encrypt;
+		AES128_Decrypt aes128_decrypt;
+		AES256_Encrypt aes256_encrypt;
+		AES256_Decrypt aes256_decrypt;
+		SHA1 mac_sha1;
+		SHA256 mac_sha256;
 
 		TLS_SecurityParameters security_parameters;
 		TLS_ProtocolVersion protocol;
@@ -46,10 +46,10 @@ namespace clan
 		impl->connection.reset();
 	}
 
-	void NetGameClient::connect(const std::string &server, const std::string &port)
+	void NetGameClient::connect(const std::string &server, const std::string &port, bool use_tls)
 	{
 		disconnect();
-		impl->connection.reset(new NetGameConnection(this, SocketName(server, port)));
+		impl->connection.reset(new NetGameConnection(this, SocketName(server, port), use_tls));
 	}
 
 	void NetGameClient::disconnect()
@@ -71,6 +71,14 @@ namespace clan
 			impl->connection->send_event(game_event);
 	}
 
+	NetGameConnectionStatistics NetGameClient::get_statistics() const
+	{
+		if (impl->connection.get() != nullptr)
+			return impl->connection->get_statistics();
+		else
+			return NetGameConnectionStatistics();
+	}
+
 	Signal<void(const NetGameEvent &)> &NetGameClient::sig_event_received()
 	{
 		return impl->sig_game_event_received;
@@ -88,16 +96,13 @@ namespace clan
 
 	void NetGameClient::add_network_event(const NetGameNetworkEvent &e)
 	{
-		std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
-		impl->events.push_back(e);
+		impl->events.push(e);
 	}
 
 	void NetGameClient_Impl::process()
 	{
-		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
 		std::vector<NetGameNetworkEvent> new_events;
-		new_events.swap(events);
-		mutex_lock.unlock();
+		events.pop_all(new_events);
 		for (auto & new_event : new_events)
 		{
 			switch (new_event.type)
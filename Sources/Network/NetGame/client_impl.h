@@ -28,8 +28,8 @@
 
 #pragma once
 
+#include "network_event_queue.h"
 #include <memory>
-#include <mutex>
 
 namespace clan
 {
@@ -38,8 +38,7 @@ namespace clan
 	public:
 		void process();
 
-		std::recursive_mutex mutex;
-		std::vector<NetGameNetworkEvent> events;
+		NetGameNetworkEventQueue events;
 
 		std::unique_ptr<NetGameConnection> connection;
 		Signal<void(const NetGameEvent &)> sig_game_event_received;
@@ -41,10 +41,10 @@ namespace clan
 		impl->start(this, site, connection);
 	}
 
-	NetGameConnection::NetGameConnection(NetGameConnectionSite *site, const SocketName &socket_name)
+	NetGameConnection::NetGameConnection(NetGameConnectionSite *site, const SocketName &socket_name, bool use_tls)
 		: impl(new NetGameConnection_Impl)
 	{
-		impl->start(this, site, socket_name);
+		impl->start(this, site, socket_name, use_tls);
 	}
 
 	NetGameConnection::~NetGameConnection()
@@ -67,6 +67,16 @@ namespace clan
 		impl->send_event(game_event);
 	}
 
+	void NetGameConnection::send_events(const std::vector<NetGameEvent> &game_events)
+	{
+		impl->send_events(game_events);
+	}
+
+	int NetGameConnection::get_send_queue_length() const
+	{
+		return impl->get_send_queue_length();
+	}
+
 	void NetGameConnection::disconnect()
 	{
 		impl->disconnect();
@@ -76,4 +86,9 @@ namespace clan
 	{
 		return impl->get_remote_name();
 	}
+
+	NetGameConnectionStatistics NetGameConnection::get_statistics() const
+	{
+		return impl->get_statistics();
+	}
 }
@@ -31,13 +31,14 @@
 #include "API/Network/NetGame/connection.h"
 #include "API/Network/NetGame/connection_site.h"
 #include "API/Core/System/databuffer.h"
+#include "API/Core/System/system.h"
 #include "network_event.h"
 #include "network_data.h"
 #include "connection_impl.h"
 
 namespace clan
 {
-	NetGameConnection_Impl::NetGameConnection_Impl()
+	NetGameConnection_Impl::NetGameConnection_Impl() : pending_events(0)
 	{
 	}
 
@@ -51,11 +52,12 @@ namespace clan
 		thread = std::thread(&NetGameConnection_Impl::connection_main, this);
 	}
 
-	void NetGameConnection_Impl::start(NetGameConnection *xbase, NetGameConnectionSite *xsite, const SocketName &xsocket_name)
+	void NetGameConnection_Impl::start(NetGameConnection *xbase, NetGameConnectionSite *xsite, const SocketName &xsocket_name, bool xuse_tls)
 	{
 		base = xbase;
 		site = xsite;
 		socket_name = xsocket_name;
+		use_tls = xuse_tls;
 		is_connected = false;
 		thread = std::thread(&NetGameConnection_Impl::connection_main, this);
 	}
@@ -64,6 +66,7 @@ namespace clan
 	{
 		std::unique_lock<std::mutex> mutex_lock(mutex);
 		stop_flag = true;
+		stop_time = System::get_time();
 		mutex_lock.unlock();
 		worker_event.notify();
 		if (thread.joinable())
@@ -103,6 +106,25 @@ namespace clan
 		message.type = Message::type_message;
 		message.event = game_event;
 		send_queue.push_back(message);
+		counters.set_send_queue_length(send_queue.size());
+		mutex_lock.unlock();
+		worker_event.notify();
+	}
+
+	void NetGameConnection_Impl::send_events(const std::vector<NetGameEvent> &game_events)
+	{
+		if (game_events.empty())
+			return;
+
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		for (const auto &game_event : game_events)
+		{
+			Message message;
+			message.type = Message::type_message;
+			message.event = game_event;
+			send_queue.push_back(message);
+		}
+		counters.set_send_queue_length(send_queue.size());
 		mutex_lock.unlock();
 		worker_event.notify();
 	}
@@ -113,6 +135,7 @@ namespace clan
 		Message message;
 		message.type = Message::type_disconnect;
 		send_queue.push_back(message);
+		disconnect_requested = true;
 		mutex_lock.unlock();
 		worker_event.notify();
 	}
@@ -122,11 +145,26 @@ namespace clan
 		return socket_name;
 	}
 
+	NetGameConnectionStatistics NetGameConnection_Impl::get_statistics() const
+	{
+		NetGameConnectionStatistics stats = counters.get_statistics();
+		stats.remote_name = socket_name.get_address() + ":" + socket_name.get_port();
+		stats.events_pending = pending_events.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void NetGameConnection_Impl::event_dispatched()
+	{
+		// Wake up the connection thread when the queue has drained to half its limit
+		if (pending_events.fetch_sub(1, std::memory_order_relaxed) == max_pending_events / 2 + 1)
+			worker_event.notify();
+	}
+
 	bool NetGameConnection_Impl::read_connection_data(DataBuffer &receive_buffer, int &bytes_received)
 	{
 		while (true)
 		{
-			int bytes = connection.read(receive_buffer.get_data() + bytes_received, receive_buffer.get_size() - bytes_received);
+			int bytes = connection_read(receive_buffer.get_data() + bytes_received, receive_buffer.get_size() - bytes_received);
 			if (bytes < 0)
 				return false;
 
@@ -137,6 +175,7 @@ namespace clan
 			}
 
 			bytes_received += bytes;
+			counters.add_bytes_received(bytes, System::get_time());
 
 			int bytes_consumed = 0;
 			bool exit = read_data(receive_buffer.get_data(), bytes_received, bytes_consumed);
@@ -149,6 +188,10 @@ namespace clan
 
 			if (exit)
 				return exit;
+
+			// Leave the remaining data in the socket until the site catches up
+			if (is_throttled())
+				return false;
 		}
 
 	}
@@ -157,24 +200,30 @@ namespace clan
 	{
 		while (true)
 		{
-			int bytes = connection.write(send_buffer.get_data() + bytes_sent, send_buffer.get_size() - bytes_sent);
+			int bytes = connection_write(send_buffer.get_data() + bytes_sent, send_buffer.get_size() - bytes_sent);
 			if (bytes < 0)
 				return false;
 
 			bytes_sent += bytes;
+			counters.add_bytes_sent(bytes, System::get_time());
+			counters.set_send_buffer_bytes(send_buffer.get_size() - bytes_sent);
+
+			while (send_buffer_events_written < send_buffer_event_ends.size() && send_buffer_event_ends[send_buffer_events_written] <= bytes_sent)
+				send_buffer_events_written++;
+			counters.set_send_buffer_events(send_buffer_event_ends.size() - send_buffer_events_written);
 
 			if (bytes_sent == send_buffer.get_size())
 			{
 				if (send_graceful_close)
 				{
-					connection.close();
-					return true;
+					return connection_shutdown();
 				}
 				else
 				{
 					bytes_sent = 0;
 					send_buffer.set_size(0);
 					send_graceful_close = write_data(send_buffer);
+					counters.set_send_buffer_bytes(send_buffer.get_size());
 					if (send_buffer.get_size() == 0)
 						return false;
 				}
@@ -182,12 +231,26 @@ namespace clan
 		}
 	}
 
+	bool NetGameConnection_Impl::connection_shutdown()
+	{
+		// Bytes accepted by TLS may still be waiting in it as records the socket had no room for
+		if (use_tls)
+			return tls_connection.shutdown();
+
+		connection.close();
+		return true;
+	}
+
 	void NetGameConnection_Impl::connection_main()
 	{
 		try
 		{
 			if (!is_connected)
+			{
 				connection = TCPConnection(socket_name);
+				if (use_tls)
+					tls_connection = TLSConnection(connection);
+			}
 			is_connected = true;
 			site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::client_connected));
 
@@ -201,16 +264,31 @@ namespace clan
 
 			while (true)
 			{
-				if (read_connection_data(receive_buffer, bytes_received))
-					break;
-				if (write_connection_data(send_buffer, bytes_sent, send_graceful_close))
+				bool throttled = is_throttled();
+				if (!throttled)
+				{
+					uint64_t start_time = System::get_microseconds();
+					bool closed = read_connection_data(receive_buffer, bytes_received);
+					counters.add_read_time(System::get_microseconds() - start_time);
+					if (closed)
+						break;
+				}
+
+				uint64_t start_time = System::get_microseconds();
+				bool closed = write_connection_data(send_buffer, bytes_sent, send_graceful_close);
+				counters.add_write_time(System::get_microseconds() - start_time);
+				if (closed)
 					break;
 
+				update_round_trip_time();
+
 				std::unique_lock<std::mutex> lock(mutex);
-				if (stop_flag)
+				if (stop_flag && (!disconnect_requested || System::get_time() - stop_time >= max_linger_time))
 					break;
-				NetworkEvent *events[] = { &connection };
-				worker_event.wait(lock, 1, events);
+
+				// While throttled only wait for event_dispatched() or send_event() to notify us
+				NetworkEvent *events[] = { connection_event() };
+				worker_event.wait(lock, throttled ? 0 : 1, events, stop_flag ? 100 : -1);
 			}
 
 			site->add_network_event(NetGameNetworkEvent(base, NetGameNetworkEvent::client_disconnected));
@@ -221,6 +299,17 @@ namespace clan
 		}
 	}
 
+	void NetGameConnection_Impl::update_round_trip_time()
+	{
+		// Asking the TCP stack is a system call, so only do it about once a second
+		uint64_t time = System::get_time();
+		if (time - last_round_trip_update >= 1000)
+		{
+			last_round_trip_update = time;
+			counters.set_round_trip_time(connection.get_round_trip_time());
+		}
+	}
+
 	bool NetGameConnection_Impl::read_data(const void *data, int size, int &bytes_consumed)
 	{
 		bytes_consumed = 0;
@@ -239,7 +328,11 @@ namespace clan
 				return true;
 			}
 
-			site->add_network_event(NetGameNetworkEvent(base, incoming_event));
+			NetGameNetworkEvent network_event(base, incoming_event);
+			network_event.sender = this;
+			pending_events.fetch_add(1, std::memory_order_relaxed);
+			counters.add_events_received(1, System::get_time());
+			site->add_network_event(network_event);
 		}
 		return false;
 	}
@@ -249,6 +342,12 @@ namespace clan
 		std::unique_lock<std::mutex> mutex_lock(mutex);
 		std::vector<Message> new_send_queue;
 		send_queue.swap(new_send_queue);
+
+		// Move the events over to the buffer count before the queue count drops, so they are never missing from get_send_queue_length()
+		send_buffer_event_ends.clear();
+		send_buffer_events_written = 0;
+		counters.set_send_buffer_events(new_send_queue.size());
+		counters.set_send_queue_length(0);
 		mutex_lock.unlock();
 		for (auto & elem : new_send_queue)
 		{
@@ -259,6 +358,9 @@ namespace clan
 				int pos = buffer.get_size();
 				buffer.set_size(pos + packet.get_size());
 				memcpy(buffer.get_data() + pos, packet.get_data(), packet.get_size());
+				send_buffer_event_ends.push_back(buffer.get_size());
+
+				counters.add_events_sent(1, System::get_time());
 			}
 			else if (elem.type == Message::type_disconnect)
 			{
@@ -29,10 +29,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <thread>
 #include "API/Network/Socket/tcp_connection.h"
+#include "API/Network/Socket/tls_connection.h"
 #include "API/Network/Socket/socket_name.h"
+#include "connection_statistics.h"
 
 namespace clan
 {
@@ -42,12 +45,18 @@ namespace clan
 		NetGameConnection_Impl();
 		~NetGameConnection_Impl();
 		void start(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection);
-		void start(NetGameConnection *base, NetGameConnectionSite *site, const SocketName &socket_name);
+		void start(NetGameConnection *base, NetGameConnectionSite *site, const SocketName &socket_name, bool use_tls);
 		void set_data(const std::string &name, void *data);
 		void *get_data(const std::string &name) const;
 		void send_event(const NetGameEvent &game_event);
+		void send_events(const std::vector<NetGameEvent> &game_events);
+		int get_send_queue_length() const { return counters.get_send_queue_length() + counters.get_send_buffer_events(); }
 		void disconnect();
 		SocketName get_remote_name() const;
+		NetGameConnectionStatistics get_statistics() const;
+
+		/// \brief Called by the site when an event received on this connection has been taken off its queue
+		void event_dispatched();
 
 	private:
 		void connection_main();
@@ -58,17 +67,41 @@ namespace clan
 		bool read_data(const void *data, int size, int &out_bytes_consumed);
 		bool write_data(DataBuffer &buffer);
 
+		void update_round_trip_time();
+
+		int connection_read(void *data, int size) { return use_tls ? tls_connection.read(data, size) : connection.read(data, size); }
+		int connection_write(const void *data, int size) { return use_tls ? tls_connection.write(data, size) : connection.write(data, size); }
+		NetworkEvent *connection_event() { return use_tls ? static_cast<NetworkEvent *>(&tls_connection) : &connection; }
+
+		/// \brief Closes the socket after everything written to it has been sent. Returns false if it has to be called again.
+		bool connection_shutdown();
+
+		bool is_throttled() const { return pending_events.load(std::memory_order_relaxed) >= max_pending_events; }
+
+		// Stop reading from the socket when this many received events are still waiting in the site's queue
+		enum { max_pending_events = 1024 };
+
+		// Milliseconds a connection destroyed after disconnect() keeps sending the events queued before it
+		enum { max_linger_time = 5000 };
+
 		NetGameConnection *base;
 
 		NetGameConnectionSite *site;
 
 		NetworkConditionVariable worker_event;
 		TCPConnection connection;
+		TLSConnection tls_connection;
+		bool use_tls = false;
 		SocketName socket_name;
 		bool is_connected;
 		std::thread thread;
 		bool stop_flag = false;
+		bool disconnect_requested = false;
+		uint64_t stop_time = 0;
 		std::mutex mutex;
+		std::atomic_int pending_events;
+		NetGameConnectionCounters counters;
+		uint64_t last_round_trip_update = 0;
 		struct Message
 		{
 			Message() : type(type_message), event(std::string()) { }
@@ -81,6 +114,10 @@ namespace clan
 			NetGameEvent event;
 		};
 		std::vector<Message> send_queue;
+
+		// End offset of each event encoded into the send buffer, so events still waiting for the socket can be counted
+		std::vector<int> send_buffer_event_ends;
+		size_t send_buffer_events_written = 0;
 		struct AttachedData
 		{
 			std::string name;
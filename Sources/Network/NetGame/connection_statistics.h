@@ -0,0 +1,115 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Network/NetGame/statistics.h"
+#include <atomic>
+
+namespace clan
+{
+	/// \brief Rolling per second rate of some quantity
+	///
+	/// Only one thread may call add(). Any thread may call get_rate().
+	class NetGameRateWindow
+	{
+	public:
+		NetGameRateWindow();
+
+		void add(uint64_t amount, uint64_t time_ms);
+		double get_rate(uint64_t time_ms) const;
+
+	private:
+		// The window covers the completed buckets, i.e. 1.75 seconds lagging up to 250 ms behind
+		enum { bucket_count = 8, bucket_length_ms = 250 };
+
+		std::atomic<uint64_t> bucket_index[bucket_count];
+		std::atomic<uint64_t> bucket_amount[bucket_count];
+	};
+
+	/// \brief Traffic counters updated by a connection thread
+	///
+	/// All updates use relaxed atomics. A snapshot may be taken from any thread at any time.
+	class NetGameConnectionCounters
+	{
+	public:
+		void add_bytes_received(int bytes, uint64_t time_ms)
+		{
+			bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+			bytes_received_rate.add(bytes, time_ms);
+		}
+
+		void add_bytes_sent(int bytes, uint64_t time_ms)
+		{
+			bytes_sent.fetch_add(bytes, std::memory_order_relaxed);
+			bytes_sent_rate.add(bytes, time_ms);
+		}
+
+		void add_events_received(int count, uint64_t time_ms)
+		{
+			events_received.fetch_add(count, std::memory_order_relaxed);
+			events_received_rate.add(count, time_ms);
+		}
+
+		void add_events_sent(int count, uint64_t time_ms)
+		{
+			events_sent.fetch_add(count, std::memory_order_relaxed);
+			events_sent_rate.add(count, time_ms);
+		}
+
+		void add_read_time(uint64_t microseconds) { read_time.fetch_add(microseconds, std::memory_order_relaxed); }
+		void add_write_time(uint64_t microseconds) { write_time.fetch_add(microseconds, std::memory_order_relaxed); }
+
+		void set_send_queue_length(int length) { send_queue_length.store(length, std::memory_order_relaxed); }
+		void set_send_buffer_bytes(int bytes) { send_buffer_bytes.store(bytes, std::memory_order_relaxed); }
+		void set_send_buffer_events(int count) { send_buffer_events.store(count, std::memory_order_relaxed); }
+		void set_round_trip_time(int microseconds) { round_trip_time.store(microseconds, std::memory_order_relaxed); }
+
+		NetGameConnectionStatistics get_statistics() const;
+
+		int get_send_queue_length() const { return send_queue_length.load(std::memory_order_relaxed); }
+		int get_send_buffer_events() const { return send_buffer_events.load(std::memory_order_relaxed); }
+
+	private:
+		std::atomic<uint64_t> bytes_received{ 0 };
+		std::atomic<uint64_t> bytes_sent{ 0 };
+		std::atomic<uint64_t> events_received{ 0 };
+		std::atomic<uint64_t> events_sent{ 0 };
+		std::atomic<uint64_t> read_time{ 0 };
+		std::atomic<uint64_t> write_time{ 0 };
+		std::atomic_int send_queue_length{ 0 };
+		std::atomic_int send_buffer_bytes{ 0 };
+		std::atomic_int send_buffer_events{ 0 };
+		std::atomic_int round_trip_time{ -1 };
+
+		NetGameRateWindow bytes_received_rate;
+		NetGameRateWindow bytes_sent_rate;
+		NetGameRateWindow events_received_rate;
+		NetGameRateWindow events_sent_rate;
+	};
+}
@@ -0,0 +1,352 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/NetGame/interest_manager.h"
+#include "API/Network/NetGame/connection.h"
+#include "API/Core/System/exception.h"
+#include "interest_manager_impl.h"
+#include <algorithm>
+#include <cmath>
+
+namespace clan
+{
+	NetGameInterestManager::NetGameInterestManager(float cell_size, int default_budget)
+		: impl(new NetGameInterestManager_Impl())
+	{
+		if (cell_size <= 0.0f)
+			throw Exception("Invalid cell size");
+
+		impl->cell_size = cell_size;
+		impl->default_budget = default_budget;
+	}
+
+	NetGameInterestManager::~NetGameInterestManager()
+	{
+	}
+
+	void NetGameInterestManager::add_observer(NetGameConnection *connection, const Pointf &position, float view_radius)
+	{
+		if (impl->observers.find(connection) != impl->observers.end())
+			throw Exception("Connection is already an observer");
+
+		std::unique_ptr<NetGameInterestManager_Impl::Observer> observer(new NetGameInterestManager_Impl::Observer());
+		observer->connection = connection;
+		observer->position = position;
+		observer->view_radius = view_radius;
+		observer->budget = impl->default_budget;
+		impl->update_cells(observer.get());
+		impl->observers[connection] = std::move(observer);
+	}
+
+	void NetGameInterestManager::remove_observer(NetGameConnection *connection)
+	{
+		auto it = impl->observers.find(connection);
+		if (it == impl->observers.end())
+			return;
+
+		NetGameInterestManager_Impl::Observer *observer = it->second.get();
+		impl->remove_from_cells(observer);
+
+		for (int channel : observer->channels)
+		{
+			std::vector<NetGameInterestManager_Impl::Observer *> &subscribers = impl->channels[channel];
+			subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), observer), subscribers.end());
+			if (subscribers.empty())
+				impl->channels.erase(channel);
+		}
+
+		impl->observers.erase(it);
+	}
+
+	void NetGameInterestManager::set_observer_position(NetGameConnection *connection, const Pointf &position)
+	{
+		NetGameInterestManager_Impl::Observer *observer = impl->get_observer(connection);
+		observer->position = position;
+		impl->update_cells(observer);
+	}
+
+	void NetGameInterestManager::set_observer_radius(NetGameConnection *connection, float view_radius)
+	{
+		NetGameInterestManager_Impl::Observer *observer = impl->get_observer(connection);
+		observer->view_radius = view_radius;
+		impl->update_cells(observer);
+	}
+
+	void NetGameInterestManager::set_observer_budget(NetGameConnection *connection, int budget)
+	{
+		impl->get_observer(connection)->budget = budget;
+	}
+
+	void NetGameInterestManager::subscribe(NetGameConnection *connection, int channel)
+	{
+		NetGameInterestManager_Impl::Observer *observer = impl->get_observer(connection);
+		if (std::find(observer->channels.begin(), observer->channels.end(), channel) != observer->channels.end())
+			return;
+
+		observer->channels.push_back(channel);
+		impl->channels[channel].push_back(observer);
+	}
+
+	void NetGameInterestManager::unsubscribe(NetGameConnection *connection, int channel)
+	{
+		NetGameInterestManager_Impl::Observer *observer = impl->get_observer(connection);
+		auto it = std::find(observer->channels.begin(), observer->channels.end(), channel);
+		if (it == observer->channels.end())
+			return;
+
+		observer->channels.erase(it);
+
+		std::vector<NetGameInterestManager_Impl::Observer *> &subscribers = impl->channels[channel];
+		subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), observer), subscribers.end());
+		if (subscribers.empty())
+			impl->channels.erase(channel);
+	}
+
+	void NetGameInterestManager::send_event(int entity_id, const Pointf &position, const NetGameEvent &game_event, float priority)
+	{
+		// An observer is listed in every cell its view area overlaps, so only the cell of the position needs to be checked
+		auto it = impl->cells.find(NetGameInterestManager_Impl::cell_key(impl->to_cell(position.x), impl->to_cell(position.y)));
+		if (it == impl->cells.end())
+			return;
+
+		std::shared_ptr<const NetGameEvent> shared_event;
+		for (NetGameInterestManager_Impl::Observer *observer : it->second)
+		{
+			float dx = position.x - observer->position.x;
+			float dy = position.y - observer->position.y;
+			if (dx * dx + dy * dy <= observer->view_radius * observer->view_radius)
+			{
+				if (!shared_event)
+					shared_event = std::make_shared<NetGameEvent>(game_event);
+				impl->queue_event(observer, entity_id, shared_event, priority);
+			}
+		}
+	}
+
+	void NetGameInterestManager::send_channel_event(int channel, const NetGameEvent &game_event, float priority)
+	{
+		auto it = impl->channels.find(channel);
+		if (it == impl->channels.end())
+			return;
+
+		std::shared_ptr<const NetGameEvent> shared_event = std::make_shared<NetGameEvent>(game_event);
+		for (NetGameInterestManager_Impl::Observer *observer : it->second)
+			impl->queue_event(observer, -1, shared_event, priority);
+	}
+
+	void NetGameInterestManager::send_observer_event(NetGameConnection *connection, const NetGameEvent &game_event, float priority)
+	{
+		impl->queue_event(impl->get_observer(connection), -1, std::make_shared<NetGameEvent>(game_event), priority);
+	}
+
+	void NetGameInterestManager::tick()
+	{
+		for (auto &it : impl->observers)
+			impl->flush(it.second.get());
+	}
+
+	int NetGameInterestManager::get_observer_count() const
+	{
+		return (int)impl->observers.size();
+	}
+
+	int NetGameInterestManager::get_queued_event_count(NetGameConnection *connection) const
+	{
+		return (int)impl->get_observer(connection)->queue.size();
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	NetGameInterestManager_Impl::Observer *NetGameInterestManager_Impl::get_observer(NetGameConnection *connection) const
+	{
+		auto it = observers.find(connection);
+		if (it == observers.end())
+			throw Exception("Connection is not an observer");
+		return it->second.get();
+	}
+
+	int NetGameInterestManager_Impl::to_cell(float value) const
+	{
+		return (int)std::floor(value / cell_size);
+	}
+
+	void NetGameInterestManager_Impl::update_cells(Observer *observer)
+	{
+		int x1 = to_cell(observer->position.x - observer->view_radius);
+		int y1 = to_cell(observer->position.y - observer->view_radius);
+		int x2 = to_cell(observer->position.x + observer->view_radius);
+		int y2 = to_cell(observer->position.y + observer->view_radius);
+
+		// Most moves stay within the same cells
+		if (x1 == observer->cell_x1 && y1 == observer->cell_y1 && x2 == observer->cell_x2 && y2 == observer->cell_y2)
+			return;
+
+		remove_from_cells(observer);
+
+		observer->cell_x1 = x1;
+		observer->cell_y1 = y1;
+		observer->cell_x2 = x2;
+		observer->cell_y2 = y2;
+
+		for (int y = y1; y <= y2; y++)
+		{
+			for (int x = x1; x <= x2; x++)
+				cells[cell_key(x, y)].push_back(observer);
+		}
+	}
+
+	void NetGameInterestManager_Impl::remove_from_cells(Observer *observer)
+	{
+		for (int y = observer->cell_y1; y <= observer->cell_y2; y++)
+		{
+			for (int x = observer->cell_x1; x <= observer->cell_x2; x++)
+			{
+				auto it = cells.find(cell_key(x, y));
+				if (it == cells.end())
+					continue;
+
+				std::vector<Observer *> &cell = it->second;
+				auto pos = std::find(cell.begin(), cell.end(), observer);
+				if (pos != cell.end())
+				{
+					*pos = cell.back();
+					cell.pop_back();
+				}
+
+				if (cell.empty())
+					cells.erase(it);
+			}
+		}
+
+		observer->cell_x1 = 0;
+		observer->cell_y1 = 0;
+		observer->cell_x2 = -1;
+		observer->cell_y2 = -1;
+	}
+
+	void NetGameInterestManager_Impl::queue_event(Observer *observer, int entity_id, const std::shared_ptr<const NetGameEvent> &game_event, float priority)
+	{
+		if (entity_id != -1)
+		{
+			auto it = observer->entity_queue_index.find(entity_id);
+			if (it != observer->entity_queue_index.end())
+			{
+				// Keep the priority built up so far, only the newest state of an entity is worth sending
+				QueuedEvent &queued = observer->queue[it->second];
+				queued.event = game_event;
+				queued.priority = priority;
+				return;
+			}
+		}
+
+		size_t index = observer->queue.size();
+		if (index < max_queued_events)
+		{
+			observer->queue.push_back(QueuedEvent{ entity_id, game_event, priority, 0.0f });
+		}
+		else
+		{
+			// Full queue, make room by dropping the event that has waited with the lowest priority
+			auto lowest = std::min_element(observer->queue.begin(), observer->queue.end(), [](const QueuedEvent &a, const QueuedEvent &b) { return a.accumulated_priority < b.accumulated_priority; });
+			if (lowest->accumulated_priority >= priority)
+				return;
+
+			if (lowest->entity_id != -1)
+				observer->entity_queue_index.erase(lowest->entity_id);
+			index = lowest - observer->queue.begin();
+			*lowest = QueuedEvent{ entity_id, game_event, priority, 0.0f };
+		}
+
+		if (entity_id != -1)
+			observer->entity_queue_index[entity_id] = index;
+	}
+
+	void NetGameInterestManager_Impl::flush(Observer *observer)
+	{
+		std::vector<QueuedEvent> &queue = observer->queue;
+		if (queue.empty())
+			return;
+
+		for (QueuedEvent &queued : queue)
+			queued.accumulated_priority += queued.priority;
+
+		// Events not yet written to the socket use up the budget
+		int budget = observer->budget - observer->connection->get_send_queue_length();
+		if (budget <= 0)
+			return;
+
+		send_batch.clear();
+
+		if ((size_t)budget >= queue.size())
+		{
+			for (QueuedEvent &queued : queue)
+				send_batch.push_back(*queued.event);
+			queue.clear();
+			observer->entity_queue_index.clear();
+		}
+		else
+		{
+			send_order.resize(queue.size());
+			for (size_t i = 0; i < queue.size(); i++)
+				send_order[i] = i;
+
+			std::nth_element(send_order.begin(), send_order.begin() + budget, send_order.end(), [&](size_t a, size_t b) { return queue[a].accumulated_priority > queue[b].accumulated_priority; });
+
+			// Send the chosen events in the order they were queued
+			sent.assign(queue.size(), false);
+			for (int i = 0; i < budget; i++)
+				sent[send_order[i]] = true;
+
+			size_t keep = 0;
+			for (size_t i = 0; i < queue.size(); i++)
+			{
+				if (sent[i])
+				{
+					send_batch.push_back(*queue[i].event);
+				}
+				else
+				{
+					if (keep != i)
+						queue[keep] = std::move(queue[i]);
+					keep++;
+				}
+			}
+			queue.erase(queue.begin() + keep, queue.end());
+
+			observer->entity_queue_index.clear();
+			for (size_t i = 0; i < queue.size(); i++)
+			{
+				if (queue[i].entity_id != -1)
+					observer->entity_queue_index[queue[i].entity_id] = i;
+			}
+		}
+
+		observer->connection->send_events(send_batch);
+	}
+}
@@ -0,0 +1,94 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Network/NetGame/event.h"
+#include "API/Core/Math/point.h"
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+namespace clan
+{
+	class NetGameConnection;
+
+	class NetGameInterestManager_Impl
+	{
+	public:
+		struct QueuedEvent
+		{
+			int entity_id;
+			std::shared_ptr<const NetGameEvent> event;
+			float priority;
+			float accumulated_priority;
+		};
+
+		struct Observer
+		{
+			NetGameConnection *connection = nullptr;
+			Pointf position;
+			float view_radius = 0.0f;
+			int budget = 0;
+
+			// Grid cells covered by the view area, inclusive
+			int cell_x1 = 0, cell_y1 = 0, cell_x2 = -1, cell_y2 = -1;
+
+			std::vector<int> channels;
+			std::vector<QueuedEvent> queue;
+			std::unordered_map<int, size_t> entity_queue_index;
+		};
+
+		Observer *get_observer(NetGameConnection *connection) const;
+
+		void update_cells(Observer *observer);
+		void remove_from_cells(Observer *observer);
+
+		// All observers share one copy of an event until it is handed to their connections
+		void queue_event(Observer *observer, int entity_id, const std::shared_ptr<const NetGameEvent> &game_event, float priority);
+		void flush(Observer *observer);
+
+		int to_cell(float value) const;
+		static uint64_t cell_key(int x, int y) { return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y); }
+
+		// Queued events per observer before the lowest priority ones are dropped
+		enum { max_queued_events = 4096 };
+
+		float cell_size = 64.0f;
+		int default_budget = 64;
+
+		std::unordered_map<NetGameConnection *, std::unique_ptr<Observer>> observers;
+		std::unordered_map<uint64_t, std::vector<Observer *>> cells;
+		std::unordered_map<int, std::vector<Observer *>> channels;
+
+		// Reused by flush to avoid allocating every tick
+		std::vector<size_t> send_order;
+		std::vector<bool> sent;
+		std::vector<NetGameEvent> send_batch;
+	};
+}
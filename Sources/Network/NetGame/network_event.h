@@ -33,6 +33,7 @@
 namespace clan
 {
 	class NetGameConnection;
+	class NetGameConnection_Impl;
 
 	class NetGameNetworkEvent
 	{
@@ -62,5 +63,8 @@ namespace clan
 		NetGameConnection *connection;
 		Type type;
 		NetGameEvent game_event;
+
+		/// \brief Connection to credit when the event has been dispatched (used for backpressure)
+		NetGameConnection_Impl *sender = nullptr;
 	};
 }
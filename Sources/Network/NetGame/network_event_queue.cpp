@@ -0,0 +1,96 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/NetGame/connection.h"
+#include "API/Network/NetGame/connection_site.h"
+#include "network_event_queue.h"
+#include "connection_impl.h"
+
+namespace clan
+{
+	NetGameNetworkEventQueue::NetGameNetworkEventQueue() : head(nullptr)
+	{
+	}
+
+	NetGameNetworkEventQueue::~NetGameNetworkEventQueue()
+	{
+		clear();
+	}
+
+	void NetGameNetworkEventQueue::push(const NetGameNetworkEvent &e)
+	{
+		Node *node = new Node(e);
+		node->next = head.load(std::memory_order_relaxed);
+		while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void NetGameNetworkEventQueue::pop_all(std::vector<NetGameNetworkEvent> &out_events)
+	{
+		Node *node = take_all();
+		while (node)
+		{
+			if (node->event.sender)
+				node->event.sender->event_dispatched();
+
+			out_events.push_back(node->event);
+
+			Node *next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+	void NetGameNetworkEventQueue::clear()
+	{
+		Node *node = take_all();
+		while (node)
+		{
+			Node *next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+	NetGameNetworkEventQueue::Node *NetGameNetworkEventQueue::take_all()
+	{
+		// The producers build a LIFO list. Reverse it to get the events back in FIFO order.
+		Node *node = head.exchange(nullptr, std::memory_order_acquire);
+		Node *reversed = nullptr;
+		while (node)
+		{
+			Node *next = node->next;
+			node->next = reversed;
+			reversed = node;
+			node = next;
+		}
+		return reversed;
+	}
+}
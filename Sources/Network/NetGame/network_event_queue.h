@@ -0,0 +1,77 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "network_event.h"
+#include <atomic>
+#include <vector>
+
+namespace clan
+{
+	/// \brief Multiple producer, single consumer queue of network events
+	///
+	/// Connection threads push events without taking any locks. The thread calling
+	/// process_events() takes the entire batch in one atomic exchange.
+	class NetGameNetworkEventQueue
+	{
+	public:
+		NetGameNetworkEventQueue();
+		~NetGameNetworkEventQueue();
+
+		/// \brief Adds an event to the queue. Can be called from any thread.
+		void push(const NetGameNetworkEvent &e);
+
+		/// \brief Moves all queued events, in the order they were pushed, to out_events
+		///
+		/// Must only be called from the consumer thread. Releases the backpressure credit
+		/// each event holds on its connection.
+		void pop_all(std::vector<NetGameNetworkEvent> &out_events);
+
+		/// \brief Discards all queued events
+		///
+		/// Does not touch the connections the events came from, so it is safe to call after they are destroyed.
+		void clear();
+
+	private:
+		NetGameNetworkEventQueue(const NetGameNetworkEventQueue &) = delete;
+		NetGameNetworkEventQueue &operator=(const NetGameNetworkEventQueue &) = delete;
+
+		struct Node
+		{
+			Node(const NetGameNetworkEvent &e) : event(e) { }
+
+			NetGameNetworkEvent event;
+			Node *next = nullptr;
+		};
+
+		Node *take_all();
+
+		std::atomic<Node *> head;
+	};
+}
@@ -54,8 +54,7 @@ namespace clan
 
 	void NetGameServer::add_network_event(const NetGameNetworkEvent &e)
 	{
-		std::unique_lock<std::mutex> mutex_lock(impl->mutex);
-		impl->events.push_back(e);
+		impl->events.push(e);
 	}
 
 	void NetGameServer::send_event(const NetGameEvent &game_event)
@@ -67,13 +66,43 @@ namespace clan
 		}
 	}
 
+	NetGameServerStatistics NetGameServer::get_statistics() const
+	{
+		NetGameServerStatistics stats;
+
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		stats.connections_accepted = impl->connections_accepted;
+		stats.totals = impl->disconnected_totals;
+		for (auto & elem : impl->connections)
+		{
+			stats.connections.push_back(elem->get_statistics());
+		}
+		lock.unlock();
+
+		for (const auto &connection_stats : stats.connections)
+		{
+			NetGameServer_Impl::add_statistics(stats.totals, connection_stats);
+
+			stats.totals.bytes_received_per_second += connection_stats.bytes_received_per_second;
+			stats.totals.bytes_sent_per_second += connection_stats.bytes_sent_per_second;
+			stats.totals.events_received_per_second += connection_stats.events_received_per_second;
+			stats.totals.events_sent_per_second += connection_stats.events_sent_per_second;
+			stats.totals.events_pending += connection_stats.events_pending;
+			stats.totals.send_queue_length += connection_stats.send_queue_length;
+			stats.totals.send_buffer_bytes += connection_stats.send_buffer_bytes;
+			stats.totals.round_trip_time = std::max(stats.totals.round_trip_time, connection_stats.round_trip_time);
+		}
+
+		return stats;
+	}
+
 	void NetGameServer::start(const std::string &port)
 	{
 		stop();
 		std::unique_lock<std::mutex> lock(impl->mutex);
 		impl->stop_flag = false;
 		lock.unlock();
-		impl->tcp_listen.reset(new TCPListen(SocketName(port)));
+		impl->tcp_listen.reset(new TCPListen(SocketName(port), NetGameServer_Impl::listen_backlog));
 		impl->listen_thread = std::thread(&NetGameServer::listen_thread_main, this);
 	}
 
@@ -83,7 +112,7 @@ namespace clan
 		std::unique_lock<std::mutex> lock(impl->mutex);
 		impl->stop_flag = false;
 		lock.unlock();
-		impl->tcp_listen.reset(new TCPListen(SocketName(address, port)));
+		impl->tcp_listen.reset(new TCPListen(SocketName(address, port), NetGameServer_Impl::listen_backlog));
 		impl->listen_thread = std::thread(&NetGameServer::listen_thread_main, this);
 	}
 
@@ -102,6 +131,9 @@ namespace clan
 			delete elem;
 		}
 		impl->connections.clear();
+		impl->events.clear();
+		impl->connections_accepted = 0;
+		impl->disconnected_totals = NetGameConnectionStatistics();
 	}
 
 	void NetGameServer::listen_thread_main()
@@ -115,12 +147,17 @@ namespace clan
 			NetworkEvent *events[] = { impl->tcp_listen.get() };
 			impl->worker_event.wait(lock, 1, events);
 
-			SocketName peer_endpoint;
-			TCPConnection connection = impl->tcp_listen->accept(peer_endpoint);
-			if (!connection.is_null())
+			while (true)
 			{
+				SocketName peer_endpoint;
+				TCPConnection connection = impl->tcp_listen->accept(peer_endpoint);
+				if (connection.is_null())
+					break;
+
 				std::unique_ptr<NetGameConnection> game_connection(new NetGameConnection(this, connection));
-				impl->connections.push_back(game_connection.release());
+				impl->connections.insert(game_connection.get());
+				impl->connections_accepted++;
+				game_connection.release();
 			}
 		}
 	}
@@ -142,10 +179,8 @@ namespace clan
 
 	void NetGameServer_Impl::process()
 	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
 		std::vector<NetGameNetworkEvent> new_events;
-		new_events.swap(events);
-		mutex_lock.unlock();
+		events.pop_all(new_events);
 
 		for (auto & new_event : new_events)
 		{
@@ -166,12 +201,8 @@ namespace clan
 			// Destroy connection object
 			{
 				std::unique_lock<std::mutex> mutex_lock(mutex);
-				std::vector<NetGameConnection *>::iterator connection_it;
-				connection_it = std::find(connections.begin(), connections.end(), new_event.connection);
-				if (connection_it != connections.end())
-				{
-					connections.erase(connection_it);
-				}
+				add_statistics(disconnected_totals, new_event.connection->get_statistics());
+				connections.erase(new_event.connection);
 				delete new_event.connection;
 			}
 			break;
@@ -180,4 +211,14 @@ namespace clan
 			}
 		}
 	}
+
+	void NetGameServer_Impl::add_statistics(NetGameConnectionStatistics &totals, const NetGameConnectionStatistics &stats)
+	{
+		totals.bytes_received += stats.bytes_received;
+		totals.bytes_sent += stats.bytes_sent;
+		totals.events_received += stats.events_received;
+		totals.events_sent += stats.events_sent;
+		totals.read_time += stats.read_time;
+		totals.write_time += stats.write_time;
+	}
 }
@@ -29,9 +29,11 @@
 #pragma once
 
 #include "API/Network/Socket/tcp_listen.h"
+#include "network_event_queue.h"
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_set>
 
 namespace clan
 {
@@ -40,14 +42,22 @@ namespace clan
 	public:
 		void process();
 
+		static void add_statistics(NetGameConnectionStatistics &totals, const NetGameConnectionStatistics &stats);
+
 		std::unique_ptr<TCPListen> tcp_listen;
 		std::thread listen_thread;
 
 		NetworkConditionVariable worker_event;
 		std::mutex mutex;
 		bool stop_flag = false;
-		std::vector<NetGameConnection *> connections;
-		std::vector<NetGameNetworkEvent> events;
+		std::unordered_set<NetGameConnection *> connections;
+		NetGameNetworkEventQueue events;
+
+		uint64_t connections_accepted = 0;
+
+		// Large enough that a burst of connecting clients is not turned away while the listen thread catches up
+		enum { listen_backlog = 1024 };
+		NetGameConnectionStatistics disconnected_totals;
 
 		Signal<void(NetGameConnection *)> sig_game_client_connected;
 		Signal<void(NetGameConnection *, const std::string &)> sig_game_client_disconnected;
@@ -0,0 +1,131 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/NetGame/statistics.h"
+#include "API/Core/System/system.h"
+#include "connection_statistics.h"
+#include <algorithm>
+
+namespace clan
+{
+	JsonValue NetGameConnectionStatistics::to_json() const
+	{
+		JsonValue json = JsonValue::object();
+		if (!remote_name.empty())
+			json["remote_name"] = JsonValue::string(remote_name);
+		json["bytes_received"] = JsonValue::number(static_cast<double>(bytes_received));
+		json["bytes_sent"] = JsonValue::number(static_cast<double>(bytes_sent));
+		json["events_received"] = JsonValue::number(static_cast<double>(events_received));
+		json["events_sent"] = JsonValue::number(static_cast<double>(events_sent));
+		json["bytes_received_per_second"] = JsonValue::number(bytes_received_per_second);
+		json["bytes_sent_per_second"] = JsonValue::number(bytes_sent_per_second);
+		json["events_received_per_second"] = JsonValue::number(events_received_per_second);
+		json["events_sent_per_second"] = JsonValue::number(events_sent_per_second);
+		json["events_pending"] = JsonValue::number(events_pending);
+		json["send_queue_length"] = JsonValue::number(send_queue_length);
+		json["send_buffer_bytes"] = JsonValue::number(send_buffer_bytes);
+		json["read_time"] = JsonValue::number(static_cast<double>(read_time));
+		json["write_time"] = JsonValue::number(static_cast<double>(write_time));
+		json["round_trip_time"] = JsonValue::number(round_trip_time);
+		return json;
+	}
+
+	JsonValue NetGameServerStatistics::to_json() const
+	{
+		JsonValue json = JsonValue::object();
+		json["connections_accepted"] = JsonValue::number(static_cast<double>(connections_accepted));
+		json["totals"] = totals.to_json();
+		json["connections"] = JsonValue::array();
+		for (const auto &connection : connections)
+			json["connections"].items().push_back(connection.to_json());
+		return json;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	NetGameRateWindow::NetGameRateWindow()
+	{
+		for (int i = 0; i < bucket_count; i++)
+		{
+			bucket_index[i].store(0, std::memory_order_relaxed);
+			bucket_amount[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void NetGameRateWindow::add(uint64_t amount, uint64_t time_ms)
+	{
+		uint64_t index = time_ms / bucket_length_ms;
+		int slot = static_cast<int>(index % bucket_count);
+		if (bucket_index[slot].load(std::memory_order_relaxed) != index)
+		{
+			bucket_amount[slot].store(amount, std::memory_order_relaxed);
+			bucket_index[slot].store(index, std::memory_order_relaxed);
+		}
+		else
+		{
+			bucket_amount[slot].store(bucket_amount[slot].load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+	}
+
+	double NetGameRateWindow::get_rate(uint64_t time_ms) const
+	{
+		uint64_t current = time_ms / bucket_length_ms;
+		uint64_t total = 0;
+		for (int i = 0; i < bucket_count; i++)
+		{
+			uint64_t index = bucket_index[i].load(std::memory_order_relaxed);
+			if (index < current && index + bucket_count > current)
+				total += bucket_amount[i].load(std::memory_order_relaxed);
+		}
+		return total * 1000.0 / ((bucket_count - 1) * bucket_length_ms);
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	NetGameConnectionStatistics NetGameConnectionCounters::get_statistics() const
+	{
+		uint64_t time_ms = System::get_time();
+
+		NetGameConnectionStatistics stats;
+		stats.bytes_received = bytes_received.load(std::memory_order_relaxed);
+		stats.bytes_sent = bytes_sent.load(std::memory_order_relaxed);
+		stats.events_received = events_received.load(std::memory_order_relaxed);
+		stats.events_sent = events_sent.load(std::memory_order_relaxed);
+		stats.bytes_received_per_second = bytes_received_rate.get_rate(time_ms);
+		stats.bytes_sent_per_second = bytes_sent_rate.get_rate(time_ms);
+		stats.events_received_per_second = events_received_rate.get_rate(time_ms);
+		stats.events_sent_per_second = events_sent_rate.get_rate(time_ms);
+		stats.send_queue_length = send_queue_length.load(std::memory_order_relaxed);
+		stats.send_buffer_bytes = send_buffer_bytes.load(std::memory_order_relaxed);
+		stats.read_time = read_time.load(std::memory_order_relaxed);
+		stats.write_time = write_time.load(std::memory_order_relaxed);
+		stats.round_trip_time = round_trip_time.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
@@ -34,6 +34,8 @@
 #ifndef WIN32
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
 #endif
 
 namespace clan
@@ -138,30 +140,34 @@ namespace clan
 
 	bool NetworkConditionVariable::wait_impl(int count, NetworkEvent **events, int timeout_ms)
 	{
-		int max_fd = impl->notify_handle[0];
+		// poll has no FD_SETSIZE limit on the descriptor values, which matters for processes with thousands of connections
+		pollfd local_fds[16];
+		std::vector<pollfd> heap_fds;
+		pollfd *fds = local_fds;
+		if (count + 1 > 16)
+		{
+			heap_fds.resize(count + 1);
+			fds = heap_fds.data();
+		}
 
-		fd_set rfds, wfds;
-		FD_ZERO(&rfds);
-		FD_ZERO(&wfds);
-		FD_SET(impl->notify_handle[0], &rfds);
+		fds[0].fd = impl->notify_handle[0];
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
 
 		for (int i = 0; i < count; i++)
 		{
-			events[i]->get_socket_handle()->begin_wait(rfds, wfds, max_fd);
+			fds[i + 1].revents = 0;
+			events[i]->get_socket_handle()->begin_wait(fds[i + 1]);
 		}
 
-		timeval tv;
-		tv.tv_sec = timeout_ms / 1000;
-		tv.tv_usec = (timeout_ms % 1000) * 1000;
-
-		//FIXME - Should this have: Use "!impl->can_write ? &wfds : 0" ??
-		int result = select(max_fd + 1, &rfds, 0, 0, timeout_ms >= 0 ? &tv : 0);
-		if (result == -1)
-			throw Exception("select failed");
+		// Sockets only ask for POLLOUT after a write would have blocked
+		int result = poll(fds, count + 1, timeout_ms >= 0 ? timeout_ms : -1);
+		if (result == -1 && errno != EINTR)
+			throw Exception("poll failed");
 
 		for (int i = 0; i < count; i++)
 		{
-			events[i]->get_socket_handle()->end_wait(rfds, wfds);
+			events[i]->get_socket_handle()->end_wait(fds[i + 1]);
 		}
 
 		impl->reset_notify();
@@ -53,6 +53,9 @@ namespace clan
 		//int result = setsockopt(impl->handle, SOL_SOCKET, SO_RCVBUF, (const char *) &receive_buffer_size, sizeof(int));
 		int result = setsockopt(impl->handle, SOL_SOCKET, SO_SNDBUF, (const char *)&send_buffer_size, sizeof(int));
 
+		int value = 1;
+		result = setsockopt(impl->handle, IPPROTO_TCP, TCP_NODELAY, (const char *)&value, sizeof(int));
+
 		result = WSAEventSelect(impl->handle, impl->wait_handle, FD_READ | FD_WRITE | FD_CLOSE);
 		if (result == SOCKET_ERROR)
 			throw Exception("WSAEventSelect failed");
@@ -122,6 +125,11 @@ namespace clan
 		return name;
 	}
 
+	int TCPConnection::get_round_trip_time()
+	{
+		return -1;
+	}
+
 	SocketHandle *TCPConnection::get_socket_handle()
 	{
 		return impl.get();
@@ -172,6 +180,9 @@ namespace clan
 		//int result = setsockopt(impl->handle, SOL_SOCKET, SO_RCVBUF, (const char *) &receive_buffer_size, sizeof(int));
 		setsockopt(impl->handle, SOL_SOCKET, SO_SNDBUF, (const char *) &send_buffer_size, sizeof(int));
 
+		int value = 1;
+		setsockopt(impl->handle, IPPROTO_TCP, TCP_NODELAY, (const char *) &value, sizeof(int));
+
 		int nonblocking = 1;
 		ioctl(impl->handle, FIONBIO, &nonblocking);
 	}
@@ -245,6 +256,20 @@ namespace clan
 		return name;
 	}
 
+	int TCPConnection::get_round_trip_time()
+	{
+#if defined(__linux__)
+		tcp_info info;
+		memset(&info, 0, sizeof(tcp_info));
+		socklen_t size = sizeof(tcp_info);
+		if (!impl || getsockopt(impl->handle, IPPROTO_TCP, TCP_INFO, &info, &size) == -1)
+			return -1;
+		return info.tcpi_rtt;
+#else
+		return -1;
+#endif
+	}
+
 	SocketHandle *TCPConnection::get_socket_handle()
 	{
 		return impl.get();
@@ -9,6 +9,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -90,8 +91,8 @@ namespace clan
 	class SocketHandle
 	{
 	public:
-		virtual void begin_wait(fd_set &rfds, fd_set &wfds, int &max_fd) = 0;
-		virtual void end_wait(fd_set &rfds, fd_set &wfds) = 0;
+		virtual void begin_wait(pollfd &fd) = 0;
+		virtual void end_wait(const pollfd &fd) = 0;
 	};
 
 	class TCPSocket : public SocketHandle
@@ -111,7 +112,7 @@ namespace clan
 		}
 
 		TCPSocket(int handle)
-			: handle(handle)
+			: handle(handle), can_write(false)
 		{
 		}
 
@@ -129,17 +130,17 @@ namespace clan
 			}
 		}
 
-		void begin_wait(fd_set &rfds, fd_set &wfds, int &max_fd) override
+		void begin_wait(pollfd &fd) override
 		{
-			FD_SET(handle, &rfds);
+			fd.fd = handle;
+			fd.events = POLLIN;
 			if (!can_write)
-				FD_SET(handle, &wfds);
-			max_fd = std::max(max_fd, handle);
+				fd.events |= POLLOUT;
 		}
 
-		void end_wait(fd_set &rfds, fd_set &wfds) override
+		void end_wait(const pollfd &fd) override
 		{
-			if (FD_ISSET(handle, &wfds))
+			if (fd.revents & (POLLOUT | POLLERR | POLLHUP))
 			{
 				can_write = true;
 			}
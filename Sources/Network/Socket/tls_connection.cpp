@@ -0,0 +1,204 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+#include "API/Network/Socket/tls_connection.h"
+#include "API/Network/Socket/tcp_connection.h"
+#include "API/Network/Socket/socket_name.h"
+#include "API/Core/Crypto/tls_client.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/Math/cl_math.h"
+
+namespace clan
+{
+	class TLSConnection_Impl
+	{
+	public:
+		TLSConnection_Impl(const TCPConnection &connection) : connection(connection), receive_buffer(receive_buffer_size)
+		{
+			// Queue the client hello
+			tls.encrypt(nullptr, 0);
+			flush();
+		}
+
+		bool flush();
+		bool fill();
+
+		TCPConnection connection;
+		TLSClient tls;
+
+		// Encrypted data read from the socket that the TLSClient had no room for yet.
+		// Kept for the lifetime of the connection so that reads do not allocate.
+		DataBuffer receive_buffer;
+		int receive_buffer_pos = 0;
+		int receive_buffer_end = 0;
+
+		bool remote_closed = false;
+
+		enum { receive_buffer_size = 64 * 1024 };
+	};
+
+	TLSConnection::TLSConnection()
+	{
+	}
+
+	TLSConnection::TLSConnection(const SocketName &endpoint)
+		: impl(std::make_shared<TLSConnection_Impl>(TCPConnection(endpoint)))
+	{
+	}
+
+	TLSConnection::TLSConnection(const TCPConnection &connection)
+		: impl(std::make_shared<TLSConnection_Impl>(connection))
+	{
+	}
+
+	TLSConnection::~TLSConnection()
+	{
+	}
+
+	bool TLSConnection::is_handshake_complete() const
+	{
+		return impl && impl->tls.is_handshake_complete();
+	}
+
+	SocketName TLSConnection::get_local_name()
+	{
+		return impl->connection.get_local_name();
+	}
+
+	SocketName TLSConnection::get_remote_name()
+	{
+		return impl->connection.get_remote_name();
+	}
+
+	void TLSConnection::close()
+	{
+		if (impl)
+			impl->connection.close();
+	}
+
+	bool TLSConnection::shutdown()
+	{
+		impl->tls.close();
+		if (!impl->flush() || !impl->tls.is_closed())
+			return false;
+
+		impl->connection.close();
+		return true;
+	}
+
+	int TLSConnection::write(const void *data, int size)
+	{
+		int bytes_accepted = 0;
+		while (bytes_accepted < size)
+		{
+			int bytes = impl->tls.encrypt(static_cast<const char *>(data) + bytes_accepted, size - bytes_accepted);
+			bytes_accepted += bytes;
+
+			// Stop once the socket is full, otherwise make room for more records
+			if (!impl->flush() || bytes == 0)
+				break;
+		}
+
+		if (size == 0)
+			impl->flush();
+
+		if (size > 0 && bytes_accepted == 0)
+			return -1;
+		return bytes_accepted;
+	}
+
+	int TLSConnection::read(void *data, int size)
+	{
+		while (impl->tls.get_decrypted_data_available() == 0)
+		{
+			if (impl->remote_closed)
+				return 0;
+			if (!impl->fill())
+				return -1;
+		}
+
+		int bytes = clan::min(size, impl->tls.get_decrypted_data_available());
+		memcpy(data, impl->tls.get_decrypted_data(), bytes);
+		impl->tls.decrypted_data_consumed(bytes);
+		return bytes;
+	}
+
+	int TLSConnection::get_round_trip_time()
+	{
+		return impl->connection.get_round_trip_time();
+	}
+
+	SocketHandle *TLSConnection::get_socket_handle()
+	{
+		return impl->connection.get_socket_handle();
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	bool TLSConnection_Impl::flush()
+	{
+		while (tls.get_encrypted_data_available() > 0)
+		{
+			int bytes = connection.write(tls.get_encrypted_data(), tls.get_encrypted_data_available());
+			if (bytes == -1)
+				return false;
+			tls.encrypted_data_consumed(bytes);
+		}
+		return true;
+	}
+
+	bool TLSConnection_Impl::fill()
+	{
+		// Read a full buffer from the socket at a time and let the TLSClient decrypt as many records as it can from it
+		if (receive_buffer_pos == receive_buffer_end)
+		{
+			int bytes = connection.read(receive_buffer.get_data(), receive_buffer.get_size());
+			if (bytes == -1)
+				return false;
+
+			if (bytes == 0)
+			{
+				remote_closed = true;
+				return true;
+			}
+
+			receive_buffer_pos = 0;
+			receive_buffer_end = bytes;
+		}
+
+		int bytes = tls.decrypt(receive_buffer.get_data() + receive_buffer_pos, receive_buffer_end - receive_buffer_pos);
+		receive_buffer_pos += bytes;
+
+		// The handshake may have produced records that must be sent before any more data arrives
+		flush();
+
+		return bytes > 0 || tls.get_decrypted_data_available() > 0;
+	}
+}
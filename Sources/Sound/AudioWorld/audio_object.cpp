@@ -29,22 +29,34 @@ namespace clan
 
 	Vec3f AudioObject::get_position() const
 	{
-		return impl->position;
+		AudioWorld_Impl *world = impl->world;
+		return Vec3f(world->position_x[impl->index], world->position_y[impl->index], world->position_z[impl->index]);
+	}
+
+	Vec3f AudioObject::get_velocity() const
+	{
+		AudioWorld_Impl *world = impl->world;
+		return Vec3f(world->velocity_x[impl->index], world->velocity_y[impl->index], world->velocity_z[impl->index]);
 	}
 
 	float AudioObject::get_attenuation_begin() const
 	{
-		return impl->attenuation_begin;
+		return impl->world->attenuation_begin[impl->index];
 	}
 
 	float AudioObject::get_attenuation_end() const
 	{
-		return impl->attenuation_end;
+		return impl->world->attenuation_end[impl->index];
 	}
 
 	float AudioObject::get_volume() const
 	{
-		return impl->volume;
+		return impl->world->volume[impl->index];
+	}
+
+	float AudioObject::get_occlusion() const
+	{
+		return impl->world->occlusion[impl->index];
 	}
 
 	bool AudioObject::is_looping() const
@@ -64,22 +76,38 @@ namespace clan
 
 	void AudioObject::set_position(const Vec3f &position)
 	{
-		impl->position = position;
+		AudioWorld_Impl *world = impl->world;
+		world->position_x[impl->index] = position.x;
+		world->position_y[impl->index] = position.y;
+		world->position_z[impl->index] = position.z;
+	}
+
+	void AudioObject::set_velocity(const Vec3f &velocity)
+	{
+		AudioWorld_Impl *world = impl->world;
+		world->velocity_x[impl->index] = velocity.x;
+		world->velocity_y[impl->index] = velocity.y;
+		world->velocity_z[impl->index] = velocity.z;
 	}
 
 	void AudioObject::set_attenuation_begin(float distance)
 	{
-		impl->attenuation_begin = distance;
+		impl->world->attenuation_begin[impl->index] = distance;
 	}
 
 	void AudioObject::set_attenuation_end(float distance)
 	{
-		impl->attenuation_end = distance;
+		impl->world->attenuation_end[impl->index] = distance;
 	}
 
 	void AudioObject::set_volume(float volume)
 	{
-		impl->volume = volume;
+		impl->world->volume[impl->index] = volume;
+	}
+
+	void AudioObject::set_occlusion(float occlusion)
+	{
+		impl->world->occlusion[impl->index] = occlusion;
 	}
 
 	void AudioObject::set_sound(const SoundBuffer &buffer)
@@ -107,6 +135,7 @@ namespace clan
 		if (!impl->ambience || impl->world->play_ambience)
 		{
 			impl->session = impl->sound.prepare(impl->looping);
+			impl->base_frequency = (float)impl->session.get_frequency();
 			impl->world->update_session(impl.get());
 			impl->session.play();
 			impl->world->active_objects.push_back(*this);
@@ -125,13 +154,13 @@ namespace clan
 	/////////////////////////////////////////////////////////////////////////////
 
 	AudioObject_Impl::AudioObject_Impl(AudioWorld_Impl *world)
-		: world(world), attenuation_begin(0.0f), attenuation_end(0.0f), volume(1.0f), looping(false), ambience(false)
+		: world(world), index(0), base_frequency(0.0f), looping(false), ambience(false)
 	{
-		it = world->objects.insert(world->objects.end(), this);
+		index = world->add_object(this);
 	}
 
 	AudioObject_Impl::~AudioObject_Impl()
 	{
-		world->objects.erase(it);
+		world->remove_object(index);
 	}
 }
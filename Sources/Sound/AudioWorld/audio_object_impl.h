@@ -44,12 +44,13 @@ namespace clan
 		~AudioObject_Impl();
 
 		AudioWorld_Impl *world;
-		std::list<AudioObject_Impl *>::iterator it;
 
-		Vec3f position;
-		float attenuation_begin;
-		float attenuation_end;
-		float volume;
+		/// \brief Position of the object in the emitter arrays of the world. Changes when other objects are removed.
+		int index;
+
+		/// \brief Frequency of the session before the Doppler shift
+		float base_frequency;
+
 		bool looping;
 		bool ambience;
 		SoundBuffer sound;
@@ -6,6 +6,14 @@
 #include "API/Core/Math/cl_math.h"
 #include "audio_world_impl.h"
 #include "audio_object_impl.h"
+#include "../soundbuffer_session_impl.h"
+#include "../soundoutput_impl.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace clan
 {
@@ -20,6 +28,31 @@ namespace clan
 		impl->listener_orientation = orientation;
 	}
 
+	void AudioWorld::set_listener_velocity(const Vec3f &velocity)
+	{
+		impl->listener_velocity = velocity;
+	}
+
+	void AudioWorld::set_doppler_factor(float factor)
+	{
+		impl->doppler_factor = factor;
+	}
+
+	float AudioWorld::get_doppler_factor() const
+	{
+		return impl->doppler_factor;
+	}
+
+	void AudioWorld::set_speed_of_sound(float speed)
+	{
+		impl->speed_of_sound = speed;
+	}
+
+	float AudioWorld::get_speed_of_sound() const
+	{
+		return impl->speed_of_sound;
+	}
+
 	bool AudioWorld::is_ambience_enabled() const
 	{
 		return impl->play_ambience;
@@ -37,10 +70,7 @@ namespace clan
 
 	void AudioWorld::update()
 	{
-		for (auto it = impl->objects.begin(); it != impl->objects.end(); ++it)
-		{
-			impl->update_session(*it);
-		}
+		impl->update_sessions();
 
 		for (auto it = impl->active_objects.begin(); it != impl->active_objects.end();)
 		{
@@ -58,39 +88,275 @@ namespace clan
 	/////////////////////////////////////////////////////////////////////////////
 
 	AudioWorld_Impl::AudioWorld_Impl(const ResourceManager &resources)
-		: play_ambience(true), reverse_stereo(false), resources(resources)
+		: doppler_factor(0.0f), speed_of_sound(343.3f), play_ambience(true), reverse_stereo(false), resources(resources)
 	{
 	}
 
 	AudioWorld_Impl::~AudioWorld_Impl()
 	{
+		// Objects only kept alive by the world remove themselves from the emitter arrays, so release them while the arrays exist
+		active_objects.clear();
+	}
+
+	int AudioWorld_Impl::add_object(AudioObject_Impl *obj)
+	{
+		objects.push_back(obj);
+		position_x.push_back(0.0f);
+		position_y.push_back(0.0f);
+		position_z.push_back(0.0f);
+		velocity_x.push_back(0.0f);
+		velocity_y.push_back(0.0f);
+		velocity_z.push_back(0.0f);
+		attenuation_begin.push_back(0.0f);
+		attenuation_end.push_back(0.0f);
+		volume.push_back(1.0f);
+		occlusion.push_back(0.0f);
+		mix_volume.push_back(1.0f);
+		mix_pan.push_back(0.0f);
+		mix_pan_depth.push_back(0.0f);
+		mix_pitch.push_back(1.0f);
+		return (int)objects.size() - 1;
+	}
+
+	void AudioWorld_Impl::remove_object(int index)
+	{
+		int last = (int)objects.size() - 1;
+		if (index != last)
+		{
+			objects[index] = objects[last];
+			objects[index]->index = index;
+			position_x[index] = position_x[last];
+			position_y[index] = position_y[last];
+			position_z[index] = position_z[last];
+			velocity_x[index] = velocity_x[last];
+			velocity_y[index] = velocity_y[last];
+			velocity_z[index] = velocity_z[last];
+			attenuation_begin[index] = attenuation_begin[last];
+			attenuation_end[index] = attenuation_end[last];
+			volume[index] = volume[last];
+			occlusion[index] = occlusion[last];
+			mix_volume[index] = mix_volume[last];
+			mix_pan[index] = mix_pan[last];
+			mix_pan_depth[index] = mix_pan_depth[last];
+			mix_pitch[index] = mix_pitch[last];
+		}
+
+		objects.pop_back();
+		position_x.pop_back();
+		position_y.pop_back();
+		position_z.pop_back();
+		velocity_x.pop_back();
+		velocity_y.pop_back();
+		velocity_z.pop_back();
+		attenuation_begin.pop_back();
+		attenuation_end.pop_back();
+		volume.pop_back();
+		occlusion.pop_back();
+		mix_volume.pop_back();
+		mix_pan.pop_back();
+		mix_pan_depth.pop_back();
+		mix_pitch.pop_back();
 	}
 
 	void AudioWorld_Impl::update_session(AudioObject_Impl *obj)
 	{
-		if (obj->attenuation_begin != obj->attenuation_end)
+		begin_spatialize();
+		spatialize(obj->index, obj->index + 1);
+		apply_session(obj);
+		flush_commands();
+	}
+
+	void AudioWorld_Impl::update_sessions()
+	{
+		begin_spatialize();
+		spatialize_all();
+		for (auto & obj : objects)
+			apply_session(obj);
+		flush_commands();
+	}
+
+	void AudioWorld_Impl::begin_spatialize()
+	{
+		ear_vector = listener_orientation.rotate_vector(Vec3f(1.0f, 0.0f, 0.0f));
+		front_vector = listener_orientation.rotate_vector(Vec3f(0.0f, 0.0f, 1.0f));
+		if (reverse_stereo)
+			ear_vector = -ear_vector;
+	}
+
+	void AudioWorld_Impl::spatialize(int begin, int end)
+	{
+		// Closing speeds are clamped so the shifted frequency stays positive and at most doubles
+		float max_listener_speed = doppler_factor > 0.0f ? speed_of_sound / doppler_factor : 0.0f;
+		float max_source_speed = max_listener_speed * 0.5f;
+
+		for (int i = begin; i < end; i++)
 		{
+			float base_volume = volume[i] * (1.0f - occlusion[i]);
+			if (attenuation_begin[i] == attenuation_end[i])
+			{
+				mix_volume[i] = base_volume;
+				mix_pan[i] = 0.0f;
+				mix_pan_depth[i] = 0.0f;
+				mix_pitch[i] = 1.0f;
+				continue;
+			}
+
 			// Calculate volume from distance
-			float distance = obj->position.distance(listener_position);
-			float t = 1.0f - smoothstep(obj->attenuation_begin, obj->attenuation_end, distance);
+			Vec3f delta(position_x[i] - listener_position.x, position_y[i] - listener_position.y, position_z[i] - listener_position.z);
+			float distance = delta.length();
+			float t = 1.0f - smoothstep(attenuation_begin[i], attenuation_end[i], distance);
 
-			// Calculate pan from ear angle
-			Vec3f sound_direction = Vec3f::normalize(obj->position - listener_position);
-			Vec3f ear_vector = listener_orientation.rotate_vector(Vec3f(1.0f, 0.0f, 0.0f));
-			float pan = Vec3f::dot(ear_vector, sound_direction);
-			if (reverse_stereo)
-				pan = -pan;
+			// Calculate pan from ear angle, and depth from the angle to the front
+			float rcp_distance = distance > 0.0f ? 1.0f / distance : 0.0f;
+			float pan = Vec3f::dot(ear_vector, delta) * rcp_distance;
+			float depth = -Vec3f::dot(front_vector, delta) * rcp_distance;
 
 			// Final volume needs to stay the same no matter the panning direction
-			float volume = (0.5f + std::abs(pan) * 0.5f) * t * obj->volume;
+			mix_volume[i] = (0.5f + std::abs(pan) * 0.5f) * t * base_volume;
+			mix_pan[i] = pan;
+			mix_pan_depth[i] = depth;
 
-			obj->session.set_volume(volume);
-			obj->session.set_pan(pan);
+			if (doppler_factor > 0.0f)
+			{
+				// Speeds along the line from the source to the listener
+				Vec3f velocity(velocity_x[i], velocity_y[i], velocity_z[i]);
+				float listener_speed = std::min(-Vec3f::dot(delta, listener_velocity) * rcp_distance, max_listener_speed);
+				float source_speed = std::min(-Vec3f::dot(delta, velocity) * rcp_distance, max_source_speed);
+				mix_pitch[i] = (speed_of_sound - doppler_factor * listener_speed) / (speed_of_sound - doppler_factor * source_speed);
+			}
+			else
+			{
+				mix_pitch[i] = 1.0f;
+			}
 		}
-		else
+	}
+
+	void AudioWorld_Impl::spatialize_all()
+	{
+		int size = (int)objects.size();
+
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (size / 4) * 4;
+
+		__m128 listener_x = _mm_set1_ps(listener_position.x);
+		__m128 listener_y = _mm_set1_ps(listener_position.y);
+		__m128 listener_z = _mm_set1_ps(listener_position.z);
+		__m128 ear_x = _mm_set1_ps(ear_vector.x);
+		__m128 ear_y = _mm_set1_ps(ear_vector.y);
+		__m128 ear_z = _mm_set1_ps(ear_vector.z);
+		__m128 back_x = _mm_set1_ps(-front_vector.x);
+		__m128 back_y = _mm_set1_ps(-front_vector.y);
+		__m128 back_z = _mm_set1_ps(-front_vector.z);
+		__m128 listener_velocity_x = _mm_set1_ps(listener_velocity.x);
+		__m128 listener_velocity_y = _mm_set1_ps(listener_velocity.y);
+		__m128 listener_velocity_z = _mm_set1_ps(listener_velocity.z);
+		__m128 zero = _mm_setzero_ps();
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 two = _mm_set1_ps(2.0f);
+		__m128 three = _mm_set1_ps(3.0f);
+		__m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		bool doppler = doppler_factor > 0.0f;
+		__m128 sound_speed = _mm_set1_ps(speed_of_sound);
+		__m128 doppler_scale = _mm_set1_ps(doppler_factor);
+		__m128 max_listener_speed = _mm_set1_ps(doppler ? speed_of_sound / doppler_factor : 0.0f);
+		__m128 max_source_speed = _mm_mul_ps(max_listener_speed, half);
+
+		for (int i = 0; i < sse_size; i += 4)
 		{
-			obj->session.set_volume(obj->volume);
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(&position_x[i]), listener_x);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(&position_y[i]), listener_y);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(&position_z[i]), listener_z);
+			__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+			__m128 rcp_distance = _mm_and_ps(_mm_cmpgt_ps(distance, zero), _mm_div_ps(one, distance));
+
+			// 1 - smoothstep(begin, end, distance)
+			__m128 begin = _mm_loadu_ps(&attenuation_begin[i]);
+			__m128 end = _mm_loadu_ps(&attenuation_end[i]);
+			__m128 attenuated = _mm_cmpneq_ps(begin, end);
+			__m128 t = _mm_div_ps(_mm_sub_ps(distance, begin), _mm_sub_ps(end, begin));
+			t = _mm_min_ps(_mm_max_ps(t, zero), one);
+			t = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(three, _mm_mul_ps(two, t))));
+
+			__m128 pan = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ear_x, dx), _mm_mul_ps(ear_y, dy)), _mm_mul_ps(ear_z, dz)), rcp_distance);
+			__m128 depth = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(back_x, dx), _mm_mul_ps(back_y, dy)), _mm_mul_ps(back_z, dz)), rcp_distance);
+
+			__m128 base_volume = _mm_mul_ps(_mm_loadu_ps(&volume[i]), _mm_sub_ps(one, _mm_loadu_ps(&occlusion[i])));
+			__m128 pan_volume = _mm_add_ps(half, _mm_mul_ps(_mm_and_ps(pan, abs_mask), half));
+			__m128 spatial_volume = _mm_mul_ps(_mm_mul_ps(pan_volume, t), base_volume);
+
+			// Objects without attenuation keep their volume and play centered
+			_mm_storeu_ps(&mix_volume[i], _mm_or_ps(_mm_and_ps(attenuated, spatial_volume), _mm_andnot_ps(attenuated, base_volume)));
+			_mm_storeu_ps(&mix_pan[i], _mm_and_ps(attenuated, pan));
+			_mm_storeu_ps(&mix_pan_depth[i], _mm_and_ps(attenuated, depth));
+
+			__m128 pitch = one;
+			if (doppler)
+			{
+				__m128 listener_speed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, listener_velocity_x), _mm_mul_ps(dy, listener_velocity_y)), _mm_mul_ps(dz, listener_velocity_z));
+				__m128 source_speed = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&velocity_x[i])), _mm_mul_ps(dy, _mm_loadu_ps(&velocity_y[i]))), _mm_mul_ps(dz, _mm_loadu_ps(&velocity_z[i])));
+				listener_speed = _mm_min_ps(_mm_sub_ps(zero, _mm_mul_ps(listener_speed, rcp_distance)), max_listener_speed);
+				source_speed = _mm_min_ps(_mm_sub_ps(zero, _mm_mul_ps(source_speed, rcp_distance)), max_source_speed);
+				pitch = _mm_div_ps(_mm_sub_ps(sound_speed, _mm_mul_ps(doppler_scale, listener_speed)), _mm_sub_ps(sound_speed, _mm_mul_ps(doppler_scale, source_speed)));
+				pitch = _mm_or_ps(_mm_and_ps(attenuated, pitch), _mm_andnot_ps(attenuated, one));
+			}
+			_mm_storeu_ps(&mix_pitch[i], pitch);
+		}
+
+#else
+		const int sse_size = 0;
+#endif
+
+		spatialize(sse_size, size);
+	}
+
+	void AudioWorld_Impl::apply_session(AudioObject_Impl *obj)
+	{
+		if (obj->session.is_null())
+			return;
+
+		int i = obj->index;
+		if (attenuation_begin[i] == attenuation_end[i])
+		{
+			obj->session.set_volume(mix_volume[i]);
 			obj->session.set_pan(0.0f);
 		}
+		else
+		{
+			SoundBuffer_Session_Impl *session = obj->session.impl.get();
+			float new_volume = mix_volume[i];
+			float new_pan = mix_pan[i];
+			float new_depth = mix_pan_depth[i];
+			if (session->volume != new_volume || session->pan != new_pan || session->pan_depth != new_depth || !session->positional)
+			{
+				session->volume = new_volume;
+				session->pan = new_pan;
+				session->pan_depth = new_depth;
+				session->positional = true;
+
+				// Only one sound output exists at a time, so all sessions share its command queue
+				SoundCommand command;
+				command.type = cl_sound_command_set_spatial;
+				command.session = obj->session.impl;
+				command.value = new_volume;
+				command.pan = new_pan;
+				command.pan_depth = new_depth;
+				commands.push_back(command);
+			}
+		}
+
+		int frequency = (int)(obj->base_frequency * mix_pitch[i] + 0.5f);
+		if (frequency != obj->session.get_frequency())
+			obj->session.set_frequency(frequency);
+	}
+
+	void AudioWorld_Impl::flush_commands()
+	{
+		if (commands.empty())
+			return;
+
+		std::shared_ptr<SoundOutput_Impl> output = commands.front().session->output.impl;
+		output->push_commands(commands);
+		commands.clear();
 	}
 }
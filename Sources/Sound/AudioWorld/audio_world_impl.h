@@ -29,9 +29,11 @@
 #pragma once
 
 #include <list>
+#include <vector>
 #include "API/Core/Math/vec3.h"
 #include "API/Core/Math/quaternion.h"
 #include "API/Core/Resources/resource_manager.h"
+#include "../Mixer/sound_command_queue.h"
 
 namespace clan
 {
@@ -43,16 +45,58 @@ namespace clan
 		AudioWorld_Impl(const ResourceManager &resources);
 		~AudioWorld_Impl();
 
+		/// \brief Adds an object to the emitter arrays and returns its index
+		int add_object(AudioObject_Impl *obj);
+
+		/// \brief Removes an object by moving the last object into its place
+		void remove_object(int index);
+
+		/// \brief Spatializes a single object and applies the result to its session
 		void update_session(AudioObject_Impl *obj);
 
-		std::list<AudioObject_Impl *> objects;
+		/// \brief Spatializes all objects, four at a time, and applies the results to their sessions
+		void update_sessions();
+
+		std::vector<AudioObject_Impl *> objects;
 		std::list<AudioObject> active_objects;
 
+		// Emitters stored as one array per component, indexed by AudioObject_Impl::index
+		std::vector<float> position_x, position_y, position_z;
+		std::vector<float> velocity_x, velocity_y, velocity_z;
+		std::vector<float> attenuation_begin, attenuation_end;
+		std::vector<float> volume, occlusion;
+
+		// Results of the last spatialization
+		std::vector<float> mix_volume, mix_pan, mix_pan_depth, mix_pitch;
+
 		Vec3f listener_position;
+		Vec3f listener_velocity;
 		Quaternionf listener_orientation;
+		float doppler_factor;
+		float speed_of_sound;
 		bool play_ambience;
 		bool reverse_stereo;
 
 		ResourceManager resources;
+
+	private:
+		/// \brief Calculates the listener vectors shared by all objects
+		void begin_spatialize();
+
+		/// \brief Spatializes objects [begin, end) one at a time
+		void spatialize(int begin, int end);
+
+		/// \brief Spatializes all objects
+		void spatialize_all();
+
+		/// \brief Sends the results for an object to its session, or adds them to the batch of spatial commands
+		void apply_session(AudioObject_Impl *obj);
+
+		/// \brief Hands the batched commands to the mixer thread
+		void flush_commands();
+
+		Vec3f ear_vector;
+		Vec3f front_vector;
+		std::vector<SoundCommand> commands;
 	};
 }
@@ -0,0 +1,101 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_command_queue.h"
+#include "sound_mixer.h"
+#include "../soundbuffer_session_impl.h"
+
+namespace clan
+{
+	SoundCommandQueue::SoundCommandQueue(int capacity) : ring(capacity), read_pos(0), write_pos(0)
+	{
+	}
+
+	void SoundCommandQueue::push(SoundCommand &command, const std::function<void()> &make_room)
+	{
+		std::unique_lock<std::mutex> lock(producer_mutex);
+
+		unsigned int pos = write_pos.load(std::memory_order_relaxed);
+		while (pos - read_pos.load(std::memory_order_acquire) == ring.size())
+			make_room();
+
+		move(command, ring[pos & (ring.size() - 1)]);
+
+		write_pos.store(pos + 1, std::memory_order_release);
+	}
+
+	void SoundCommandQueue::push(std::vector<SoundCommand> &commands, const std::function<void()> &make_room)
+	{
+		std::unique_lock<std::mutex> lock(producer_mutex);
+
+		unsigned int pos = write_pos.load(std::memory_order_relaxed);
+		for (auto & command : commands)
+		{
+			// Publish what is written so far while waiting, so a batch larger than the ring can drain
+			if (pos - read_pos.load(std::memory_order_acquire) == ring.size())
+			{
+				write_pos.store(pos, std::memory_order_release);
+				while (pos - read_pos.load(std::memory_order_acquire) == ring.size())
+					make_room();
+			}
+
+			move(command, ring[pos & (ring.size() - 1)]);
+			pos++;
+		}
+
+		write_pos.store(pos, std::memory_order_release);
+	}
+
+	bool SoundCommandQueue::pop(SoundCommand &command)
+	{
+		unsigned int pos = read_pos.load(std::memory_order_relaxed);
+		if (pos == write_pos.load(std::memory_order_acquire))
+			return false;
+
+		SoundCommand &slot = ring[pos & (ring.size() - 1)];
+		move(slot, command);
+
+		// Drop any references left from the previous command before handing the slot back
+		slot.session.reset();
+		slot.bus.reset();
+
+		read_pos.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	void SoundCommandQueue::move(SoundCommand &from, SoundCommand &to)
+	{
+		to.type = from.type;
+		to.session.swap(from.session);
+		to.bus.swap(from.bus);
+		to.value = from.value;
+		to.pan = from.pan;
+		to.pan_depth = from.pan_depth;
+	}
+}
@@ -0,0 +1,104 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace clan
+{
+	class SoundBuffer_Session_Impl;
+	class SoundMixer;
+
+	enum SoundCommandType
+	{
+		cl_sound_command_play,
+		cl_sound_command_stop,
+		cl_sound_command_set_volume,
+		cl_sound_command_set_pan,
+		cl_sound_command_set_pan_depth,
+		cl_sound_command_set_spatial
+	};
+
+	/// \brief Change to a sound session requested by a game thread
+	class SoundCommand
+	{
+	public:
+		SoundCommandType type = cl_sound_command_play;
+		std::shared_ptr<SoundBuffer_Session_Impl> session;
+
+		/// \brief Bus to play the session on. Null means the master bus.
+		std::shared_ptr<SoundMixer> bus;
+
+		/// \brief New volume or panning
+		float value = 0.0f;
+
+		/// \brief Panning and depth of cl_sound_command_set_spatial. The volume is in value.
+		float pan = 0.0f;
+		float pan_depth = 0.0f;
+	};
+
+	/// \brief Ring of commands from the game threads to the mixer thread
+	///
+	/// The ring is single producer, single consumer. The mixer thread is the only consumer and
+	/// never takes a lock. Producers are serialized by a mutex only they use, so the mixer never
+	/// waits on a game thread. A game thread only waits when the ring is full, and then leaves
+	/// it to the caller to make room, since there may be no mixer thread to drain it.
+	class SoundCommandQueue
+	{
+	public:
+		/// \brief Constructs the ring. The capacity must be a power of two.
+		SoundCommandQueue(int capacity = default_capacity);
+
+		/// \brief Queues a command. Calls make_room until there is space if the ring is full.
+		void push(SoundCommand &command, const std::function<void()> &make_room);
+
+		/// \brief Queues all commands in order, taking the producer lock once. The commands are left without sessions.
+		void push(std::vector<SoundCommand> &commands, const std::function<void()> &make_room);
+
+		/// \brief Takes the oldest command off the ring. Returns false if the ring is empty. Consumer only.
+		bool pop(SoundCommand &command);
+
+		enum { default_capacity = 4096 };
+
+	private:
+		static void move(SoundCommand &from, SoundCommand &to);
+
+		std::vector<SoundCommand> ring;
+		std::atomic<unsigned int> read_pos;
+		std::atomic<unsigned int> write_pos;
+		std::mutex producer_mutex;
+
+		SoundCommandQueue(const SoundCommandQueue &source) = delete;
+		SoundCommandQueue &operator =(const SoundCommandQueue &source) = delete;
+	};
+}
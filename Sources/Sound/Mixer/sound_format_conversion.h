@@ -28,7 +28,7 @@
 
 #pragma once
 
-#include "speaker_position.h"
+#include "API/Sound/speaker_position.h"
 #include "sound_mixing_buffers_data.h"
 
 namespace clan
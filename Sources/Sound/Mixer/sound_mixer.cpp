@@ -0,0 +1,300 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_mixer.h"
+#include "sound_mixing_input.h"
+#include "API/Sound/sound_sse.h"
+#include <algorithm>
+
+namespace clan
+{
+	SoundMixer::SoundMixer(SpeakerPositionMask speakers) : speakers(speakers), volume(1.0f), next_input(0)
+	{
+	}
+
+	void SoundMixer::set_speakers(SpeakerPositionMask new_speakers)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		speakers = new_speakers;
+		for (auto & elem : buses)
+		{
+			std::shared_ptr<SoundMixer> bus = elem.lock();
+			if (bus)
+				bus->set_speakers(new_speakers);
+		}
+	}
+
+	float SoundMixer::get_volume() const
+	{
+		return volume;
+	}
+
+	void SoundMixer::set_volume(float new_volume)
+	{
+		volume = new_volume;
+	}
+
+	void SoundMixer::add_filter(SoundFilter &filter)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		filters.push_back(filter);
+	}
+
+	void SoundMixer::remove_filter(SoundFilter &filter)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		for (auto it = filters.begin(); it != filters.end(); ++it)
+		{
+			if (*it == filter)
+			{
+				filters.erase(it);
+				break;
+			}
+		}
+	}
+
+	void SoundMixer::add_input(const std::shared_ptr<SoundSampleSource> &input)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		inputs.push_back(input);
+	}
+
+	void SoundMixer::remove_input(SoundSampleSource *input)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		for (auto it = inputs.begin(); it != inputs.end(); ++it)
+		{
+			if (it->get() == input)
+			{
+				inputs.erase(it);
+				break;
+			}
+		}
+	}
+
+	void SoundMixer::add_bus(const std::shared_ptr<SoundMixer> &bus)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		bus->set_speakers(speakers);
+		bus->set_worker_pool(worker_pool);
+		buses.push_back(bus);
+	}
+
+	void SoundMixer::set_worker_pool(const std::shared_ptr<SoundMixerWorkerPool> &pool)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		worker_pool = pool;
+		worker_used.resize(pool ? pool->get_worker_count() : 0);
+		for (auto & elem : buses)
+		{
+			std::shared_ptr<SoundMixer> bus = elem.lock();
+			if (bus)
+				bus->set_worker_pool(pool);
+		}
+	}
+
+	void SoundMixer::mix(float **temp, int sample_count)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+
+		buffers.resize(speakers, sample_count);
+		buffers.clear();
+
+		if (worker_pool && inputs.size() >= (size_t)worker_pool->get_worker_count() * min_inputs_per_worker)
+			mix_inputs_parallel(temp, sample_count);
+		else
+			mix_inputs(temp, sample_count);
+
+		for (size_t i = 0; i < buses.size();)
+		{
+			std::shared_ptr<SoundMixer> bus = buses[i].lock();
+			if (bus)
+			{
+				SoundMixingInput input;
+				bus->get_data(input, speakers, temp, sample_count);
+				program.mix(buffers, speakers, input, sample_count);
+				i++;
+			}
+			else
+			{
+				buses.erase(buses.begin() + i);
+			}
+		}
+
+		filter_buffers(sample_count);
+	}
+
+	bool SoundMixer::get_data(SoundMixingInput &output, SpeakerPositionMask output_speakers, float **temp, int sample_count)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		mix(temp, sample_count);
+		output.data = buffers;
+		output.speakers = speakers;
+		output.set_volume(volume);
+
+		// Fade volume changes over the block to avoid clicks
+		if (has_previous_volumes)
+			output.ramp_from(previous_volumes);
+		else
+			std::copy(output.volumes, output.volumes + 32, previous_volumes);
+		has_previous_volumes = true;
+		return true;
+	}
+
+	void SoundMixer::mix_inputs(float **temp, int sample_count)
+	{
+		// The last block of an ended source still has to be mixed before the source is removed
+		for (size_t i = 0; i < inputs.size();)
+		{
+			SoundMixingInput input;
+			bool playing = inputs[i]->get_data(input, speakers, temp, sample_count);
+			if (input.speakers)
+				program.mix(buffers, speakers, input, sample_count);
+			if (playing)
+				i++;
+			else
+				inputs.erase(inputs.begin() + i);
+		}
+	}
+
+	void SoundMixer::mix_inputs_parallel(float **temp, int sample_count)
+	{
+		// Vectors keep their capacity, so these only allocate when the input count grows
+		input_ended.assign(inputs.size(), 0);
+		for (auto & elem : worker_used)
+			elem = 0;
+
+		next_input = 0;
+		task_temp = temp;
+		task_sample_count = sample_count;
+		worker_pool->run(*this);
+
+		// Worker 0 mixed straight into our buffers. Add the sums of the other workers.
+		for (int worker_index = 1; worker_index < (int)worker_used.size(); worker_index++)
+		{
+			if (!worker_used[worker_index])
+				continue;
+
+			SoundMixingBuffersContainer &accumulation = worker_pool->get_worker(worker_index).accumulation;
+			for (int i = 0; i < 32; i++)
+			{
+				if (buffers.channels[i])
+					SoundSSE::mix_one_to_one(accumulation.channels[i], sample_count, buffers.channels[i], 1.0f);
+			}
+		}
+
+		size_t count = 0;
+		for (size_t i = 0; i < inputs.size(); i++)
+		{
+			if (!input_ended[i])
+				inputs[count++] = inputs[i];
+		}
+		inputs.resize(count);
+	}
+
+	void SoundMixer::run_worker(int worker_index)
+	{
+		SoundMixerWorker &worker = worker_pool->get_worker(worker_index);
+
+		float **temp = task_temp;
+		SoundMixingBuffersData *output = &buffers;
+		SoundMixerProgram *worker_program = &program;
+		if (worker_index != 0)
+		{
+			worker.reserve(task_sample_count);
+			temp = worker.temp;
+			output = &worker.accumulation;
+			worker_program = &worker.program;
+		}
+
+		int num_inputs = (int)inputs.size();
+		while (true)
+		{
+			// Hand out one input at a time, since decoding and resampling costs vary a lot between sources
+			int i = next_input++;
+			if (i >= num_inputs)
+				break;
+
+			if (worker_index != 0 && !worker_used[worker_index])
+			{
+				worker.accumulation.resize(speakers, task_sample_count);
+				worker.accumulation.clear();
+				worker_used[worker_index] = 1;
+			}
+
+			SoundMixingInput input;
+			bool playing = inputs[i]->get_data(input, speakers, temp, task_sample_count);
+			if (input.speakers)
+				worker_program->mix(*output, speakers, input, task_sample_count);
+			if (!playing)
+				input_ended[i] = 1;
+		}
+	}
+
+	void SoundMixer::filter_buffers(int sample_count)
+	{
+		if (filters.empty())
+			return;
+
+		float *channels[32];
+		int num_channels = 0;
+		for (auto & elem : buffers.channels)
+		{
+			if (elem)
+				channels[num_channels++] = elem;
+		}
+
+		for (auto & filter : filters)
+			filter.filter(channels, sample_count, num_channels);
+	}
+
+	int SoundMixer::get_speaker_count(SpeakerPositionMask speakers)
+	{
+		int count = 0;
+		for (; speakers != 0; speakers >>= 1)
+		{
+			if (speakers & 1)
+				count++;
+		}
+		return count;
+	}
+
+	SpeakerPositionMask SoundMixer::get_default_speakers(int channels)
+	{
+		switch (channels)
+		{
+		case 1: return cl_speakers_mono;
+		case 2: return cl_speakers_stereo;
+		case 4: return cl_speakers_quad;
+		case 6: return cl_speakers_5_1;
+		case 8: return cl_speakers_7_1;
+		default: return channels >= 32 ? 0xffffffff : (1u << channels) - 1;
+		}
+	}
+}
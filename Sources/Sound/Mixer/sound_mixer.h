@@ -28,25 +28,98 @@
 
 #pragma once
 
+#include "API/Sound/soundfilter.h"
 #include "sound_sample_source.h"
+#include "sound_mixer_program.h"
+#include "sound_mixing_buffers_container.h"
+#include "sound_mixer_worker_pool.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace clan
 {
-	class SoundMixer : public SoundSampleSource
+	/// \brief Mixing bus summing a set of sample sources and child buses
+	///
+	/// A SoundMixer is itself a sample source so buses can be nested to any depth. The
+	/// mixer renders its inputs in its own speaker layout, runs its filters and then
+	/// hands the result to its parent with its volume applied.
+	///
+	/// When a worker pool is attached the inputs of the mixer are spread across the
+	/// workers. Each worker sums its share into its own accumulation buffers, which are
+	/// added together once all workers are done. Child buses are still mixed in order.
+	class SoundMixer : public SoundSampleSource, private SoundMixerTask
 	{
 	public:
-		SoundMixer(int frequency, SoundMixerProgram *program);
+		SoundMixer(SpeakerPositionMask speakers = cl_speakers_stereo);
 
-		void add_input_source(SoundSampleSource *input_source);
-		void remove_input_source(SoundSampleSource *input_source);
+		SpeakerPositionMask get_speakers() const { return speakers; }
 
-		int get_frequency() const { return frequency; }
-		void get_data(SoundMixingBuffersData &output, int sample_count);
+		/// \brief Changes the speaker layout the inputs are mixed in
+		void set_speakers(SpeakerPositionMask speakers);
+
+		float get_volume() const;
+		void set_volume(float volume);
+
+		void add_filter(SoundFilter &filter);
+		void remove_filter(SoundFilter &filter);
+
+		/// \brief Adds a sample source that stays in the mixer until it reports that it ended
+		void add_input(const std::shared_ptr<SoundSampleSource> &input);
+		void remove_input(SoundSampleSource *input);
+
+		/// \brief Adds a child bus that is mixed until it is destroyed
+		void add_bus(const std::shared_ptr<SoundMixer> &bus);
+
+		/// \brief Mixes the inputs of this mixer and its child buses on a worker pool. Null mixes everything on the calling thread.
+		void set_worker_pool(const std::shared_ptr<SoundMixerWorkerPool> &pool);
+
+		/// \brief Mixes all inputs into the mixing buffers
+		void mix(float **temp, int sample_count);
+
+		/// \brief Mixing buffers holding the result of the last mix call
+		SoundMixingBuffersContainer &get_buffers() { return buffers; }
+
+		bool get_data(SoundMixingInput &output, SpeakerPositionMask output_speakers, float **temp, int sample_count) override;
+
+		/// \brief Returns the number of speakers in a speaker mask
+		static int get_speaker_count(SpeakerPositionMask speakers);
+
+		/// \brief Returns the speaker layout normally used for a number of channels
+		static SpeakerPositionMask get_default_speakers(int channels);
+
+		/// \brief Number of scratch channels a sample source may use
+		enum { max_source_channels = 8 };
 
 	private:
-		int frequency;
-		SoundMixerProgram *program;
-		std::vector<SoundMixingBuffersContainer *> inputs;
-		std::vector<SoundSampleSource *> sources;
+		void mix_inputs(float **temp, int sample_count);
+		void mix_inputs_parallel(float **temp, int sample_count);
+		void run_worker(int worker_index) override;
+		void filter_buffers(int sample_count);
+
+		/// \brief Fewest inputs per worker for which mixing in parallel pays off
+		enum { min_inputs_per_worker = 2 };
+
+		SpeakerPositionMask speakers;
+
+		/// \brief Atomic so that game threads can change the volume while the bus is mixing
+		std::atomic<float> volume;
+		float previous_volumes[32];
+		bool has_previous_volumes = false;
+
+		std::vector<SoundFilter> filters;
+		std::vector<std::shared_ptr<SoundSampleSource> > inputs;
+		std::vector<std::weak_ptr<SoundMixer> > buses;
+		StandardSoundMixerProgram program;
+		SoundMixingBuffersContainer buffers;
+		mutable std::recursive_mutex mutex;
+
+		std::shared_ptr<SoundMixerWorkerPool> worker_pool;
+		std::vector<char> input_ended;
+		std::vector<char> worker_used;
+		std::atomic_int next_input;
+		float **task_temp = nullptr;
+		int task_sample_count = 0;
 	};
 }
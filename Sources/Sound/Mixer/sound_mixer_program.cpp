@@ -0,0 +1,236 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_mixer_program.h"
+#include "API/Sound/sound_sse.h"
+#include <algorithm>
+
+namespace clan
+{
+	void StandardSoundMixerProgram::mix(SoundMixingBuffersData &output, SpeakerPositionMask output_speakers, const SoundMixingInput &input, int sample_count)
+	{
+		const RouteTable &table = get_route_table(input.speakers, output_speakers, input.spread);
+
+		// Sum all input channels routed to an output channel in one pass over that channel
+		float *channels[32];
+		float volumes[32];
+		float start_volumes[32];
+		size_t pos = 0;
+		while (pos < table.routes.size())
+		{
+			int output_channel = table.routes[pos].output_channel;
+			float output_volume = input.volumes[output_channel];
+			float output_start_volume = input.ramp ? input.start_volumes[output_channel] : output_volume;
+
+			int count = 0;
+			for (; pos < table.routes.size() && table.routes[pos].output_channel == output_channel; pos++)
+			{
+				float *channel = input.data.channels[table.routes[pos].input_channel];
+				float volume = table.routes[pos].volume * output_volume;
+				float start_volume = table.routes[pos].volume * output_start_volume;
+				if (channel && (volume != 0.0f || start_volume != 0.0f))
+				{
+					channels[count] = channel;
+					volumes[count] = volume;
+					start_volumes[count] = start_volume;
+					count++;
+				}
+			}
+
+			if (count > 0 && output.channels[output_channel])
+			{
+				if (output_start_volume != output_volume)
+					SoundSSE::mix_many_to_one_ramp(channels, start_volumes, volumes, count, sample_count, output.channels[output_channel]);
+				else
+					SoundSSE::mix_many_to_one(channels, volumes, count, sample_count, output.channels[output_channel]);
+			}
+		}
+	}
+
+	const StandardSoundMixerProgram::RouteTable &StandardSoundMixerProgram::get_route_table(SpeakerPositionMask input_speakers, SpeakerPositionMask output_speakers, bool spread)
+	{
+		for (auto & table : route_tables)
+		{
+			if (table.input_speakers == input_speakers && table.output_speakers == output_speakers && table.spread == spread)
+				return table;
+		}
+
+		RouteTable table;
+		table.input_speakers = input_speakers;
+		table.output_speakers = output_speakers;
+		table.spread = spread;
+		if (spread)
+			add_spread_routes(table.routes, input_speakers, output_speakers);
+		else
+			add_routes(table.routes, input_speakers, output_speakers);
+		route_tables.push_back(table);
+		return route_tables.back();
+	}
+
+	void StandardSoundMixerProgram::add_routes(std::vector<Route> &routes, SpeakerPositionMask input_speakers, SpeakerPositionMask output_speakers)
+	{
+		for (int i = 0; i < 32; i++)
+		{
+			SpeakerPosition speaker = (SpeakerPosition)(1 << i);
+			if ((input_speakers & speaker) == 0)
+				continue;
+
+			// Mono sources play at full volume in both front speakers, like they always did in stereo
+			if (input_speakers == cl_speakers_mono && (output_speakers & cl_speakers_stereo) == cl_speakers_stereo)
+			{
+				add_route(routes, i, cl_speaker_front_left, output_speakers, 1.0f);
+				add_route(routes, i, cl_speaker_front_right, output_speakers, 1.0f);
+			}
+			else
+			{
+				add_route(routes, i, speaker, output_speakers, 1.0f);
+			}
+		}
+
+		std::stable_sort(routes.begin(), routes.end(), [](const Route &a, const Route &b) { return a.output_channel < b.output_channel; });
+	}
+
+	void StandardSoundMixerProgram::add_spread_routes(std::vector<Route> &routes, SpeakerPositionMask input_speakers, SpeakerPositionMask output_speakers)
+	{
+		// Every input channel but the LFE is downmixed into every output speaker but the LFE
+		int num_inputs = 0;
+		for (int i = 0; i < 32; i++)
+		{
+			if (((input_speakers >> i) & 1) && (1u << i) != cl_speaker_low_frequency)
+				num_inputs++;
+		}
+
+		for (int i = 0; i < 32; i++)
+		{
+			SpeakerPosition speaker = (SpeakerPosition)(1 << i);
+			if ((input_speakers & speaker) == 0)
+				continue;
+
+			if (speaker == cl_speaker_low_frequency)
+			{
+				add_route(routes, i, speaker, output_speakers, 1.0f);
+				continue;
+			}
+
+			for (int j = 0; j < 32; j++)
+			{
+				if (((output_speakers >> j) & 1) && (1u << j) != cl_speaker_low_frequency)
+				{
+					Route route = { i, j, 1.0f / num_inputs };
+					routes.push_back(route);
+				}
+			}
+		}
+
+		std::stable_sort(routes.begin(), routes.end(), [](const Route &a, const Route &b) { return a.output_channel < b.output_channel; });
+	}
+
+	void StandardSoundMixerProgram::add_route(std::vector<Route> &routes, int input_channel, SpeakerPosition speaker, SpeakerPositionMask output_speakers, float volume)
+	{
+		if (output_speakers & speaker)
+		{
+			for (int i = 0; i < 32; i++)
+			{
+				if (speaker == (1 << i))
+				{
+					Route route = { input_channel, i, volume };
+					routes.push_back(route);
+					break;
+				}
+			}
+			return;
+		}
+
+		// Speakers missing in the output are folded into their nearest neighbours.
+		// Each entry lists the speakers to try in order and the volume used for them.
+		struct Fallback
+		{
+			SpeakerPositionMask speakers;
+			float volume;
+		};
+
+		const float half_power = 0.7071f;
+		const Fallback none[] = { { 0, 0.0f } };
+		const Fallback front_left[] = { { cl_speaker_front_center, half_power }, { 0, 0.0f } };
+		const Fallback front_right[] = { { cl_speaker_front_center, half_power }, { 0, 0.0f } };
+		const Fallback front_center[] = { { cl_speakers_stereo, half_power }, { 0, 0.0f } };
+		const Fallback back_left[] = { { cl_speaker_side_left, 1.0f }, { cl_speaker_front_left, half_power }, { cl_speaker_front_center, 0.5f }, { 0, 0.0f } };
+		const Fallback back_right[] = { { cl_speaker_side_right, 1.0f }, { cl_speaker_front_right, half_power }, { cl_speaker_front_center, 0.5f }, { 0, 0.0f } };
+		const Fallback front_left_of_center[] = { { cl_speaker_front_left, 1.0f }, { cl_speaker_front_center, 1.0f }, { 0, 0.0f } };
+		const Fallback front_right_of_center[] = { { cl_speaker_front_right, 1.0f }, { cl_speaker_front_center, 1.0f }, { 0, 0.0f } };
+		const Fallback back_center[] = { { cl_speaker_back_left | cl_speaker_back_right, half_power }, { cl_speaker_side_left | cl_speaker_side_right, half_power }, { cl_speakers_stereo, 0.5f }, { cl_speaker_front_center, half_power }, { 0, 0.0f } };
+		const Fallback side_left[] = { { cl_speaker_back_left, 1.0f }, { cl_speaker_front_left, half_power }, { cl_speaker_front_center, 0.5f }, { 0, 0.0f } };
+		const Fallback side_right[] = { { cl_speaker_back_right, 1.0f }, { cl_speaker_front_right, half_power }, { cl_speaker_front_center, 0.5f }, { 0, 0.0f } };
+		const Fallback top_center[] = { { cl_speakers_stereo, 0.5f }, { cl_speaker_front_center, half_power }, { 0, 0.0f } };
+		const Fallback top_front_left[] = { { cl_speaker_front_left, 1.0f }, { cl_speaker_front_center, half_power }, { 0, 0.0f } };
+		const Fallback top_front_center[] = { { cl_speaker_front_center, 1.0f }, { cl_speakers_stereo, half_power }, { 0, 0.0f } };
+		const Fallback top_front_right[] = { { cl_speaker_front_right, 1.0f }, { cl_speaker_front_center, half_power }, { 0, 0.0f } };
+		const Fallback top_back_left[] = { { cl_speaker_back_left, 1.0f }, { cl_speaker_side_left, 1.0f }, { cl_speaker_front_left, half_power }, { cl_speaker_front_center, 0.5f }, { 0, 0.0f } };
+		const Fallback top_back_center[] = { { cl_speaker_back_center, 1.0f }, { cl_speaker_back_left | cl_speaker_back_right, half_power }, { cl_speaker_side_left | cl_speaker_side_right, half_power }, { cl_speakers_stereo, 0.5f }, { cl_speaker_front_center, half_power }, { 0, 0.0f } };
+		const Fallback top_back_right[] = { { cl_speaker_back_right, 1.0f }, { cl_speaker_side_right, 1.0f }, { cl_speaker_front_right, half_power }, { cl_speaker_front_center, 0.5f }, { 0, 0.0f } };
+
+		const Fallback *fallbacks = none;
+		switch (speaker)
+		{
+		case cl_speaker_front_left: fallbacks = front_left; break;
+		case cl_speaker_front_right: fallbacks = front_right; break;
+		case cl_speaker_front_center: fallbacks = front_center; break;
+		case cl_speaker_low_frequency: fallbacks = none; break;
+		case cl_speaker_back_left: fallbacks = back_left; break;
+		case cl_speaker_back_right: fallbacks = back_right; break;
+		case cl_speaker_front_left_of_center: fallbacks = front_left_of_center; break;
+		case cl_speaker_front_right_of_center: fallbacks = front_right_of_center; break;
+		case cl_speaker_back_center: fallbacks = back_center; break;
+		case cl_speaker_side_left: fallbacks = side_left; break;
+		case cl_speaker_side_right: fallbacks = side_right; break;
+		case cl_speaker_top_center: fallbacks = top_center; break;
+		case cl_speaker_top_front_left: fallbacks = top_front_left; break;
+		case cl_speaker_top_front_center: fallbacks = top_front_center; break;
+		case cl_speaker_top_front_right: fallbacks = top_front_right; break;
+		case cl_speaker_top_back_left: fallbacks = top_back_left; break;
+		case cl_speaker_top_back_center: fallbacks = top_back_center; break;
+		case cl_speaker_top_back_right: fallbacks = top_back_right; break;
+		}
+
+		for (; fallbacks->speakers != 0; fallbacks++)
+		{
+			if ((output_speakers & fallbacks->speakers) == fallbacks->speakers)
+			{
+				for (int i = 0; i < 32; i++)
+				{
+					if ((fallbacks->speakers >> i) & 1)
+						add_route(routes, input_channel, (SpeakerPosition)(1 << i), output_speakers, volume * fallbacks->volume);
+				}
+				return;
+			}
+		}
+
+		// No suitable speaker in the output. The channel is dropped, as is the LFE channel when there is no subwoofer.
+	}
+}
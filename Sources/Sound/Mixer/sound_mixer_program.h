@@ -28,52 +28,51 @@
 
 #pragma once
 
-#include "speaker_position.h"
-#include "channel_buffers_data.h"
+#include "API/Sound/speaker_position.h"
+#include "sound_mixing_input.h"
+#include <vector>
 
 namespace clan
 {
-	class SoundMixingInput
-	{
-	public:
-		SoundMixingBuffersData data;
-		unsigned int buffer_size;
-		float read_cursor;
-		unsigned int write_cursor;
-		float volumes[32];
-		float speed;
-
-		virtual void get_more_data() = 0;
-	};
-
+	/// \brief Mixes a block of input channels into the output channels of a mixer
 	class SoundMixerProgram
 	{
 	public:
-		virtual void mix(SoundMixingBuffersData &output, std::vector<SoundMixingInput*> inputs, unsigned int sample_count) = 0;
+		virtual ~SoundMixerProgram() { }
+
+		/// \brief Adds the input to the output
+		virtual void mix(SoundMixingBuffersData &output, SpeakerPositionMask output_speakers, const SoundMixingInput &input, int sample_count) = 0;
 	};
 
+	/// \brief Mixer program routing each input speaker to the same output speaker, or its nearest downmix/upmix equivalent
+	///
+	/// Every output channel is produced in a single SIMD pass over all the input channels routed to it.
 	class StandardSoundMixerProgram : public SoundMixerProgram
 	{
 	public:
-		void mix(SoundMixingBuffersData &output, std::vector<SoundMixingInput*> inputs, unsigned int sample_count)
+		void mix(SoundMixingBuffersData &output, SpeakerPositionMask output_speakers, const SoundMixingInput &input, int sample_count) override;
+
+	private:
+		struct Route
 		{
-			for (unsigned int i = 0; i < inputs.size(); i++)
-			{
-				SoundMixingInput *input = inputs[i];
-				for (unsigned int s = 0; s < sample_count; s++)
-				{
-					for (int c = 0; c < 32; c++)
-					{
-						if (output.channels[c])
-							if (input->data.channels[c])
-								output.channels[c][s] += input->data.channels[c][(unsigned int)input->read_cursor] * input->volumes[c];
-					}
+			int input_channel;
+			int output_channel;
+			float volume;
+		};
+
+		struct RouteTable
+		{
+			SpeakerPositionMask input_speakers;
+			SpeakerPositionMask output_speakers;
+			bool spread;
+			std::vector<Route> routes;	// Sorted by output channel
+		};
+
+		const RouteTable &get_route_table(SpeakerPositionMask input_speakers, SpeakerPositionMask output_speakers, bool spread);
+		static void add_routes(std::vector<Route> &routes, SpeakerPositionMask input_speakers, SpeakerPositionMask output_speakers);
+		static void add_spread_routes(std::vector<Route> &routes, SpeakerPositionMask input_speakers, SpeakerPositionMask output_speakers);
+		static void add_route(std::vector<Route> &routes, int input_channel, SpeakerPosition speaker, SpeakerPositionMask output_speakers, float volume);
 
-					input->read_cursor += input->speed;
-					if (input->read_cursor >= input->write_cursor)
-						input->get_more_data();
-				}
-			}
-		}
+		std::vector<RouteTable> route_tables;
 	};
 }
@@ -0,0 +1,134 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_mixer_worker_pool.h"
+#include "API/Sound/sound_sse.h"
+
+namespace clan
+{
+	SoundMixerWorker::SoundMixerWorker() : temp_size(0)
+	{
+		for (auto & elem : temp)
+			elem = nullptr;
+	}
+
+	SoundMixerWorker::~SoundMixerWorker()
+	{
+		for (auto & elem : temp)
+			SoundSSE::aligned_free(elem);
+	}
+
+	void SoundMixerWorker::reserve(int sample_count)
+	{
+		if (sample_count <= temp_size)
+			return;
+
+		for (auto & elem : temp)
+		{
+			SoundSSE::aligned_free(elem);
+			elem = (float *)SoundSSE::aligned_alloc(sizeof(float) * sample_count);
+		}
+		temp_size = sample_count;
+	}
+
+	SoundMixerWorkerPool::SoundMixerWorkerPool(int num_workers)
+		: task(nullptr), generation(0), workers_busy(0), stop_flag(false)
+	{
+		if (num_workers < 1)
+			num_workers = 1;
+
+		for (int i = 0; i < num_workers; i++)
+			workers.push_back(std::unique_ptr<SoundMixerWorker>(new SoundMixerWorker()));
+
+		for (int i = 1; i < num_workers; i++)
+			threads.push_back(std::thread(&SoundMixerWorkerPool::worker_main, this, i));
+	}
+
+	SoundMixerWorkerPool::~SoundMixerWorkerPool()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stop_flag = true;
+		lock.unlock();
+		start_condition.notify_all();
+
+		for (auto & thread : threads)
+			thread.join();
+	}
+
+	void SoundMixerWorkerPool::run(SoundMixerTask &new_task)
+	{
+		if (threads.empty())
+		{
+			new_task.run_worker(0);
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		task = &new_task;
+		workers_busy = (int)threads.size();
+		generation++;
+		lock.unlock();
+		start_condition.notify_all();
+
+		new_task.run_worker(0);
+
+		// The other workers usually finish at about the same time as this one. Spin a little before sleeping.
+		for (int i = 0; i < 1000 && workers_busy.load() != 0; i++)
+			std::this_thread::yield();
+
+		lock.lock();
+		done_condition.wait(lock, [&]() { return workers_busy.load() == 0; });
+		task = nullptr;
+	}
+
+	void SoundMixerWorkerPool::worker_main(int worker_index)
+	{
+		unsigned int last_generation = 0;
+		while (true)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			start_condition.wait(lock, [&]() { return stop_flag || generation != last_generation; });
+			if (stop_flag)
+				break;
+			last_generation = generation;
+			SoundMixerTask *current_task = task;
+			lock.unlock();
+
+			current_task->run_worker(worker_index);
+
+			if (--workers_busy == 0)
+			{
+				// Lock to make sure run() is either before its check or inside its wait
+				lock.lock();
+				lock.unlock();
+				done_condition.notify_one();
+			}
+		}
+	}
+}
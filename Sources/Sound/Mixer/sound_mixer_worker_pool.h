@@ -0,0 +1,114 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "sound_mixer_program.h"
+#include "sound_mixing_buffers_container.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace clan
+{
+	/// \brief Work executed by every thread of a SoundMixerWorkerPool
+	class SoundMixerTask
+	{
+	public:
+		virtual ~SoundMixerTask() { }
+
+		/// \brief Called once on each worker. Worker 0 is the thread that called SoundMixerWorkerPool::run.
+		virtual void run_worker(int worker_index) = 0;
+	};
+
+	/// \brief Scratch space owned by a single worker thread
+	class SoundMixerWorker
+	{
+	public:
+		SoundMixerWorker();
+		~SoundMixerWorker();
+
+		/// \brief Reallocates the temp buffers if they are smaller than sample_count
+		void reserve(int sample_count);
+
+		/// \brief Channels a sample source may render into
+		float *temp[8];
+		int temp_size;
+
+		/// \brief Sum of the inputs mixed by this worker
+		SoundMixingBuffersContainer accumulation;
+
+		StandardSoundMixerProgram program;
+
+	private:
+		SoundMixerWorker(const SoundMixerWorker &source) = delete;
+		SoundMixerWorker &operator =(const SoundMixerWorker &source) = delete;
+	};
+
+	/// \brief Fixed set of threads mixing sample sources in parallel with the mixer thread
+	///
+	/// Tasks are handed over without any memory allocation, so the pool can be used from the
+	/// mixer thread while it is racing the sound card deadline.
+	class SoundMixerWorkerPool
+	{
+	public:
+		/// \brief Starts num_workers - 1 threads. The thread calling run() is the last worker.
+		SoundMixerWorkerPool(int num_workers);
+		~SoundMixerWorkerPool();
+
+		int get_worker_count() const { return (int)workers.size(); }
+
+		/// \brief Scratch space for a worker. Only touch this from that worker, or while no task is running.
+		SoundMixerWorker &get_worker(int worker_index) { return *workers[worker_index]; }
+
+		/// \brief Runs the task on all workers and waits for them to finish
+		///
+		/// Only one thread may call run at a time, and tasks must not call run themselves.
+		void run(SoundMixerTask &task);
+
+	private:
+		void worker_main(int worker_index);
+
+		std::vector<std::unique_ptr<SoundMixerWorker> > workers;
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+		std::condition_variable start_condition;
+		std::condition_variable done_condition;
+		SoundMixerTask *task;
+		unsigned int generation;
+		std::atomic_int workers_busy;
+		bool stop_flag;
+
+		SoundMixerWorkerPool(const SoundMixerWorkerPool &source) = delete;
+		SoundMixerWorkerPool &operator =(const SoundMixerWorkerPool &source) = delete;
+	};
+}
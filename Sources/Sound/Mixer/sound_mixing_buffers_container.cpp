@@ -0,0 +1,70 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_mixing_buffers_container.h"
+#include "API/Sound/sound_sse.h"
+
+namespace clan
+{
+	void SoundMixingBuffersContainer::resize(SpeakerPositionMask new_speakers, int new_sample_count)
+	{
+		if (new_speakers == speakers && new_sample_count == sample_count)
+			return;
+
+		free();
+		speakers = new_speakers;
+		sample_count = new_sample_count;
+		for (int i = 0; i < 32; i++)
+		{
+			if ((speakers >> i) & 1)
+				channels[i] = (float *)SoundSSE::aligned_alloc(sizeof(float) * sample_count);
+		}
+		clear();
+	}
+
+	void SoundMixingBuffersContainer::clear()
+	{
+		for (auto & elem : channels)
+		{
+			if (elem)
+				SoundSSE::set_float(elem, sample_count, 0.0f);
+		}
+	}
+
+	void SoundMixingBuffersContainer::free()
+	{
+		for (auto & elem : channels)
+		{
+			SoundSSE::aligned_free(elem);
+			elem = nullptr;
+		}
+		speakers = 0;
+		sample_count = 0;
+	}
+}
@@ -28,32 +28,35 @@
 
 #pragma once
 
-#include "channel_buffers_data.h"
+#include "API/Sound/speaker_position.h"
+#include "sound_mixing_buffers_data.h"
 
 namespace clan
 {
+	/// \brief Mixing buffers owning one channel for each speaker in a speaker mask
 	class SoundMixingBuffersContainer : public SoundMixingBuffersData
 	{
 	public:
-		SoundMixingBuffersContainer(SpeakerPositionMask input_speakers, int sample_count)
-		{
-			for (int i = 0; input_speakers != 0; (input_speakers >>= 1), i++)
-			{
-				if (input_speakers & 1)
-					channels[i] = new float[sample_count];
-				else
-					channels[i] = 0;
-			}
-		}
-
-		~SoundMixingBuffersContainer()
-		{
-			for (int i = 0; i < 32; i++)
-				delete[] channels[i];
-		}
+		SoundMixingBuffersContainer() { }
+		SoundMixingBuffersContainer(SpeakerPositionMask speakers, int sample_count) { resize(speakers, sample_count); }
+		~SoundMixingBuffersContainer() { free(); }
+
+		SpeakerPositionMask get_speakers() const { return speakers; }
+		int get_sample_count() const { return sample_count; }
+
+		/// \brief Reallocates the channels if the speakers or sample count changed
+		void resize(SpeakerPositionMask new_speakers, int new_sample_count);
+
+		/// \brief Sets all samples in all channels to zero
+		void clear();
 
 	private:
-		SoundMixingBuffersContainer(const SoundMixingBuffersContainer &source) { }
-		SoundMixingBuffersContainer &operator =(const SoundMixingBuffersContainer &source) { }
+		void free();
+
+		SpeakerPositionMask speakers = 0;
+		int sample_count = 0;
+
+		SoundMixingBuffersContainer(const SoundMixingBuffersContainer &source) = delete;
+		SoundMixingBuffersContainer &operator =(const SoundMixingBuffersContainer &source) = delete;
 	};
 }
@@ -0,0 +1,123 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_mixing_input.h"
+#include <algorithm>
+#include <cmath>
+
+namespace clan
+{
+	void SoundMixingInput::set_volume(float volume, float pan, float depth, SpeakerPositionMask output_speakers)
+	{
+		// Direction of each speaker bit in degrees, clockwise from straight ahead
+		const float no_azimuth = 1000.0f;
+		const int num_positions = 18;
+		const float speaker_azimuths[num_positions] =
+		{
+			-30.0f, 30.0f, 0.0f, no_azimuth, -135.0f, 135.0f, -15.0f, 15.0f, 180.0f,
+			-90.0f, 90.0f, no_azimuth, -30.0f, 0.0f, 30.0f, -135.0f, 180.0f, 135.0f
+		};
+		const float pi = 3.14159265f;
+
+		if (volume < 0.0f) volume = 0.0f;
+		if (volume > 1.0f) volume = 1.0f;
+
+		// Distinct directions of the output speakers, in increasing order
+		float azimuths[num_positions];
+		int num_azimuths = 0;
+		for (int i = 0; i < num_positions; i++)
+		{
+			if (((output_speakers >> i) & 1) && speaker_azimuths[i] != no_azimuth)
+				azimuths[num_azimuths++] = speaker_azimuths[i];
+		}
+		std::sort(azimuths, azimuths + num_azimuths);
+		num_azimuths = std::unique(azimuths, azimuths + num_azimuths) - azimuths;
+
+		// A direction shorter than one fades from the nearest speakers towards all speakers at equal power
+		float length = std::min(std::sqrt(pan * pan + depth * depth), 1.0f);
+		float diffuse = num_azimuths > 0 ? 1.0f / std::sqrt((float)num_azimuths) : 0.0f;
+
+		float gains[num_positions];
+		for (int i = 0; i < num_azimuths; i++)
+			gains[i] = (1.0f - length) * diffuse;
+
+		// Constant power panning between the two speakers around the direction
+		if (num_azimuths >= 2 && length > 0.0f)
+		{
+			float direction = std::atan2(pan, -depth) * 180.0f / pi;
+			int next = 0;
+			while (next < num_azimuths && azimuths[next] <= direction)
+				next++;
+			int prev = (next + num_azimuths - 1) % num_azimuths;
+			next = next % num_azimuths;
+
+			float start = azimuths[prev];
+			float end = azimuths[next];
+			if (end <= start)
+				end += 360.0f;
+			if (direction < start)
+				direction += 360.0f;
+
+			float t = (direction - start) / (end - start);
+			gains[prev] += length * std::cos(t * pi * 0.5f);
+			gains[next] += length * std::sin(t * pi * 0.5f);
+		}
+
+		for (int i = 0; i < 32; i++)
+		{
+			if (((output_speakers >> i) & 1) == 0)
+			{
+				volumes[i] = 0.0f;
+			}
+			else if (i == 3)
+			{
+				// Low frequency effects are not directional
+				volumes[i] = volume;
+			}
+			else if (i >= num_positions || speaker_azimuths[i] == no_azimuth)
+			{
+				volumes[i] = volume * (1.0f - length) * diffuse;
+			}
+			else
+			{
+				// Speakers in the same direction, like front left and top front left, share its power
+				int index = std::find(azimuths, azimuths + num_azimuths, speaker_azimuths[i]) - azimuths;
+				int shared = 0;
+				for (int j = 0; j < num_positions; j++)
+				{
+					if (((output_speakers >> j) & 1) && speaker_azimuths[j] == speaker_azimuths[i])
+						shared++;
+				}
+				volumes[i] = volume * gains[index] / std::sqrt((float)shared);
+			}
+		}
+
+		spread = true;
+	}
+}
@@ -0,0 +1,115 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/speaker_position.h"
+#include "sound_mixing_buffers_data.h"
+
+namespace clan
+{
+	/// \brief Block of sample data handed by a sample source to a mixer program
+	class SoundMixingInput
+	{
+	public:
+		SoundMixingInput() { for (auto & elem : volumes) elem = 0.0f; }
+
+		/// \brief Channel data, indexed by speaker bit like the mixer output
+		SoundMixingBuffersData data;
+
+		/// \brief Speakers present in data
+		SpeakerPositionMask speakers = 0;
+
+		/// \brief Volume applied to each output speaker, indexed by speaker bit
+		float volumes[32];
+
+		/// \brief Volume at the start of the block for each output speaker. Only used if ramp is true.
+		float start_volumes[32];
+
+		/// \brief Fade linearly from start_volumes to volumes over the block
+		bool ramp = false;
+
+		/// \brief Route every input channel to every output speaker, so volumes alone decide where the input is heard
+		bool spread = false;
+
+		/// \brief Fades from the volumes used for the previous block, and stores the current volumes for the next block
+		void ramp_from(float *previous_volumes)
+		{
+			ramp = false;
+			for (int i = 0; i < 32; i++)
+			{
+				start_volumes[i] = previous_volumes[i];
+				if (previous_volumes[i] != volumes[i])
+					ramp = true;
+				previous_volumes[i] = volumes[i];
+			}
+		}
+
+		/// \brief Sets the same volume for all speakers
+		void set_volume(float volume) { for (auto & elem : volumes) elem = volume; }
+
+		/// \brief Sets the volume for all speakers, attenuating the left or right side speakers by the panning position
+		void set_volume(float volume, float pan)
+		{
+			const SpeakerPositionMask left_speakers = cl_speaker_front_left | cl_speaker_back_left | cl_speaker_front_left_of_center | cl_speaker_side_left | cl_speaker_top_front_left | cl_speaker_top_back_left;
+			const SpeakerPositionMask right_speakers = cl_speaker_front_right | cl_speaker_back_right | cl_speaker_front_right_of_center | cl_speaker_side_right | cl_speaker_top_front_right | cl_speaker_top_back_right;
+
+			float left_pan = 1 - pan;
+			float right_pan = 1 + pan;
+			if (left_pan < 0.0f) left_pan = 0.0f;
+			if (left_pan > 1.0f) left_pan = 1.0f;
+			if (right_pan < 0.0f) right_pan = 0.0f;
+			if (right_pan > 1.0f) right_pan = 1.0f;
+			if (volume < 0.0f) volume = 0.0f;
+			if (volume > 1.0f) volume = 1.0f;
+
+			for (int i = 0; i < 32; i++)
+			{
+				if ((left_speakers >> i) & 1)
+					volumes[i] = volume * left_pan;
+				else if ((right_speakers >> i) & 1)
+					volumes[i] = volume * right_pan;
+				else
+					volumes[i] = volume;
+			}
+		}
+
+		/// \brief Spreads the input over the output speakers and pans it towards a direction around the listener
+		///
+		/// Pan is the left to right and depth the front to back component of the direction. The input
+		/// is panned between the two speakers nearest to the direction, and is heard from all speakers
+		/// as the direction shrinks towards zero length.
+		void set_volume(float volume, float pan, float depth, SpeakerPositionMask output_speakers);
+
+		/// \brief Returns true if the layout has speakers beside or behind the listener
+		static bool is_surround(SpeakerPositionMask speakers)
+		{
+			return (speakers & (cl_speaker_back_left | cl_speaker_back_right | cl_speaker_back_center | cl_speaker_side_left | cl_speaker_side_right)) != 0;
+		}
+	};
+}
@@ -0,0 +1,587 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_resampler.h"
+#include "API/Sound/sound_sse.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	/// \brief Polyphase windowed sinc coefficients for one cutoff frequency
+	///
+	/// Row r holds the taps for a read position r/sinc_phases past an input sample. Tap k
+	/// is applied to the input sample at offset k - (sinc_taps / 2 - 1) from the read position.
+	class SoundResampler::SincTable
+	{
+	public:
+		SincTable(double cutoff) : coefficients((sinc_phases + 1) * sinc_taps)
+		{
+			const double pi = 3.14159265358979323846;
+			const double half_width = sinc_taps / 2;
+			for (int row = 0; row <= sinc_phases; row++)
+			{
+				double fraction = row / (double)sinc_phases;
+				float *taps = &coefficients[row * sinc_taps];
+
+				double sum = 0.0;
+				for (int k = 0; k < sinc_taps; k++)
+				{
+					double t = (k - (sinc_taps / 2 - 1)) - fraction;
+					double x = cutoff * t;
+					double sinc = (x == 0.0) ? 1.0 : std::sin(pi * x) / (pi * x);
+					double window = (std::abs(t) >= half_width) ? 0.0 : 0.42 + 0.5 * std::cos(pi * t / half_width) + 0.08 * std::cos(2.0 * pi * t / half_width);
+					double value = cutoff * sinc * window;
+					taps[k] = (float)value;
+					sum += value;
+				}
+
+				// Normalize each phase to unity gain so that DC passes unchanged
+				for (int k = 0; k < sinc_taps; k++)
+					taps[k] = (float)(taps[k] / sum);
+			}
+		}
+
+		/// \brief Returns the row at or below fraction. The taps for fraction lie between it and the next row, phase_fraction of the way.
+		const float *get_taps(float fraction, float &phase_fraction) const
+		{
+			float phase = fraction * sinc_phases;
+			int row = (int)phase;
+			if (row >= sinc_phases)
+				row = sinc_phases - 1;
+			phase_fraction = phase - row;
+			return &coefficients[row * sinc_taps];
+		}
+
+	private:
+		std::vector<float> coefficients;
+	};
+
+	SoundResampler::SoundResampler(int num_channels)
+		: num_channels(num_channels), channels(num_channels), attached(false), read_pos(history), write_pos(history), fraction(0.0), flushed(false), quality(cl_resample_linear), sinc_table_ratio(0.0)
+	{
+	}
+
+	SoundResampler::~SoundResampler()
+	{
+		for (auto & buffer : buffers)
+			free_buffer(buffer);
+	}
+
+	void SoundResampler::set_quality(SoundResampleQuality new_quality)
+	{
+		quality = new_quality;
+	}
+
+	int SoundResampler::get_input_space()
+	{
+		// Keep the attached window small enough to fit the channel buffers if it is detached later
+		if (attached)
+			return buffer_size - history - (write_pos - read_pos);
+
+		allocate_buffers();
+
+		// Move the unread samples and the history needed by the kernels to the start of the buffers
+		int keep_from = read_pos - history;
+		if (keep_from > 0 && buffer_size - write_pos < buffer_size / 2)
+		{
+			for (auto & buffer : buffers)
+				memmove(buffer, buffer + keep_from, sizeof(float) * (write_pos - keep_from));
+			read_pos -= keep_from;
+			write_pos -= keep_from;
+		}
+		return buffer_size - write_pos;
+	}
+
+	void SoundResampler::input_written(int sample_count)
+	{
+		write_pos += sample_count;
+	}
+
+	void SoundResampler::flush()
+	{
+		if (flushed)
+			return;
+
+		// Attached data is already padded with silence
+		if (attached)
+		{
+			write_pos += history;
+			flushed = true;
+			return;
+		}
+
+		int padding = std::min((int)history, get_input_space());
+		for (auto & buffer : buffers)
+			SoundSSE::set_float(buffer + write_pos, padding, 0.0f);
+		write_pos += padding;
+		flushed = true;
+	}
+
+	void SoundResampler::reset()
+	{
+		attached = false;
+		for (int c = 0; c < (int)buffers.size(); c++)
+		{
+			SoundSSE::set_float(buffers[c], history, 0.0f);
+			channels[c] = buffers[c];
+		}
+		read_pos = history;
+		write_pos = history;
+		fraction = 0.0;
+		flushed = false;
+	}
+
+	void SoundResampler::attach(const float *const *data, int position)
+	{
+		attached = true;
+		for (int c = 0; c < num_channels; c++)
+			channels[c] = data[c] - history;
+		read_pos = history + position;
+		write_pos = read_pos;
+		fraction = 0.0;
+		flushed = false;
+	}
+
+	void SoundResampler::detach()
+	{
+		if (!attached)
+			return;
+
+		allocate_buffers();
+
+		int keep_from = read_pos - history;
+		int count = std::min(write_pos - keep_from, (int)buffer_size);
+		for (int c = 0; c < num_channels; c++)
+		{
+			SoundSSE::copy_float(channels[c] + keep_from, count, buffers[c]);
+			channels[c] = buffers[c];
+		}
+		read_pos -= keep_from;
+		write_pos = count;
+		attached = false;
+	}
+
+	void SoundResampler::allocate_buffers()
+	{
+		if (!buffers.empty())
+			return;
+
+		for (int c = 0; c < num_channels; c++)
+		{
+			float *buffer = alloc_buffer();
+			SoundSSE::set_float(buffer, history, 0.0f);
+			buffers.push_back(buffer);
+			if (!attached)
+				channels[c] = buffer;
+		}
+	}
+
+	int SoundResampler::process(float **output, int num_output_channels, int output_offset, int sample_count, double ratio)
+	{
+		if (quality == cl_resample_sinc && (!sinc_table || sinc_table_ratio != ratio))
+		{
+			sinc_table = get_sinc_table(ratio);
+			sinc_table_ratio = ratio;
+		}
+
+		int produced = 0;
+		while (produced < sample_count)
+		{
+			int count;
+			if (ratio == 1.0 && fraction == 0.0)
+				count = process_copy(output, num_output_channels, output_offset + produced, sample_count - produced);
+			else if (ratio == 2.0 && fraction == 0.0 && quality != cl_resample_sinc)
+				count = process_decimate(output, num_output_channels, output_offset + produced, sample_count - produced);
+			else if (ratio == 0.5 && fraction == 0.0 && quality != cl_resample_sinc)
+				count = process_double(output, num_output_channels, output_offset + produced, sample_count - produced);
+			else
+				count = process_block(output, num_output_channels, output_offset + produced, sample_count - produced, ratio);
+
+			if (count == 0)
+				break;
+			produced += count;
+		}
+		return produced;
+	}
+
+	int SoundResampler::get_lookahead() const
+	{
+		switch (quality)
+		{
+		default:
+		case cl_resample_nearest: return 0;
+		case cl_resample_linear: return 1;
+		case cl_resample_cubic: return 2;
+		case cl_resample_sinc: return sinc_taps / 2;
+		}
+	}
+
+	int SoundResampler::process_copy(float **output, int num_output_channels, int output_offset, int sample_count)
+	{
+		// Every kernel returns the input sample itself at whole sample positions
+		int count = std::min(sample_count, write_pos - read_pos);
+		if (count <= 0)
+			return 0;
+
+		int copy_channels = std::min(num_channels, num_output_channels);
+		for (int c = 0; c < copy_channels; c++)
+			SoundSSE::copy_float(channels[c] + read_pos, count, output[c] + output_offset);
+
+		read_pos += count;
+		return count;
+	}
+
+	int SoundResampler::process_decimate(float **output, int num_output_channels, int output_offset, int sample_count)
+	{
+		// Every other input sample. Only used by the kernels that do not low-pass filter.
+		int count = std::min(sample_count, (write_pos - read_pos + 1) / 2);
+		if (count <= 0)
+			return 0;
+
+		int copy_channels = std::min(num_channels, num_output_channels);
+		for (int c = 0; c < copy_channels; c++)
+		{
+			const float *input = channels[c] + read_pos;
+			float *out = output[c] + output_offset;
+
+#ifndef CL_DISABLE_SSE2
+			int sse_size = ((count - 1) / 4) * 4;
+			for (int i = 0; i < sse_size; i += 4)
+			{
+				__m128 samples0 = _mm_loadu_ps(input + i * 2);
+				__m128 samples1 = _mm_loadu_ps(input + i * 2 + 4);
+				_mm_storeu_ps(out + i, _mm_shuffle_ps(samples0, samples1, _MM_SHUFFLE(2, 0, 2, 0)));
+			}
+#else
+			const int sse_size = 0;
+#endif
+			for (int i = sse_size; i < count; i++)
+				out[i] = input[i * 2];
+		}
+
+		read_pos += count * 2;
+		return count;
+	}
+
+	int SoundResampler::process_double(float **output, int num_output_channels, int output_offset, int sample_count)
+	{
+		// Each input sample followed by the interpolated sample halfway to the next one
+		int pairs = std::min(sample_count / 2, write_pos - get_lookahead() - read_pos);
+		if (pairs <= 0)
+			return process_block(output, num_output_channels, output_offset, sample_count, 0.5);
+
+		int copy_channels = std::min(num_channels, num_output_channels);
+		for (int c = 0; c < copy_channels; c++)
+		{
+			const float *input = channels[c] + read_pos;
+			float *out = output[c] + output_offset;
+
+			int sse_size = 0;
+#ifndef CL_DISABLE_SSE2
+			sse_size = (pairs / 4) * 4;
+			__m128 half = _mm_set1_ps(0.5f);
+			__m128 cubic_outer = _mm_set1_ps(-1.0f / 16.0f);
+			__m128 cubic_inner = _mm_set1_ps(9.0f / 16.0f);
+			for (int i = 0; i < sse_size; i += 4)
+			{
+				__m128 x1 = _mm_loadu_ps(input + i);
+				__m128 mid;
+				if (quality == cl_resample_linear)
+				{
+					__m128 x2 = _mm_loadu_ps(input + i + 1);
+					mid = _mm_mul_ps(_mm_add_ps(x1, x2), half);
+				}
+				else if (quality == cl_resample_cubic)
+				{
+					__m128 x0 = _mm_loadu_ps(input + i - 1);
+					__m128 x2 = _mm_loadu_ps(input + i + 1);
+					__m128 x3 = _mm_loadu_ps(input + i + 2);
+					mid = _mm_add_ps(_mm_mul_ps(_mm_add_ps(x1, x2), cubic_inner), _mm_mul_ps(_mm_add_ps(x0, x3), cubic_outer));
+				}
+				else
+				{
+					mid = x1;
+				}
+				_mm_storeu_ps(out + i * 2, _mm_unpacklo_ps(x1, mid));
+				_mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(x1, mid));
+			}
+#endif
+			for (int i = sse_size; i < pairs; i++)
+			{
+				float mid;
+				if (quality == cl_resample_linear)
+					mid = (input[i] + input[i + 1]) * 0.5f;
+				else if (quality == cl_resample_cubic)
+					mid = (input[i] + input[i + 1]) * (9.0f / 16.0f) - (input[i - 1] + input[i + 2]) * (1.0f / 16.0f);
+				else
+					mid = input[i];
+				out[i * 2] = input[i];
+				out[i * 2 + 1] = mid;
+			}
+		}
+
+		read_pos += pairs;
+		return pairs * 2;
+	}
+
+	int SoundResampler::process_block(float **output, int num_output_channels, int output_offset, int sample_count, double ratio)
+	{
+		int lookahead = get_lookahead();
+
+		// Without output channels only the read position has to move. Find where it ends up directly.
+		if (num_output_channels == 0)
+		{
+			int available = write_pos - lookahead - read_pos;
+			if (available <= 0)
+				return 0;
+
+			int count = std::min(sample_count, (int)std::ceil((available - fraction) / ratio));
+			double end = fraction + count * ratio;
+			int step = (int)end;
+			read_pos += step;
+			fraction = end - step;
+			return count;
+		}
+
+		// Find the read positions for the block once for all channels
+		int max_count = std::min(sample_count, (int)block_size);
+		int pos = read_pos;
+		double frac = fraction;
+		int count;
+		for (count = 0; count < max_count && pos + lookahead < write_pos; count++)
+		{
+			block_positions[count] = pos;
+			block_fractions[count] = (float)frac;
+			frac += ratio;
+			int step = (int)frac;
+			pos += step;
+			frac -= step;
+		}
+
+		if (count == 0)
+			return 0;
+
+		int process_channels = std::min(num_channels, num_output_channels);
+		for (int c = 0; c < process_channels; c++)
+		{
+			float *out = output[c] + output_offset;
+			switch (quality)
+			{
+			case cl_resample_nearest: nearest(channels[c], block_positions, count, out); break;
+			case cl_resample_linear: linear(channels[c], block_positions, block_fractions, count, out); break;
+			case cl_resample_cubic: cubic(channels[c], block_positions, block_fractions, count, out); break;
+			case cl_resample_sinc: sinc(channels[c], block_positions, block_fractions, count, *sinc_table, out); break;
+			}
+		}
+
+		read_pos = pos;
+		fraction = frac;
+		return count;
+	}
+
+	void SoundResampler::nearest(const float *input, const int *positions, int count, float *output)
+	{
+		for (int i = 0; i < count; i++)
+			output[i] = input[positions[i]];
+	}
+
+	void SoundResampler::linear(const float *input, const int *positions, const float *fractions, int count, float *output)
+	{
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (count / 4) * 4;
+		for (int i = 0; i < sse_size; i += 4)
+		{
+			const int *p = positions + i;
+			__m128 x0 = _mm_set_ps(input[p[3]], input[p[2]], input[p[1]], input[p[0]]);
+			__m128 x1 = _mm_set_ps(input[p[3] + 1], input[p[2] + 1], input[p[1] + 1], input[p[0] + 1]);
+			__m128 t = _mm_loadu_ps(fractions + i);
+			_mm_storeu_ps(output + i, _mm_add_ps(x0, _mm_mul_ps(t, _mm_sub_ps(x1, x0))));
+		}
+#else
+		const int sse_size = 0;
+#endif
+		for (int i = sse_size; i < count; i++)
+		{
+			const float *x = input + positions[i];
+			output[i] = x[0] + fractions[i] * (x[1] - x[0]);
+		}
+	}
+
+	void SoundResampler::cubic(const float *input, const int *positions, const float *fractions, int count, float *output)
+	{
+		// Catmull-Rom spline through the two samples on each side of the read position
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (count / 4) * 4;
+		__m128 half = _mm_set1_ps(0.5f);
+		__m128 two = _mm_set1_ps(2.0f);
+		__m128 three = _mm_set1_ps(3.0f);
+		__m128 four = _mm_set1_ps(4.0f);
+		__m128 five = _mm_set1_ps(5.0f);
+		for (int i = 0; i < sse_size; i += 4)
+		{
+			const int *p = positions + i;
+			__m128 x0 = _mm_set_ps(input[p[3] - 1], input[p[2] - 1], input[p[1] - 1], input[p[0] - 1]);
+			__m128 x1 = _mm_set_ps(input[p[3]], input[p[2]], input[p[1]], input[p[0]]);
+			__m128 x2 = _mm_set_ps(input[p[3] + 1], input[p[2] + 1], input[p[1] + 1], input[p[0] + 1]);
+			__m128 x3 = _mm_set_ps(input[p[3] + 2], input[p[2] + 2], input[p[1] + 2], input[p[0] + 2]);
+			__m128 t = _mm_loadu_ps(fractions + i);
+
+			__m128 a = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(three, _mm_sub_ps(x1, x2)), x3), x0);
+			__m128 b = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(two, x0), _mm_mul_ps(five, x1)), _mm_mul_ps(four, x2)), x3);
+			__m128 c = _mm_sub_ps(x2, x0);
+			__m128 v = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, t), b), t), c);
+			_mm_storeu_ps(output + i, _mm_add_ps(x1, _mm_mul_ps(_mm_mul_ps(half, t), v)));
+		}
+#else
+		const int sse_size = 0;
+#endif
+		for (int i = sse_size; i < count; i++)
+		{
+			const float *x = input + positions[i];
+			float t = fractions[i];
+			float a = 3.0f * (x[0] - x[1]) + x[2] - x[-1];
+			float b = 2.0f * x[-1] - 5.0f * x[0] + 4.0f * x[1] - x[2];
+			float c = x[1] - x[-1];
+			output[i] = x[0] + 0.5f * t * ((a * t + b) * t + c);
+		}
+	}
+
+	void SoundResampler::sinc(const float *input, const int *positions, const float *fractions, int count, const SincTable &table, float *output)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const float *x = input + positions[i] - (sinc_taps / 2 - 1);
+			float t;
+			const float *taps = table.get_taps(fractions[i], t);
+			const float *next_taps = taps + sinc_taps;
+
+			// Sum the two neighbouring phases separately and interpolate the results
+#ifndef CL_DISABLE_SSE2
+			__m128 sum0 = _mm_setzero_ps();
+			__m128 sum1 = _mm_setzero_ps();
+			for (int k = 0; k < sinc_taps; k += 4)
+			{
+				__m128 samples = _mm_loadu_ps(x + k);
+				sum0 = _mm_add_ps(sum0, _mm_mul_ps(samples, _mm_loadu_ps(taps + k)));
+				sum1 = _mm_add_ps(sum1, _mm_mul_ps(samples, _mm_loadu_ps(next_taps + k)));
+			}
+			__m128 sum = _mm_add_ps(sum0, _mm_mul_ps(_mm_sub_ps(sum1, sum0), _mm_set1_ps(t)));
+			sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+			sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+			output[i] = _mm_cvtss_f32(sum);
+#else
+			float sum0 = 0.0f;
+			float sum1 = 0.0f;
+			for (int k = 0; k < sinc_taps; k++)
+			{
+				sum0 += x[k] * taps[k];
+				sum1 += x[k] * next_taps[k];
+			}
+			output[i] = sum0 + (sum1 - sum0) * t;
+#endif
+		}
+	}
+
+	std::shared_ptr<const SoundResampler::SincTable> SoundResampler::get_sinc_table(double ratio)
+	{
+		// Low-pass below the Nyquist frequency of the lower of the two rates.
+		// Tables are shared by all sessions using the same cutoff.
+		double cutoff = 0.95 * std::min(1.0, 1.0 / ratio);
+		int key = (int)(cutoff * 1024.0 + 0.5);
+
+		static std::mutex mutex;
+		static std::map<int, std::weak_ptr<const SincTable> > tables;
+
+		std::unique_lock<std::mutex> lock(mutex);
+		std::shared_ptr<const SincTable> table = tables[key].lock();
+		if (!table)
+		{
+			table = std::make_shared<SincTable>(key / 1024.0);
+			tables[key] = table;
+		}
+		return table;
+	}
+
+	/// \brief Channel buffers returned by sessions that ended, so new sessions do not have to allocate
+	class SoundResamplerBufferPool
+	{
+	public:
+		~SoundResamplerBufferPool()
+		{
+			for (auto & buffer : buffers)
+				SoundSSE::aligned_free(buffer);
+		}
+
+		std::mutex mutex;
+		std::vector<float *> buffers;
+	};
+
+	static SoundResamplerBufferPool &get_buffer_pool()
+	{
+		static SoundResamplerBufferPool pool;
+		return pool;
+	}
+
+	float *SoundResampler::alloc_buffer()
+	{
+		SoundResamplerBufferPool &pool = get_buffer_pool();
+		std::unique_lock<std::mutex> lock(pool.mutex);
+		if (!pool.buffers.empty())
+		{
+			float *buffer = pool.buffers.back();
+			pool.buffers.pop_back();
+			return buffer;
+		}
+		lock.unlock();
+
+		return (float *)SoundSSE::aligned_alloc(sizeof(float) * buffer_size);
+	}
+
+	void SoundResampler::free_buffer(float *buffer)
+	{
+		SoundResamplerBufferPool &pool = get_buffer_pool();
+		std::unique_lock<std::mutex> lock(pool.mutex);
+		if ((int)pool.buffers.size() < max_pooled_buffers)
+		{
+			pool.buffers.push_back(buffer);
+			return;
+		}
+		lock.unlock();
+
+		SoundSSE::aligned_free(buffer);
+	}
+}
@@ -0,0 +1,146 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/soundbuffer_session.h"
+#include <memory>
+#include <vector>
+
+namespace clan
+{
+	/// \brief Streaming sample rate converter for the channels of a sound session
+	///
+	/// Input is written directly into the resampler's channel buffers, which keep enough
+	/// history and lookahead around the read position for the interpolation kernel.
+	/// Alternatively the resampler can be attached to fully decoded sample data, which it then
+	/// reads in place. The channel buffers are taken from a shared pool when first needed.
+	/// Output is produced in blocks: the read positions for a block are computed once and
+	/// then every channel is run through a SIMD kernel.
+	class SoundResampler
+	{
+	public:
+		SoundResampler(int num_channels);
+		~SoundResampler();
+
+		SoundResampleQuality get_quality() const { return quality; }
+		void set_quality(SoundResampleQuality quality);
+
+		/// \brief Returns how many samples of silence attached data must have before the first and after the last sample
+		static int get_input_padding() { return history; }
+
+		/// \brief Reads input directly from decoded sample data instead of the channel buffers
+		///
+		/// Input is committed with input_written as usual, but nothing is written to get_input.
+		/// \param data Start of each channel. Each channel must be padded with get_input_padding() samples of silence at both ends.
+		/// \param position Sample to start reading from
+		void attach(const float *const *data, int position);
+
+		/// \brief Copies the unread part of the attached data into the channel buffers and stops reading from it
+		void detach();
+
+		/// \brief Returns true if input is read from attached data
+		bool is_attached() const { return attached; }
+
+		/// \brief Returns how many samples can be written to the input buffers, or committed from attached data
+		int get_input_space();
+
+		/// \brief Returns the write position in the input buffer of a channel
+		float *get_input(int channel) { return buffers[channel] + write_pos; }
+
+		/// \brief Commits samples written to the input buffers
+		void input_written(int sample_count);
+
+		/// \brief Pads the input with silence so the last input samples can be played
+		void flush();
+
+		/// \brief Returns true if flush was called
+		bool is_flushed() const { return flushed; }
+
+		/// \brief Discards all buffered input and detaches from attached data
+		void reset();
+
+		/// \brief Resamples buffered input
+		///
+		/// \param output Output channels
+		/// \param num_output_channels Number of output channels. Extra input channels are skipped. With none, input is only consumed.
+		/// \param output_offset Position in the output channels to start writing at
+		/// \param sample_count Maximum number of samples to write
+		/// \param ratio Input frequency divided by output frequency
+		/// \return Number of samples written. Less than sample_count means more input is needed.
+		int process(float **output, int num_output_channels, int output_offset, int sample_count, double ratio);
+
+	private:
+		class SincTable;
+
+		int get_lookahead() const;
+		int process_copy(float **output, int num_output_channels, int output_offset, int sample_count);
+		int process_decimate(float **output, int num_output_channels, int output_offset, int sample_count);
+		int process_double(float **output, int num_output_channels, int output_offset, int sample_count);
+		int process_block(float **output, int num_output_channels, int output_offset, int sample_count, double ratio);
+
+		static void nearest(const float *input, const int *positions, int count, float *output);
+		static void linear(const float *input, const int *positions, const float *fractions, int count, float *output);
+		static void cubic(const float *input, const int *positions, const float *fractions, int count, float *output);
+		static void sinc(const float *input, const int *positions, const float *fractions, int count, const SincTable &table, float *output);
+
+		static std::shared_ptr<const SincTable> get_sinc_table(double ratio);
+
+		/// \brief Takes the channel buffers from the pool the first time they are needed
+		void allocate_buffers();
+
+		static float *alloc_buffer();
+		static void free_buffer(float *buffer);
+
+		enum
+		{
+			buffer_size = 16 * 1024,
+			block_size = 256,
+			sinc_taps = 32,
+			sinc_phases = 256,
+			history = sinc_taps / 2,
+			max_pooled_buffers = 256
+		};
+
+		int num_channels;
+		std::vector<float *> buffers;
+		std::vector<const float *> channels;
+		bool attached;
+		int read_pos;
+		int write_pos;
+		double fraction;
+		bool flushed;
+		SoundResampleQuality quality;
+
+		std::shared_ptr<const SincTable> sinc_table;
+		double sinc_table_ratio;
+
+		int block_positions[block_size];
+		float block_fractions[block_size];
+	};
+}
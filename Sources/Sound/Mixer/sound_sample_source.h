@@ -28,14 +28,27 @@
 
 #pragma once
 
+#include "API/Sound/speaker_position.h"
+
 namespace clan
 {
-	class SoundMixingBuffersData;
+	class SoundMixingInput;
 
+	/// \brief Node in the mixing graph
 	class SoundSampleSource
 	{
 	public:
-		virtual int get_frequency() const = 0;
-		virtual void get_data(SoundMixingBuffersData &output, int sample_count) = 0;
+		virtual ~SoundSampleSource() { }
+
+		/// \brief Renders the next block of samples at the mixing frequency
+		///
+		/// A source that is silent for the block may leave output.speakers empty, and nothing is mixed.
+		///
+		/// \param output Receives the channels, their speakers and the volume for each output speaker
+		/// \param output_speakers Speakers of the mixer the source is mixed into
+		/// \param temp SoundMixer::max_source_channels scratch channels the source may render into
+		/// \param sample_count Number of samples to render
+		/// \return false if the source finished playing and should be removed from the mixer
+		virtual bool get_data(SoundMixingInput &output, SpeakerPositionMask output_speakers, float **temp, int sample_count) = 0;
 	};
 }
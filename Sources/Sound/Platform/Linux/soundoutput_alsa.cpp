@@ -32,6 +32,8 @@
 #include <API/Core/System/exception.h>
 #include "API/Core/System/system.h"
 #include "API/Core/Text/logger.h"
+#include <algorithm>
+#include <cerrno>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
@@ -41,46 +43,44 @@
 namespace clan
 {
 
+// Underruns closer together than this (in milliseconds) make the period grow
+static const uint64_t underrun_window = 5000;
+
+// Time without underruns (in milliseconds) before the period shrinks back towards the requested size
+static const uint64_t stable_time = 30000;
+
+// Largest period (in frames) the adaptive buffering may grow to
+static const snd_pcm_uframes_t max_period = 8192;
+
 /////////////////////////////////////////////////////////////////////////////
 // SoundOutput_alsa construction:
 
-SoundOutput_alsa::SoundOutput_alsa(int mixing_frequency, int mixing_latency) :
-	SoundOutput_Impl(mixing_frequency, mixing_latency), frames_in_buffer(4096),
-	frames_in_period(1024)
+SoundOutput_alsa::SoundOutput_alsa(int mixing_frequency, int mixing_latency, const std::string &device_name) :
+	SoundOutput_Impl(mixing_frequency, mixing_latency), handle(nullptr), frames_in_period(0),
+	frames_in_buffer(0), mmap_access(false), requested_period(0), mapped_offset(0), mapped_fragment(nullptr),
+	first_underrun_time(0), last_underrun_time(0), recent_underruns(0)
 {
-	int rc;
-	snd_pcm_hw_params_t *hwparams;
-	
-	rc = snd_pcm_open(&handle, "default", SND_PCM_STREAM_PLAYBACK, 0);
+	std::string name = device_name.empty() ? "default" : device_name;
+
+	int rc = snd_pcm_open(&handle, name.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
 	if (rc < 0)
 	{
-		log_event("warn", "ClanSound: Couldn't open sound device, disabling sound");
+		log_event("warn", "ClanSound: Couldn't open sound device %1, disabling sound", name);
 		handle = nullptr;
 		return;
 	}
 
-	snd_pcm_hw_params_alloca(&hwparams);
-	snd_pcm_hw_params_any(handle, hwparams);
-	snd_pcm_hw_params_set_access(handle, hwparams, SND_PCM_ACCESS_RW_INTERLEAVED);
-	snd_pcm_hw_params_set_format(handle, hwparams, SND_PCM_FORMAT_FLOAT);
-	snd_pcm_hw_params_set_channels(handle, hwparams, 2);
-	snd_pcm_hw_params_set_rate_near(handle, hwparams,
-				(unsigned int *)&this->mixing_frequency, nullptr);
-	snd_pcm_hw_params_set_buffer_size_near(handle, hwparams, &frames_in_buffer);
-	frames_in_period = frames_in_buffer / 4;
-	snd_pcm_hw_params_set_period_size_near(handle, hwparams, &frames_in_period, nullptr);
-	
-	rc = snd_pcm_hw_params(handle, hwparams);
-	if (rc < 0)
+	// Two periods per buffer: the device plays one while the mixer fills the other
+	requested_period = std::max(mixing_frequency * mixing_latency / 2000, 64);
+	if (!configure(requested_period))
 	{
 		log_event("warn", "ClanSound: Couldn't initialize sound device, disabling sound");
 		snd_pcm_close(handle);
 		handle = nullptr;
 		return;
 	}
-	
-	snd_pcm_hw_params_get_period_size(hwparams, &frames_in_period, nullptr);
 
+	last_underrun_time = System::get_time();
 	start_mixer_thread();
 }
 
@@ -125,27 +125,81 @@ int SoundOutput_alsa::get_fragment_size()
 	return frames_in_period;
 }
 
+float *SoundOutput_alsa::lock_fragment()
+{
+	mapped_fragment = nullptr;
+	if (handle == nullptr || !mmap_access)
+		return nullptr;
+
+	prepare_stream();
+
+	snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+	if (avail < 0)
+	{
+		recover(avail);
+		return nullptr;
+	}
+
+	// Without a free period write_fragment blocks in snd_pcm_mmap_writei instead
+	if (avail < (snd_pcm_sframes_t)frames_in_period)
+		return nullptr;
+
+	const snd_pcm_channel_area_t *areas = nullptr;
+	snd_pcm_uframes_t offset = 0;
+	snd_pcm_uframes_t frames = frames_in_period;
+	int rc = snd_pcm_mmap_begin(handle, &areas, &offset, &frames);
+	if (rc < 0)
+	{
+		recover(rc);
+		return nullptr;
+	}
+
+	// Mix in place only when the period does not wrap around the end of the ring buffer,
+	// and the two channels are packed the way the mixer interleaves them
+	bool interleaved = areas[0].addr == areas[1].addr && areas[0].step == 64 && areas[1].step == 64 &&
+		areas[1].first == areas[0].first + 32 && (areas[0].first % 8) == 0;
+	if (frames < frames_in_period || !interleaved)
+	{
+		snd_pcm_mmap_commit(handle, offset, 0);
+		return nullptr;
+	}
+
+	mapped_offset = offset;
+	mapped_fragment = reinterpret_cast<float *>(static_cast<char *>(areas[0].addr) + areas[0].first / 8) + offset * 2;
+	return mapped_fragment;
+}
+
 void SoundOutput_alsa::write_fragment(float *data)
 {
 	snd_pcm_sframes_t rc;
 
 	if (handle == nullptr) return;
 
-	switch(snd_pcm_state(handle)) {
-		case SND_PCM_STATE_XRUN:
-		case SND_PCM_STATE_SUSPENDED:
-			snd_pcm_prepare(handle);
-			break;
-		case SND_PCM_STATE_PAUSED:
-			snd_pcm_pause(handle, 0);
-			break;
-		default:
-			break;
+	if (mapped_fragment && data == mapped_fragment)
+	{
+		// The mixer wrote straight into the device buffer
+		mapped_fragment = nullptr;
+		rc = snd_pcm_mmap_commit(handle, mapped_offset, frames_in_period);
+		if (rc >= 0)
+			start_stream();
+	}
+	else
+	{
+		prepare_stream();
+		if (mmap_access)
+			rc = snd_pcm_mmap_writei(handle, data, frames_in_period);
+		else
+			rc = snd_pcm_writei(handle, data, frames_in_period);
 	}
 
-	rc = snd_pcm_writei(handle, data, frames_in_period);
 	if (rc < 0)
-		log_event("debug", "ClanSound: snd_pcm_writei() failed!");
+	{
+		log_event("debug", "ClanSound: Writing to the sound device failed: %1", snd_strerror(rc));
+		recover(rc);
+	}
+
+	update_latency();
+	adapt_period();
 }
 
 void SoundOutput_alsa::wait()
@@ -162,6 +216,142 @@ void SoundOutput_alsa::wait()
 /////////////////////////////////////////////////////////////////////////////
 // SoundOutput_alsa implementation:
 
+bool SoundOutput_alsa::configure(snd_pcm_uframes_t period)
+{
+	snd_pcm_hw_params_t *hwparams;
+	snd_pcm_sw_params_t *swparams;
+	snd_pcm_hw_params_alloca(&hwparams);
+	snd_pcm_sw_params_alloca(&swparams);
+
+	snd_pcm_hw_params_any(handle, hwparams);
+
+	// Prefer mmap so the mixer can write into the device buffer without a copy
+	mmap_access = snd_pcm_hw_params_set_access(handle, hwparams, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+	if (!mmap_access && snd_pcm_hw_params_set_access(handle, hwparams, SND_PCM_ACCESS_RW_INTERLEAVED) < 0)
+		return false;
+
+	if (snd_pcm_hw_params_set_format(handle, hwparams, SND_PCM_FORMAT_FLOAT) < 0)
+		return false;
+	if (snd_pcm_hw_params_set_channels(handle, hwparams, 2) < 0)
+		return false;
+
+	unsigned int rate = mixing_frequency;
+	snd_pcm_hw_params_set_rate_near(handle, hwparams, &rate, nullptr);
+	mixing_frequency = rate;
+
+	unsigned int periods = 2;
+	frames_in_period = period;
+	snd_pcm_hw_params_set_period_size_near(handle, hwparams, &frames_in_period, nullptr);
+	snd_pcm_hw_params_set_periods_near(handle, hwparams, &periods, nullptr);
+
+	if (snd_pcm_hw_params(handle, hwparams) < 0)
+		return false;
+
+	snd_pcm_hw_params_get_period_size(hwparams, &frames_in_period, nullptr);
+	snd_pcm_hw_params_get_buffer_size(hwparams, &frames_in_buffer);
+
+	// Start playing once all but one period is queued, and wake the mixer when a whole period is free
+	snd_pcm_sw_params_current(handle, swparams);
+	snd_pcm_sw_params_set_start_threshold(handle, swparams, frames_in_buffer - frames_in_period);
+	snd_pcm_sw_params_set_avail_min(handle, swparams, frames_in_period);
+	if (snd_pcm_sw_params(handle, swparams) < 0)
+		return false;
+
+	output_latency = (int)((int64_t)frames_in_buffer * 1000000 / mixing_frequency);
+	return true;
+}
+
+void SoundOutput_alsa::prepare_stream()
+{
+	switch(snd_pcm_state(handle)) {
+		case SND_PCM_STATE_XRUN:
+			recover(-EPIPE);
+			break;
+		case SND_PCM_STATE_SUSPENDED:
+			recover(-ESTRPIPE);
+			break;
+		case SND_PCM_STATE_PAUSED:
+			snd_pcm_pause(handle, 0);
+			break;
+		default:
+			break;
+	}
+}
+
+void SoundOutput_alsa::start_stream()
+{
+	// snd_pcm_writei starts the stream at the start threshold, but committing mapped frames does not
+	if (snd_pcm_state(handle) != SND_PCM_STATE_PREPARED)
+		return;
+
+	snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+	if (avail >= 0 && avail <= (snd_pcm_sframes_t)frames_in_period)
+	{
+		int rc = snd_pcm_start(handle);
+		if (rc < 0)
+			log_event("debug", "ClanSound: Couldn't start sound device: %1", snd_strerror(rc));
+	}
+}
+
+void SoundOutput_alsa::recover(int error)
+{
+	if (error == -EPIPE)
+	{
+		underruns++;
+
+		uint64_t now = System::get_time();
+		if (recent_underruns == 0 || now - first_underrun_time > underrun_window)
+		{
+			first_underrun_time = now;
+			recent_underruns = 0;
+		}
+		recent_underruns++;
+		last_underrun_time = now;
+	}
+
+	if (snd_pcm_recover(handle, error, 1) < 0)
+		log_event("debug", "ClanSound: Couldn't recover sound device: %1", snd_strerror(error));
+}
+
+void SoundOutput_alsa::update_latency()
+{
+	snd_pcm_sframes_t delay = 0;
+	if (snd_pcm_delay(handle, &delay) == 0 && delay >= 0)
+		output_latency = (int)((int64_t)delay * 1000000 / mixing_frequency);
+}
+
+void SoundOutput_alsa::adapt_period()
+{
+	uint64_t now = System::get_time();
+	snd_pcm_uframes_t period = frames_in_period;
+
+	if (recent_underruns >= 2 && frames_in_period < max_period)
+		period = std::min(frames_in_period * 2, max_period);
+	else if (frames_in_period > requested_period && now - last_underrun_time > stable_time)
+		period = std::max(frames_in_period / 2, requested_period);
+
+	if (period == frames_in_period)
+		return;
+
+	// Reconfiguring drops the queued periods, which costs one short gap. The mixer picks up
+	// the new size through get_fragment_size() on its next fragment.
+	snd_pcm_uframes_t old_period = frames_in_period;
+	snd_pcm_drop(handle);
+	if (configure(period))
+	{
+		log_event("debug", "ClanSound: Changed sound device period from %1 to %2 frames", (int)old_period, (int)frames_in_period);
+	}
+	else if (!configure(old_period))
+	{
+		log_event("warn", "ClanSound: Couldn't reconfigure sound device, disabling sound");
+		snd_pcm_close(handle);
+		handle = nullptr;
+	}
+
+	recent_underruns = 0;
+	last_underrun_time = now;
+}
+
 }
 
 #endif
@@ -46,7 +46,8 @@ class SoundOutput_alsa : public SoundOutput_Impl
 {
 //! Construction:
 public:
-	SoundOutput_alsa(int mixing_frequency, int mixing_latency);
+	//: Opens the ALSA PCM device_name, or "default" if the name is empty.
+	SoundOutput_alsa(int mixing_frequency, int mixing_latency, const std::string &device_name);
 	
 	~SoundOutput_alsa();
 
@@ -68,6 +69,9 @@ public:
 	//: Returns the buffer size used by device (returned as num [stereo] samples).
 	virtual int get_fragment_size() override;
 
+	//: Maps the next period of the device buffer so the mixer can write straight into it.
+	virtual float *lock_fragment() override;
+
 	//: Writes a fragment to the soundcard.
 	virtual void write_fragment(float *data) override;
 
@@ -76,6 +80,44 @@ public:
 
 //! Implementation:
 private:
+	//: Sets up hardware and software parameters for the given period size.
+	bool configure(snd_pcm_uframes_t period);
+
+	//: Resumes a stream that was paused, suspended or ran dry.
+	void prepare_stream();
+
+	//: Starts a prepared stream once mapped periods fill it up to the start threshold.
+	void start_stream();
+
+	//: Recovers from a failed ALSA call. Counts underruns.
+	void recover(int error);
+
+	//: Reads the current delay of the device into output_latency.
+	void update_latency();
+
+	//: Grows the period after repeated underruns and shrinks it back once playback is stable.
+	void adapt_period();
+
+	//: True if the device accepted mmap access.
+	bool mmap_access;
+
+	//: Period size asked for by the mixing latency. The adaptive period never goes below this.
+	snd_pcm_uframes_t requested_period;
+
+	//: Offset of the period mapped by lock_fragment.
+	snd_pcm_uframes_t mapped_offset;
+
+	//: Device memory returned by lock_fragment, or null.
+	float *mapped_fragment;
+
+	//: Time of the underrun that started the current run of underruns, in milliseconds.
+	uint64_t first_underrun_time;
+
+	//: Time of the last underrun, or of the last period change, in milliseconds.
+	uint64_t last_underrun_time;
+
+	//: Underruns since first_underrun_time.
+	int recent_underruns;
 };
 
 }
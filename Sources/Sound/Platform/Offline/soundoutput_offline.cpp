@@ -0,0 +1,203 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "soundoutput_offline.h"
+#include "API/Core/IOData/cl_endian.h"
+#include "API/Sound/sound_sse.h"
+#include <cstring>
+
+namespace clan
+{
+	SoundOutput_Offline::SoundOutput_Offline(int mixing_frequency, int mixing_latency, SpeakerPositionMask init_speakers,
+		const IODevice &wave_output, bool wave_float, const std::function<void(const float *, int)> &callback)
+		: SoundOutput_Impl(mixing_frequency, mixing_latency), fragment_size(0), fragment_position(0),
+		wave_output(wave_output), wave_float(wave_float), callback(callback), wave_size_position(-1), wave_data_size(0)
+	{
+		name = "Offline";
+		speakers = init_speakers;
+
+		// Mix in blocks of one latency period, rounded up to whole SSE vectors
+		fragment_size = ((mixing_frequency * mixing_latency / 1000) + 3) & ~3;
+		if (fragment_size < 64)
+			fragment_size = 64;
+		fragment_position = fragment_size;
+
+		if (!wave_output.is_null())
+			write_wave_header();
+	}
+
+	SoundOutput_Offline::~SoundOutput_Offline()
+	{
+		if (!wave_output.is_null())
+			finish_wave();
+	}
+
+	void SoundOutput_Offline::render(float *output, int sample_count)
+	{
+		int num_channels = SoundMixer::get_speaker_count(speakers);
+		while (sample_count > 0)
+		{
+			if (fragment_position == fragment_size)
+			{
+				mix_fragment_locked();
+				fragment_position = 0;
+			}
+
+			int count = fragment_size - fragment_position;
+			if (count > sample_count)
+				count = sample_count;
+
+			const float *data = interleaved_buffer + fragment_position * num_channels;
+			memcpy(output, data, sizeof(float) * count * num_channels);
+			deliver(data, count);
+			output += count * num_channels;
+			sample_count -= count;
+			fragment_position += count;
+		}
+	}
+
+	void SoundOutput_Offline::render(int sample_count)
+	{
+		int num_channels = SoundMixer::get_speaker_count(speakers);
+		while (sample_count > 0)
+		{
+			if (fragment_position == fragment_size)
+			{
+				mix_fragment_locked();
+				fragment_position = 0;
+			}
+
+			int count = fragment_size - fragment_position;
+			if (count > sample_count)
+				count = sample_count;
+
+			deliver(interleaved_buffer + fragment_position * num_channels, count);
+			sample_count -= count;
+			fragment_position += count;
+		}
+	}
+
+	void SoundOutput_Offline::mix_fragment_locked()
+	{
+		// Game threads apply queued commands themselves when the queue fills up between renders
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		mix_fragment();
+	}
+
+	void SoundOutput_Offline::deliver(const float *data, int count)
+	{
+		if (!wave_output.is_null())
+			write_wave_samples(data, count);
+		if (callback)
+			callback(data, count);
+	}
+
+	void SoundOutput_Offline::write_wave_header()
+	{
+		// KSDATAFORMAT_SUBTYPE_PCM and KSDATAFORMAT_SUBTYPE_IEEE_FLOAT
+		static const unsigned char subformat_pcm[16] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+		static const unsigned char subformat_float[16] = { 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+
+		int num_channels = SoundMixer::get_speaker_count(speakers);
+		int bits = wave_float ? 32 : 16;
+		int block_align = num_channels * bits / 8;
+
+		// Plain PCM is understood by more readers, so the extensible format is only used when needed
+		bool extensible = wave_float || speakers != SoundMixer::get_default_speakers(num_channels) || num_channels > 2;
+
+		wave_output.set_little_endian_mode();
+		wave_output.write("RIFF", 4);
+		wave_output.write_uint32(0xffffffff);
+		wave_output.write("WAVE", 4);
+
+		wave_output.write("fmt ", 4);
+		wave_output.write_uint32(extensible ? 40 : 16);
+		wave_output.write_uint16(extensible ? 0xfffe : 1);
+		wave_output.write_uint16(num_channels);
+		wave_output.write_uint32(mixing_frequency);
+		wave_output.write_uint32(mixing_frequency * block_align);
+		wave_output.write_uint16(block_align);
+		wave_output.write_uint16(bits);
+		if (extensible)
+		{
+			wave_output.write_uint16(22);
+			wave_output.write_uint16(bits);
+			wave_output.write_uint32(speakers);
+			wave_output.write(wave_float ? subformat_float : subformat_pcm, 16);
+		}
+
+		wave_output.write("data", 4);
+		wave_size_position = wave_output.get_position();
+		wave_output.write_uint32(0xffffffff);
+
+		wave_buffer.resize(fragment_size * block_align);
+	}
+
+	void SoundOutput_Offline::write_wave_samples(const float *data, int count)
+	{
+		int size = count * SoundMixer::get_speaker_count(speakers);
+		if (wave_float)
+		{
+			memcpy(wave_buffer.data(), data, size * sizeof(float));
+			Endian::swap_if_big(wave_buffer.data(), sizeof(float), size);
+			wave_output.write(wave_buffer.data(), size * sizeof(float));
+			wave_data_size += size * sizeof(float);
+		}
+		else
+		{
+			short *samples = reinterpret_cast<short *>(wave_buffer.data());
+			SoundSSE::pack_16bit(data, size, samples);
+			Endian::swap_if_big(samples, sizeof(short), size);
+			wave_output.write(samples, size * sizeof(short));
+			wave_data_size += size * sizeof(short);
+		}
+	}
+
+	void SoundOutput_Offline::finish_wave()
+	{
+		// Destructors must not throw. A device that cannot seek keeps the stream sizes.
+		try
+		{
+			if (wave_size_position < 0 || wave_data_size > 0xffffffff - (uint64_t)wave_size_position)
+				return;
+
+			int end_position = wave_output.get_position();
+			if (wave_output.seek(4))
+			{
+				wave_output.write_uint32((uint32_t)(wave_size_position - 4 + wave_data_size));
+				wave_output.seek(wave_size_position);
+				wave_output.write_uint32((uint32_t)wave_data_size);
+				wave_output.seek(end_position);
+			}
+		}
+		catch (...)
+		{
+		}
+	}
+}
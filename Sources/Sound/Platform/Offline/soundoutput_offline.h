@@ -0,0 +1,86 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "../../soundoutput_impl.h"
+#include "API/Core/IOData/iodevice.h"
+#include <functional>
+
+namespace clan
+{
+	/// \brief Sound output without a device, mixed on demand by SoundOutput::render
+	///
+	/// Everything mixed is also passed on to an optional wave file and callback.
+	class SoundOutput_Offline : public SoundOutput_Impl
+	{
+	public:
+		SoundOutput_Offline(int mixing_frequency, int mixing_latency, SpeakerPositionMask speakers,
+			const IODevice &wave_output, bool wave_float, const std::function<void(const float *, int)> &callback);
+		~SoundOutput_Offline();
+
+		/// \brief Mixes sample_count interleaved samples per speaker into output
+		void render(float *output, int sample_count);
+
+		/// \brief Mixes sample_count samples per speaker, only passing them to the wave file and callback
+		void render(int sample_count);
+
+	protected:
+		void silence() override { }
+		int get_fragment_size() override { return fragment_size; }
+		void write_fragment(float *data) override { }
+		void wait() override { }
+
+	private:
+		/// \brief Mixes the next fragment while no game thread applies commands
+		void mix_fragment_locked();
+
+		/// \brief Hands count interleaved samples per speaker to the wave file and callback
+		void deliver(const float *data, int count);
+
+		void write_wave_header();
+		void write_wave_samples(const float *data, int count);
+
+		/// \brief Fills in the sizes in the wave header, if the device can seek
+		void finish_wave();
+
+		int fragment_size;
+
+		/// \brief Samples of the last mixed fragment already handed out by render
+		int fragment_position;
+
+		IODevice wave_output;
+		bool wave_float;
+		std::function<void(const float *, int)> callback;
+
+		/// \brief Position of the data chunk size in the wave file, or -1 if unknown
+		int wave_size_position;
+		uint64_t wave_data_size;
+		std::vector<char> wave_buffer;
+	};
+}
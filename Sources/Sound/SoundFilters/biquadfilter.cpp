@@ -0,0 +1,73 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "API/Sound/SoundFilters/biquadfilter.h"
+#include "biquadfilter_provider.h"
+
+namespace clan
+{
+	BiquadFilter::BiquadFilter(BiquadFilterType type, float frequency, float q, float gain_db, int sample_rate)
+		: SoundFilter(new BiquadFilterProvider(type, frequency, q, gain_db, sample_rate))
+	{
+	}
+
+	BiquadFilter::~BiquadFilter()
+	{
+	}
+
+	BiquadFilterProvider *BiquadFilter::get_provider() const
+	{
+		return static_cast <BiquadFilterProvider *> (SoundFilter::get_provider());
+	}
+
+	BiquadFilterType BiquadFilter::get_type() const
+	{
+		return get_provider()->get_type();
+	}
+
+	float BiquadFilter::get_frequency() const
+	{
+		return get_provider()->get_frequency();
+	}
+
+	float BiquadFilter::get_q() const
+	{
+		return get_provider()->get_q();
+	}
+
+	float BiquadFilter::get_gain() const
+	{
+		return get_provider()->get_gain();
+	}
+
+	void BiquadFilter::set_parameters(BiquadFilterType type, float frequency, float q, float gain_db)
+	{
+		get_provider()->set_parameters(type, frequency, q, gain_db);
+	}
+}
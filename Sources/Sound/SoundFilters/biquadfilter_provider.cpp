@@ -0,0 +1,264 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "biquadfilter_provider.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	BiquadFilterProvider::BiquadFilterProvider(BiquadFilterType type, float frequency, float q, float gain_db, int sample_rate)
+		: sample_rate(sample_rate)
+	{
+		parameters.type = type;
+		parameters.frequency = frequency;
+		parameters.q = q;
+		parameters.gain_db = gain_db;
+		parameters_changed = false;
+		update_coefficients(parameters);
+
+		for (auto & state : states)
+		{
+			state[0] = 0.0f;
+			state[1] = 0.0f;
+		}
+	}
+
+	BiquadFilterType BiquadFilterProvider::get_type() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.type;
+	}
+
+	float BiquadFilterProvider::get_frequency() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.frequency;
+	}
+
+	float BiquadFilterProvider::get_q() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.q;
+	}
+
+	float BiquadFilterProvider::get_gain() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.gain_db;
+	}
+
+	void BiquadFilterProvider::set_parameters(BiquadFilterType type, float frequency, float q, float gain_db)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.type = type;
+		parameters.frequency = frequency;
+		parameters.q = q;
+		parameters.gain_db = gain_db;
+		parameters_changed = true;
+	}
+
+	void BiquadFilterProvider::filter(float **sample_data, int num_samples, int channels)
+	{
+		if (parameters_changed)
+		{
+			// Never block the mixer. If the game thread holds the lock the change is picked up next block.
+			std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+			if (lock.owns_lock())
+			{
+				Parameters params = parameters;
+				parameters_changed = false;
+				lock.unlock();
+				update_coefficients(params);
+			}
+		}
+
+		channels = std::min(channels, (int)max_channels);
+		for (int c = 0; c < channels; c++)
+			filter_channel(sample_data[c], num_samples, states[c]);
+	}
+
+	void BiquadFilterProvider::filter_channel(float *data, int num_samples, float state[2])
+	{
+		float z1 = state[0];
+		float z2 = state[1];
+
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (num_samples / 4) * 4;
+
+		__m128 t0 = _mm_loadu_ps(block_coefficients[0]);
+		__m128 t1 = _mm_loadu_ps(block_coefficients[1]);
+		__m128 t2 = _mm_loadu_ps(block_coefficients[2]);
+		__m128 t3 = _mm_loadu_ps(block_coefficients[3]);
+		__m128 s1 = _mm_loadu_ps(block_coefficients[4]);
+		__m128 s2 = _mm_loadu_ps(block_coefficients[5]);
+
+		// Four samples at a time: y = T * x + S * z, then step the state past the block
+		for (int i = 0; i < sse_size; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(data + i);
+			float x2 = data[i + 2];
+			float x3 = data[i + 3];
+
+			__m128 y = _mm_mul_ps(t0, _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 0, 0, 0)));
+			y = _mm_add_ps(y, _mm_mul_ps(t1, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 1, 1))));
+			y = _mm_add_ps(y, _mm_mul_ps(t2, _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 2, 2))));
+			y = _mm_add_ps(y, _mm_mul_ps(t3, _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3))));
+			y = _mm_add_ps(y, _mm_mul_ps(s1, _mm_set1_ps(z1)));
+			y = _mm_add_ps(y, _mm_mul_ps(s2, _mm_set1_ps(z2)));
+			_mm_storeu_ps(data + i, y);
+
+			float y2 = data[i + 2];
+			float y3 = data[i + 3];
+			z1 = b1 * x3 - a1 * y3 + b2 * x2 - a2 * y2;
+			z2 = b2 * x3 - a2 * y3;
+		}
+#else
+		const int sse_size = 0;
+#endif
+
+		for (int i = sse_size; i < num_samples; i++)
+		{
+			float x = data[i];
+			float y = b0 * x + z1;
+			z1 = b1 * x - a1 * y + z2;
+			z2 = b2 * x - a2 * y;
+			data[i] = y;
+		}
+
+		// Denormals are very slow, and the tail of a decaying filter ends up there
+		if (std::abs(z1) < 1e-20f) z1 = 0.0f;
+		if (std::abs(z2) < 1e-20f) z2 = 0.0f;
+
+		state[0] = z1;
+		state[1] = z2;
+	}
+
+	void BiquadFilterProvider::update_coefficients(const Parameters &params)
+	{
+		const double pi = 3.14159265358979323846;
+
+		double frequency = std::max(1.0, std::min((double)params.frequency, sample_rate * 0.49));
+		double q = std::max((double)params.q, 0.01);
+		double w0 = 2.0 * pi * frequency / sample_rate;
+		double cos_w0 = std::cos(w0);
+		double alpha = std::sin(w0) / (2.0 * q);
+		double a = std::pow(10.0, params.gain_db / 40.0);
+		double shelf = 2.0 * std::sqrt(a) * alpha;
+
+		double nb0 = 1.0, nb1 = 0.0, nb2 = 0.0, na0 = 1.0, na1 = 0.0, na2 = 0.0;
+		switch (params.type)
+		{
+		case cl_biquad_lowpass:
+			nb0 = (1.0 - cos_w0) / 2.0;
+			nb1 = 1.0 - cos_w0;
+			nb2 = (1.0 - cos_w0) / 2.0;
+			na0 = 1.0 + alpha;
+			na1 = -2.0 * cos_w0;
+			na2 = 1.0 - alpha;
+			break;
+		case cl_biquad_highpass:
+			nb0 = (1.0 + cos_w0) / 2.0;
+			nb1 = -(1.0 + cos_w0);
+			nb2 = (1.0 + cos_w0) / 2.0;
+			na0 = 1.0 + alpha;
+			na1 = -2.0 * cos_w0;
+			na2 = 1.0 - alpha;
+			break;
+		case cl_biquad_bandpass:
+			nb0 = alpha;
+			nb1 = 0.0;
+			nb2 = -alpha;
+			na0 = 1.0 + alpha;
+			na1 = -2.0 * cos_w0;
+			na2 = 1.0 - alpha;
+			break;
+		case cl_biquad_notch:
+			nb0 = 1.0;
+			nb1 = -2.0 * cos_w0;
+			nb2 = 1.0;
+			na0 = 1.0 + alpha;
+			na1 = -2.0 * cos_w0;
+			na2 = 1.0 - alpha;
+			break;
+		case cl_biquad_peaking:
+			nb0 = 1.0 + alpha * a;
+			nb1 = -2.0 * cos_w0;
+			nb2 = 1.0 - alpha * a;
+			na0 = 1.0 + alpha / a;
+			na1 = -2.0 * cos_w0;
+			na2 = 1.0 - alpha / a;
+			break;
+		case cl_biquad_lowshelf:
+			nb0 = a * ((a + 1.0) - (a - 1.0) * cos_w0 + shelf);
+			nb1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cos_w0);
+			nb2 = a * ((a + 1.0) - (a - 1.0) * cos_w0 - shelf);
+			na0 = (a + 1.0) + (a - 1.0) * cos_w0 + shelf;
+			na1 = -2.0 * ((a - 1.0) + (a + 1.0) * cos_w0);
+			na2 = (a + 1.0) + (a - 1.0) * cos_w0 - shelf;
+			break;
+		case cl_biquad_highshelf:
+			nb0 = a * ((a + 1.0) + (a - 1.0) * cos_w0 + shelf);
+			nb1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cos_w0);
+			nb2 = a * ((a + 1.0) + (a - 1.0) * cos_w0 - shelf);
+			na0 = (a + 1.0) - (a - 1.0) * cos_w0 + shelf;
+			na1 = 2.0 * ((a - 1.0) - (a + 1.0) * cos_w0);
+			na2 = (a + 1.0) - (a - 1.0) * cos_w0 - shelf;
+			break;
+		}
+
+		b0 = (float)(nb0 / na0);
+		b1 = (float)(nb1 / na0);
+		b2 = (float)(nb2 / na0);
+		a1 = (float)(na1 / na0);
+		a2 = (float)(na2 / na0);
+
+		// Run the scalar filter on a unit input or state to find each column of the block matrices
+		for (int column = 0; column < 6; column++)
+		{
+			float x[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float z1 = (column == 4) ? 1.0f : 0.0f;
+			float z2 = (column == 5) ? 1.0f : 0.0f;
+			if (column < 4)
+				x[column] = 1.0f;
+
+			for (int n = 0; n < 4; n++)
+			{
+				float y = b0 * x[n] + z1;
+				z1 = b1 * x[n] - a1 * y + z2;
+				z2 = b2 * x[n] - a2 * y;
+				block_coefficients[column][n] = y;
+			}
+		}
+	}
+}
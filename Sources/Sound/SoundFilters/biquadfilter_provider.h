@@ -0,0 +1,78 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/SoundProviders/soundfilter_provider.h"
+#include "API/Sound/SoundFilters/biquadfilter.h"
+#include <atomic>
+#include <mutex>
+
+namespace clan
+{
+	class BiquadFilterProvider : public SoundFilterProvider
+	{
+	public:
+		BiquadFilterProvider(BiquadFilterType type, float frequency, float q, float gain_db, int sample_rate);
+
+		void filter(float **sample_data, int num_samples, int channels) override;
+
+		BiquadFilterType get_type() const;
+		float get_frequency() const;
+		float get_q() const;
+		float get_gain() const;
+		void set_parameters(BiquadFilterType type, float frequency, float q, float gain_db);
+
+	private:
+		struct Parameters
+		{
+			BiquadFilterType type;
+			float frequency;
+			float q;
+			float gain_db;
+		};
+
+		void update_coefficients(const Parameters &params);
+		void filter_channel(float *data, int num_samples, float state[2]);
+
+		static const int max_channels = 32;
+
+		int sample_rate;
+
+		mutable std::mutex mutex;
+		Parameters parameters;
+		std::atomic_bool parameters_changed;
+
+		float b0, b1, b2, a1, a2;
+
+		// Response of four outputs to each of four inputs and the two state variables
+		float block_coefficients[6][4];
+
+		float states[max_channels][2];
+	};
+}
@@ -0,0 +1,113 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "API/Sound/SoundFilters/compressorfilter.h"
+#include "compressorfilter_provider.h"
+
+namespace clan
+{
+	CompressorFilter::CompressorFilter(float threshold, float ratio, float attack, float release, float makeup_gain, int sample_rate)
+		: SoundFilter(new CompressorFilterProvider(threshold, ratio, attack, release, makeup_gain, sample_rate))
+	{
+	}
+
+	CompressorFilter::~CompressorFilter()
+	{
+	}
+
+	CompressorFilterProvider *CompressorFilter::get_provider() const
+	{
+		return static_cast <CompressorFilterProvider *> (SoundFilter::get_provider());
+	}
+
+	float CompressorFilter::get_threshold() const
+	{
+		return get_provider()->get_threshold();
+	}
+
+	void CompressorFilter::set_threshold(float threshold)
+	{
+		get_provider()->set_threshold(threshold);
+	}
+
+	float CompressorFilter::get_ratio() const
+	{
+		return get_provider()->get_ratio();
+	}
+
+	void CompressorFilter::set_ratio(float ratio)
+	{
+		get_provider()->set_ratio(ratio);
+	}
+
+	float CompressorFilter::get_attack() const
+	{
+		return get_provider()->get_attack();
+	}
+
+	void CompressorFilter::set_attack(float attack)
+	{
+		get_provider()->set_attack(attack);
+	}
+
+	float CompressorFilter::get_release() const
+	{
+		return get_provider()->get_release();
+	}
+
+	void CompressorFilter::set_release(float release)
+	{
+		get_provider()->set_release(release);
+	}
+
+	float CompressorFilter::get_hold() const
+	{
+		return get_provider()->get_hold();
+	}
+
+	void CompressorFilter::set_hold(float hold)
+	{
+		get_provider()->set_hold(hold);
+	}
+
+	float CompressorFilter::get_makeup_gain() const
+	{
+		return get_provider()->get_makeup_gain();
+	}
+
+	void CompressorFilter::set_makeup_gain(float makeup_gain)
+	{
+		get_provider()->set_makeup_gain(makeup_gain);
+	}
+
+	float CompressorFilter::get_gain_reduction() const
+	{
+		return get_provider()->get_gain_reduction();
+	}
+}
@@ -0,0 +1,312 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "compressorfilter_provider.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+#ifndef CL_DISABLE_SSE2
+	// Approximations good to about 1e-5, which is far below what can be heard in a gain.
+	// Both are exact where it matters: log2(x) - log2(x) is zero and exp2(0) is one.
+	static inline __m128 fast_log2(__m128 x)
+	{
+		__m128i bits = _mm_castps_si128(x);
+		__m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		__m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+		// log2(m) = 2 / ln(2) * atanh((m - 1) / (m + 1)), m in [1, 2)
+		__m128 one = _mm_set1_ps(1.0f);
+		__m128 t = _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one));
+		__m128 t2 = _mm_mul_ps(t, t);
+		__m128 p = _mm_set1_ps(0.41219858f);
+		p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.57707802f));
+		p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(0.96179669f));
+		p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(2.88539008f));
+		return _mm_add_ps(exponent, _mm_mul_ps(p, t));
+	}
+
+	static inline __m128 fast_exp2(__m128 x)
+	{
+		x = _mm_max_ps(_mm_min_ps(x, _mm_set1_ps(126.0f)), _mm_set1_ps(-125.0f));
+		__m128i whole = _mm_cvttps_epi32(x);
+		__m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(whole));
+
+		// Taylor series of e^(f * ln(2)), f in (-1, 1)
+		__m128 p = _mm_set1_ps(1.5403530e-4f);
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.3333558e-3f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.6181291e-3f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.5504109e-2f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.24022651f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.69314718f));
+		p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+		return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(whole, 23)));
+	}
+#endif
+
+	CompressorFilterProvider::CompressorFilterProvider(float threshold, float ratio, float attack, float release, float makeup_gain, int sample_rate)
+		: sample_rate(sample_rate), envelope(0.0f), hold_counter(0)
+	{
+		parameters.threshold = threshold;
+		parameters.ratio = ratio;
+		parameters.attack = attack;
+		parameters.release = release;
+		parameters.hold = 0.0f;
+		parameters.makeup_gain = makeup_gain;
+		parameters_changed = false;
+		gain_reduction = 0.0f;
+		update_parameters(parameters);
+	}
+
+	float CompressorFilterProvider::get_threshold() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.threshold;
+	}
+
+	void CompressorFilterProvider::set_threshold(float new_threshold)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.threshold = new_threshold;
+		parameters_changed = true;
+	}
+
+	float CompressorFilterProvider::get_ratio() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.ratio;
+	}
+
+	void CompressorFilterProvider::set_ratio(float ratio)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.ratio = ratio;
+		parameters_changed = true;
+	}
+
+	float CompressorFilterProvider::get_attack() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.attack;
+	}
+
+	void CompressorFilterProvider::set_attack(float attack)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.attack = attack;
+		parameters_changed = true;
+	}
+
+	float CompressorFilterProvider::get_release() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.release;
+	}
+
+	void CompressorFilterProvider::set_release(float release)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.release = release;
+		parameters_changed = true;
+	}
+
+	float CompressorFilterProvider::get_hold() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.hold;
+	}
+
+	void CompressorFilterProvider::set_hold(float hold)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.hold = hold;
+		parameters_changed = true;
+	}
+
+	float CompressorFilterProvider::get_makeup_gain() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.makeup_gain;
+	}
+
+	void CompressorFilterProvider::set_makeup_gain(float makeup_gain)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.makeup_gain = makeup_gain;
+		parameters_changed = true;
+	}
+
+	float CompressorFilterProvider::get_gain_reduction() const
+	{
+		return gain_reduction;
+	}
+
+	void CompressorFilterProvider::update_parameters(const Parameters &params)
+	{
+		threshold = std::pow(10.0f, params.threshold / 20.0f);
+		slope = 1.0f - 1.0f / std::max(params.ratio, 1.0f);
+		attack_coefficient = params.attack > 0.0f ? std::exp(-1000.0f / (params.attack * sample_rate)) : 0.0f;
+		release_coefficient = params.release > 0.0f ? std::exp(-1000.0f / (params.release * sample_rate)) : 0.0f;
+		hold_samples = (int)(std::max(params.hold, 0.0f) * sample_rate / 1000.0f);
+		makeup = std::pow(10.0f, params.makeup_gain / 20.0f);
+	}
+
+	void CompressorFilterProvider::filter(float **sample_data, int num_samples, int channels)
+	{
+		if (parameters_changed)
+		{
+			// Never block the mixer. If the game thread holds the lock the change is picked up next block.
+			std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+			if (lock.owns_lock())
+			{
+				Parameters params = parameters;
+				parameters_changed = false;
+				lock.unlock();
+				update_parameters(params);
+			}
+		}
+
+		if (channels <= 0)
+			return;
+
+		for (int pos = 0; pos < num_samples; pos += chunk_size)
+		{
+			int count = std::min((int)chunk_size, num_samples - pos);
+			find_peaks(sample_data, pos, count, channels);
+			follow_envelope(count);
+			compute_gains(count);
+
+			for (int c = 0; c < channels; c++)
+			{
+				float *data = sample_data[c] + pos;
+
+#ifndef CL_DISABLE_SSE2
+				int sse_size = (count / 4) * 4;
+				for (int i = 0; i < sse_size; i += 4)
+					_mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), _mm_loadu_ps(levels + i)));
+#else
+				const int sse_size = 0;
+#endif
+				for (int i = sse_size; i < count; i++)
+					data[i] *= levels[i];
+			}
+		}
+
+		gain_reduction = envelope > threshold ? slope * 20.0f * std::log10(envelope / threshold) : 0.0f;
+	}
+
+	void CompressorFilterProvider::find_peaks(float **sample_data, int offset, int count, int channels)
+	{
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (count / 4) * 4;
+
+		__m128 sign_mask = _mm_set1_ps(-0.0f);
+		for (int i = 0; i < sse_size; i += 4)
+		{
+			__m128 peak = _mm_setzero_ps();
+			for (int c = 0; c < channels; c++)
+				peak = _mm_max_ps(peak, _mm_andnot_ps(sign_mask, _mm_loadu_ps(sample_data[c] + offset + i)));
+			_mm_storeu_ps(levels + i, peak);
+		}
+#else
+		const int sse_size = 0;
+#endif
+
+		for (int i = sse_size; i < count; i++)
+		{
+			float peak = 0.0f;
+			for (int c = 0; c < channels; c++)
+				peak = std::max(peak, std::abs(sample_data[c][offset + i]));
+			levels[i] = peak;
+		}
+	}
+
+	void CompressorFilterProvider::follow_envelope(int count)
+	{
+		// Each sample depends on the previous one, so this part stays serial
+		float env = envelope;
+		int hold = hold_counter;
+		for (int i = 0; i < count; i++)
+		{
+			float peak = levels[i];
+			if (peak > env)
+			{
+				env = peak + attack_coefficient * (env - peak);
+				hold = hold_samples;
+			}
+			else if (hold > 0)
+			{
+				hold--;
+			}
+			else
+			{
+				env = peak + release_coefficient * (env - peak);
+			}
+			levels[i] = env;
+		}
+		hold_counter = hold;
+
+		// Denormals are very slow, and a decaying envelope ends up there
+		if (env < 1e-20f)
+			env = 0.0f;
+		envelope = env;
+	}
+
+	void CompressorFilterProvider::compute_gains(int count)
+	{
+		// gain = (threshold / level) ^ slope above the threshold, evaluated as a power of two
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (count / 4) * 4;
+
+		__m128 threshold0 = _mm_set1_ps(threshold);
+		__m128 log_threshold = fast_log2(threshold0);
+		__m128 slope0 = _mm_set1_ps(slope);
+		__m128 makeup0 = _mm_set1_ps(makeup);
+		for (int i = 0; i < sse_size; i += 4)
+		{
+			__m128 level = _mm_max_ps(_mm_loadu_ps(levels + i), threshold0);
+			__m128 exponent = _mm_mul_ps(slope0, _mm_sub_ps(log_threshold, fast_log2(level)));
+			_mm_storeu_ps(levels + i, _mm_mul_ps(fast_exp2(exponent), makeup0));
+		}
+#else
+		const int sse_size = 0;
+#endif
+
+		for (int i = sse_size; i < count; i++)
+		{
+			float level = levels[i];
+			levels[i] = level > threshold ? std::pow(threshold / level, slope) * makeup : makeup;
+		}
+	}
+}
@@ -0,0 +1,96 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/SoundProviders/soundfilter_provider.h"
+#include <atomic>
+#include <mutex>
+
+namespace clan
+{
+	class CompressorFilterProvider : public SoundFilterProvider
+	{
+	public:
+		CompressorFilterProvider(float threshold, float ratio, float attack, float release, float makeup_gain, int sample_rate);
+
+		void filter(float **sample_data, int num_samples, int channels) override;
+
+		float get_threshold() const;
+		void set_threshold(float threshold);
+		float get_ratio() const;
+		void set_ratio(float ratio);
+		float get_attack() const;
+		void set_attack(float attack);
+		float get_release() const;
+		void set_release(float release);
+		float get_hold() const;
+		void set_hold(float hold);
+		float get_makeup_gain() const;
+		void set_makeup_gain(float makeup_gain);
+		float get_gain_reduction() const;
+
+	private:
+		struct Parameters
+		{
+			float threshold;
+			float ratio;
+			float attack;
+			float release;
+			float hold;
+			float makeup_gain;
+		};
+
+		void update_parameters(const Parameters &params);
+		void find_peaks(float **sample_data, int offset, int count, int channels);
+		void follow_envelope(int count);
+		void compute_gains(int count);
+
+		static const int chunk_size = 256;
+
+		int sample_rate;
+
+		mutable std::mutex mutex;
+		Parameters parameters;
+		std::atomic_bool parameters_changed;
+
+		float threshold;
+		float slope;
+		float attack_coefficient;
+		float release_coefficient;
+		int hold_samples;
+		float makeup;
+
+		float envelope;
+		int hold_counter;
+		std::atomic<float> gain_reduction;
+
+		// Peak levels, then the envelope, then the gains of a chunk
+		float levels[chunk_size];
+	};
+}
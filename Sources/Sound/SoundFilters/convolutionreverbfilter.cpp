@@ -0,0 +1,73 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "API/Sound/SoundFilters/convolutionreverbfilter.h"
+#include "convolutionreverbfilter_provider.h"
+
+namespace clan
+{
+	ConvolutionReverbFilter::ConvolutionReverbFilter(const std::vector<float> &impulse_response, int block_size)
+		: SoundFilter(new ConvolutionReverbFilterProvider(impulse_response, block_size))
+	{
+	}
+
+	ConvolutionReverbFilter::~ConvolutionReverbFilter()
+	{
+	}
+
+	ConvolutionReverbFilterProvider *ConvolutionReverbFilter::get_provider() const
+	{
+		return static_cast <ConvolutionReverbFilterProvider *> (SoundFilter::get_provider());
+	}
+
+	int ConvolutionReverbFilter::get_latency() const
+	{
+		return get_provider()->get_latency();
+	}
+
+	float ConvolutionReverbFilter::get_wet_level() const
+	{
+		return get_provider()->get_wet_level();
+	}
+
+	void ConvolutionReverbFilter::set_wet_level(float level)
+	{
+		get_provider()->set_wet_level(level);
+	}
+
+	float ConvolutionReverbFilter::get_dry_level() const
+	{
+		return get_provider()->get_dry_level();
+	}
+
+	void ConvolutionReverbFilter::set_dry_level(float level)
+	{
+		get_provider()->set_dry_level(level);
+	}
+}
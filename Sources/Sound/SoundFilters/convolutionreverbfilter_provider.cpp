@@ -0,0 +1,220 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "convolutionreverbfilter_provider.h"
+#include <algorithm>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	ConvolutionReverbFilterProvider::ConvolutionReverbFilterProvider(const std::vector<float> &impulse_response, int block_size)
+		: block_size(block_size), fft_size(block_size * 2), num_partitions(std::max(((int)impulse_response.size() + block_size - 1) / std::max(block_size, 1), 1)),
+		fft(std::max(block_size, 1) * 2), fifo_pos(0)
+	{
+		if (block_size < 16)
+			throw Exception("Convolution block size must be at least 16");
+
+		wet_level = 1.0f;
+		dry_level = 1.0f;
+
+		sum_real.resize(fft_size);
+		sum_imag.resize(fft_size);
+
+		// Spectrum of each block of the response, zero padded to twice the block size.
+		// The scale of the inverse transform is folded in here.
+		response_real.resize(num_partitions * fft_size);
+		response_imag.resize(num_partitions * fft_size);
+		float scale = 1.0f / fft_size;
+		for (int partition = 0; partition < num_partitions; partition++)
+		{
+			float *real = response_real.data() + partition * fft_size;
+			float *imag = response_imag.data() + partition * fft_size;
+			for (int i = 0; i < block_size; i++)
+			{
+				size_t index = (size_t)partition * block_size + i;
+				real[i] = index < impulse_response.size() ? impulse_response[index] * scale : 0.0f;
+			}
+			fft.forward(real, imag);
+		}
+	}
+
+	int ConvolutionReverbFilterProvider::get_latency() const
+	{
+		return block_size;
+	}
+
+	float ConvolutionReverbFilterProvider::get_wet_level() const
+	{
+		return wet_level;
+	}
+
+	void ConvolutionReverbFilterProvider::set_wet_level(float level)
+	{
+		wet_level = level;
+	}
+
+	float ConvolutionReverbFilterProvider::get_dry_level() const
+	{
+		return dry_level;
+	}
+
+	void ConvolutionReverbFilterProvider::set_dry_level(float level)
+	{
+		dry_level = level;
+	}
+
+	void ConvolutionReverbFilterProvider::filter(float **sample_data, int num_samples, int channels)
+	{
+		float wet = wet_level;
+		float dry = dry_level;
+
+		channels = std::min(channels, (int)max_channels);
+		int num_pairs = (channels + 1) / 2;
+		while ((int)pairs.size() < num_pairs)
+		{
+			ChannelPair pair;
+			for (int side = 0; side < 2; side++)
+			{
+				pair.input[side].resize(block_size, 0.0f);
+				pair.output[side].resize(block_size, 0.0f);
+				pair.previous_input[side].resize(block_size, 0.0f);
+			}
+			pair.history_real.resize(num_partitions * fft_size, 0.0f);
+			pair.history_imag.resize(num_partitions * fft_size, 0.0f);
+			pair.history_pos = 0;
+			pairs.push_back(pair);
+		}
+
+		// Input is collected and output played back one block at a time
+		int pos = 0;
+		while (pos < num_samples)
+		{
+			int count = std::min(num_samples - pos, block_size - fifo_pos);
+			for (int c = 0; c < channels; c++)
+			{
+				ChannelPair &pair = pairs[c / 2];
+				float *data = sample_data[c] + pos;
+				float *input = pair.input[c % 2].data() + fifo_pos;
+				const float *output = pair.output[c % 2].data() + fifo_pos;
+
+#ifndef CL_DISABLE_SSE2
+				int sse_size = (count / 4) * 4;
+				__m128 wet0 = _mm_set1_ps(wet);
+				__m128 dry0 = _mm_set1_ps(dry);
+				for (int i = 0; i < sse_size; i += 4)
+				{
+					__m128 x = _mm_loadu_ps(data + i);
+					_mm_storeu_ps(input + i, x);
+					_mm_storeu_ps(data + i, _mm_add_ps(_mm_mul_ps(x, dry0), _mm_mul_ps(_mm_loadu_ps(output + i), wet0)));
+				}
+#else
+				const int sse_size = 0;
+#endif
+				for (int i = sse_size; i < count; i++)
+				{
+					input[i] = data[i];
+					data[i] = data[i] * dry + output[i] * wet;
+				}
+			}
+
+			pos += count;
+			fifo_pos += count;
+			if (fifo_pos == block_size)
+			{
+				for (int i = 0; i < num_pairs; i++)
+					process_block(pairs[i]);
+				fifo_pos = 0;
+			}
+		}
+	}
+
+	void ConvolutionReverbFilterProvider::process_block(ChannelPair &pair)
+	{
+		// Overlap-save: transform the last two blocks of input into the newest slot of the history
+		float *real = pair.history_real.data() + pair.history_pos * fft_size;
+		float *imag = pair.history_imag.data() + pair.history_pos * fft_size;
+		std::copy(pair.previous_input[0].begin(), pair.previous_input[0].end(), real);
+		std::copy(pair.input[0].begin(), pair.input[0].end(), real + block_size);
+		std::copy(pair.previous_input[1].begin(), pair.previous_input[1].end(), imag);
+		std::copy(pair.input[1].begin(), pair.input[1].end(), imag + block_size);
+		pair.previous_input[0].swap(pair.input[0]);
+		pair.previous_input[1].swap(pair.input[1]);
+		fft.forward(real, imag);
+
+		std::fill(sum_real.begin(), sum_real.end(), 0.0f);
+		std::fill(sum_imag.begin(), sum_imag.end(), 0.0f);
+
+		// Block p of the response meets the input from p blocks ago
+		for (int partition = 0; partition < num_partitions; partition++)
+		{
+			int slot = pair.history_pos - partition;
+			if (slot < 0)
+				slot += num_partitions;
+
+			const float *xr = pair.history_real.data() + slot * fft_size;
+			const float *xi = pair.history_imag.data() + slot * fft_size;
+			const float *hr = response_real.data() + partition * fft_size;
+			const float *hi = response_imag.data() + partition * fft_size;
+			float *sr = sum_real.data();
+			float *si = sum_imag.data();
+
+#ifndef CL_DISABLE_SSE2
+			for (int i = 0; i < fft_size; i += 4)
+			{
+				__m128 a_real = _mm_loadu_ps(xr + i);
+				__m128 a_imag = _mm_loadu_ps(xi + i);
+				__m128 b_real = _mm_loadu_ps(hr + i);
+				__m128 b_imag = _mm_loadu_ps(hi + i);
+				__m128 product_real = _mm_sub_ps(_mm_mul_ps(a_real, b_real), _mm_mul_ps(a_imag, b_imag));
+				__m128 product_imag = _mm_add_ps(_mm_mul_ps(a_real, b_imag), _mm_mul_ps(a_imag, b_real));
+				_mm_storeu_ps(sr + i, _mm_add_ps(_mm_loadu_ps(sr + i), product_real));
+				_mm_storeu_ps(si + i, _mm_add_ps(_mm_loadu_ps(si + i), product_imag));
+			}
+#else
+			for (int i = 0; i < fft_size; i++)
+			{
+				sr[i] += xr[i] * hr[i] - xi[i] * hi[i];
+				si[i] += xr[i] * hi[i] + xi[i] * hr[i];
+			}
+#endif
+		}
+
+		// The response is real, so the two channels come back apart in the real and imaginary parts
+		fft.inverse(sum_real.data(), sum_imag.data());
+		std::copy(sum_real.begin() + block_size, sum_real.end(), pair.output[0].begin());
+		std::copy(sum_imag.begin() + block_size, sum_imag.end(), pair.output[1].begin());
+
+		pair.history_pos++;
+		if (pair.history_pos == num_partitions)
+			pair.history_pos = 0;
+	}
+}
@@ -0,0 +1,86 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/SoundProviders/soundfilter_provider.h"
+#include "sound_fft.h"
+#include <atomic>
+#include <vector>
+
+namespace clan
+{
+	class ConvolutionReverbFilterProvider : public SoundFilterProvider
+	{
+	public:
+		ConvolutionReverbFilterProvider(const std::vector<float> &impulse_response, int block_size);
+
+		void filter(float **sample_data, int num_samples, int channels) override;
+
+		int get_latency() const;
+		float get_wet_level() const;
+		void set_wet_level(float level);
+		float get_dry_level() const;
+		void set_dry_level(float level);
+
+	private:
+		// Two channels are transformed together, one as the real part and one as the imaginary part
+		struct ChannelPair
+		{
+			std::vector<float> input[2];
+			std::vector<float> output[2];
+			std::vector<float> previous_input[2];
+
+			// Spectra of the last num_partitions input blocks
+			std::vector<float> history_real;
+			std::vector<float> history_imag;
+			int history_pos;
+		};
+
+		void process_block(ChannelPair &pair);
+
+		static const int max_channels = 32;
+
+		int block_size;
+		int fft_size;
+		int num_partitions;
+		SoundFFT fft;
+
+		std::vector<float> response_real;
+		std::vector<float> response_imag;
+
+		std::vector<ChannelPair> pairs;
+		int fifo_pos;
+
+		std::vector<float> sum_real;
+		std::vector<float> sum_imag;
+
+		std::atomic<float> wet_level;
+		std::atomic<float> dry_level;
+	};
+}
@@ -0,0 +1,87 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "API/Sound/SoundFilters/delayfilter.h"
+#include "delayfilter_provider.h"
+
+namespace clan
+{
+	DelayFilter::DelayFilter(float max_delay, int sample_rate) : SoundFilter(new DelayFilterProvider(max_delay, sample_rate))
+	{
+	}
+
+	DelayFilter::~DelayFilter()
+	{
+	}
+
+	DelayFilterProvider *DelayFilter::get_provider() const
+	{
+		return static_cast <DelayFilterProvider *> (SoundFilter::get_provider());
+	}
+
+	int DelayFilter::get_tap_count() const
+	{
+		return get_provider()->get_tap_count();
+	}
+
+	int DelayFilter::add_tap(float delay, float gain)
+	{
+		return get_provider()->add_tap(delay, gain);
+	}
+
+	void DelayFilter::set_tap(int index, float delay, float gain)
+	{
+		get_provider()->set_tap(index, delay, gain);
+	}
+
+	void DelayFilter::remove_taps()
+	{
+		get_provider()->remove_taps();
+	}
+
+	float DelayFilter::get_feedback() const
+	{
+		return get_provider()->get_feedback();
+	}
+
+	void DelayFilter::set_feedback(float feedback)
+	{
+		get_provider()->set_feedback(feedback);
+	}
+
+	float DelayFilter::get_dry_level() const
+	{
+		return get_provider()->get_dry_level();
+	}
+
+	void DelayFilter::set_dry_level(float level)
+	{
+		get_provider()->set_dry_level(level);
+	}
+}
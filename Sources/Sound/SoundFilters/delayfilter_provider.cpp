@@ -0,0 +1,237 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "delayfilter_provider.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	DelayFilterProvider::DelayFilterProvider(float max_delay, int sample_rate)
+		: sample_rate(sample_rate), write_pos(0), num_mixer_taps(0), min_delay(max_chunk_size), feedback(0.0f), dry_level(1.0f)
+	{
+		buffer_length = (int)std::ceil(std::max(max_delay, 0.0f) * sample_rate / 1000.0f) + max_chunk_size + 2;
+
+		parameters.num_taps = 0;
+		parameters.feedback = 0.0f;
+		parameters.dry_level = 1.0f;
+		parameters_changed = false;
+	}
+
+	int DelayFilterProvider::get_tap_count() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.num_taps;
+	}
+
+	int DelayFilterProvider::add_tap(float delay, float gain)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (parameters.num_taps == DelayFilter::max_taps)
+			throw Exception("Too many taps in delay filter");
+
+		int index = parameters.num_taps++;
+		parameters.taps[index].delay = delay;
+		parameters.taps[index].gain = gain;
+		parameters_changed = true;
+		return index;
+	}
+
+	void DelayFilterProvider::set_tap(int index, float delay, float gain)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (index < 0 || index >= parameters.num_taps)
+			throw Exception("Delay filter tap index out of range");
+
+		parameters.taps[index].delay = delay;
+		parameters.taps[index].gain = gain;
+		parameters_changed = true;
+	}
+
+	void DelayFilterProvider::remove_taps()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.num_taps = 0;
+		parameters_changed = true;
+	}
+
+	float DelayFilterProvider::get_feedback() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.feedback;
+	}
+
+	void DelayFilterProvider::set_feedback(float new_feedback)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.feedback = new_feedback;
+		parameters_changed = true;
+	}
+
+	float DelayFilterProvider::get_dry_level() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.dry_level;
+	}
+
+	void DelayFilterProvider::set_dry_level(float level)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.dry_level = level;
+		parameters_changed = true;
+	}
+
+	void DelayFilterProvider::update_taps(const Parameters &params)
+	{
+		int max_tap_delay = buffer_length - max_chunk_size - 2;
+
+		num_mixer_taps = params.num_taps;
+		min_delay = max_chunk_size;
+		for (int i = 0; i < num_mixer_taps; i++)
+		{
+			float delay = params.taps[i].delay * sample_rate / 1000.0f;
+			delay = std::max(1.0f, std::min(delay, (float)max_tap_delay));
+
+			mixer_taps[i].delay = (int)delay;
+			mixer_taps[i].fraction = delay - mixer_taps[i].delay;
+			mixer_taps[i].gain = params.taps[i].gain;
+			min_delay = std::min(min_delay, mixer_taps[i].delay);
+		}
+
+		feedback = params.feedback;
+		dry_level = params.dry_level;
+	}
+
+	void DelayFilterProvider::filter(float **sample_data, int num_samples, int channels)
+	{
+		if (parameters_changed)
+		{
+			// Never block the mixer. If the game thread holds the lock the change is picked up next block.
+			std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+			if (lock.owns_lock())
+			{
+				Parameters params = parameters;
+				parameters_changed = false;
+				lock.unlock();
+				update_taps(params);
+			}
+		}
+
+		channels = std::min(channels, (int)max_channels);
+		if ((int)buffers.size() < channels)
+		{
+			buffers.resize(channels);
+			for (auto & buffer : buffers)
+				buffer.resize(buffer_length * 2, 0.0f);
+		}
+
+		// A chunk never reads samples it writes itself, so taps shorter than a chunk shrink it
+		int pos = 0;
+		while (pos < num_samples)
+		{
+			int count = std::min(std::min(num_samples - pos, buffer_length - write_pos), min_delay);
+			for (int c = 0; c < channels; c++)
+				filter_chunk(sample_data[c] + pos, buffers[c].data(), count);
+
+			write_pos += count;
+			if (write_pos == buffer_length)
+				write_pos = 0;
+			pos += count;
+		}
+	}
+
+	void DelayFilterProvider::filter_chunk(float *data, float *buffer, int count)
+	{
+		for (int i = 0; i < count; i++)
+			tap_sum[i] = 0.0f;
+
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (count / 4) * 4;
+#else
+		const int sse_size = 0;
+#endif
+
+		for (int t = 0; t < num_mixer_taps; t++)
+		{
+			const MixerTap &tap = mixer_taps[t];
+			int start = write_pos - tap.delay - 1;
+			if (start < 0)
+				start += buffer_length;
+
+			// Linear interpolation between the sample at the whole delay and the one before it
+			const float *older = buffer + start;
+			const float *newer = older + 1;
+			float gain_newer = tap.gain * (1.0f - tap.fraction);
+			float gain_older = tap.gain * tap.fraction;
+
+#ifndef CL_DISABLE_SSE2
+			__m128 gain_newer0 = _mm_set1_ps(gain_newer);
+			__m128 gain_older0 = _mm_set1_ps(gain_older);
+			for (int i = 0; i < sse_size; i += 4)
+			{
+				__m128 sum = _mm_loadu_ps(tap_sum + i);
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(newer + i), gain_newer0));
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(older + i), gain_older0));
+				_mm_storeu_ps(tap_sum + i, sum);
+			}
+#endif
+			for (int i = sse_size; i < count; i++)
+				tap_sum[i] += newer[i] * gain_newer + older[i] * gain_older;
+		}
+
+		float *write = buffer + write_pos;
+		float *mirror = write + buffer_length;
+
+#ifndef CL_DISABLE_SSE2
+		__m128 feedback0 = _mm_set1_ps(feedback);
+		__m128 dry_level0 = _mm_set1_ps(dry_level);
+		for (int i = 0; i < sse_size; i += 4)
+		{
+			__m128 input = _mm_loadu_ps(data + i);
+			__m128 delayed = _mm_loadu_ps(tap_sum + i);
+			__m128 line = _mm_add_ps(input, _mm_mul_ps(delayed, feedback0));
+			_mm_storeu_ps(write + i, line);
+			_mm_storeu_ps(mirror + i, line);
+			_mm_storeu_ps(data + i, _mm_add_ps(_mm_mul_ps(input, dry_level0), delayed));
+		}
+#endif
+		for (int i = sse_size; i < count; i++)
+		{
+			float input = data[i];
+			float line = input + tap_sum[i] * feedback;
+			write[i] = line;
+			mirror[i] = line;
+			data[i] = input * dry_level + tap_sum[i];
+		}
+	}
+}
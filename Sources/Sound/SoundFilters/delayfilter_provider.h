@@ -0,0 +1,102 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/SoundProviders/soundfilter_provider.h"
+#include "API/Sound/SoundFilters/delayfilter.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace clan
+{
+	class DelayFilterProvider : public SoundFilterProvider
+	{
+	public:
+		DelayFilterProvider(float max_delay, int sample_rate);
+
+		void filter(float **sample_data, int num_samples, int channels) override;
+
+		int get_tap_count() const;
+		int add_tap(float delay, float gain);
+		void set_tap(int index, float delay, float gain);
+		void remove_taps();
+		float get_feedback() const;
+		void set_feedback(float feedback);
+		float get_dry_level() const;
+		void set_dry_level(float level);
+
+	private:
+		struct Tap
+		{
+			float delay;
+			float gain;
+		};
+
+		struct Parameters
+		{
+			Tap taps[DelayFilter::max_taps];
+			int num_taps;
+			float feedback;
+			float dry_level;
+		};
+
+		struct MixerTap
+		{
+			int delay;
+			float fraction;
+			float gain;
+		};
+
+		void update_taps(const Parameters &params);
+		void filter_chunk(float *data, float *buffer, int count);
+
+		static const int max_channels = 32;
+		static const int max_chunk_size = 64;
+
+		int sample_rate;
+
+		// Every sample is stored twice, at pos and pos + buffer_length, so any tap can read a chunk without wrapping
+		int buffer_length;
+		int write_pos;
+		std::vector<std::vector<float> > buffers;
+
+		mutable std::mutex mutex;
+		Parameters parameters;
+		std::atomic_bool parameters_changed;
+
+		MixerTap mixer_taps[DelayFilter::max_taps];
+		int num_mixer_taps;
+		int min_delay;
+		float feedback;
+		float dry_level;
+
+		float tap_sum[max_chunk_size];
+	};
+}
@@ -0,0 +1,97 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "API/Sound/SoundFilters/reverbfilter.h"
+#include "reverbfilter_provider.h"
+
+namespace clan
+{
+	ReverbFilter::ReverbFilter(int sample_rate) : SoundFilter(new ReverbFilterProvider(sample_rate))
+	{
+	}
+
+	ReverbFilter::~ReverbFilter()
+	{
+	}
+
+	ReverbFilterProvider *ReverbFilter::get_provider() const
+	{
+		return static_cast <ReverbFilterProvider *> (SoundFilter::get_provider());
+	}
+
+	float ReverbFilter::get_room_size() const
+	{
+		return get_provider()->get_room_size();
+	}
+
+	void ReverbFilter::set_room_size(float room_size)
+	{
+		get_provider()->set_room_size(room_size);
+	}
+
+	float ReverbFilter::get_damping() const
+	{
+		return get_provider()->get_damping();
+	}
+
+	void ReverbFilter::set_damping(float damping)
+	{
+		get_provider()->set_damping(damping);
+	}
+
+	float ReverbFilter::get_wet_level() const
+	{
+		return get_provider()->get_wet_level();
+	}
+
+	void ReverbFilter::set_wet_level(float level)
+	{
+		get_provider()->set_wet_level(level);
+	}
+
+	float ReverbFilter::get_dry_level() const
+	{
+		return get_provider()->get_dry_level();
+	}
+
+	void ReverbFilter::set_dry_level(float level)
+	{
+		get_provider()->set_dry_level(level);
+	}
+
+	float ReverbFilter::get_width() const
+	{
+		return get_provider()->get_width();
+	}
+
+	void ReverbFilter::set_width(float width)
+	{
+		get_provider()->set_width(width);
+	}
+}
@@ -0,0 +1,333 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "reverbfilter_provider.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	// Delay line lengths of the original Freeverb, for 44.1 kHz
+	static const int comb_tunings[8] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+	static const int allpass_tunings[4] = { 556, 441, 341, 225 };
+	static const int stereo_spread = 23;
+	static const float fixed_gain = 0.015f;
+	static const float allpass_feedback = 0.5f;
+
+	ReverbFilterProvider::ReverbFilterProvider(int sample_rate)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			int spread = side * stereo_spread;
+			for (int i = 0; i < num_combs; i++)
+			{
+				int length = std::max((comb_tunings[i] + spread) * sample_rate / 44100, 4);
+				combs[side][i].buffer.resize(length, 0.0f);
+				combs[side][i].pos = 0;
+				combs[side][i].store = 0.0f;
+			}
+			for (int i = 0; i < num_allpasses; i++)
+			{
+				int length = std::max((allpass_tunings[i] + spread) * sample_rate / 44100, 4);
+				allpasses[side][i].buffer.resize(length, 0.0f);
+				allpasses[side][i].pos = 0;
+				allpasses[side][i].store = 0.0f;
+			}
+		}
+
+		parameters.room_size = 0.5f;
+		parameters.damping = 0.5f;
+		parameters.wet_level = 1.0f;
+		parameters.dry_level = 1.0f;
+		parameters.width = 1.0f;
+		parameters_changed = false;
+		update_parameters(parameters);
+	}
+
+	float ReverbFilterProvider::get_room_size() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.room_size;
+	}
+
+	void ReverbFilterProvider::set_room_size(float room_size)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.room_size = room_size;
+		parameters_changed = true;
+	}
+
+	float ReverbFilterProvider::get_damping() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.damping;
+	}
+
+	void ReverbFilterProvider::set_damping(float damping)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.damping = damping;
+		parameters_changed = true;
+	}
+
+	float ReverbFilterProvider::get_wet_level() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.wet_level;
+	}
+
+	void ReverbFilterProvider::set_wet_level(float level)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.wet_level = level;
+		parameters_changed = true;
+	}
+
+	float ReverbFilterProvider::get_dry_level() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.dry_level;
+	}
+
+	void ReverbFilterProvider::set_dry_level(float level)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.dry_level = level;
+		parameters_changed = true;
+	}
+
+	float ReverbFilterProvider::get_width() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		return parameters.width;
+	}
+
+	void ReverbFilterProvider::set_width(float width)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		parameters.width = width;
+		parameters_changed = true;
+	}
+
+	void ReverbFilterProvider::update_parameters(const Parameters &params)
+	{
+		float room_size = std::max(0.0f, std::min(params.room_size, 1.0f));
+		float damping = std::max(0.0f, std::min(params.damping, 1.0f));
+		float width = std::max(0.0f, std::min(params.width, 1.0f));
+
+		feedback = room_size * 0.28f + 0.7f;
+		damp1 = damping * 0.4f;
+		damp2 = 1.0f - damp1;
+		wet1 = params.wet_level * (width * 0.5f + 0.5f);
+		wet2 = params.wet_level * ((1.0f - width) * 0.5f);
+		dry = params.dry_level;
+
+		// The comb filters damp with a one pole low pass: store = damp2 * input + damp1 * store
+		for (int column = 0; column < 5; column++)
+		{
+			float store = (column == 4) ? 1.0f : 0.0f;
+			for (int n = 0; n < 4; n++)
+			{
+				float input = (n == column) ? 1.0f : 0.0f;
+				store = damp2 * input + damp1 * store;
+				damp_coefficients[column][n] = store;
+			}
+		}
+	}
+
+	void ReverbFilterProvider::filter(float **sample_data, int num_samples, int channels)
+	{
+		if (parameters_changed)
+		{
+			// Never block the mixer. If the game thread holds the lock the change is picked up next block.
+			std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+			if (lock.owns_lock())
+			{
+				Parameters params = parameters;
+				parameters_changed = false;
+				lock.unlock();
+				update_parameters(params);
+			}
+		}
+
+		if (channels <= 0)
+			return;
+
+		int num_sides = std::min(channels, 2);
+		for (int pos = 0; pos < num_samples; pos += chunk_size)
+		{
+			int count = std::min((int)chunk_size, num_samples - pos);
+			float *left = sample_data[0] + pos;
+			float *right = (num_sides == 2) ? sample_data[1] + pos : left;
+
+			// Both sides are fed the same mono mix
+			for (int i = 0; i < count; i++)
+				input_mix[i] = (left[i] + right[i]) * fixed_gain;
+
+			for (int side = 0; side < num_sides; side++)
+			{
+				float *output = outputs[side];
+				for (int i = 0; i < count; i++)
+					output[i] = 0.0f;
+
+				for (auto & comb : combs[side])
+					process_comb(comb, input_mix, output, count);
+				for (auto & allpass : allpasses[side])
+					process_allpass(allpass, output, count);
+			}
+
+			if (num_sides == 2)
+			{
+				for (int i = 0; i < count; i++)
+				{
+					float out_left = outputs[0][i] * wet1 + outputs[1][i] * wet2 + left[i] * dry;
+					float out_right = outputs[1][i] * wet1 + outputs[0][i] * wet2 + right[i] * dry;
+					left[i] = out_left;
+					right[i] = out_right;
+				}
+			}
+			else
+			{
+				for (int i = 0; i < count; i++)
+					left[i] = outputs[0][i] * (wet1 + wet2) + left[i] * dry;
+			}
+		}
+	}
+
+	void ReverbFilterProvider::process_comb(DelayLine &comb, const float *input, float *output, int count)
+	{
+		float *buffer = comb.buffer.data();
+		int length = (int)comb.buffer.size();
+		float store = comb.store;
+
+		int i = 0;
+		while (i < count)
+		{
+			// Reads and writes stay apart by the delay length, so every segment up to the wrap point is independent
+			int segment = std::min(count - i, length - comb.pos);
+			float *line = buffer + comb.pos;
+			const float *in = input + i;
+			float *out = output + i;
+
+#ifndef CL_DISABLE_SSE2
+			int sse_size = (segment / 4) * 4;
+
+			__m128 c0 = _mm_loadu_ps(damp_coefficients[0]);
+			__m128 c1 = _mm_loadu_ps(damp_coefficients[1]);
+			__m128 c2 = _mm_loadu_ps(damp_coefficients[2]);
+			__m128 c3 = _mm_loadu_ps(damp_coefficients[3]);
+			__m128 c_store = _mm_loadu_ps(damp_coefficients[4]);
+			__m128 feedback0 = _mm_set1_ps(feedback);
+			__m128 store0 = _mm_set1_ps(store);
+
+			for (int k = 0; k < sse_size; k += 4)
+			{
+				__m128 y = _mm_loadu_ps(line + k);
+				_mm_storeu_ps(out + k, _mm_add_ps(_mm_loadu_ps(out + k), y));
+
+				__m128 s = _mm_mul_ps(c_store, store0);
+				s = _mm_add_ps(s, _mm_mul_ps(c0, _mm_shuffle_ps(y, y, _MM_SHUFFLE(0, 0, 0, 0))));
+				s = _mm_add_ps(s, _mm_mul_ps(c1, _mm_shuffle_ps(y, y, _MM_SHUFFLE(1, 1, 1, 1))));
+				s = _mm_add_ps(s, _mm_mul_ps(c2, _mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 2, 2, 2))));
+				s = _mm_add_ps(s, _mm_mul_ps(c3, _mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3))));
+				_mm_storeu_ps(line + k, _mm_add_ps(_mm_loadu_ps(in + k), _mm_mul_ps(s, feedback0)));
+
+				store0 = _mm_shuffle_ps(s, s, _MM_SHUFFLE(3, 3, 3, 3));
+			}
+			store = _mm_cvtss_f32(store0);
+#else
+			const int sse_size = 0;
+#endif
+
+			for (int k = sse_size; k < segment; k++)
+			{
+				float y = line[k];
+				out[k] += y;
+				store = y * damp2 + store * damp1;
+				line[k] = in[k] + store * feedback;
+			}
+
+			comb.pos += segment;
+			if (comb.pos == length)
+				comb.pos = 0;
+			i += segment;
+		}
+
+		// Denormals are very slow, and the tail of a decaying filter ends up there
+		if (std::abs(store) < 1e-20f)
+			store = 0.0f;
+		comb.store = store;
+	}
+
+	void ReverbFilterProvider::process_allpass(DelayLine &allpass, float *data, int count)
+	{
+		float *buffer = allpass.buffer.data();
+		int length = (int)allpass.buffer.size();
+
+		int i = 0;
+		while (i < count)
+		{
+			int segment = std::min(count - i, length - allpass.pos);
+			float *line = buffer + allpass.pos;
+			float *io = data + i;
+
+#ifndef CL_DISABLE_SSE2
+			int sse_size = (segment / 4) * 4;
+
+			__m128 feedback0 = _mm_set1_ps(allpass_feedback);
+			for (int k = 0; k < sse_size; k += 4)
+			{
+				__m128 input = _mm_loadu_ps(io + k);
+				__m128 delayed = _mm_loadu_ps(line + k);
+				_mm_storeu_ps(io + k, _mm_sub_ps(delayed, input));
+				_mm_storeu_ps(line + k, _mm_add_ps(input, _mm_mul_ps(delayed, feedback0)));
+			}
+#else
+			const int sse_size = 0;
+#endif
+
+			for (int k = sse_size; k < segment; k++)
+			{
+				float input = io[k];
+				float delayed = line[k];
+				io[k] = delayed - input;
+				line[k] = input + delayed * allpass_feedback;
+			}
+
+			allpass.pos += segment;
+			if (allpass.pos == length)
+				allpass.pos = 0;
+			i += segment;
+		}
+	}
+}
@@ -0,0 +1,98 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/SoundProviders/soundfilter_provider.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace clan
+{
+	class ReverbFilterProvider : public SoundFilterProvider
+	{
+	public:
+		ReverbFilterProvider(int sample_rate);
+
+		void filter(float **sample_data, int num_samples, int channels) override;
+
+		float get_room_size() const;
+		void set_room_size(float room_size);
+		float get_damping() const;
+		void set_damping(float damping);
+		float get_wet_level() const;
+		void set_wet_level(float level);
+		float get_dry_level() const;
+		void set_dry_level(float level);
+		float get_width() const;
+		void set_width(float width);
+
+	private:
+		struct Parameters
+		{
+			float room_size;
+			float damping;
+			float wet_level;
+			float dry_level;
+			float width;
+		};
+
+		struct DelayLine
+		{
+			std::vector<float> buffer;
+			int pos;
+			float store;
+		};
+
+		static const int num_combs = 8;
+		static const int num_allpasses = 4;
+		static const int chunk_size = 256;
+
+		void update_parameters(const Parameters &params);
+		void process_comb(DelayLine &comb, const float *input, float *output, int count);
+		void process_allpass(DelayLine &allpass, float *data, int count);
+
+		mutable std::mutex mutex;
+		Parameters parameters;
+		std::atomic_bool parameters_changed;
+
+		float feedback;
+		float damp1, damp2;
+		float wet1, wet2, dry;
+
+		// Response of four low pass outputs to each of four inputs and the previous output
+		float damp_coefficients[5][4];
+
+		DelayLine combs[2][num_combs];
+		DelayLine allpasses[2][num_allpasses];
+
+		float input_mix[chunk_size];
+		float outputs[2][chunk_size];
+	};
+}
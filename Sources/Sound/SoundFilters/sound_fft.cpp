@@ -0,0 +1,138 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_fft.h"
+#include <cmath>
+#include <utility>
+
+#ifndef CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	SoundFFT::SoundFFT(int size) : size(size)
+	{
+		if (size < 2 || (size & (size - 1)) != 0)
+			throw Exception("FFT size must be a power of two");
+
+		int bits = 0;
+		while ((1 << bits) < size)
+			bits++;
+
+		bit_reverse.resize(size);
+		for (int i = 0; i < size; i++)
+		{
+			int reversed = 0;
+			for (int b = 0; b < bits; b++)
+			{
+				if (i & (1 << b))
+					reversed |= 1 << (bits - 1 - b);
+			}
+			bit_reverse[i] = reversed;
+		}
+
+		const double pi = 3.14159265358979323846;
+		twiddle_real.resize(size);
+		twiddle_imag.resize(size);
+		for (int half = 1; half < size; half *= 2)
+		{
+			for (int j = 0; j < half; j++)
+			{
+				double angle = -pi * j / half;
+				twiddle_real[half + j] = (float)std::cos(angle);
+				twiddle_imag[half + j] = (float)std::sin(angle);
+			}
+		}
+	}
+
+	void SoundFFT::inverse(float *real, float *imag) const
+	{
+		// Swapping real and imaginary parts turns the forward transform into the inverse one
+		forward(imag, real);
+	}
+
+	void SoundFFT::forward(float *real, float *imag) const
+	{
+		for (int i = 0; i < size; i++)
+		{
+			int j = bit_reverse[i];
+			if (i < j)
+			{
+				std::swap(real[i], real[j]);
+				std::swap(imag[i], imag[j]);
+			}
+		}
+
+		for (int half = 1; half < size; half *= 2)
+		{
+			const float *w_real = twiddle_real.data() + half;
+			const float *w_imag = twiddle_imag.data() + half;
+
+			for (int block = 0; block < size; block += half * 2)
+			{
+				float *a_real = real + block;
+				float *a_imag = imag + block;
+				float *b_real = a_real + half;
+				float *b_imag = a_imag + half;
+
+#ifndef CL_DISABLE_SSE2
+				int sse_size = (half / 4) * 4;
+				for (int j = 0; j < sse_size; j += 4)
+				{
+					__m128 wr = _mm_loadu_ps(w_real + j);
+					__m128 wi = _mm_loadu_ps(w_imag + j);
+					__m128 br = _mm_loadu_ps(b_real + j);
+					__m128 bi = _mm_loadu_ps(b_imag + j);
+					__m128 tr = _mm_sub_ps(_mm_mul_ps(br, wr), _mm_mul_ps(bi, wi));
+					__m128 ti = _mm_add_ps(_mm_mul_ps(br, wi), _mm_mul_ps(bi, wr));
+					__m128 ar = _mm_loadu_ps(a_real + j);
+					__m128 ai = _mm_loadu_ps(a_imag + j);
+					_mm_storeu_ps(a_real + j, _mm_add_ps(ar, tr));
+					_mm_storeu_ps(a_imag + j, _mm_add_ps(ai, ti));
+					_mm_storeu_ps(b_real + j, _mm_sub_ps(ar, tr));
+					_mm_storeu_ps(b_imag + j, _mm_sub_ps(ai, ti));
+				}
+#else
+				const int sse_size = 0;
+#endif
+
+				for (int j = sse_size; j < half; j++)
+				{
+					float tr = b_real[j] * w_real[j] - b_imag[j] * w_imag[j];
+					float ti = b_real[j] * w_imag[j] + b_imag[j] * w_real[j];
+					b_real[j] = a_real[j] - tr;
+					b_imag[j] = a_imag[j] - ti;
+					a_real[j] += tr;
+					a_imag[j] += ti;
+				}
+			}
+		}
+	}
+}
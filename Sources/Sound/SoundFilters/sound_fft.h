@@ -0,0 +1,58 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <vector>
+
+namespace clan
+{
+	/// \brief Radix-2 complex FFT on split real and imaginary arrays
+	class SoundFFT
+	{
+	public:
+		/// \brief Constructs an FFT for the given size, which must be a power of two
+		SoundFFT(int size);
+
+		int get_size() const { return size; }
+
+		/// \brief Transforms in place from time to frequency domain
+		void forward(float *real, float *imag) const;
+
+		/// \brief Transforms in place from frequency to time domain. The result is not divided by the size.
+		void inverse(float *real, float *imag) const;
+
+	private:
+		int size;
+		std::vector<int> bit_reverse;
+
+		// The twiddle factors of the stage that combines blocks of length half start at index half
+		std::vector<float> twiddle_real;
+		std::vector<float> twiddle_imag;
+	};
+}
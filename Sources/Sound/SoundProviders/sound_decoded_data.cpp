@@ -0,0 +1,95 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_decoded_data.h"
+#include "Mixer/sound_resampler.h"
+#include "API/Sound/SoundProviders/soundprovider.h"
+#include "API/Sound/SoundProviders/soundprovider_session.h"
+#include <chrono>
+#include <thread>
+
+namespace clan
+{
+	SoundDecodedData::SoundDecodedData(int num_channels, int num_samples, int frequency)
+		: num_samples(num_samples), frequency(frequency), storage(num_channels), channels(num_channels)
+	{
+		int padding = SoundResampler::get_input_padding();
+		for (int c = 0; c < num_channels; c++)
+		{
+			storage[c].resize(padding + num_samples + padding, 0.0f);
+			channels[c] = storage[c].data() + padding;
+		}
+	}
+
+	std::shared_ptr<SoundDecodedData> SoundDecodedData::decode(SoundProvider *provider, float max_seconds)
+	{
+		SoundProvider_Session *session = provider->begin_session();
+
+		int length = session->get_num_samples();
+		int frequency = session->get_frequency();
+		int num_channels = session->get_num_channels();
+		if (length <= 0 || num_channels <= 0 || length > max_seconds * frequency)
+		{
+			provider->end_session(session);
+			return std::shared_ptr<SoundDecodedData>();
+		}
+
+		std::shared_ptr<SoundDecodedData> decoded(new SoundDecodedData(num_channels, length, frequency));
+		std::vector<float *> output(num_channels);
+
+		session->play();
+		int position = 0;
+		int stalls = 0;
+		while (position < length && !session->eof())
+		{
+			for (int c = 0; c < num_channels; c++)
+				output[c] = decoded->storage[c].data() + SoundResampler::get_input_padding() + position;
+
+			int samples = session->get_data(output.data(), length - position);
+			position += samples;
+
+			// Providers decoding on another thread may not have the next samples ready yet
+			if (samples > 0)
+			{
+				stalls = 0;
+			}
+			else
+			{
+				if (++stalls == 1000)
+					break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+
+		provider->end_session(session);
+
+		decoded->num_samples = position;
+		return decoded;
+	}
+}
@@ -0,0 +1,68 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace clan
+{
+	class SoundProvider;
+
+	/// \brief Fully decoded samples of a sound provider
+	///
+	/// The data is immutable once decoded, so any number of sessions can read it at the same time.
+	/// Channels are stored planar and padded with silence at both ends, allowing the resampler to
+	/// read them in place.
+	class SoundDecodedData
+	{
+	public:
+		/// \brief Decodes all samples of a provider
+		///
+		/// \param provider Provider to decode
+		/// \param max_seconds Longest sound to decode. Longer sounds are better streamed.
+		/// \return The decoded data, or null if the sound is too long or its length is unknown
+		static std::shared_ptr<SoundDecodedData> decode(SoundProvider *provider, float max_seconds);
+
+		int get_num_samples() const { return num_samples; }
+		int get_frequency() const { return frequency; }
+		int get_num_channels() const { return (int)channels.size(); }
+
+		/// \brief Returns the first sample of each channel
+		const float *const *get_channels() const { return channels.data(); }
+
+	private:
+		SoundDecodedData(int num_channels, int num_samples, int frequency);
+
+		int num_samples;
+		int frequency;
+		std::vector<std::vector<float> > storage;
+		std::vector<const float *> channels;
+	};
+}
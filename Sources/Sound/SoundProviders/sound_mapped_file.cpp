@@ -0,0 +1,112 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_mapped_file.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/Text/string_help.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace clan
+{
+#ifdef WIN32
+
+	SoundMappedFile::SoundMappedFile(const std::string &filename) : data(nullptr), size(0), mapping(nullptr)
+	{
+		HANDLE file = CreateFile(StringHelp::utf8_to_ucs2(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw Exception("Unable to open " + filename);
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			throw Exception("Unable to map empty file " + filename);
+		}
+
+		// The mapping keeps the file open
+		mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr)
+			throw Exception("Unable to map " + filename);
+
+		data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (data == nullptr)
+		{
+			CloseHandle(mapping);
+			throw Exception("Unable to map " + filename);
+		}
+		size = (size_t)file_size.QuadPart;
+	}
+
+	SoundMappedFile::~SoundMappedFile()
+	{
+		UnmapViewOfFile(data);
+		CloseHandle(mapping);
+	}
+
+#else
+
+	SoundMappedFile::SoundMappedFile(const std::string &filename) : data(nullptr), size(0)
+	{
+		int file = open(filename.c_str(), O_RDONLY);
+		if (file == -1)
+			throw Exception("Unable to open " + filename);
+
+		struct stat file_stat;
+		if (fstat(file, &file_stat) == -1 || file_stat.st_size == 0)
+		{
+			close(file);
+			throw Exception("Unable to map empty file " + filename);
+		}
+		size = (size_t)file_stat.st_size;
+
+		// The mapping keeps the file open
+		void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+		close(file);
+		if (address == MAP_FAILED)
+			throw Exception("Unable to map " + filename);
+
+		// Ask for the pages to be read ahead now, so the mixer thread does not stall on page faults later
+		madvise(address, size, MADV_WILLNEED);
+		data = (const char *)address;
+	}
+
+	SoundMappedFile::~SoundMappedFile()
+	{
+		munmap((void *)data, size);
+	}
+
+#endif
+}
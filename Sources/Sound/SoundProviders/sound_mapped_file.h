@@ -0,0 +1,60 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <string>
+
+namespace clan
+{
+	/// \brief Read-only memory mapping of a whole file
+	///
+	/// Sound data played from a mapping is paged in by the operating system and shared between all
+	/// sessions and processes using the file, instead of being copied into the heap.
+	class SoundMappedFile
+	{
+	public:
+		/// \brief Maps the file. Throws an exception if it cannot be opened or mapped.
+		SoundMappedFile(const std::string &filename);
+		~SoundMappedFile();
+
+		const char *get_data() const { return data; }
+		size_t get_size() const { return size; }
+
+	private:
+		const char *data;
+		size_t size;
+
+#ifdef WIN32
+		HANDLE mapping;
+#endif
+
+		SoundMappedFile(const SoundMappedFile &) = delete;
+		SoundMappedFile &operator =(const SoundMappedFile &) = delete;
+	};
+}
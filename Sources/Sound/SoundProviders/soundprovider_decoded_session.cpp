@@ -0,0 +1,112 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "soundprovider_decoded_session.h"
+#include "API/Sound/sound_sse.h"
+#include "API/Core/System/exception.h"
+#include <algorithm>
+
+namespace clan
+{
+	SoundProvider_Decoded_Session::SoundProvider_Decoded_Session(const std::shared_ptr<const SoundDecodedData> &data) :
+		data(data), position(0)
+	{
+		end_position = data->get_num_samples();
+	}
+
+	SoundProvider_Decoded_Session::~SoundProvider_Decoded_Session()
+	{
+	}
+
+	int SoundProvider_Decoded_Session::get_num_samples() const
+	{
+		return data->get_num_samples();
+	}
+
+	int SoundProvider_Decoded_Session::get_frequency() const
+	{
+		return data->get_frequency();
+	}
+
+	int SoundProvider_Decoded_Session::get_num_channels() const
+	{
+		return data->get_num_channels();
+	}
+
+	int SoundProvider_Decoded_Session::get_position() const
+	{
+		return position;
+	}
+
+	bool SoundProvider_Decoded_Session::eof() const
+	{
+		return (position >= end_position);
+	}
+
+	void SoundProvider_Decoded_Session::stop()
+	{
+	}
+
+	bool SoundProvider_Decoded_Session::play()
+	{
+		return true;
+	}
+
+	bool SoundProvider_Decoded_Session::set_position(int pos)
+	{
+		if (pos < 0 || pos > data->get_num_samples())
+			return false;
+		position = pos;
+		return true;
+	}
+
+	bool SoundProvider_Decoded_Session::set_end_position(int pos)
+	{
+		if (pos > data->get_num_samples())
+			throw Exception("Attempted to set the sample end position higher than the number of samples");
+		end_position = pos;
+		return true;
+	}
+
+	int SoundProvider_Decoded_Session::get_data(float **data_ptr, int data_requested)
+	{
+		int retrieved = std::max(std::min(data_requested, end_position - position), 0);
+		for (int c = 0; c < data->get_num_channels(); c++)
+			SoundSSE::copy_float(data->get_channels()[c] + position, retrieved, data_ptr[c]);
+		position += retrieved;
+		return retrieved;
+	}
+
+	int SoundProvider_Decoded_Session::skip_data(int data_requested)
+	{
+		int skipped = std::max(std::min(data_requested, end_position - position), 0);
+		position += skipped;
+		return skipped;
+	}
+}
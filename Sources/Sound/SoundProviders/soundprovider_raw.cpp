@@ -38,13 +38,22 @@ namespace clan
 		int num_samples,
 		int bytes_per_sample,
 		bool stereo,
-		int frequency) : impl(std::make_shared<SoundProvider_Raw_Impl>())
+		int frequency,
+		bool copy_data) : impl(std::make_shared<SoundProvider_Raw_Impl>())
 	{
 		int data_size = num_samples * bytes_per_sample;
 		if (stereo) data_size *= 2;
 
-		impl->sound_data = new unsigned char[data_size];
-		memcpy(impl->sound_data, sound_data, data_size);
+		if (copy_data)
+		{
+			impl->sound_data = new unsigned char[data_size];
+			memcpy(impl->sound_data, sound_data, data_size);
+			impl->owns_data = true;
+		}
+		else
+		{
+			impl->sound_data = (unsigned char *)sound_data;
+		}
 		impl->num_samples = num_samples;
 		impl->bytes_per_sample = bytes_per_sample;
 		impl->stereo = stereo;
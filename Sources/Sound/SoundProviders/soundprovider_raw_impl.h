@@ -33,17 +33,20 @@ namespace clan
 	class SoundProvider_Raw_Impl
 	{
 	public:
-		SoundProvider_Raw_Impl() : sound_data(nullptr)
+		SoundProvider_Raw_Impl() : sound_data(nullptr), owns_data(false)
 		{
 		}
 
 		~SoundProvider_Raw_Impl()
 		{
-			if (sound_data)
+			if (owns_data)
 				delete[] sound_data;
 		}
 
 		unsigned char *sound_data;
+
+		/// \brief False if sound_data belongs to the application
+		bool owns_data;
 		int num_samples;
 		int bytes_per_sample;
 		bool stereo;
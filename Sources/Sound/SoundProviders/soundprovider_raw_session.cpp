@@ -97,12 +97,12 @@ namespace clan
 		{
 			if (source.impl->stereo)
 			{
-				short *src = (short *)source.impl->sound_data + position * source.impl->bytes_per_sample;
-				SoundSSE::unpack_16bit_stereo(src, data_requested, data_ptr);
+				short *src = (short *)source.impl->sound_data + position * 2;
+				SoundSSE::unpack_16bit_stereo(src, data_requested * 2, data_ptr);
 			}
 			else
 			{
-				short *src = (short *)source.impl->sound_data + position * source.impl->bytes_per_sample;
+				short *src = (short *)source.impl->sound_data + position;
 				SoundSSE::unpack_16bit_mono(src, data_requested, data_ptr[0]);
 			}
 		}
@@ -110,12 +110,12 @@ namespace clan
 		{
 			if (source.impl->stereo)
 			{
-				unsigned char *src = (unsigned char *)source.impl->sound_data + position * source.impl->bytes_per_sample;
-				SoundSSE::unpack_8bit_stereo(src, data_requested, data_ptr);
+				unsigned char *src = (unsigned char *)source.impl->sound_data + position * 2;
+				SoundSSE::unpack_8bit_stereo(src, data_requested * 2, data_ptr);
 			}
 			else
 			{
-				unsigned char *src = (unsigned char *)source.impl->sound_data + position * source.impl->bytes_per_sample;
+				unsigned char *src = (unsigned char *)source.impl->sound_data + position;
 				SoundSSE::unpack_8bit_mono(src, data_requested, data_ptr[0]);
 			}
 		}
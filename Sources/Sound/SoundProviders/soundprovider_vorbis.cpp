@@ -30,6 +30,8 @@
 #include "API/Sound/SoundProviders/soundprovider_vorbis.h"
 #include "API/Core/IOData/iodevice.h"
 #include "API/Core/IOData/file_system.h"
+#include "API/Core/IOData/memory_device.h"
+#include "API/Core/System/exception.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/IOData/path_help.h"
 #include "soundprovider_vorbis_impl.h"
@@ -44,7 +46,7 @@ namespace clan
 		: impl(std::make_shared<SoundProvider_Vorbis_Impl>())
 	{
 		IODevice input = fs.open_file(filename, File::open_existing, File::access_read, File::share_all);
-		impl->load(input);
+		impl->load(input, stream);
 	}
 
 	SoundProvider_Vorbis::SoundProvider_Vorbis(
@@ -55,14 +57,14 @@ namespace clan
 		std::string filename = PathHelp::get_filename(fullname, PathHelp::path_type_file);
 		FileSystem vfs(path);
 		IODevice input = vfs.open_file(filename, File::open_existing, File::access_read, File::share_all);
-		impl->load(input);
+		impl->load(input, stream);
 	}
 
 	SoundProvider_Vorbis::SoundProvider_Vorbis(
 		IODevice &file, bool stream)
 		: impl(std::make_shared<SoundProvider_Vorbis_Impl>())
 	{
-		impl->load(file);
+		impl->load(file, stream);
 	}
 
 	SoundProvider_Vorbis::~SoundProvider_Vorbis()
@@ -79,11 +81,32 @@ namespace clan
 		delete session;
 	}
 
-	void SoundProvider_Vorbis_Impl::load(IODevice &input)
+	void SoundProvider_Vorbis_Impl::load(IODevice &input, bool stream)
 	{
+		if (stream)
+		{
+			// Every session reads from its own duplicate of the device
+			try
+			{
+				stream_device = input.duplicate();
+				return;
+			}
+			catch (const Exception &)
+			{
+			}
+		}
+
 		int size = input.get_size();
 		buffer = DataBuffer(size);
 		int bytes_read = input.read(buffer.get_data(), buffer.get_size());
 		buffer.set_size(bytes_read);
 	}
+
+	IODevice SoundProvider_Vorbis_Impl::open_device()
+	{
+		if (!stream_device.is_null())
+			return stream_device.duplicate();
+		else
+			return MemoryDevice(buffer);
+	}
 }
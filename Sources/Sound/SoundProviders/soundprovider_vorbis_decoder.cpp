@@ -0,0 +1,96 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "soundprovider_vorbis_decoder.h"
+#include "soundprovider_vorbis_session.h"
+#include <algorithm>
+
+namespace clan
+{
+	std::mutex SoundProvider_Vorbis_Decoder::instance_mutex;
+	std::weak_ptr<SoundProvider_Vorbis_Decoder> SoundProvider_Vorbis_Decoder::instance;
+
+	SoundProvider_Vorbis_Decoder::SoundProvider_Vorbis_Decoder() : wake_flag(false), stop_flag(false)
+	{
+		thread = std::thread(&SoundProvider_Vorbis_Decoder::thread_main, this);
+	}
+
+	SoundProvider_Vorbis_Decoder::~SoundProvider_Vorbis_Decoder()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stop_flag = true;
+		lock.unlock();
+		wake_condition.notify_all();
+		thread.join();
+	}
+
+	std::shared_ptr<SoundProvider_Vorbis_Decoder> SoundProvider_Vorbis_Decoder::get_instance()
+	{
+		std::unique_lock<std::mutex> lock(instance_mutex);
+		std::shared_ptr<SoundProvider_Vorbis_Decoder> decoder = instance.lock();
+		if (!decoder)
+		{
+			decoder = std::make_shared<SoundProvider_Vorbis_Decoder>();
+			instance = decoder;
+		}
+		return decoder;
+	}
+
+	void SoundProvider_Vorbis_Decoder::add(SoundProvider_Vorbis_Session *session)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		sessions.push_back(session);
+	}
+
+	void SoundProvider_Vorbis_Decoder::remove(SoundProvider_Vorbis_Session *session)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		sessions.erase(std::remove(sessions.begin(), sessions.end(), session), sessions.end());
+	}
+
+	void SoundProvider_Vorbis_Decoder::wake()
+	{
+		// A wake-up lost between the check and the wait in thread_main is caught by the timeout
+		wake_flag = true;
+		wake_condition.notify_one();
+	}
+
+	void SoundProvider_Vorbis_Decoder::thread_main()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!stop_flag)
+		{
+			wake_condition.wait_for(lock, std::chrono::milliseconds(10), [&]() { return stop_flag || wake_flag; });
+			wake_flag = false;
+
+			for (auto & session : sessions)
+				session->decode_ahead();
+		}
+	}
+}
@@ -0,0 +1,75 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace clan
+{
+	class SoundProvider_Vorbis_Session;
+
+	/// \brief Background thread decoding all Ogg Vorbis sessions ahead of the mixer
+	///
+	/// The thread is shared by all sessions and exits when the last session is destroyed.
+	class SoundProvider_Vorbis_Decoder
+	{
+	public:
+		SoundProvider_Vorbis_Decoder();
+		~SoundProvider_Vorbis_Decoder();
+
+		/// \brief Returns the decoder, starting its thread if no session is using it
+		static std::shared_ptr<SoundProvider_Vorbis_Decoder> get_instance();
+
+		void add(SoundProvider_Vorbis_Session *session);
+
+		/// \brief Removes a session. Waits if the thread is decoding right now.
+		void remove(SoundProvider_Vorbis_Session *session);
+
+		/// \brief Asks the thread to top up the rings. Never blocks, so the mixer may call it.
+		void wake();
+
+	private:
+		void thread_main();
+
+		std::vector<SoundProvider_Vorbis_Session *> sessions;
+		std::mutex mutex;
+		std::condition_variable wake_condition;
+		std::atomic_bool wake_flag;
+		bool stop_flag;
+		std::thread thread;
+
+		static std::mutex instance_mutex;
+		static std::weak_ptr<SoundProvider_Vorbis_Decoder> instance;
+	};
+}
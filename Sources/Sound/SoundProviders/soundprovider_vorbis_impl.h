@@ -30,6 +30,7 @@
 
 #include "API/Sound/soundformat.h"
 #include "API/Core/System/databuffer.h"
+#include "API/Core/IOData/iodevice.h"
 #include <string>
 
 namespace clan
@@ -37,8 +38,13 @@ namespace clan
 	class SoundProvider_Vorbis_Impl
 	{
 	public:
-		void load(IODevice &input);
+		/// \brief Keeps a device to stream from if stream is true and the device can be duplicated, otherwise loads the data to memory
+		void load(IODevice &input, bool stream);
+
+		/// \brief Returns a device positioned at the start of the data for a new session
+		IODevice open_device();
 
 		DataBuffer buffer;
+		IODevice stream_device;
 	};
 }
@@ -29,33 +29,53 @@
 #include "Sound/precomp.h"
 #include "soundprovider_vorbis_session.h"
 #include "soundprovider_vorbis_impl.h"
+#include "soundprovider_vorbis_decoder.h"
 #include "API/Sound/soundformat.h"
 #include "API/Core/IOData/iodevice.h"
-#include "API/Core/IOData/memory_device.h"
 #include "API/Core/System/exception.h"
+#include <algorithm>
+#include <cstring>
 
 namespace clan
 {
 	SoundProvider_Vorbis_Session::SoundProvider_Vorbis_Session(SoundProvider_Vorbis &source) :
-		source(source), position(0), stream_eof(false), handle(nullptr), stream_byte_offset(0), pcm(nullptr), pcm_position(0), pcm_samples(0)
+		source(source), device_size(0), serial_number(0), audio_start(0), handle(nullptr), num_samples(-1),
+		input_pos(0), input_end(0), input_eof(false), pcm(nullptr), pcm_position(0), pcm_samples(0),
+		decoder_generation(0), write_pos(0), decoder_end(false), seek_position(-1),
+		write_state(0), read_pos(0), generation(0), seek_target(0), looping(false), position(0), stream_eof(false)
 	{
-		int error = 0;
-		handle = stb_vorbis_open_pushdata(source.impl->buffer.get_data<unsigned char>(), source.impl->buffer.get_size(), &stream_byte_offset, &error, nullptr);
-		if (handle == nullptr)
+		device = source.impl->open_device();
+		device_size = device.get_size();
+
+		unsigned char header[27];
+		if (device.read(header, 27) != 27 || memcmp(header, "OggS", 4) != 0)
 			throw Exception("Unable to read ogg file");
+		serial_number = header[14] | (header[15] << 8) | (header[16] << 16) | ((uint32_t)header[17] << 24);
 
-		stream_info = stb_vorbis_get_info(handle);
+		num_samples = find_num_samples();
+
+		open_stream();
+		audio_start = input_pos;
+		ring.resize(stream_info.channels, std::vector<float>(ring_size));
+
+		// Decode the first part of the stream here, so the mixer has data as soon as the session is played
+		decode_ahead();
+
+		decoder = SoundProvider_Vorbis_Decoder::get_instance();
+		decoder->add(this);
 	}
 
 	SoundProvider_Vorbis_Session::~SoundProvider_Vorbis_Session()
 	{
+		if (decoder)
+			decoder->remove(this);
 		if (handle)
 			stb_vorbis_close(handle);
 	}
 
 	int SoundProvider_Vorbis_Session::get_num_samples() const
 	{
-		return -1;
+		return num_samples;
 	}
 
 	int SoundProvider_Vorbis_Session::get_frequency() const
@@ -73,6 +93,15 @@ namespace clan
 		return position;
 	}
 
+	bool SoundProvider_Vorbis_Session::set_looping(bool loop)
+	{
+		// The decoder continues at the start of the stream by itself, so looping is gapless
+		looping = loop;
+		if (decoder)
+			decoder->wake();
+		return true;
+	}
+
 	bool SoundProvider_Vorbis_Session::eof() const
 	{
 		return stream_eof;
@@ -89,58 +118,321 @@ namespace clan
 
 	bool SoundProvider_Vorbis_Session::set_position(int pos)
 	{
-		// Currently only support seeking to beginning of stream.
-		if (pos != 0) return false;
+		if (pos < 0 || (num_samples >= 0 && pos > num_samples))
+			return false;
 
+		// The decoder thread seeks once it sees the new generation. Until then the ring reads as empty.
+		seek_target = pos;
+		generation.fetch_add(1, std::memory_order_release);
+		position = pos;
+		stream_eof = false;
+		decoder->wake();
+		return true;
+	}
+
+	int SoundProvider_Vorbis_Session::get_data(float **channels, int data_requested)
+	{
+		uint64_t state = write_state.load(std::memory_order_acquire);
+		if (state_generation(state) != (generation.load(std::memory_order_relaxed) & 0x7fffffff))
+		{
+			decoder->wake();
+			return 0;
+		}
+
+		unsigned int pos = read_pos.load(std::memory_order_relaxed);
+		unsigned int available = state_write_pos(state) - pos;
+		int count = std::min((int)available, data_requested);
+
+		int start = pos & (ring_size - 1);
+		int first_count = std::min(count, ring_size - start);
+		for (int j = 0; j < stream_info.channels; j++)
+		{
+			memcpy(channels[j], ring[j].data() + start, first_count * sizeof(float));
+			memcpy(channels[j] + first_count, ring[j].data(), (count - first_count) * sizeof(float));
+		}
+
+		read_pos.store(pos + count, std::memory_order_release);
+		position += count;
+
+		if (count == (int)available && state_end(state))
+			stream_eof = true;
+		else if (available - count < ring_size / 2)
+			decoder->wake();
+
+		return count;
+	}
+
+	void SoundProvider_Vorbis_Session::decode_ahead()
+	{
+		try
+		{
+			unsigned int current_generation = generation.load(std::memory_order_acquire);
+			if (current_generation != decoder_generation)
+			{
+				// The mixer does not read the ring until the new generation is published, so the ring can be restarted at its read position
+				decoder_generation = current_generation;
+				write_pos = read_pos.load(std::memory_order_acquire);
+				decoder_end = false;
+				seek(seek_target);
+				publish();
+			}
+
+			bool decoded_since_open = true;
+			while (!decoder_end && generation.load(std::memory_order_relaxed) == decoder_generation)
+			{
+				unsigned int space = ring_size - (write_pos - read_pos.load(std::memory_order_acquire));
+				if (space == 0)
+					break;
+
+				if (pcm_position == pcm_samples)
+				{
+					if (decode_frame())
+					{
+						decoded_since_open = true;
+					}
+					else if (looping && decoded_since_open)
+					{
+						open_stream();
+						decoded_since_open = false;
+						continue;
+					}
+					else
+					{
+						decoder_end = true;
+						publish();
+						break;
+					}
+				}
+
+				int count = std::min((int)space, pcm_samples - pcm_position);
+				int start = write_pos & (ring_size - 1);
+				int first_count = std::min(count, ring_size - start);
+				for (int j = 0; j < stream_info.channels; j++)
+				{
+					memcpy(ring[j].data() + start, pcm[j] + pcm_position, first_count * sizeof(float));
+					memcpy(ring[j].data(), pcm[j] + pcm_position + first_count, (count - first_count) * sizeof(float));
+				}
+
+				pcm_position += count;
+				write_pos += count;
+				publish();
+			}
+		}
+		catch (const Exception &)
+		{
+			// A read error ends the stream
+			decoder_end = true;
+			publish();
+		}
+	}
+
+	void SoundProvider_Vorbis_Session::publish()
+	{
+		write_state.store(pack_state(decoder_generation, decoder_end, write_pos), std::memory_order_release);
+	}
+
+	void SoundProvider_Vorbis_Session::open_stream()
+	{
 		if (handle)
 			stb_vorbis_close(handle);
 		handle = nullptr;
-		stream_byte_offset = 0;
 
-		int error = 0;
-		handle = stb_vorbis_open_pushdata(source.impl->buffer.get_data<unsigned char>(), source.impl->buffer.get_size(), &stream_byte_offset, &error, nullptr);
-		if (handle == nullptr)
+		device.seek(0);
+		input_pos = 0;
+		input_end = 0;
+		input_eof = false;
+		if (!read_input())
 			throw Exception("Unable to read ogg file");
 
+		while (true)
+		{
+			int used = 0;
+			int error = 0;
+			handle = stb_vorbis_open_pushdata(input.data(), input_end, &used, &error, nullptr);
+			if (handle)
+			{
+				input_pos = used;
+				break;
+			}
+			if (error != VORBIS_need_more_data || !read_input())
+				throw Exception("Unable to read ogg file");
+		}
+
 		stream_info = stb_vorbis_get_info(handle);
-		stream_eof = false;
-		return true;
+		pcm = nullptr;
+		pcm_position = 0;
+		pcm_samples = 0;
+		seek_position = -1;
 	}
 
-	int SoundProvider_Vorbis_Session::get_data(float **channels, int data_requested)
+	bool SoundProvider_Vorbis_Session::decode_frame()
 	{
-		int data_left = data_requested;
-		while (!eof() && data_left > 0)
+		while (true)
 		{
-			while (pcm_position == pcm_samples)
+			float **output = nullptr;
+			int samples = 0;
+			int used = stb_vorbis_decode_frame_pushdata(handle, input.data() + input_pos, input_end - input_pos, nullptr, &output, &samples);
+			if (used == 0 && samples == 0)
 			{
-				pcm = nullptr;
-				pcm_position = 0;
-				pcm_samples = 0;
-				int bytes_used = stb_vorbis_decode_frame_pushdata(handle, source.impl->buffer.get_data<unsigned char>() + stream_byte_offset, source.impl->buffer.get_size() - stream_byte_offset, nullptr, &pcm, &pcm_samples);
-				stream_byte_offset += bytes_used;
-				if (bytes_used == 0 || stream_byte_offset == source.impl->buffer.get_size())
-				{
-					stream_eof = true;
-					break;
-				}
+				// stb_vorbis needs a complete page
+				if (!read_input())
+					return false;
+				continue;
+			}
+
+			input_pos += used;
+			if (samples == 0)
+				continue;
+
+			int skip = 0;
+			if (seek_position >= 0)
+			{
+				// The sample offset is unknown until the end of the first page after a seek
+				int next_sample = stb_vorbis_get_sample_offset(handle);
+				if (next_sample < 0 || next_sample <= seek_position)
+					continue;
+
+				skip = std::max(seek_position - (next_sample - samples), 0);
+				seek_position = -1;
 			}
 
-			int samples = pcm_samples - pcm_position;
-			if (samples > data_left) samples = data_left;
+			pcm = output;
+			pcm_position = skip;
+			pcm_samples = samples;
+			return true;
+		}
+	}
+
+	bool SoundProvider_Vorbis_Session::read_input()
+	{
+		if (input_eof)
+			return false;
+
+		if (input_pos > 0)
+		{
+			memmove(input.data(), input.data() + input_pos, input_end - input_pos);
+			input_end -= input_pos;
+			input_pos = 0;
+		}
+
+		if ((int)input.size() - input_end < input_chunk_size)
+		{
+			// No valid page is this big
+			if ((int)input.size() >= max_input_size)
+				return false;
+			input.resize(std::min(std::max((int)input.size() * 2, input_end + input_chunk_size), (int)max_input_size));
+		}
+
+		int bytes = device.read(input.data() + input_end, (int)input.size() - input_end, false);
+		if (bytes <= 0)
+		{
+			input_eof = true;
+			return false;
+		}
+		input_end += bytes;
+		return true;
+	}
 
-			int buffer_pos = data_requested - data_left;
-			for (int j = 0; j < stream_info.channels; j++)
+	void SoundProvider_Vorbis_Session::seek(int pos)
+	{
+		// Bisect for the last page that completes at or before pos, using the granule positions of the pages
+		OggPage page;
+		OggPage best = { audio_start, 0, 0 };
+		int low = audio_start;
+		int high = device_size;
+		while (high - low > input_chunk_size)
+		{
+			int middle = low + (high - low) / 2;
+			if (find_page(middle, high, page) && page.granule_position >= 0 && page.granule_position <= pos)
 			{
-				memcpy(&channels[j][buffer_pos], &pcm[j][pcm_position], samples*sizeof(float));
+				best = page;
+				low = page.offset + page.size;
 			}
+			else
+			{
+				high = middle;
+			}
+		}
+
+		int offset = low;
+		while (find_page(offset, device_size, page) && page.granule_position <= pos)
+		{
+			if (page.granule_position >= 0)
+				best = page;
+			offset = page.offset + page.size;
+		}
+
+		if (best.offset == audio_start)
+		{
+			// The first frames have known positions when decoding from the start of the stream
+			open_stream();
+			seek_position = pos;
+			return;
+		}
 
-			pcm_position += samples;
-			data_left -= samples;
+		// Samples from the end of the page onwards get known positions. Decode from the page and drop what is before pos.
+		stb_vorbis_flush_pushdata(handle);
+		device.seek(best.offset);
+		input_pos = 0;
+		input_end = 0;
+		input_eof = false;
+		pcm = nullptr;
+		pcm_position = 0;
+		pcm_samples = 0;
+		seek_position = pos;
+	}
+
+	bool SoundProvider_Vorbis_Session::find_page(int offset, int end_offset, OggPage &page)
+	{
+		// A page is at most 65307 bytes, so the next page header must start within that distance
+		const int max_page_size = 65307;
+		std::vector<unsigned char> buffer(std::min(max_page_size + 27 + 255, std::max(end_offset - offset, 0)));
+		if (buffer.size() < 27)
+			return false;
+
+		device.seek(offset);
+		int bytes = device.read(buffer.data(), (int)buffer.size(), false);
+		for (int i = 0; i + 27 <= bytes; i++)
+		{
+			const unsigned char *header = buffer.data() + i;
+			if (memcmp(header, "OggS", 4) != 0 || header[4] != 0)
+				continue;
+
+			uint32_t serial = header[14] | (header[15] << 8) | (header[16] << 16) | ((uint32_t)header[17] << 24);
+			int num_segments = header[26];
+			if (serial != serial_number || i + 27 + num_segments > bytes)
+				continue;
+
+			int body_size = 0;
+			for (int k = 0; k < num_segments; k++)
+				body_size += header[27 + k];
 
-			position += samples;
+			uint64_t granule = 0;
+			for (int k = 7; k >= 0; k--)
+				granule = (granule << 8) | header[6 + k];
+
+			page.offset = offset + i;
+			page.size = 27 + num_segments + body_size;
+			page.granule_position = (int64_t)granule;
+			return true;
 		}
+		return false;
+	}
+
+	int SoundProvider_Vorbis_Session::find_num_samples()
+	{
+		// The granule position of the last page is the length of the stream
+		const int search_size = 65307 + 27 + 255;
+		int offset = std::max(device_size - search_size, 0);
 
-		return data_requested - data_left;
+		int64_t granule = -1;
+		OggPage page;
+		while (find_page(offset, device_size, page))
+		{
+			if (page.granule_position >= 0)
+				granule = page.granule_position;
+			offset = page.offset + page.size;
+		}
+		return granule >= 0 && granule < 0x7fffffff ? (int)granule : -1;
 	}
 }
@@ -30,12 +30,23 @@
 
 #include "API/Sound/SoundProviders/soundprovider_session.h"
 #include "API/Sound/SoundProviders/soundprovider_vorbis.h"
+#include "API/Core/IOData/iodevice.h"
 #include "stb_vorbis.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace clan
 {
-	class IODevice;
+	class SoundProvider_Vorbis_Decoder;
 
+	/// \brief Session decoding an Ogg Vorbis stream ahead of the mixer
+	///
+	/// The stream is read from its own IODevice and decoded by the shared decoder thread
+	/// into a ring of PCM samples. The mixer thread only copies samples out of the ring.
+	/// Memory use is bounded by the ring and the largest Ogg page, whatever the length of
+	/// the stream.
 	class SoundProvider_Vorbis_Session : public SoundProvider_Session
 	{
 	public:
@@ -47,6 +58,7 @@ namespace clan
 		int get_num_channels() const override;
 		int get_position() const override;
 
+		bool set_looping(bool loop) override;
 		bool eof() const override;
 		void stop() override;
 		bool play() override;
@@ -54,17 +66,85 @@ namespace clan
 		bool set_end_position(int pos) override { return false; }
 		int get_data(float **data_ptr, int data_requested) override;
 
+		/// \brief Decodes until the ring is full or the stream ended. Called by the decoder thread.
+		void decode_ahead();
+
 	private:
+		struct OggPage
+		{
+			int offset;
+			int size;
+			int64_t granule_position;
+		};
+
+		void open_stream();
+		bool decode_frame();
+		bool read_input();
+		void seek(int pos);
+		bool find_page(int offset, int end_offset, OggPage &page);
+		int find_num_samples();
+		void publish();
+
+		static uint64_t pack_state(unsigned int generation, bool end, unsigned int write_pos) { return ((uint64_t)generation << 33) | ((uint64_t)(end ? 1 : 0) << 32) | write_pos; }
+		static unsigned int state_generation(uint64_t state) { return (unsigned int)(state >> 33); }
+		static bool state_end(uint64_t state) { return ((state >> 32) & 1) != 0; }
+		static unsigned int state_write_pos(uint64_t state) { return (unsigned int)state; }
+
 		SoundProvider_Vorbis source;
-		int position;
-		bool stream_eof;
+		std::shared_ptr<SoundProvider_Vorbis_Decoder> decoder;
+		IODevice device;
+		int device_size;
+		uint32_t serial_number;
+
+		/// \brief Offset of the first page after the Vorbis headers
+		int audio_start;
 
 		stb_vorbis *handle;
 		stb_vorbis_info stream_info;
-		int stream_byte_offset;
+		int num_samples;
+
+		// Decoder thread state
+
+		/// \brief Compressed data read from the device but not yet consumed by stb_vorbis
+		std::vector<unsigned char> input;
+		int input_pos;
+		int input_end;
+		bool input_eof;
 
 		float **pcm;
 		int pcm_position;
 		int pcm_samples;
+
+		unsigned int decoder_generation;
+		unsigned int write_pos;
+		bool decoder_end;
+
+		/// \brief Sample a seek is decoding towards. Frames before it are dropped. -1 when not seeking.
+		int seek_position;
+
+		// Ring shared between the decoder thread (producer) and the mixer (consumer)
+
+		std::vector<std::vector<float> > ring;
+
+		/// \brief Generation, end flag and write position published by the decoder in one atomic
+		std::atomic<uint64_t> write_state;
+		std::atomic<unsigned int> read_pos;
+
+		/// \brief Bumped by set_position. Ring data published for an older generation is ignored.
+		std::atomic<unsigned int> generation;
+		std::atomic_int seek_target;
+		std::atomic_bool looping;
+
+		// Mixer state
+
+		int position;
+		bool stream_eof;
+
+		enum
+		{
+			ring_size = 16384,	// Samples per channel. Must be a power of two.
+			input_chunk_size = 16 * 1024,
+			max_input_size = 1024 * 1024
+		};
 	};
 }
@@ -29,6 +29,8 @@
 #include "Sound/precomp.h"
 #include "API/Sound/SoundProviders/soundprovider_wave.h"
 #include "API/Core/IOData/file_system.h"
+#include "API/Core/IOData/file_help.h"
+#include "API/Core/IOData/file.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/IOData/path_help.h"
 #include "API/Core/IOData/iodevice.h"
@@ -45,6 +47,9 @@ namespace clan
 		const FileSystem &fs,
 		bool stream) : impl(std::make_shared<SoundProvider_Wave_Impl>())
 	{
+		if (stream && impl->map(PathHelp::combine(fs.get_path(), filename)))
+			return;
+
 		IODevice source = fs.open_file(filename, File::open_existing, File::access_read, File::share_read);
 		impl->load(source);
 	}
@@ -53,6 +58,9 @@ namespace clan
 		const std::string &fullname, bool stream)
 		: impl(std::make_shared<SoundProvider_Wave_Impl>())
 	{
+		if (stream && impl->map(fullname))
+			return;
+
 		std::string path = PathHelp::get_fullpath(fullname, PathHelp::path_type_file);
 		std::string filename = PathHelp::get_filename(fullname, PathHelp::path_type_file);
 		FileSystem vfs(path);
@@ -82,6 +90,38 @@ namespace clan
 	}
 
 	void SoundProvider_Wave_Impl::load(IODevice &source)
+	{
+		uint32_t data_size = load_header(source);
+
+		char *buffer = new char[data_size];
+		source.read(buffer, data_size);
+		data = buffer;
+	}
+
+	bool SoundProvider_Wave_Impl::map(const std::string &filename)
+	{
+		if (!FileHelp::file_exists(filename))
+			return false;
+
+		File file(filename, File::open_existing, File::access_read, File::share_read);
+		uint32_t data_size = load_header(file);
+		uint64_t data_offset = file.get_position();
+		file.close();
+
+		mapping.reset(new SoundMappedFile(filename));
+
+		// Play what is there of a truncated file
+		if (data_offset + data_size > mapping->get_size())
+		{
+			data_size = data_offset < mapping->get_size() ? (uint32_t)(mapping->get_size() - data_offset) : 0;
+			num_samples = data_size / (num_channels * (format == sf_16bit_signed ? 2 : 1));
+		}
+
+		data = mapping->get_data() + data_offset;
+		return true;
+	}
+
+	uint32_t SoundProvider_Wave_Impl::load_header(IODevice &source)
 	{
 		source.set_little_endian_mode();
 
@@ -115,10 +155,8 @@ namespace clan
 
 		uint32_t subchunk2_size = find_subchunk("data", source, subchunk_pos, chunk_size);
 
-		data = new char[subchunk2_size];
-		source.read(data, subchunk2_size);
-
 		num_samples = subchunk2_size / block_align;
+		return subchunk2_size;
 	}
 
 	unsigned int SoundProvider_Wave_Impl::find_subchunk(const char *chunk, IODevice &source, unsigned int file_offset, unsigned int max_offset)
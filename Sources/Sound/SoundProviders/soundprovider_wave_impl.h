@@ -29,6 +29,8 @@
 #pragma once
 
 #include "API/Sound/soundformat.h"
+#include "sound_mapped_file.h"
+#include <memory>
 
 namespace clan
 {
@@ -45,18 +47,33 @@ namespace clan
 
 		~SoundProvider_Wave_Impl()
 		{
-			delete[] data;
+			if (!mapping)
+				delete[] data;
 		}
 
+		/// \brief Reads the header and the sample data into memory
 		void load(IODevice &source);
 
-		char *data;
+		/// \brief Reads the header and maps the sample data straight from the file.
+		///
+		/// Returns false if the file is not a plain file on disk, such as a file inside a zip archive.
+		bool map(const std::string &filename);
+
+		/// \brief Sample data, in memory or inside the mapping
+		const char *data;
+
+		/// \brief Mapping of the file. Null if the data was read into memory.
+		std::unique_ptr<SoundMappedFile> mapping;
+
 		SoundFormat format;
 		int num_channels;
 		int num_samples;
 		int frequency;
 
 	private:
+		/// \brief Reads the header and returns the size of the sample data. The device is left at the start of the data.
+		uint32_t load_header(IODevice &source);
+
 		uint32_t find_subchunk(const char *chunk, IODevice &source, uint32_t file_offset, uint32_t max_offset);
 	};
 }
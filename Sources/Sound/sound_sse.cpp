@@ -230,6 +230,29 @@ namespace clan
 		}
 	}
 
+	void SoundSSE::pack_16bit(const float *input, int size, short *output)
+	{
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (size / 8) * 8;
+
+		__m128 constant1 = _mm_set1_ps(32767);
+		for (int i = 0; i < sse_size; i += 8)
+		{
+			__m128 samples0 = _mm_mul_ps(_mm_loadu_ps(input + i), constant1);
+			__m128 samples1 = _mm_mul_ps(_mm_loadu_ps(input + i + 4), constant1);
+			__m128i isamples = _mm_packs_epi32(_mm_cvtps_epi32(samples0), _mm_cvtps_epi32(samples1));
+			_mm_storeu_si128((__m128i*)(output + i), isamples);
+		}
+
+#else
+		const int sse_size = 0;
+#endif
+
+		// Pack remaining
+		for (int i = sse_size; i < size; i++)
+			output[i] = input[i] * 32767;
+	}
+
 	void SoundSSE::pack_float_stereo(float *input[2], int size, float *output)
 	{
 #ifndef CL_DISABLE_SSE2
@@ -258,7 +281,7 @@ namespace clan
 		}
 	}
 
-	void SoundSSE::copy_float(float *input, int size, float *output)
+	void SoundSSE::copy_float(const float *input, int size, float *output)
 	{
 #ifndef CL_DISABLE_SSE2
 		int sse_size = (size / 4) * 4;
@@ -298,6 +321,30 @@ namespace clan
 			channel[i] *= volume;
 	}
 
+	void SoundSSE::clamp_float(float *channel, int size, float min_value, float max_value)
+	{
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (size / 4) * 4;
+
+		__m128 min0 = _mm_set1_ps(min_value);
+		__m128 max0 = _mm_set1_ps(max_value);
+		for (int i = 0; i < sse_size; i += 4)
+		{
+			__m128 s = _mm_loadu_ps(channel + i);
+			s = _mm_min_ps(_mm_max_ps(s, min0), max0);
+			_mm_storeu_ps(channel + i, s);
+		}
+#else
+		const int sse_size = 0;
+#endif
+
+		for (int i = sse_size; i < size; i++)
+		{
+			if (channel[i] > max_value) channel[i] = max_value;
+			else if (channel[i] < min_value) channel[i] = min_value;
+		}
+	}
+
 	void SoundSSE::set_float(float *channel, int size, float value)
 	{
 #ifndef CL_DISABLE_SSE2
@@ -398,6 +445,52 @@ namespace clan
 		}
 	}
 
+	void SoundSSE::mix_many_to_one_ramp(float **input, float *start_volume, float *end_volume, int channels, int size, float *output)
+	{
+		if (size <= 0)
+			return;
+
+		float step[32];
+		for (int j = 0; j < channels; j++)
+			step[j] = (end_volume[j] - start_volume[j]) / size;
+
+#ifndef CL_DISABLE_SSE2
+		int sse_size = (size / 4) * 4;
+		__m128 volume0[32];
+		__m128 step0[32];
+		for (int j = 0; j < channels; j++)
+		{
+			volume0[j] = _mm_add_ps(_mm_set1_ps(start_volume[j]), _mm_mul_ps(_mm_set1_ps(step[j]), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f)));
+			step0[j] = _mm_set1_ps(step[j] * 4.0f);
+		}
+
+		for (int i = 0; i < sse_size; i += 4)
+		{
+			__m128 sample0 = _mm_loadu_ps(output + i);
+			for (int j = 0; j < channels; j++)
+			{
+				__m128 sample1 = _mm_loadu_ps(input[j] + i);
+				sample0 = _mm_add_ps(_mm_mul_ps(sample1, volume0[j]), sample0);
+				volume0[j] = _mm_add_ps(volume0[j], step0[j]);
+			}
+			_mm_storeu_ps(output + i, sample0);
+		}
+
+#else
+		const int sse_size = 0;
+#endif
+
+		for (int i = sse_size; i < size; i++)
+		{
+			float sample0 = output[i];
+			for (int j = 0; j < channels; j++)
+			{
+				sample0 += input[j][i] * (start_volume[j] + step[j] * i);
+			}
+			output[i] = sample0;
+		}
+	}
+
 	void SoundSSE::unpack_float_stereo(float *input, int size, float *output[2])
 	{
 #ifndef CL_DISABLE_SSE2
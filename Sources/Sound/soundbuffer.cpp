@@ -59,6 +59,7 @@ namespace clan
 		: impl(std::make_shared<SoundBuffer_Impl>())
 	{
 		impl->provider = SoundProviderFactory::load(fullname, streamed, sound_format);
+		impl->cache_decoded = !streamed;
 	}
 
 	SoundBuffer::SoundBuffer(
@@ -69,6 +70,7 @@ namespace clan
 		: impl(std::make_shared<SoundBuffer_Impl>())
 	{
 		impl->provider = SoundProviderFactory::load(filename, streamed, fs, type);
+		impl->cache_decoded = !streamed;
 	}
 
 	SoundBuffer::SoundBuffer(
@@ -78,6 +80,7 @@ namespace clan
 		: impl(std::make_shared<SoundBuffer_Impl>())
 	{
 		impl->provider = SoundProviderFactory::load(file, streamed, type);
+		impl->cache_decoded = !streamed;
 	}
 
 	SoundBuffer::~SoundBuffer()
@@ -30,11 +30,12 @@
 #include "soundbuffer_impl.h"
 #include "API/Sound/SoundProviders/soundprovider.h"
 #include "API/Sound/soundfilter.h"
+#include "SoundProviders/sound_decoded_data.h"
 
 namespace clan
 {
 	SoundBuffer_Impl::SoundBuffer_Impl() :
-		provider(nullptr),
+		provider(nullptr), cache_decoded(false), decode_attempted(false),
 		volume(1.0f), pan(0.0f)
 	{
 	}
@@ -44,4 +45,17 @@ namespace clan
 		if (provider)
 			delete provider;
 	}
+
+	const float SoundBuffer_Impl::max_decoded_seconds = 10.0f;
+
+	std::shared_ptr<const SoundDecodedData> SoundBuffer_Impl::get_decoded_data()
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		if (cache_decoded && !decode_attempted)
+		{
+			decode_attempted = true;
+			decoded = SoundDecodedData::decode(provider, max_decoded_seconds);
+		}
+		return decoded;
+	}
 }
@@ -29,12 +29,14 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <mutex>
 
 namespace clan
 {
 	class SoundProvider;
 	class SoundFilter;
+	class SoundDecodedData;
 
 	class SoundBuffer_Impl
 	{
@@ -42,7 +44,21 @@ namespace clan
 		SoundBuffer_Impl();
 		virtual ~SoundBuffer_Impl();
 
+		/// \brief Returns the decoded samples shared by all sessions, or null if the sound is played from the provider
+		///
+		/// The provider is decoded the first time this is called.
+		std::shared_ptr<const SoundDecodedData> get_decoded_data();
+
 		SoundProvider *provider;
+
+		/// \brief True if the provider was loaded as a static sound that may be decoded once and cached
+		bool cache_decoded;
+		bool decode_attempted;
+		std::shared_ptr<const SoundDecodedData> decoded;
+
+		/// \brief Longest sound that is cached decoded
+		static const float max_decoded_seconds;
+
 		float volume;
 		float pan;
 		std::vector<SoundFilter> filters;
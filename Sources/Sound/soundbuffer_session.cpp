@@ -30,6 +30,7 @@
 #include "API/Sound/soundbuffer_session.h"
 #include "API/Sound/SoundProviders/soundprovider_session.h"
 #include "API/Sound/soundfilter.h"
+#include "API/Sound/soundbus.h"
 #include "soundbuffer_session_impl.h"
 #include "soundoutput_impl.h"
 
@@ -112,7 +113,6 @@ namespace clan
 	{
 		if (impl)
 		{
-			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
 			return impl->volume;
 		}
 		else
@@ -125,7 +125,6 @@ namespace clan
 	{
 		if (impl)
 		{
-			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
 			return impl->pan;
 		}
 		else
@@ -134,6 +133,18 @@ namespace clan
 		}
 	}
 
+	float SoundBuffer_Session::get_pan_depth() const
+	{
+		if (impl)
+		{
+			return impl->pan_depth;
+		}
+		else
+		{
+			return 0.0f;
+		}
+	}
+
 	bool SoundBuffer_Session::get_looping() const
 	{
 		if (impl)
@@ -150,7 +161,6 @@ namespace clan
 	{
 		if (impl)
 		{
-			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
 			return impl->playing;
 		}
 		else
@@ -166,7 +176,8 @@ namespace clan
 			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
 			if (impl->provider_session->set_position(new_pos))
 			{
-				// instantly update position here?
+				// Drop the samples already buffered for resampling so the new position is heard instantly
+				impl->reset_resampler();
 				return true;
 			}
 			return false;
@@ -210,8 +221,11 @@ namespace clan
 
 	void SoundBuffer_Session::set_volume(float new_volume)
 	{
-		if (impl)
+		if (impl && impl->volume != new_volume)
+		{
 			impl->volume = new_volume;
+			impl->output.impl->set_session_volume(*this, new_volume);
+		}
 	}
 
 	void SoundBuffer_Session::set_frequency(int new_frequency)
@@ -222,22 +236,30 @@ namespace clan
 
 	void SoundBuffer_Session::set_pan(float new_pan)
 	{
-		if (impl)
+		if (impl && impl->pan != new_pan)
+		{
 			impl->pan = new_pan;
+			impl->output.impl->set_session_pan(*this, new_pan);
+		}
+	}
+
+	void SoundBuffer_Session::set_pan_depth(float new_depth)
+	{
+		if (impl && (impl->pan_depth != new_depth || !impl->positional))
+		{
+			impl->pan_depth = new_depth;
+			impl->positional = true;
+			impl->output.impl->set_session_pan_depth(*this, new_depth);
+		}
 	}
 
 	void SoundBuffer_Session::play()
 	{
 		if (impl)
 		{
-			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
-			if (impl->playing) return;
-			if (impl->provider_session->play())
-			{
-				impl->playing = true;
-				mutex_lock.unlock();
-				impl->output.impl->play_session(*this);
-			}
+			// The mixer thread starts the provider session, and clears the flag again if that fails
+			if (impl->playing.exchange(true)) return;
+			impl->output.impl->play_session(*this);
 		}
 	}
 
@@ -245,16 +267,25 @@ namespace clan
 	{
 		if (impl)
 		{
-			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
-			if (!impl->playing) return;
-			mutex_lock.unlock();
+			if (!impl->playing.exchange(false)) return;
 			impl->output.impl->stop_session(*this);
-			mutex_lock.lock();
-			impl->playing = false;
-			impl->provider_session->stop();
 		}
 	}
 
+	int SoundBuffer_Session::get_priority() const
+	{
+		if (impl)
+			return impl->priority;
+		else
+			return 0;
+	}
+
+	void SoundBuffer_Session::set_priority(int priority)
+	{
+		if (impl)
+			impl->priority = priority;
+	}
+
 	void SoundBuffer_Session::set_looping(bool loop)
 	{
 		if (impl)
@@ -262,6 +293,10 @@ namespace clan
 			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
 			impl->looping = loop;
 			impl->provider_session->set_looping(loop);
+
+			// Looping sounds cannot be read in place from decoded samples
+			if (loop)
+				impl->resampler->detach();
 		}
 	}
 
@@ -288,4 +323,55 @@ namespace clan
 			}
 		}
 	}
+
+	SoundResampleQuality SoundBuffer_Session::get_resample_quality() const
+	{
+		if (impl)
+		{
+			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+			return impl->resampler->get_quality();
+		}
+		else
+		{
+			return cl_resample_linear;
+		}
+	}
+
+	void SoundBuffer_Session::set_resample_quality(SoundResampleQuality quality)
+	{
+		if (impl)
+		{
+			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+			impl->resampler->set_quality(quality);
+		}
+	}
+
+	SoundBus SoundBuffer_Session::get_bus() const
+	{
+		SoundBus bus;
+		if (impl)
+			bus.impl = impl->get_bus();
+		return bus;
+	}
+
+	void SoundBuffer_Session::set_bus(SoundBus &bus)
+	{
+		if (impl)
+		{
+			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+			bool playing = impl->playing;
+			mutex_lock.unlock();
+
+			// Move a playing session from its old bus to the new one
+			if (playing)
+				impl->output.impl->stop_session(*this);
+
+			mutex_lock.lock();
+			impl->bus = bus.impl;
+			mutex_lock.unlock();
+
+			if (playing)
+				impl->output.impl->play_session(*this);
+		}
+	}
 }
@@ -30,71 +30,160 @@
 #include "soundbuffer_session_impl.h"
 #include "soundbuffer_impl.h"
 #include "soundoutput_impl.h"
+#include "Mixer/sound_mixer.h"
+#include "Mixer/sound_mixing_input.h"
 #include "API/Sound/sound_sse.h"
 #include "API/Sound/soundfilter.h"
 #include "API/Sound/SoundProviders/soundprovider.h"
 #include "API/Sound/SoundProviders/soundprovider_session.h"
+#include "SoundProviders/soundprovider_decoded_session.h"
 #include "API/Core/Text/logger.h"
+#include <algorithm>
 
 namespace clan
 {
 	SoundBuffer_Session_Impl::SoundBuffer_Session_Impl(SoundBuffer &soundbuffer, bool looping, SoundOutput &output)
-		: soundbuffer(soundbuffer), provider_session(nullptr), output(output), volume(1.0f), pan(0.0f), looping(looping), playing(false)
+		: soundbuffer(soundbuffer), provider_session(nullptr), decoded_session(nullptr), output(output), volume(1.0f), pan(0.0f), pan_depth(0.0f), positional(false), looping(looping), playing(false), priority(0),
+		mix_volume(1.0f), mix_pan(0.0f), mix_pan_depth(0.0f), mix_positional(false), mix_playing(false), mix_virtual(false), mix_audibility(0.0f), has_previous_volumes(false), mixed_previous_block(false)
 	{
 		volume = soundbuffer.get_volume();
 		pan = soundbuffer.get_pan();
-		provider_session = soundbuffer.get_provider()->begin_session();
+		mix_volume = volume;
+		mix_pan = pan;
+		std::shared_ptr<const SoundDecodedData> decoded = soundbuffer.impl->get_decoded_data();
+		if (decoded)
+		{
+			decoded_session = new SoundProvider_Decoded_Session(decoded);
+			provider_session = decoded_session;
+		}
+		else
+		{
+			provider_session = soundbuffer.get_provider()->begin_session();
+		}
 		provider_session->set_looping(looping);
 		frequency = provider_session->get_frequency();
 
-		num_buffer_samples = 16 * 1024;
 		num_buffer_channels = provider_session->get_num_channels();
-		buffer_position = 0.0;
-		buffer_samples_written = 0;
-
-		float_buffer_data = new float*[num_buffer_channels];
-		for (int i = 0; i < num_buffer_channels; i++) float_buffer_data[i] = new float[num_buffer_samples];
+		num_mix_channels = num_buffer_channels < (int)SoundMixer::max_source_channels ? num_buffer_channels : (int)SoundMixer::max_source_channels;
 
+		resampler.reset(new SoundResampler(num_buffer_channels));
 		float_buffer_data_offsetted.resize(num_buffer_channels);
+		reset_resampler();
 	}
 
 	SoundBuffer_Session_Impl::~SoundBuffer_Session_Impl()
 	{
-		if (provider_session)
+		if (decoded_session)
+		{
+			delete decoded_session;
+		}
+		else if (provider_session)
 		{
 			soundbuffer.get_provider()->end_session(provider_session);
 		}
+	}
+
+	void SoundBuffer_Session_Impl::reset_resampler()
+	{
+		// Sounds that do not loop are read in place from the decoded samples. Looping sounds are
+		// copied into the resampler buffers, so the kernels see the start of the sound after its end.
+		if (decoded_session && !looping)
+			resampler->attach(decoded_session->get_decoded_data()->get_channels(), decoded_session->get_position());
+		else
+			resampler->reset();
+	}
+
+	bool SoundBuffer_Session_Impl::get_data(SoundMixingInput &mix_input, SpeakerPositionMask output_speakers, float **temp, int sample_count)
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+
+		if (mix_virtual && !mixed_previous_block)
+		{
+			get_data_in_mixer_frequency(sample_count, temp, 0);
+
+			// Fade in from silence if the session is mixed again
+			std::fill(previous_volumes, previous_volumes + 32, 0.0f);
+			has_previous_volumes = true;
+			return mix_playing;
+		}
+
+		get_data_in_mixer_frequency(sample_count, temp, num_mix_channels);
+		run_filters(temp, sample_count);
+
+		// Channels beyond the mixer scratch space are not played
+		mix_input.speakers = SoundMixer::get_default_speakers(num_mix_channels);
+		for (int i = 0, chan = 0; chan < num_mix_channels; i++)
+		{
+			if ((mix_input.speakers >> i) & 1)
+				mix_input.data.channels[i] = temp[chan++];
+		}
+		float volume = mix_virtual ? 0.0f : mix_volume;
+		if (mix_positional && SoundMixingInput::is_surround(output_speakers))
+			mix_input.set_volume(volume, mix_pan, mix_pan_depth, output_speakers);
+		else
+			mix_input.set_volume(volume, mix_pan);
+		mixed_previous_block = !mix_virtual;
+
+		// Fade volume and pan changes over the block to avoid clicks
+		if (has_previous_volumes)
+			mix_input.ramp_from(previous_volumes);
+		else
+			std::copy(mix_input.volumes, mix_input.volumes + 32, previous_volumes);
+		has_previous_volumes = true;
 
-		for (int j = 0; j < num_buffer_channels; ++j) delete[] float_buffer_data[j];
-		delete[] float_buffer_data;
+		return mix_playing;
 	}
 
-	bool SoundBuffer_Session_Impl::mix_to(float **sample_data, float **temp_data, int num_samples, int num_channels)
+	bool SoundBuffer_Session_Impl::start_playback()
 	{
 		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
-		get_data_in_mixer_frequency(num_samples, temp_data);
-		run_filters(temp_data, num_samples);
-		mix_channels(num_channels, num_samples, sample_data, temp_data);
-		return playing;
+		if (!provider_session->play())
+			return false;
+
+		if (resampler->is_flushed())
+			reset_resampler();
+		has_previous_volumes = false;
+		mixed_previous_block = false;
+		return true;
 	}
 
-	void SoundBuffer_Session_Impl::get_data()
+	float SoundBuffer_Session_Impl::get_mix_audibility() const
+	{
+		std::shared_ptr<SoundMixer> bus = mix_bus.lock();
+		return bus ? mix_volume * bus->get_volume() : mix_volume;
+	}
+
+	void SoundBuffer_Session_Impl::stop_playback()
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		provider_session->stop();
+	}
+
+	int SoundBuffer_Session_Impl::read_provider_data()
 	{
 		int num_session_channels = provider_session->get_num_channels();
 		if (num_session_channels != num_buffer_channels)
 		{
 			log_event("mixer", "Number of session channels does not match the number of buffers");
-			return;
+			return 0;
+		}
+
+		if (resampler->is_attached())
+		{
+			int skipped = decoded_session->skip_data(resampler->get_input_space());
+			resampler->input_written(skipped);
+			return skipped;
 		}
 
 		if (num_session_channels > 0)
 		{
-			// Copy stream data to working buffer:
+			// Copy stream data to the resampler input buffers:
+			int num_buffer_samples = resampler->get_input_space();
 			int samples_left = num_buffer_samples;
 			while (samples_left > 0)
 			{
 				for (int i = 0; i < num_session_channels; i++)
-					float_buffer_data_offsetted[i] = float_buffer_data[i] + num_buffer_samples - samples_left;
+					float_buffer_data_offsetted[i] = resampler->get_input(i) + num_buffer_samples - samples_left;
 
 				int written = provider_session->get_data(&float_buffer_data_offsetted[0], samples_left);
 				samples_left -= written;
@@ -126,49 +215,50 @@ namespace clan
 				}
 			}
 
-			buffer_samples_written = num_buffer_samples - samples_left;
+			resampler->input_written(num_buffer_samples - samples_left);
+			return num_buffer_samples - samples_left;
 		}
+		return 0;
 	}
 
-	void SoundBuffer_Session_Impl::get_data_in_mixer_frequency(int num_samples, float **temp_data)
+	void SoundBuffer_Session_Impl::get_data_in_mixer_frequency(int num_samples, float **temp_data, int num_channels)
 	{
 		// Convert from session frequency to mixer frequency:
-		// This is done by copying data from the temporary session buffers (buffer_data) to
-		// the temporary mixing buffers (temp_data), and if buffer_data is exhausted, calling
-		// get_data() to fill it with new data from the soundprovider session object.
-		double speed = frequency / double(output.get_mixing_frequency());
-		int sample_count;
-		for (sample_count = 0; sample_count < num_samples; sample_count++)
+		// The resampler converts as much as it has input for, and read_provider_data() refills
+		// its input buffers from the soundprovider session object when it runs dry.
+		double ratio = frequency / double(output.get_mixing_frequency());
+		int sample_count = 0;
+		while (sample_count < num_samples)
 		{
-			if (buffer_position < buffer_samples_written)
+			sample_count += resampler->process(temp_data, num_channels, sample_count, num_samples - sample_count, ratio);
+			if (sample_count == num_samples)
+				break;
+
+			if (resampler->is_flushed())
 			{
-				for (int chan = 0; chan < num_buffer_channels; chan++)
-				{
-					temp_data[chan][sample_count] = float_buffer_data[chan][int(buffer_position)];
-				}
+				mix_playing = false;
+				playing = false;
+				break;
 			}
-			else
+
+			// Out of data, get more from provider. Once the provider has no more, let the resampler play out its last samples.
+			if (provider_session->eof() && !looping)
 			{
-				if (provider_session->eof())
-				{
-					playing = false;
+				resampler->flush();
+			}
+			else if (read_provider_data() == 0)
+			{
+				// A streaming provider may still be decoding. Play silence instead of ending the session.
+				if (!provider_session->eof())
 					break;
-				}
-
-				// Out of data, get more from provider:
-				buffer_position -= buffer_samples_written;
-				get_data();
-				sample_count--;
-				continue;
+				resampler->flush();
 			}
-
-			buffer_position += speed;
 		}
 
 		// Clear the remaining samples (if any)
 		for (; sample_count < num_samples; sample_count++)
 		{
-			for (int chan = 0; chan < num_buffer_channels; chan++)
+			for (int chan = 0; chan < num_channels; chan++)
 			{
 				temp_data[chan][sample_count] = 0.0f;
 			}
@@ -179,45 +269,7 @@ namespace clan
 	{
 		for (auto & elem : filters)
 		{
-			elem.filter(temp_data, num_samples, num_buffer_channels);
-		}
-	}
-
-	void SoundBuffer_Session_Impl::get_channel_volume(float *channel_volume)
-	{
-		float left_pan = 1 - pan;
-		float right_pan = 1 + pan;
-		if (left_pan < 0.0f) left_pan = 0.0f;
-		if (left_pan > 1.0f) left_pan = 1.0f;
-		if (right_pan < 0.0f) right_pan = 0.0f;
-		if (right_pan > 1.0f) right_pan = 1.0f;
-		if (volume < 0.0f) volume = 0.0f;
-		if (volume > 1.0f) volume = 1.0f;
-
-		float left_volume = volume * left_pan;
-		float right_volume = volume * right_pan;
-
-		channel_volume[0] = left_volume;
-		channel_volume[1] = right_volume;
-	}
-
-	void SoundBuffer_Session_Impl::mix_channels(int num_channels, int num_samples, float ** sample_data, float ** temp_data)
-	{
-		float channel_volume[2];
-		get_channel_volume(channel_volume);
-
-		if (num_buffer_channels == 1)
-		{
-			// If its a mono stream, play it in left and right channels:
-			SoundSSE::mix_one_to_many(temp_data[0], num_samples, sample_data, channel_volume, 2);
-		}
-		else
-		{
-			if (num_channels > num_buffer_channels)
-				num_channels = num_buffer_channels;
-
-			for (int chan = 0; chan < num_channels; chan++)
-				SoundSSE::mix_one_to_one(temp_data[chan], num_samples, sample_data[chan], channel_volume[chan]);
+			elem.filter(temp_data, num_samples, num_mix_channels);
 		}
 	}
 }
@@ -32,17 +32,22 @@
 #include "API/Sound/soundformat.h"
 #include "API/Sound/soundoutput.h"
 #include "API/Sound/soundbuffer.h"
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include "Mixer/sound_sample_source.h"
+#include "Mixer/sound_resampler.h"
 
 namespace clan
 {
 	class SoundFilter;
 	class SoundBuffer_Impl;
 	class SoundProvider_Session;
+	class SoundProvider_Decoded_Session;
 	class SoundOutput_Impl;
+	class SoundMixer;
 
-	class SoundBuffer_Session_Impl
+	class SoundBuffer_Session_Impl : public SoundSampleSource
 	{
 	public:
 		SoundBuffer_Session_Impl(
@@ -54,48 +59,90 @@ namespace clan
 
 		SoundBuffer soundbuffer;
 		SoundProvider_Session *provider_session;
+
+		/// \brief Same as provider_session if the sound buffer decoded its samples once for all sessions. Null otherwise.
+		SoundProvider_Decoded_Session *decoded_session;
 		SoundOutput output;
-		float volume;
+		std::atomic<float> volume;
 		float frequency;
-		float pan;
+		std::atomic<float> pan;
+		std::atomic<float> pan_depth;
+
+		/// \brief True once the session was given a front to back position
+		std::atomic_bool positional;
 		bool looping;
-		bool playing;
+		std::atomic_bool playing;
+		std::atomic_int priority;
 		std::vector<SoundFilter> filters;
+		std::unique_ptr<SoundResampler> resampler;
 		mutable std::recursive_mutex mutex;
 
-		bool mix_to(float **sample_data, float **temp_data, int num_samples, int num_channels);
+		/// \brief Bus the session is mixed into. Null means the master bus of the output.
+		std::shared_ptr<SoundMixer> bus;
 
-	private:
-		/// \brief Mixes the sample data from 'temp_data' into 'sample_data'
-		void mix_channels(int num_channels, int num_samples, float ** sample_data, float ** temp_data);
+		std::shared_ptr<SoundMixer> get_bus() const { std::unique_lock<std::recursive_mutex> mutex_lock(mutex); return bus; }
+
+		bool get_data(SoundMixingInput &mix_input, SpeakerPositionMask output_speakers, float **temp, int sample_count) override;
+
+		/// \brief Discards the samples buffered for resampling and restarts at the provider position
+		void reset_resampler();
+
+		// State owned by the mixer thread. Game threads change it through the SoundOutput command queue.
+
+		/// \brief Starts the provider session. Returns false if it could not start.
+		bool start_playback();
+
+		/// \brief Stops the provider session
+		void stop_playback();
+
+		float mix_volume;
+		float mix_pan;
+		float mix_pan_depth;
+
+		/// \brief Pan and depth give a direction. Surround outputs spread the session over all speakers.
+		bool mix_positional;
+		bool mix_playing;
 
-		/// \brief Returns the volume of left and right channel
-		void get_channel_volume(float *out_volume);
+		/// \brief Set by the voice management of the output when the session is not worth mixing.
+		///
+		/// A virtual session keeps advancing its position, but is not resampled, filtered or mixed.
+		bool mix_virtual;
+
+		/// \brief Returns how loud the session is mixed, ignoring panning
+		float get_mix_audibility() const;
+
+		/// \brief Audibility found by the last voice update
+		float mix_audibility;
+
+		/// \brief Bus the session was added to when it started playing
+		std::weak_ptr<SoundMixer> mix_bus;
+
+		/// \brief Volumes used for the previous block. Volume and pan changes fade from these.
+		float previous_volumes[32];
+		bool has_previous_volumes;
+
+		/// \brief True if the previous block was mixed. A session turning virtual gets one more block to fade out.
+		bool mixed_previous_block;
+
+	private:
 
 		/// \brief Reads data into temp_data in the mixers native frequency
-		void get_data_in_mixer_frequency(int num_samples, float **temp_data);
+		///
+		/// With zero channels the position advances without producing any samples.
+		void get_data_in_mixer_frequency(int num_samples, float **temp_data, int num_channels);
 
 		/// \brief Runs the sample data through attached filters
 		void run_filters(float ** temp_data, int num_samples);
 
-		/// \brief Fills temporary buffers with data from provider.
-		void get_data();
-
-		/// \brief Temporary channel buffers containing sound data in provider frequency.
-		float **float_buffer_data;
+		/// \brief Reads data from the provider into the resampler input buffers. Returns the number of samples read.
+		int read_provider_data();
 
 		std::vector<float*> float_buffer_data_offsetted;
 
-		/// \brief Size of temporary channel buffers.
-		int num_buffer_samples;
-
-		/// \brief Number of temporary channel buffers;
+		/// \brief Number of channels read from the provider;
 		int num_buffer_channels;
 
-		/// \brief Current playback position in temporary buffers.
-		double buffer_position;
-
-		/// \brief Number of samples currently written to buffer_data.
-		int buffer_samples_written;
+		/// \brief Number of channels passed on to the mixer
+		int num_mix_channels;
 	};
 }
@@ -0,0 +1,92 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "API/Sound/soundbus.h"
+#include "API/Sound/soundoutput.h"
+#include "API/Sound/soundfilter.h"
+#include "soundoutput_impl.h"
+#include "Mixer/sound_mixer.h"
+
+namespace clan
+{
+	SoundBus::SoundBus()
+	{
+	}
+
+	SoundBus::SoundBus(SoundOutput &output)
+	{
+		output.throw_if_null();
+		impl = std::make_shared<SoundMixer>();
+		output.impl->master->add_bus(impl);
+	}
+
+	SoundBus::SoundBus(SoundOutput &output, SoundBus &parent)
+	{
+		output.throw_if_null();
+		parent.throw_if_null();
+		impl = std::make_shared<SoundMixer>();
+		parent.impl->add_bus(impl);
+	}
+
+	SoundBus::~SoundBus()
+	{
+	}
+
+	void SoundBus::throw_if_null() const
+	{
+		if (!impl)
+			throw Exception("SoundBus is null");
+	}
+
+	float SoundBus::get_volume() const
+	{
+		if (impl)
+			return impl->get_volume();
+		else
+			return 0.0f;
+	}
+
+	void SoundBus::set_volume(float volume)
+	{
+		if (impl)
+			impl->set_volume(volume);
+	}
+
+	void SoundBus::add_filter(SoundFilter &filter)
+	{
+		if (impl)
+			impl->add_filter(filter);
+	}
+
+	void SoundBus::remove_filter(SoundFilter &filter)
+	{
+		if (impl)
+			impl->remove_filter(filter);
+	}
+}
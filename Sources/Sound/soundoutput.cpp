@@ -33,6 +33,7 @@
 #include "API/Sound/sound.h"
 #include "soundoutput_impl.h"
 #include "setupsound.h"
+#include "Platform/Offline/soundoutput_offline.h"
 
 #ifdef WIN32
 #include "Platform/Win32/soundoutput_win32.h"
@@ -66,6 +67,16 @@ namespace clan
 	SoundOutput::SoundOutput(const SoundOutput_Description &desc)
 	{
 		SetupSound::start();
+		if (desc.is_offline())
+		{
+			impl = std::make_shared<SoundOutput_Offline>(desc.get_mixing_frequency(), desc.get_mixing_latency(), desc.get_speakers(),
+				desc.get_offline_output(), desc.is_offline_output_float(), desc.get_offline_callback());
+			impl->set_mixing_threads(desc.get_mixing_threads());
+			impl->max_voices = desc.get_max_voices();
+			Sound::select_output(*this);
+			return;
+		}
+
 #ifdef WIN32
 		try
 		{
@@ -85,7 +96,7 @@ namespace clan
 #if defined(__linux__) && defined(HAVE_ALSA_ASOUNDLIB_H)
 		// Try building ALSA
 
-		std::shared_ptr<SoundOutput_Impl> alsa_impl(std::make_shared<SoundOutput_alsa>(desc.get_mixing_frequency(), desc.get_mixing_latency()));
+		std::shared_ptr<SoundOutput_Impl> alsa_impl(std::make_shared<SoundOutput_alsa>(desc.get_mixing_frequency(), desc.get_mixing_latency(), desc.get_device_name()));
 		if ( ( (SoundOutput_alsa *) (alsa_impl.get()))->handle)
 		{
 			impl = alsa_impl;
@@ -106,6 +117,8 @@ namespace clan
 #endif
 #endif
 #endif
+		impl->set_mixing_threads(desc.get_mixing_threads());
+		impl->max_voices = desc.get_max_voices();
 		Sound::select_output(*this);
 	}
 
@@ -142,6 +155,12 @@ namespace clan
 		return impl->mixing_latency;
 	}
 
+	SpeakerPositionMask SoundOutput::get_speakers() const
+	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+		return impl->speakers;
+	}
+
 	float SoundOutput::get_global_volume() const
 	{
 		std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
@@ -154,6 +173,31 @@ namespace clan
 		return impl->pan;
 	}
 
+	int SoundOutput::get_max_voices() const
+	{
+		return impl->max_voices;
+	}
+
+	float SoundOutput::get_output_latency() const
+	{
+		return impl->output_latency / 1000.0f;
+	}
+
+	int SoundOutput::get_underrun_count() const
+	{
+		return impl->underruns;
+	}
+
+	int SoundOutput::get_voices_mixed() const
+	{
+		return impl->voices_mixed;
+	}
+
+	int SoundOutput::get_voices_virtual() const
+	{
+		return impl->voices_virtual;
+	}
+
 	void SoundOutput::stop_all()
 	{
 	}
@@ -176,6 +220,12 @@ namespace clan
 		}
 	}
 
+	void SoundOutput::set_max_voices(int count)
+	{
+		if (impl)
+			impl->max_voices = count;
+	}
+
 	void SoundOutput::add_filter(SoundFilter &filter)
 	{
 		if (impl)
@@ -200,4 +250,20 @@ namespace clan
 			}
 		}
 	}
+
+	void SoundOutput::render(float *output, int sample_count)
+	{
+		SoundOutput_Offline *offline = dynamic_cast<SoundOutput_Offline *>(impl.get());
+		if (!offline)
+			throw Exception("SoundOutput::render is only available for offline sound outputs");
+		offline->render(output, sample_count);
+	}
+
+	void SoundOutput::render(int sample_count)
+	{
+		SoundOutput_Offline *offline = dynamic_cast<SoundOutput_Offline *>(impl.get());
+		if (!offline)
+			throw Exception("SoundOutput::render is only available for offline sound outputs");
+		offline->render(sample_count);
+	}
 }
@@ -36,12 +36,25 @@ namespace clan
 	public:
 		int mixing_frequency;
 		int mixing_latency;
+		SpeakerPositionMask speakers;
+		std::string device_name;
+		bool offline;
+		IODevice offline_output;
+		bool offline_output_float;
+		std::function<void(const float *, int)> offline_callback;
+		int mixing_threads;
+		int max_voices;
 	};
 
 	SoundOutput_Description::SoundOutput_Description() : impl(std::make_shared<SoundOutput_Description_Impl>())
 	{
 		impl->mixing_frequency = 44100;
 		impl->mixing_latency = 50;
+		impl->speakers = cl_speakers_stereo;
+		impl->offline = false;
+		impl->offline_output_float = false;
+		impl->mixing_threads = 1;
+		impl->max_voices = 0;
 	}
 
 	SoundOutput_Description::~SoundOutput_Description()
@@ -58,6 +71,46 @@ namespace clan
 		return impl->mixing_latency;
 	}
 
+	SpeakerPositionMask SoundOutput_Description::get_speakers() const
+	{
+		return impl->speakers;
+	}
+
+	const std::string &SoundOutput_Description::get_device_name() const
+	{
+		return impl->device_name;
+	}
+
+	bool SoundOutput_Description::is_offline() const
+	{
+		return impl->offline;
+	}
+
+	IODevice SoundOutput_Description::get_offline_output() const
+	{
+		return impl->offline_output;
+	}
+
+	bool SoundOutput_Description::is_offline_output_float() const
+	{
+		return impl->offline_output_float;
+	}
+
+	std::function<void(const float *, int)> SoundOutput_Description::get_offline_callback() const
+	{
+		return impl->offline_callback;
+	}
+
+	int SoundOutput_Description::get_mixing_threads() const
+	{
+		return impl->mixing_threads;
+	}
+
+	int SoundOutput_Description::get_max_voices() const
+	{
+		return impl->max_voices;
+	}
+
 	void SoundOutput_Description::set_mixing_frequency(int frequency)
 	{
 		impl->mixing_frequency = frequency;
@@ -67,4 +120,40 @@ namespace clan
 	{
 		impl->mixing_latency = latency;
 	}
+
+	void SoundOutput_Description::set_speakers(SpeakerPositionMask speakers)
+	{
+		impl->speakers = speakers;
+	}
+
+	void SoundOutput_Description::set_device_name(const std::string &name)
+	{
+		impl->device_name = name;
+	}
+
+	void SoundOutput_Description::set_offline(bool enable)
+	{
+		impl->offline = enable;
+	}
+
+	void SoundOutput_Description::set_offline_output(const IODevice &wave_file, bool float_samples)
+	{
+		impl->offline_output = wave_file;
+		impl->offline_output_float = float_samples;
+	}
+
+	void SoundOutput_Description::set_offline_callback(const std::function<void(const float *samples, int sample_count)> &callback)
+	{
+		impl->offline_callback = callback;
+	}
+
+	void SoundOutput_Description::set_mixing_threads(int count)
+	{
+		impl->mixing_threads = count;
+	}
+
+	void SoundOutput_Description::set_max_voices(int count)
+	{
+		impl->max_voices = count;
+	}
 }
@@ -31,22 +31,40 @@
 #include "soundbuffer_session_impl.h"
 #include "API/Sound/soundfilter.h"
 #include <algorithm>
+#include <limits>
 #include "API/Sound/sound_sse.h"
+#include "Mixer/sound_mixing_input.h"
 
 namespace clan
 {
 	std::recursive_mutex SoundOutput_Impl::singleton_mutex;
 	SoundOutput_Impl *SoundOutput_Impl::instance = nullptr;
 
+	// Below the least significant bit of 16 bit output
+	const float SoundOutput_Impl::inaudible_volume = 1.0f / 65536.0f;
+
+	// Milliseconds the master limiter holds its level after an over, then takes to recover.
+	// The hold is longer than the period of 50 Hz, so low tones are not flattened at every wave top.
+	static const float limiter_hold = 20.0f;
+	static const float limiter_release = 50.0f;
+
 	SoundOutput_Impl::SoundOutput_Impl(int mixing_frequency, int latency)
 		: mixing_frequency(mixing_frequency), mixing_latency(latency), volume(1.0f),
-		pan(0.0f), mix_buffer_size(0)
+		pan(0.0f), speakers(cl_speakers_stereo), master(std::make_shared<SoundMixer>(cl_speakers_stereo)),
+		limiter(0.0f, std::numeric_limits<float>::infinity(), 0.0f, limiter_release, 0.0f, mixing_frequency), mix_buffer_size(0)
 	{
-		mix_buffers[0] = nullptr;
-		mix_buffers[1] = nullptr;
-		temp_buffers[0] = nullptr;
-		temp_buffers[1] = nullptr;
-		stereo_buffer = nullptr;
+		max_voices = 0;
+		voices_mixed = 0;
+		voices_virtual = 0;
+		output_latency = latency * 1000;
+		underruns = 0;
+		mixer_running = false;
+
+		limiter.set_hold(limiter_hold);
+
+		for (auto & elem : temp_buffers)
+			elem = nullptr;
+		interleaved_buffer = nullptr;
 
 		std::unique_lock<std::recursive_mutex> lock(singleton_mutex);
 		if (instance)
@@ -57,11 +75,9 @@ namespace clan
 
 	SoundOutput_Impl::~SoundOutput_Impl()
 	{
-		SoundSSE::aligned_free(stereo_buffer);
-		SoundSSE::aligned_free(mix_buffers[0]);
-		SoundSSE::aligned_free(mix_buffers[1]);
-		SoundSSE::aligned_free(temp_buffers[0]);
-		SoundSSE::aligned_free(temp_buffers[1]);
+		SoundSSE::aligned_free(interleaved_buffer);
+		for (auto & elem : temp_buffers)
+			SoundSSE::aligned_free(elem);
 
 		std::unique_lock<std::recursive_mutex> lock(singleton_mutex);
 		instance = nullptr;
@@ -69,27 +85,219 @@ namespace clan
 
 	void SoundOutput_Impl::play_session(SoundBuffer_Session &session)
 	{
-		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
-		sessions.push_back(session);
+		SoundCommand command;
+		command.type = cl_sound_command_play;
+		command.session = session.impl;
+		command.bus = session.impl->get_bus();
+		push_command(command);
 	}
 
 	void SoundOutput_Impl::stop_session(SoundBuffer_Session &session)
 	{
+		SoundCommand command;
+		command.type = cl_sound_command_stop;
+		command.session = session.impl;
+		push_command(command);
+	}
+
+	void SoundOutput_Impl::set_session_volume(SoundBuffer_Session &session, float volume)
+	{
+		SoundCommand command;
+		command.type = cl_sound_command_set_volume;
+		command.session = session.impl;
+		command.value = volume;
+		push_command(command);
+	}
+
+	void SoundOutput_Impl::set_session_pan(SoundBuffer_Session &session, float pan)
+	{
+		SoundCommand command;
+		command.type = cl_sound_command_set_pan;
+		command.session = session.impl;
+		command.value = pan;
+		push_command(command);
+	}
+
+	void SoundOutput_Impl::set_session_pan_depth(SoundBuffer_Session &session, float depth)
+	{
+		SoundCommand command;
+		command.type = cl_sound_command_set_pan_depth;
+		command.session = session.impl;
+		command.value = depth;
+		push_command(command);
+	}
+
+	void SoundOutput_Impl::push_commands(std::vector<SoundCommand> &batch)
+	{
+		commands.push(batch, [this]() { make_room_for_commands(); });
+	}
+
+	void SoundOutput_Impl::push_command(SoundCommand &command)
+	{
+		commands.push(command, [this]() { make_room_for_commands(); });
+	}
+
+	void SoundOutput_Impl::make_room_for_commands()
+	{
+		if (mixer_running)
+		{
+			std::this_thread::yield();
+			return;
+		}
+
+		// Without a mixer thread nothing else drains the queue. Offline outputs mix under the same lock.
 		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		if (!mixer_running)
+			process_commands();
+	}
 
-		for (auto it = sessions.begin(); it != sessions.end(); ++it)
+	void SoundOutput_Impl::process_commands()
+	{
+		SoundCommand command;
+		while (commands.pop(command))
 		{
-			if (session.impl.get() == it->impl.get())
+			SoundBuffer_Session_Impl *session = command.session.get();
+			switch (command.type)
 			{
-				sessions.erase(it);
+			case cl_sound_command_play:
+				if (!session->mix_playing)
+				{
+					if (session->start_playback())
+					{
+						std::shared_ptr<SoundMixer> bus = command.bus ? command.bus : master;
+						bus->add_input(command.session);
+						session->mix_bus = bus;
+						session->mix_playing = true;
+						session->mix_virtual = false;
+						voices.push_back(command.session);
+					}
+					else
+					{
+						session->playing = false;
+					}
+				}
+				break;
+
+			case cl_sound_command_stop:
+				if (session->mix_playing)
+				{
+					std::shared_ptr<SoundMixer> bus = session->mix_bus.lock();
+					if (bus)
+						bus->remove_input(session);
+					session->mix_bus.reset();
+					session->mix_playing = false;
+					auto it = std::find(voices.begin(), voices.end(), command.session);
+					if (it != voices.end())
+						voices.erase(it);
+				}
+				session->stop_playback();
 				break;
+
+			case cl_sound_command_set_volume:
+				session->mix_volume = command.value;
+				break;
+
+			case cl_sound_command_set_pan:
+				session->mix_pan = command.value;
+				break;
+
+			case cl_sound_command_set_pan_depth:
+				session->mix_pan_depth = command.value;
+				session->mix_positional = true;
+				break;
+
+			case cl_sound_command_set_spatial:
+				session->mix_volume = command.value;
+				session->mix_pan = command.pan;
+				session->mix_pan_depth = command.pan_depth;
+				session->mix_positional = true;
+				break;
+			}
+		}
+
+		// Release the last references on this thread before mixing starts
+		command.session.reset();
+		command.bus.reset();
+	}
+
+	void SoundOutput_Impl::update_voices()
+	{
+		// Sessions that played to the end were already removed from their bus
+		for (size_t i = 0; i < voices.size();)
+		{
+			if (voices[i]->mix_playing)
+			{
+				i++;
+			}
+			else
+			{
+				voices[i] = voices.back();
+				voices.pop_back();
+			}
+		}
+
+		audible_voices.clear();
+		int num_virtual = 0;
+		for (auto & voice : voices)
+		{
+			voice->mix_audibility = voice->get_mix_audibility();
+			if (voice->mix_audibility > inaudible_volume)
+			{
+				audible_voices.push_back(voice.get());
+			}
+			else
+			{
+				voice->mix_virtual = true;
+				num_virtual++;
 			}
 		}
+
+		int budget = max_voices;
+		if (budget > 0 && (int)audible_voices.size() > budget)
+		{
+			// Highest priority first, then the loudest
+			std::nth_element(audible_voices.begin(), audible_voices.begin() + budget, audible_voices.end(), [](SoundBuffer_Session_Impl *a, SoundBuffer_Session_Impl *b)
+			{
+				int priority_a = a->priority;
+				int priority_b = b->priority;
+				if (priority_a != priority_b)
+					return priority_a > priority_b;
+				return a->mix_audibility > b->mix_audibility;
+			});
+
+			for (size_t i = budget; i < audible_voices.size(); i++)
+				audible_voices[i]->mix_virtual = true;
+			num_virtual += (int)audible_voices.size() - budget;
+			audible_voices.resize(budget);
+		}
+
+		for (auto & voice : audible_voices)
+			voice->mix_virtual = false;
+
+		voices_mixed = (int)audible_voices.size();
+		voices_virtual = num_virtual;
+	}
+
+	void SoundOutput_Impl::set_mixing_threads(int count)
+	{
+		if (count <= 0)
+			count = std::max((int)std::thread::hardware_concurrency(), 1);
+
+		std::shared_ptr<SoundMixerWorkerPool> pool;
+		if (count > 1)
+			pool = std::make_shared<SoundMixerWorkerPool>(count);
+
+		// Swap the pool while the mixer is idle. The old pool is stopped when the last reference goes away.
+		master->set_worker_pool(pool);
+		worker_pool = pool;
 	}
 
 	void SoundOutput_Impl::start_mixer_thread()
 	{
+		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
 		stop_flag = false;
+		mixer_running = true;
+		mutex_lock.unlock();
 		thread = std::thread(&SoundOutput_Impl::mixer_thread, this);
 		//	thread.set_priority(cl_priority_highest);
 	}
@@ -99,19 +307,24 @@ namespace clan
 		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
 		stop_flag = true;
 		mutex_lock.unlock();
-		thread.join();
+		if (thread.joinable())
+			thread.join();
 		thread = std::thread();
+
+		mutex_lock.lock();
+		mixer_running = false;
 	}
 
-	void SoundOutput_Impl::mix_fragment()
+	void SoundOutput_Impl::mix_fragment(float *output)
 	{
+		process_commands();
+		update_voices();
 		resize_mix_buffers();
-		clear_mix_buffers();
 		fill_mix_buffers();
 		filter_mix_buffers();
 		apply_master_volume_on_mix_buffers();
-		clamp_mix_buffers();
-		SoundSSE::pack_float_stereo(mix_buffers, mix_buffer_size, stereo_buffer);
+		limit_mix_buffers();
+		interleave_mix_buffers(output ? output : interleaved_buffer);
 	}
 
 	void SoundOutput_Impl::mixer_thread()
@@ -120,11 +333,12 @@ namespace clan
 
 		while (if_continue_mixing())
 		{
-			// Mix some audio:
-			mix_fragment();
+			// Mix some audio, straight into the device buffer if the backend has one:
+			float *fragment = lock_fragment();
+			mix_fragment(fragment);
 
 			// Send mixed data to sound card:
-			write_fragment(stereo_buffer);
+			write_fragment(fragment ? fragment : interleaved_buffer);
 
 			// Wait for sound card to want more:
 			wait();
@@ -140,92 +354,115 @@ namespace clan
 
 	void SoundOutput_Impl::resize_mix_buffers()
 	{
+		if (master->get_speakers() != speakers)
+		{
+			master->set_speakers(speakers);
+			SoundSSE::aligned_free(interleaved_buffer); interleaved_buffer = nullptr;
+			mix_buffer_size = 0;
+		}
+
 		if (get_fragment_size() != mix_buffer_size)
 		{
-			SoundSSE::aligned_free(stereo_buffer); stereo_buffer = nullptr;
-			SoundSSE::aligned_free(mix_buffers[0]); mix_buffers[0] = nullptr;
-			SoundSSE::aligned_free(mix_buffers[1]); mix_buffers[1] = nullptr;
-			SoundSSE::aligned_free(temp_buffers[0]); temp_buffers[0] = nullptr;
-			SoundSSE::aligned_free(temp_buffers[1]); temp_buffers[1] = nullptr;
+			SoundSSE::aligned_free(interleaved_buffer); interleaved_buffer = nullptr;
+			for (auto & elem : temp_buffers)
+			{
+				SoundSSE::aligned_free(elem);
+				elem = nullptr;
+			}
 
 			mix_buffer_size = get_fragment_size();
 			//if (mix_buffer_size & 3)
 			//	throw Exception("Fragment size must be a multiple of 4");
 
-			mix_buffers[0] = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size);
-			mix_buffers[1] = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size);
-			temp_buffers[0] = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size);
-			temp_buffers[1] = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size);
-			stereo_buffer = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size * 2);
-			SoundSSE::set_float(stereo_buffer, mix_buffer_size * 2, 0.0f);
+			int num_channels = SoundMixer::get_speaker_count(speakers);
+			for (auto & elem : temp_buffers)
+				elem = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size);
+			interleaved_buffer = (float *)SoundSSE::aligned_alloc(sizeof(float) * mix_buffer_size * num_channels);
+			SoundSSE::set_float(interleaved_buffer, mix_buffer_size * num_channels, 0.0f);
 		}
 	}
 
-	void SoundOutput_Impl::clear_mix_buffers()
-	{
-		// Clear channel mixing buffers:
-		SoundSSE::set_float(mix_buffers[0], mix_buffer_size, 0.0f);
-		SoundSSE::set_float(mix_buffers[1], mix_buffer_size, 0.0f);
-	}
-
 	void SoundOutput_Impl::fill_mix_buffers()
 	{
-		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
-		std::vector< SoundBuffer_Session > ended_sessions;
-		std::vector< SoundBuffer_Session >::iterator it;
-		for (it = sessions.begin(); it != sessions.end(); ++it)
-		{
-			SoundBuffer_Session session = *it;
-			bool playing = session.impl->mix_to(mix_buffers, temp_buffers, mix_buffer_size, 2);
-			if (!playing) ended_sessions.push_back(session);
-		}
-
-		// Release any sessions pending for removal:
-		int size_ended_sessions = ended_sessions.size();
-		for (int i = 0; i < size_ended_sessions; i++) stop_session(ended_sessions[i]);
+		master->mix(temp_buffers, mix_buffer_size);
 	}
 
 	void SoundOutput_Impl::filter_mix_buffers()
 	{
 		// Apply global filters to mixing buffers:
 		std::unique_lock<std::recursive_mutex> mutex_lock(mutex);
+		if (filters.empty())
+			return;
+
+		float *channels[32];
+		int num_channels = 0;
+		for (auto & elem : master->get_buffers().channels)
+		{
+			if (elem)
+				channels[num_channels++] = elem;
+		}
+
 		int size_filters = filters.size();
 		int i;
 		for (i = 0; i < size_filters; i++)
 		{
-			filters[i].filter(mix_buffers, mix_buffer_size, 2);
+			filters[i].filter(channels, mix_buffer_size, num_channels);
 		}
 	}
 
 	void SoundOutput_Impl::apply_master_volume_on_mix_buffers()
 	{
-		// Calculate volume on left and right channel:
-		float left_pan = 1 - pan;
-		float right_pan = 1 + pan;
-		if (left_pan < 0.0f) left_pan = 0.0f;
-		if (left_pan > 1.0f) left_pan = 1.0f;
-		if (right_pan < 0.0f) right_pan = 0.0f;
-		if (right_pan > 1.0f) right_pan = 1.0f;
-		if (volume < 0.0f) volume = 0.0f;
-		if (volume > 1.0f) volume = 1.0f;
-
-		float left_volume = volume * left_pan;
-		float right_volume = volume * right_pan;
+		// Calculate volume on left and right side speakers:
+		SoundMixingInput master_volume;
+		master_volume.set_volume(volume, pan);
 
-		SoundSSE::multiply_float(mix_buffers[0], mix_buffer_size, left_volume);
-		SoundSSE::multiply_float(mix_buffers[1], mix_buffer_size, right_volume);
+		SoundMixingBuffersData &mix_buffers = master->get_buffers();
+		for (int i = 0; i < 32; i++)
+		{
+			if (mix_buffers.channels[i] && master_volume.volumes[i] != 1.0f)
+				SoundSSE::multiply_float(mix_buffers.channels[i], mix_buffer_size, master_volume.volumes[i]);
+		}
 	}
 
-	void SoundOutput_Impl::clamp_mix_buffers()
+	void SoundOutput_Impl::limit_mix_buffers()
 	{
+		float *channels[32];
+		int num_channels = 0;
+		for (auto & elem : master->get_buffers().channels)
+		{
+			if (elem)
+				channels[num_channels++] = elem;
+		}
+
+		// Samples inside full scale pass unchanged unless the limiter is still recovering from an over
+		limiter.filter(channels, mix_buffer_size, num_channels);
+
 		// Make sure values stay inside 16 bit range:
-		for (auto & elem : mix_buffers)
+		for (int i = 0; i < num_channels; i++)
+			SoundSSE::clamp_float(channels[i], mix_buffer_size, -1.0f, 1.0f);
+	}
+
+	void SoundOutput_Impl::interleave_mix_buffers(float *output)
+	{
+		SoundMixingBuffersData &mix_buffers = master->get_buffers();
+		if (speakers == cl_speakers_stereo)
 		{
+			float *stereo_buffers[2] = { mix_buffers.channels[0], mix_buffers.channels[1] };
+			SoundSSE::pack_float_stereo(stereo_buffers, mix_buffer_size, output);
+			return;
+		}
+
+		int num_channels = SoundMixer::get_speaker_count(speakers);
+		int channel = 0;
+		for (auto & elem : mix_buffers.channels)
+		{
+			if (!elem)
+				continue;
+
+			float *speaker = output + channel;
 			for (int k = 0; k < mix_buffer_size; k++)
-			{
-				if (elem[k] > 1.0f)  elem[k] = 1.0f;
-				else if (elem[k] < -1.0f) elem[k] = -1.0f;
-			}
+				speaker[k * num_channels] = elem[k];
+			channel++;
 		}
 	}
 }
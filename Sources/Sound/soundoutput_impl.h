@@ -34,6 +34,10 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include "API/Sound/speaker_position.h"
+#include "Mixer/sound_mixer.h"
+#include "Mixer/sound_command_queue.h"
+#include "SoundFilters/compressorfilter_provider.h"
 
 namespace clan
 {
@@ -47,10 +51,35 @@ namespace clan
 		SoundOutput_Impl(int mixing_frequency, int mixing_latency);
 		virtual ~SoundOutput_Impl();
 
+		/// \brief Queues session changes for the mixer thread. They take effect at the start of the next fragment.
 		void play_session(SoundBuffer_Session &session);
 		void stop_session(SoundBuffer_Session &session);
+		void set_session_volume(SoundBuffer_Session &session, float volume);
+		void set_session_pan(SoundBuffer_Session &session, float pan);
+		void set_session_pan_depth(SoundBuffer_Session &session, float depth);
+
+		/// \brief Queues a batch of commands while holding the producer side of the queue once
+		void push_commands(std::vector<SoundCommand> &batch);
+
+		/// \brief Mixes the sessions on a pool of count threads. 0 uses one thread per core.
+		void set_mixing_threads(int count);
+
+		/// \brief Most sessions mixed at once. The rest become virtual. 0 means no limit.
+		std::atomic_int max_voices;
+
+		/// \brief Number of sessions mixed and virtual in the last fragment
+		std::atomic_int voices_mixed;
+		std::atomic_int voices_virtual;
+
+		/// \brief Microseconds from mixing a sample until the device plays it. Set by backends that can measure it.
+		std::atomic_int output_latency;
+
+		/// \brief Number of times the device ran out of samples
+		std::atomic_int underruns;
 
 	protected:
+		mutable std::recursive_mutex mutex;
+
 		std::string name;
 		int mixing_frequency;
 		int mixing_latency;
@@ -59,26 +88,58 @@ namespace clan
 		std::vector<SoundFilter> filters;
 		std::thread thread;
 		std::atomic_bool stop_flag;
-		std::vector< SoundBuffer_Session > sessions;
+
+		/// \brief True while the mixer thread drains the command queue. Otherwise game threads apply the commands when the queue is full.
+		std::atomic_bool mixer_running;
+
+		/// \brief Speakers of the output device. Backends supporting more than stereo set this in their constructor.
+		SpeakerPositionMask speakers;
+
+		/// \brief Root bus of the mixing graph
+		std::shared_ptr<SoundMixer> master;
+
+		/// \brief Threads helping the mixer thread. Null if all mixing is done on the mixer thread.
+		std::shared_ptr<SoundMixerWorkerPool> worker_pool;
+
+		/// \brief Session changes waiting for the mixer thread
+		SoundCommandQueue commands;
+
+		/// \brief Playing sessions, owned by the mixer thread
+		std::vector<std::shared_ptr<SoundBuffer_Session_Impl> > voices;
+
+		/// \brief Sessions that are audible, sorted when there are more than max_voices of them
+		std::vector<SoundBuffer_Session_Impl *> audible_voices;
+
+		/// \brief Sessions quieter than this are never mixed
+		static const float inaudible_volume;
+
+		/// \brief Brings overs back under full scale smoothly instead of clipping them
+		CompressorFilterProvider limiter;
 
 		int mix_buffer_size;
-		float *mix_buffers[2];
-		float *temp_buffers[2];
-		float *stereo_buffer;
+		float *temp_buffers[SoundMixer::max_source_channels];
+		float *interleaved_buffer;
 
 		/// \brief Called when we have no samples to play - and wants to tell the soundcard
 		/// \brief about this possible event.
 		virtual void silence() = 0;
 
-		/// \brief Returns the buffer size used by device (returned as num [stereo] samples).
+		/// \brief Returns the buffer size used by device (returned as num samples per speaker).
 		virtual int get_fragment_size() = 0;
 
 		/// \brief Writes a fragment to the soundcard.
+		///
+		/// The data holds get_fragment_size() samples for each speaker, interleaved in speaker bit order.
 		virtual void write_fragment(float *data) = 0;
 
 		/// \brief Waits until output source isn't full anymore.
 		virtual void wait() = 0;
 
+		/// \brief Returns device memory to mix the next fragment straight into, or null to mix into interleaved_buffer.
+		///
+		/// The returned pointer is handed back to write_fragment once the fragment is mixed.
+		virtual float *lock_fragment() { return nullptr; }
+
 		/// \brief Called by the mixer thread when it starts
 		virtual void mixer_thread_starting() { }
 
@@ -91,8 +152,8 @@ namespace clan
 		/// \brief Stops the mixer thread.
 		void stop_mixer_thread();
 
-		/// \brief Mixes a single fragment and stores the result in stereo_buffer.
-		void mix_fragment();
+		/// \brief Mixes a single fragment and stores the result in output, or in interleaved_buffer if output is null.
+		void mix_fragment(float *output = nullptr);
 
 	private:
 		/// \brief Worker thread for output device. Mixes the audio and sends it to write_fragment.
@@ -101,13 +162,22 @@ namespace clan
 		/// \brief Returns true if the mixer thread should continue mixing fragments
 		bool if_continue_mixing();
 
+		/// \brief Applies the session changes queued by the game threads
+		void process_commands();
+
+		/// \brief Queues a session change for the mixer
+		void push_command(SoundCommand &command);
+
+		/// \brief Called by game threads while the command queue is full
+		void make_room_for_commands();
+
+		/// \brief Picks the sessions to mix by priority and audibility, and makes the rest virtual
+		void update_voices();
+
 		/// \brief Ensures the mixing buffers match the fragment size
 		void resize_mix_buffers();
 
-		/// \brief Clears the content of the mixing buffers
-		void clear_mix_buffers();
-
-		/// \brief Mixes soundbuffer sessions into the mixing buffers
+		/// \brief Mixes the graph of soundbuffer sessions and buses into the master mixing buffers
 		void fill_mix_buffers();
 
 		/// \brief Applies filters to the mixing buffers
@@ -116,14 +186,16 @@ namespace clan
 		/// \brief Apply master volume and panning to mix buffers
 		void apply_master_volume_on_mix_buffers();
 
-		/// \brief Clamp mixing buffer values to the -1 to 1 range
-		void clamp_mix_buffers();
+		/// \brief Limits peaks above full scale, then clamps mixing buffer values to the -1 to 1 range
+		void limit_mix_buffers();
+
+		/// \brief Interleaves the master mixing buffers into output
+		void interleave_mix_buffers(float *output);
 
 		static std::recursive_mutex singleton_mutex;
 		static SoundOutput_Impl *instance;
 
-		mutable std::recursive_mutex mutex;
-
 		friend class SoundOutput;
+		friend class SoundBus;
 	};
 }
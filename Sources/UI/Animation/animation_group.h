@@ -28,8 +28,8 @@
 
 #pragma once
 
-#include "API/Display/System/timer.h"
 #include "animation.h"
+#include "animation_scheduler.h"
 #include <algorithm>
 #include <chrono>
 #include <vector>
@@ -53,51 +53,70 @@ namespace clan
 
 		void start(Animation animation)
 		{
-			if (active_animations.empty())
-			{
-				timer.func_expired() = [&]()
-				{
-					std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
-
-					auto it = active_animations.begin();
-					while (it != active_animations.end())
-					{
-						long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - it->start_time).count();
-						float t = clan::max(clan::min(static_cast<float>(elapsed) / it->duration, 1.0f), 0.0f);
-
-						t = it->easing(t);
-						it->setter(it->from * (1.0f - t) + it->to * t);
-
-						if (t >= 1.0f)
-						{
-							if (it->animation_end)
-								it->animation_end();
-							it = active_animations.erase(it);
-						}
-						else
-						{
-							++it;
-						}
-					}
-
-					if (active_animations.empty())
-						timer.stop();
-				};
-			}
-			timer.start(16, true);
-
-			animation.start_time = std::chrono::steady_clock::now();
+			// The start time is set by the first frame stepping the animation
+			animation.start_time = std::chrono::steady_clock::time_point();
 			active_animations.push_back(animation);
+			AnimationScheduler::instance().add(this);
 		}
 
 		void stop()
 		{
-			timer.stop();
 			active_animations.clear();
+			stop_count++;
+			if (scheduled)
+				AnimationScheduler::instance().remove(this);
+		}
+
+		bool is_active() const { return !active_animations.empty(); }
+
+		/// Advances the animations to current_time. Called by AnimationScheduler once per frame.
+		void step(std::chrono::steady_clock::time_point current_time)
+		{
+			// The setters and end callbacks may start or stop animations of this group
+			std::vector<Animation> animations;
+			animations.swap(active_animations);
+			unsigned int stops = stop_count;
+
+			auto it = animations.begin();
+			while (it != animations.end())
+			{
+				if (it->start_time == std::chrono::steady_clock::time_point())
+					it->start_time = current_time;
+
+				long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - it->start_time).count();
+				float t = clan::max(clan::min(static_cast<float>(elapsed) / it->duration, 1.0f), 0.0f);
+
+				float eased = it->easing(t);
+				it->setter(it->from * (1.0f - eased) + it->to * eased);
+				if (stop_count != stops)
+					return;
+
+				if (t >= 1.0f)
+				{
+					std::function<void()> animation_end = std::move(it->animation_end);
+					it = animations.erase(it);
+					if (animation_end)
+					{
+						animation_end();
+						if (stop_count != stops)
+							return;
+					}
+				}
+				else
+				{
+					++it;
+				}
+			}
+
+			animations.insert(animations.end(), active_animations.begin(), active_animations.end());
+			active_animations.swap(animations);
 		}
 
 	private:
 		std::vector<Animation> active_animations;
-		Timer timer;
+		unsigned int stop_count = 0;
+		bool scheduled = false;
+
+		friend class AnimationScheduler;
 	};
 }
@@ -0,0 +1,115 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "UI/precomp.h"
+#include "animation_scheduler.h"
+#include "animation_group.h"
+#include <algorithm>
+
+namespace clan
+{
+	AnimationScheduler &AnimationScheduler::instance()
+	{
+		static AnimationScheduler scheduler;
+		return scheduler;
+	}
+
+	AnimationScheduler::AnimationScheduler()
+	{
+		timer.func_expired() = [this]() { step(); };
+	}
+
+	AnimationScheduler::~AnimationScheduler()
+	{
+		for (AnimationGroup *group : groups)
+		{
+			if (group)
+				group->scheduled = false;
+		}
+	}
+
+	void AnimationScheduler::add(AnimationGroup *group)
+	{
+		if (group->scheduled)
+			return;
+
+		group->scheduled = true;
+		groups.push_back(group);
+
+		if (groups.size() == 1 && !stepping)
+			timer.start(frame_interval, true);
+	}
+
+	void AnimationScheduler::remove(AnimationGroup *group)
+	{
+		if (!group->scheduled)
+			return;
+
+		group->scheduled = false;
+		auto it = std::find(groups.begin(), groups.end(), group);
+		if (stepping)
+		{
+			*it = nullptr;
+		}
+		else
+		{
+			groups.erase(it);
+			if (groups.empty())
+				timer.stop();
+		}
+	}
+
+	void AnimationScheduler::step()
+	{
+		std::chrono::steady_clock::time_point frame_time = std::chrono::steady_clock::now();
+		stepping = true;
+
+		// Groups added by the animation callbacks wait for the next frame
+		size_t count = groups.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (groups[i])
+				groups[i]->step(frame_time);
+		}
+
+		stepping = false;
+
+		size_t active = 0;
+		for (AnimationGroup *group : groups)
+		{
+			if (group && group->is_active())
+				groups[active++] = group;
+			else if (group)
+				group->scheduled = false;
+		}
+		groups.resize(active);
+
+		if (groups.empty())
+			timer.stop();
+	}
+}
@@ -0,0 +1,75 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/System/timer.h"
+#include <chrono>
+#include <vector>
+
+namespace clan
+{
+	class AnimationGroup;
+
+	/// Steps the animations of every AnimationGroup from a single timer
+	///
+	/// All groups are advanced to the same timestamp once per frame. Animations start
+	/// at the first frame after they were added, so animations started together stay
+	/// in lockstep. The timer only runs while animations do.
+	class AnimationScheduler
+	{
+	public:
+		static AnimationScheduler &instance();
+
+		/// Milliseconds between frames
+		static const int frame_interval = 16;
+
+		/// Steps the group every frame until it has no animations left
+		void add(AnimationGroup *group);
+
+		/// Stops stepping the group
+		void remove(AnimationGroup *group);
+
+		/// Number of groups with running animations
+		size_t active_groups() const { return groups.size(); }
+
+	private:
+		AnimationScheduler();
+		~AnimationScheduler();
+		AnimationScheduler(const AnimationScheduler &) = delete;
+		AnimationScheduler &operator=(const AnimationScheduler &) = delete;
+
+		void step();
+
+		/// Scheduled groups. Groups removed during a step are set to null until the step ends.
+		std::vector<AnimationGroup *> groups;
+
+		Timer timer;
+		bool stepping = false;
+	};
+}
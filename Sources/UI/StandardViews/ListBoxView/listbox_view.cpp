@@ -44,6 +44,7 @@ namespace clan
 		slots.connect(sig_key_press(), impl.get(), &ListBoxViewImpl::on_key_press);
 		slots.connect(content_view()->sig_pointer_press(), impl.get(), &ListBoxViewImpl::on_pointer_press);
 		slots.connect(content_view()->sig_pointer_release(), impl.get(), &ListBoxViewImpl::on_pointer_release);
+		slots.connect(sig_content_offset_changed(), impl.get(), &ListBoxViewImpl::on_content_offset_changed);
 
 	}
 
@@ -58,11 +59,7 @@ namespace clan
 	
 	void ListBoxView::set_items(const std::vector<std::shared_ptr<View>> &items)
 	{
-		impl->selected_item = -1;
-		
-		auto views = content_view()->children();
-		while (!views.empty())
-			views.back()->remove_from_parent();
+		impl->clear_items();
 		
 		for (auto &item : items)
 		{
@@ -73,6 +70,43 @@ namespace clan
 		}
 
 	}
+
+	void ListBoxView::set_items(int item_count, const std::function<std::shared_ptr<View>()> &create_row, const std::function<void(const std::shared_ptr<View> &row, int index)> &update_row)
+	{
+		impl->clear_items();
+
+		impl->rows_view = std::make_shared<ListBoxRowsView>(impl.get());
+		impl->rows_item_count = item_count;
+		impl->func_create_row = create_row;
+		impl->func_update_row = update_row;
+		content_view()->add_child(impl->rows_view);
+	}
+
+	void ListBoxView::set_item_count(int item_count)
+	{
+		if (!impl->rows_view)
+			throw Exception("Listbox is not using on demand rows");
+
+		impl->rows_item_count = item_count;
+		if (impl->selected_item >= item_count)
+			impl->selected_item = -1;
+		if (impl->hot_item >= item_count)
+			impl->hot_item = -1;
+
+		impl->reset_rows();
+	}
+
+	int ListBoxView::item_count() const
+	{
+		return impl->item_count();
+	}
+
+	void ListBoxView::set_overscan(int rows)
+	{
+		impl->overscan = std::max(rows, 0);
+		if (impl->rows_view)
+			impl->rows_view->set_needs_layout();
+	}
 	
 	int ListBoxView::selected_item() const
 	{
@@ -84,21 +118,23 @@ namespace clan
 		if (index == impl->selected_item)
 			return;
 		
-		if (index < -1 || index >= (int) content_view()->children().size())
+		if (index < -1 || index >= impl->item_count())
 			throw Exception("Listbox index out of bounds");
 
-		if (impl->selected_item != -1)
-			content_view()->children().at(impl->selected_item)->set_state("selected", false);
+		auto old_selected_item = impl->item_view(impl->selected_item);
+		if (old_selected_item)
+			old_selected_item->set_state("selected", false);
 		
 		if (index != -1)
 		{
 			if (impl->hot_item == index)
 				impl->set_hot_item(-1);
 
-			auto new_selected_item = content_view()->children().at(index);
-			new_selected_item->set_state("selected", true);
+			auto new_selected_item = impl->item_view(index);
+			if (new_selected_item)
+				new_selected_item->set_state("selected", true);
 			
-			// To do: call set_content_offset() if new_selected_item is not within range (maybe add a helper on ScrollView for this?)
+			impl->scroll_to_item(index);
 		}
 		
 		impl->selected_item = index;
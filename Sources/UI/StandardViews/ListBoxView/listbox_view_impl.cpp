@@ -33,12 +33,20 @@
 #include "API/UI/Events/pointer_event.h"
 #include "API/UI/Events/key_event.h"
 #include "listbox_view_impl.h"
+#include "../../View/view_impl.h"
+#include <cmath>
 
 namespace clan
 {
+	namespace
+	{
+		const StylePropertyId prop_width("width");
+		const StylePropertyId prop_height("height");
+	}
+
 	void ListBoxViewImpl::on_key_press(KeyEvent &e)
 	{
-		if (listbox->content_view()->children().empty())
+		if (item_count() == 0)
 			return;
 
 		if (e.key() == Key::up)
@@ -49,7 +57,7 @@ namespace clan
 		}
 		else if (e.key() == Key::down)
 		{
-			listbox->set_selected_item(clan::min(selected_item + 1, (int)listbox->content_view()->children().size() - 1));
+			listbox->set_selected_item(clan::min(selected_item + 1, item_count() - 1));
 			if (func_selection_changed)
 				func_selection_changed();
 		}
@@ -84,6 +92,16 @@ namespace clan
 
 	int ListBoxViewImpl::get_selection_index(PointerEvent &e)
 	{
+		if (rows_view)
+		{
+			if (measured_row_height <= 0.0f)
+				return -1;
+
+			float y = e.pos(listbox->content_view()).y - rows_view->geometry().content_y;
+			int index = (int)std::floor(y / measured_row_height);
+			return (index >= 0 && index < rows_item_count) ? index : -1;
+		}
+
 		int index = 0;
 		for (auto &view : listbox->content_view()->children())
 		{
@@ -100,17 +118,16 @@ namespace clan
 		if ((index == hot_item) || (index == selected_item))		// Selected item state has priority
 			return;
 
-		if (index < -1 || index >= (int) listbox->content_view()->children().size())
+		if (index < -1 || index >= item_count())
 			throw Exception("Listbox index out of bounds");
 
-		if (hot_item != -1)
-			listbox->content_view()->children().at(hot_item)->set_state("hot", false);
+		auto old_hot_item = item_view(hot_item);
+		if (old_hot_item)
+			old_hot_item->set_state("hot", false);
 
-		if (index != -1)
-		{
-			auto new_selected_item = listbox->content_view()->children().at(index);
-			new_selected_item->set_state("hot", true);
-		}
+		auto new_hot_item = item_view(index);
+		if (new_hot_item)
+			new_hot_item->set_state("hot", true);
 
 		hot_item = index;
 	}
@@ -125,4 +142,240 @@ namespace clan
 		set_hot_item(-1);
 	}
 
+	void ListBoxViewImpl::on_content_offset_changed()
+	{
+		if (!rows_view || measured_row_height <= 0.0f)
+			return;
+
+		// Overscan rows let small scrolls through without a new layout
+		int first, last;
+		visible_range(measured_row_height, first, last);
+		if (first < rows_first || last > rows_last)
+			rows_view->set_needs_layout();
+	}
+
+	int ListBoxViewImpl::item_count() const
+	{
+		if (rows_view)
+			return rows_item_count;
+		else
+			return (int)listbox->content_view()->children().size();
+	}
+
+	std::shared_ptr<View> ListBoxViewImpl::item_view(int index) const
+	{
+		if (index < 0)
+			return nullptr;
+
+		if (rows_view)
+		{
+			for (size_t i = 0; i < rows.size(); i++)
+			{
+				if (row_items[i] == index)
+					return rows[i];
+			}
+			return nullptr;
+		}
+
+		const auto &children = listbox->content_view()->children();
+		return index < (int)children.size() ? children[index] : nullptr;
+	}
+
+	void ListBoxViewImpl::scroll_to_item(int index)
+	{
+		float top, bottom;
+		if (rows_view)
+		{
+			if (measured_row_height <= 0.0f)
+				return;
+			top = rows_view->geometry().content_y + index * measured_row_height;
+			bottom = top + measured_row_height;
+		}
+		else
+		{
+			auto view = item_view(index);
+			if (!view)
+				return;
+			top = view->geometry().margin_box().top;
+			bottom = view->geometry().margin_box().bottom;
+		}
+
+		Pointf offset = listbox->content_offset();
+		float viewport_height = listbox->viewport_size().height;
+		if (top < offset.y)
+			offset.y = top;
+		else if (bottom > offset.y + viewport_height)
+			offset.y = bottom - viewport_height;
+		listbox->set_content_offset(offset);
+	}
+
+	void ListBoxViewImpl::clear_items()
+	{
+		selected_item = -1;
+		hot_item = -1;
+		last_selected_item = -1;
+
+		rows_view.reset();
+		rows.clear();
+		row_items.clear();
+		row_slots = SlotContainer();
+		rows_first = 0;
+		rows_last = 0;
+		measured_row_width = -1.0f;
+		measured_row_height = 0.0f;
+		func_create_row = nullptr;
+		func_update_row = nullptr;
+
+		auto views = listbox->content_view()->children();
+		while (!views.empty())
+		{
+			views.back()->remove_from_parent();
+			views.pop_back();
+		}
+	}
+
+	void ListBoxViewImpl::reset_rows()
+	{
+		for (auto &item : row_items)
+			item = -1;
+		rows_first = 0;
+		rows_last = 0;
+		measured_row_width = -1.0f;
+		rows_view->set_needs_layout();
+	}
+
+	float ListBoxViewImpl::row_height(Canvas &canvas, float width)
+	{
+		if (width == measured_row_width)
+			return measured_row_height;
+
+		measured_row_width = width;
+		measured_row_height = 0.0f;
+		if (rows_item_count == 0)
+			return 0.0f;
+
+		if (rows.empty())
+			bind_row(0);
+
+		const auto &row = rows.front();
+		float content_width = ViewGeometry::from_margin_box(row->style_cascade(), Rectf(0.0f, 0.0f, width, 0.0f)).content_width;
+		auto height = row->style_cascade().computed_value(prop_height);
+		float content_height = height.is_length() ? height.number() : row->preferred_height(canvas, content_width);
+		measured_row_height = ViewGeometry::from_content_box(row->style_cascade(), Rectf(0.0f, 0.0f, content_width, content_height)).margin_box().get_height();
+		return measured_row_height;
+	}
+
+	void ListBoxViewImpl::visible_range(float row_height, int &first, int &last) const
+	{
+		float top = listbox->content_offset().y - rows_view->geometry().content_y;
+		float bottom = top + listbox->viewport_size().height;
+		first = clamp((int)std::floor(top / row_height), 0, rows_item_count);
+		last = clamp((int)std::ceil(bottom / row_height), first, rows_item_count);
+	}
+
+	void ListBoxViewImpl::bind_row(int index)
+	{
+		size_t slot = 0;
+		while (slot < rows.size() && row_items[slot] != -1)
+			slot++;
+
+		if (slot == rows.size())
+		{
+			auto row = func_create_row();
+			rows_view->add_child(row);
+			row_slots.connect(row->sig_pointer_enter(), this, &ListBoxViewImpl::on_pointer_enter);
+			row_slots.connect(row->sig_pointer_leave(), this, &ListBoxViewImpl::on_pointer_leave);
+			rows.push_back(row);
+			row_items.push_back(-1);
+		}
+
+		const auto &row = rows[slot];
+		row_items[slot] = index;
+		func_update_row(row, index);
+		row->set_state("selected", index == selected_item);
+		row->set_state("hot", index == hot_item);
+		row->set_hidden(false);
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	void ListBoxRowsView::layout_children(Canvas &canvas)
+	{
+		ListBoxViewImpl *impl = listbox_impl;
+
+		float width = geometry().content_width;
+		float row_height = impl->row_height(canvas, width);
+		if (row_height <= 0.0f)
+		{
+			for (size_t i = 0; i < impl->rows.size(); i++)
+			{
+				impl->row_items[i] = -1;
+				impl->rows[i]->set_hidden(true);
+			}
+			impl->rows_first = 0;
+			impl->rows_last = 0;
+			return;
+		}
+
+		int first, last;
+		impl->visible_range(row_height, first, last);
+		first = std::max(first - impl->overscan, 0);
+		last = std::min(last + impl->overscan, impl->rows_item_count);
+
+		// Release the rows scrolled out of the window
+		std::vector<bool> bound(last - first);
+		for (size_t i = 0; i < impl->rows.size(); i++)
+		{
+			int index = impl->row_items[i];
+			if (index >= first && index < last)
+			{
+				bound[index - first] = true;
+			}
+			else if (index != -1 || !impl->rows[i]->hidden())
+			{
+				impl->row_items[i] = -1;
+				impl->rows[i]->set_hidden(true);
+			}
+		}
+
+		for (int index = first; index < last; index++)
+		{
+			if (!bound[index - first])
+				impl->bind_row(index);
+		}
+
+		for (size_t i = 0; i < impl->rows.size(); i++)
+		{
+			int index = impl->row_items[i];
+			if (index == -1)
+				continue;
+
+			auto &row = impl->rows[i];
+			row->set_geometry(ViewGeometry::from_margin_box(row->style_cascade(), Rectf(0.0f, index * row_height, width, (index + 1) * row_height)));
+			ViewImpl::update_layout(row.get(), canvas);
+		}
+
+		impl->rows_first = first;
+		impl->rows_last = last;
+	}
+
+	float ListBoxRowsView::calculate_preferred_width(Canvas &canvas)
+	{
+		ListBoxViewImpl *impl = listbox_impl;
+		if (impl->rows_item_count == 0)
+			return 0.0f;
+
+		if (impl->rows.empty())
+			impl->bind_row(0);
+
+		const auto &row = impl->rows.front();
+		auto width = row->style_cascade().computed_value(prop_width);
+		float content_width = width.is_length() ? width.number() : row->preferred_width(canvas);
+		return ViewGeometry::from_content_box(row->style_cascade(), Rectf(0.0f, 0.0f, content_width, 0.0f)).margin_box().get_width();
+	}
+
+	float ListBoxRowsView::calculate_preferred_height(Canvas &canvas, float width)
+	{
+		return listbox_impl->rows_item_count * listbox_impl->row_height(canvas, width);
+	}
 }
@@ -30,6 +30,26 @@
 
 namespace clan
 {
+	class ListBoxViewImpl;
+
+	/// Holds the reused row views of a list box with on demand rows
+	class ListBoxRowsView : public View
+	{
+	public:
+		ListBoxRowsView(ListBoxViewImpl *listbox_impl) : listbox_impl(listbox_impl) { }
+
+		void layout_children(Canvas &canvas) override;
+
+	protected:
+		float calculate_preferred_width(Canvas &canvas) override;
+		float calculate_preferred_height(Canvas &canvas, float width) override;
+		float calculate_first_baseline_offset(Canvas &canvas, float width) override { return 0.0f; }
+		float calculate_last_baseline_offset(Canvas &canvas, float width) override { return 0.0f; }
+
+	private:
+		ListBoxViewImpl *listbox_impl;
+	};
+
 	class ListBoxViewImpl
 	{
 	public:
@@ -38,9 +58,34 @@ namespace clan
 		void on_pointer_release(PointerEvent &e);
 		void on_pointer_enter(PointerEvent &e);
 		void on_pointer_leave(PointerEvent &e);
+		void on_content_offset_changed();
 
 		void set_hot_item(int index);
 
+		/// Number of items, including those without a row view
+		int item_count() const;
+
+		/// View showing the item, or null if the item has no row view at the moment
+		std::shared_ptr<View> item_view(int index) const;
+
+		/// Scrolls the list so that the item is in view
+		void scroll_to_item(int index);
+
+		/// Removes the rows of on demand mode, or the item views of set_items
+		void clear_items();
+
+		/// Unbinds all on demand rows so that they are updated at the next layout
+		void reset_rows();
+
+		/// Height of each on demand row, measured from the first row
+		float row_height(Canvas &canvas, float width);
+
+		/// Items that must have a row view for the current content offset
+		void visible_range(float row_height, int &first, int &last) const;
+
+		/// Gets a row view for the item, reusing an unbound row if there is one
+		void bind_row(int index);
+
 		ListBoxView *listbox = nullptr;
 		int selected_item = -1;
 		int hot_item = -1;
@@ -48,6 +93,26 @@ namespace clan
 
 		std::function<void()> func_selection_changed;
 
+		/// On demand mode. Null when the items were passed to set_items as views.
+		std::shared_ptr<ListBoxRowsView> rows_view;
+		int rows_item_count = 0;
+		int overscan = 2;
+		std::function<std::shared_ptr<View>()> func_create_row;
+		std::function<void(const std::shared_ptr<View> &row, int index)> func_update_row;
+
+		/// Row views and the item each is bound to, or -1 if it is unused and hidden
+		std::vector<std::shared_ptr<View>> rows;
+		std::vector<int> row_items;
+
+		/// Items with a row view since the last layout
+		int rows_first = 0;
+		int rows_last = 0;
+
+		float measured_row_width = -1.0f;
+		float measured_row_height = 0.0f;
+
+		SlotContainer row_slots;
+
 	private:
 		int get_selection_index(PointerEvent &e);
 	};
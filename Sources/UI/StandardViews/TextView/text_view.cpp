@@ -39,7 +39,6 @@
 #include "API/Display/Font/glyph_metrics.h"
 #include "API/Display/Font/font_metrics.h"
 #include "API/Display/Window/display_window.h"
-#include "API/Core/Text/string_help.h"
 #include "API/Core/Text/utf8_reader.h"
 #include "text_view_impl.h"
 #include <algorithm>
@@ -50,7 +49,6 @@ namespace clan
 	TextView::TextView() : impl(new TextViewImpl())
 	{
 		impl->textfield = this;
-		impl->text_lines.resize(1);
 		impl->selection.set_view(this);
 
 		set_focus_policy(FocusPolicy::accept);
@@ -96,26 +94,13 @@ namespace clan
 
 	std::string TextView::text() const
 	{
-		size_t length = 0;
-		for (const auto &line : impl->text_lines) length += line.length() + 1;
-
-		std::string all_text;
-		all_text.reserve(length);
-		for (const auto &line : impl->text_lines)
-		{
-			if (!all_text.empty())
-				all_text.push_back('\n');
-			all_text += line;
-		}
-
-		return all_text;
+		return impl->document.text();
 	}
 
 	void TextView::set_text(const std::string &text)
 	{
-		impl->text_lines = StringHelp::split_text(text, "\n", false);
-		if (impl->text_lines.empty())
-			impl->text_lines.resize(1);
+		impl->document.set_text(text);
+		impl->measured_lines.clear();
 
 		impl->selection.reset();
 		impl->cursor_pos = Vec2i();
@@ -184,10 +169,11 @@ namespace clan
 	void TextView::set_selection(Vec2i head, Vec2i tail)
 	{
 		// Bounds check: (to do: should we throw an out of bounds exception instead?)
-		head.y = std::max(std::min(head.y, (int)impl->text_lines.size() - 1), 0);
-		tail.y = std::max(std::min(head.y, (int)impl->text_lines.size() - 1), 0);
-		head.x = std::max(std::min(head.x, (int)impl->text_lines[head.y].size()), 0);
-		tail.x = std::max(std::min(tail.x, (int)impl->text_lines[tail.y].size()), 0);
+		int last_line = impl->document.line_count() - 1;
+		head.y = std::max(std::min(head.y, last_line), 0);
+		tail.y = std::max(std::min(tail.y, last_line), 0);
+		head.x = std::max(std::min(head.x, (int)impl->document.line_length(head.y)), 0);
+		tail.x = std::max(std::min(tail.x, (int)impl->document.line_length(tail.y)), 0);
 
 		impl->selection.set_head_and_tail(head, tail);
 		impl->cursor_pos = tail;
@@ -207,7 +193,8 @@ namespace clan
 
 	void TextView::select_all()
 	{
-		set_selection(Vec2i(0, 0), Vec2i(impl->text_lines.back().size(), impl->text_lines.size() - 1));
+		int last_line = impl->document.line_count() - 1;
+		set_selection(Vec2i(0, 0), Vec2i(impl->document.line_length(last_line), last_line));
 	}
 
 	Vec2i TextView::cursor_pos() const
@@ -254,50 +241,67 @@ namespace clan
 		float top_y = baseline - font_metrics.get_ascent();
 		float bottom_y = baseline + font_metrics.get_descent();
 
+		float line_height = font_metrics.get_line_height();
+		impl->line_height = line_height;
+
 		Colorf color = style_cascade().computed_value("color").color();
+		Colorf selected_color = focus_view() == this ? Colorf(255, 255, 255) : color;
 
-		float cursor_advance = canvas.grid_fit({ font.measure_text(canvas, impl->text_lines[impl->cursor_pos.y].substr(0, impl->cursor_pos.x)).advance.width, 0.0f }).x;
+		float cursor_advance = canvas.grid_fit({ impl->measure_line(canvas, impl->cursor_pos.y).advance(impl->cursor_pos.x), 0.0f }).x;
+		float cursor_top = line_height * impl->cursor_pos.y;
 
 		// Keep cursor in view
 		impl->scroll_pos.x = std::min(impl->scroll_pos.x, cursor_advance);
 		impl->scroll_pos.x = std::max(impl->scroll_pos.x, cursor_advance - geometry().content_width + 1.0f);
+		impl->scroll_pos.y = std::min(impl->scroll_pos.y, cursor_top);
+		impl->scroll_pos.y = std::max(impl->scroll_pos.y, cursor_top + line_height - geometry().content_height);
 
-		size_t line_start_y = -impl->scroll_pos.y;
-
-		for (size_t line_index = 0; line_index < impl->text_lines.size(); line_index++)
+		// Only the visible lines are measured and drawn
+		size_t first_line = 0;
+		size_t end_line = impl->document.line_count();
+		if (line_height > 0.0f)
 		{
-			std::string txt_before = impl->get_text_before_selection(line_index);
-			std::string txt_selected = impl->get_selected_text(line_index);
-			std::string txt_after = impl->get_text_after_selection(line_index);
+			first_line = std::min((size_t)std::max(std::floor(impl->scroll_pos.y / line_height), 0.0f), end_line - 1);
+			end_line = std::min((size_t)std::max(std::ceil((impl->scroll_pos.y + geometry().content_height) / line_height), 0.0f), end_line);
+		}
 
-			float advance_before = font.measure_text(canvas, txt_before).advance.width;
-			float advance_selected = font.measure_text(canvas, txt_selected).advance.width;
+		for (size_t line_index = first_line; line_index < end_line; line_index++)
+		{
+			const TextViewLine &line = impl->measure_line(canvas, line_index);
+			float line_start_y = line_height * line_index - impl->scroll_pos.y;
 
-			// Measure text for get_character_index()
-			impl->last_measured_rects = font.get_character_indices(canvas, txt_before + txt_selected + txt_after);
-			for (auto &box : impl->last_measured_rects)
-				box.translate(-impl->scroll_pos.x, line_start_y);
+			int selection_begin, selection_end;
+			impl->get_selection_range(line_index, line.text.size(), selection_begin, selection_end);
 
-			if (!txt_selected.empty())
+			if (selection_begin == selection_end)
 			{
-				Rectf selection_rect = Rectf(advance_before - impl->scroll_pos.x, top_y + line_start_y, advance_before + advance_selected - impl->scroll_pos.x, bottom_y + line_start_y);
-				Path::rect(selection_rect).fill(canvas, focus_view() == this ? Brush::solid_rgb8(51, 153, 255) : Brush::solid_rgb8(200, 200, 200));
+				font.draw_text(canvas, -impl->scroll_pos.x, baseline + line_start_y, line.text, color);
 			}
+			else
+			{
+				float advance_before = line.advance(selection_begin);
+				float advance_after = line.advance(selection_end);
 
-			font.draw_text(canvas, -impl->scroll_pos.x, baseline + line_start_y, txt_before, color);
-			font.draw_text(canvas, advance_before - impl->scroll_pos.x, baseline + line_start_y, txt_selected, focus_view() == this ? Colorf(255, 255, 255) : color);
-			font.draw_text(canvas, advance_before + advance_selected - impl->scroll_pos.x, baseline + line_start_y, txt_after, color);
+				Rectf selection_rect = Rectf(advance_before - impl->scroll_pos.x, top_y + line_start_y, advance_after - impl->scroll_pos.x, bottom_y + line_start_y);
+				Path::rect(selection_rect).fill(canvas, focus_view() == this ? Brush::solid_rgb8(51, 153, 255) : Brush::solid_rgb8(200, 200, 200));
 
-			line_start_y += font_metrics.get_line_height();
+				font.draw_text(canvas, -impl->scroll_pos.x, baseline + line_start_y, line.text.substr(0, selection_begin), color);
+				font.draw_text(canvas, advance_before - impl->scroll_pos.x, baseline + line_start_y, line.text.substr(selection_begin, selection_end - selection_begin), selected_color);
+				font.draw_text(canvas, advance_after - impl->scroll_pos.x, baseline + line_start_y, line.text.substr(selection_end), color);
+			}
 		}
 
+		// Forget lines scrolled out of view
+		impl->measured_lines.erase(impl->measured_lines.begin(), impl->measured_lines.lower_bound(std::min(first_line, (size_t)impl->cursor_pos.y)));
+		impl->measured_lines.erase(impl->measured_lines.upper_bound(std::max(end_line, (size_t)impl->cursor_pos.y + 1) - 1), impl->measured_lines.end());
+
 		if (impl->cursor_blink_visible)
 		{
 			auto cursor_pos = canvas.grid_fit({ cursor_advance - impl->scroll_pos.x, top_y - impl->scroll_pos.y + font_metrics.get_line_height() * impl->cursor_pos.y });
 			Path::rect(cursor_pos.x, cursor_pos.y, 1.0f, bottom_y - top_y).fill(canvas, Brush(color));
 		}
 
-		if (impl->text_lines.size() == 1 && impl->text_lines.front().empty())
+		if (impl->document.length() == 0)
 		{
 			color.r = color.r * 0.5f + 0.5f;
 			color.g = color.g * 0.5f + 0.5f;
@@ -574,7 +578,8 @@ namespace clan
 
 	void TextViewImpl::select_all()
 	{
-		selection.set_head_and_tail(Vec2i(), Vec2i(text_lines.back().size(), text_lines.size()));
+		int last_line = document.line_count() - 1;
+		selection.set_head_and_tail(Vec2i(), Vec2i(document.line_length(last_line), last_line));
 	}
 
 	void TextViewImpl::move_line(int steps, bool ctrl, bool shift, bool stay_on_line)
@@ -591,10 +596,10 @@ namespace clan
 		{
 			for (int i = 0; i < steps; i++)
 			{
-				if (pos.y + 1 != text_lines.size())
+				if (pos.y + 1 != (int)document.line_count())
 				{
 					pos.y++;
-					pos.x = std::min(pos.x, (int)text_lines[pos.y].size());
+					pos.x = std::min(pos.x, (int)document.line_length(pos.y));
 				}
 			}
 		}
@@ -605,7 +610,7 @@ namespace clan
 				if (pos.y > 0)
 				{
 					pos.y--;
-					pos.x = std::min(pos.x, (int)text_lines[pos.y].size());
+					pos.x = std::min(pos.x, (int)document.line_length(pos.y));
 				}
 			}
 		}
@@ -638,13 +643,13 @@ namespace clan
 				if (!stay_on_line && pos.x == 0 && pos.y != 0)
 				{
 					pos.y--;
-					pos.x = text_lines[pos.y].size();
+					pos.x = document.line_length(pos.y);
 				}
 				pos.x = find_previous_break_character(pos.x, pos.y);
 			}
 			else
 			{
-				if (!stay_on_line && pos.x == text_lines[pos.y].size() && pos.y + 1 != text_lines.size())
+				if (!stay_on_line && pos.x == (int)document.line_length(pos.y) && pos.y + 1 != (int)document.line_count())
 				{
 					pos.y++;
 					pos.x = 0;
@@ -654,17 +659,19 @@ namespace clan
 		}
 		else
 		{
-			UTF8_Reader utf8_reader(text_lines[pos.y].data(), text_lines[pos.y].length());
+			std::string line = document.line(pos.y);
+			UTF8_Reader utf8_reader(line.data(), line.length());
 			utf8_reader.set_position(pos.x);
 
 			if (steps > 0)
 			{
 				for (int i = 0; i < steps; i++)
 				{
-					if (!stay_on_line && utf8_reader.get_position() == text_lines[pos.y].size() && pos.y + 1 != text_lines.size())
+					if (!stay_on_line && utf8_reader.get_position() == line.size() && pos.y + 1 != (int)document.line_count())
 					{
 						pos.y++;
-						utf8_reader = UTF8_Reader(text_lines[pos.y].data(), text_lines[pos.y].length());
+						line = document.line(pos.y);
+						utf8_reader = UTF8_Reader(line.data(), line.length());
 						utf8_reader.set_position(0);
 					}
 					else
@@ -680,8 +687,9 @@ namespace clan
 					if (!stay_on_line && utf8_reader.get_position() == 0 && pos.y != 0)
 					{
 						pos.y--;
-						utf8_reader = UTF8_Reader(text_lines[pos.y].data(), text_lines[pos.y].length());
-						utf8_reader.set_position(text_lines[pos.y].length());
+						line = document.line(pos.y);
+						utf8_reader = UTF8_Reader(line.data(), line.length());
+						utf8_reader.set_position(line.length());
 					}
 					else
 					{
@@ -740,8 +748,8 @@ namespace clan
 		Vec2i pos = cursor_pos;
 
 		if (ctrl)
-			pos.y = text_lines.size() - 1;
-		pos.x = text_lines[pos.y].size();
+			pos.y = document.line_count() - 1;
+		pos.x = document.line_length(pos.y);
 
 		if (pos == cursor_pos)
 			return;
@@ -771,26 +779,29 @@ namespace clan
 		{
 			save_undo();
 
-			UTF8_Reader utf8_reader(text_lines[cursor_pos.y].data(), text_lines[cursor_pos.y].length());
+			std::string line = document.line(cursor_pos.y);
+			UTF8_Reader utf8_reader(line.data(), line.length());
 			utf8_reader.set_position(cursor_pos.x);
 			utf8_reader.prev();
 			int new_cursor_pos = utf8_reader.get_position();
 
-			text_lines[cursor_pos.y].erase(text_lines[cursor_pos.y].begin() + new_cursor_pos, text_lines[cursor_pos.y].begin() + cursor_pos.x);
+			document.erase(document.offset(Vec2i(new_cursor_pos, cursor_pos.y)), cursor_pos.x - new_cursor_pos);
 			cursor_pos.x = new_cursor_pos;
 
+			lines_changed(cursor_pos.y, false);
 			textfield->set_needs_render();
 		}
 		else if (cursor_pos.y > 0)
 		{
 			save_undo();
 
+			size_t line_feed = document.line_start(cursor_pos.y) - 1;
 			cursor_pos.y--;
-			cursor_pos.x = text_lines[cursor_pos.y].length();
+			cursor_pos.x = document.line_length(cursor_pos.y);
 
-			text_lines[cursor_pos.y] += text_lines[cursor_pos.y + 1];
-			text_lines.erase(text_lines.begin() + cursor_pos.y + 1);
+			document.erase(line_feed, 1);
 
+			lines_changed(cursor_pos.y, true);
 			textfield->set_needs_render();
 		}
 	}
@@ -804,39 +815,34 @@ namespace clan
 			auto start = selection.start();
 			auto end = selection.end();
 
-			if (start.y == end.y)
-			{
-				text_lines[start.y].erase(text_lines[start.y].begin() + start.x, text_lines[start.y].begin() + end.x);
-			}
-			else
-			{
-				text_lines[start.y].erase(text_lines[start.y].begin() + start.x, text_lines[start.y].end());
-				text_lines[end.y].erase(text_lines[end.y].begin(), text_lines[end.y].begin() + end.x);
-				text_lines.erase(text_lines.begin() + start.y + 1, text_lines.begin() + end.y);
-			}
+			size_t start_offset = document.offset(start);
+			document.erase(start_offset, document.offset(end) - start_offset);
+			lines_changed(start.y, start.y != end.y);
 
 			cursor_pos = start;
 			selection.reset();
 
 			textfield->set_needs_render();
 		}
-		else if (cursor_pos.x < text_lines[cursor_pos.y].length())
+		else if (cursor_pos.x < (int)document.line_length(cursor_pos.y))
 		{
 			save_undo();
 
-			UTF8_Reader utf8_reader(text_lines[cursor_pos.y].data(), text_lines[cursor_pos.y].length());
+			std::string line = document.line(cursor_pos.y);
+			UTF8_Reader utf8_reader(line.data(), line.length());
 			utf8_reader.set_position(cursor_pos.x);
-			text_lines[cursor_pos.y].erase(text_lines[cursor_pos.y].begin() + cursor_pos.x, text_lines[cursor_pos.y].begin() + cursor_pos.x + utf8_reader.get_char_length());
+			document.erase(document.offset(cursor_pos), utf8_reader.get_char_length());
 
+			lines_changed(cursor_pos.y, false);
 			textfield->set_needs_render();
 		}
-		else if (cursor_pos.y + 1 < text_lines.size())
+		else if (cursor_pos.y + 1 < (int)document.line_count())
 		{
 			save_undo();
 
-			text_lines[cursor_pos.y] += text_lines[cursor_pos.y + 1];
-			text_lines.erase(text_lines.begin() + cursor_pos.y + 1);
+			document.erase(document.offset(cursor_pos), 1);
 
+			lines_changed(cursor_pos.y, true);
 			textfield->set_needs_render();
 		}
 	}
@@ -947,23 +953,19 @@ namespace clan
 
 		save_undo();
 
-		size_t start = 0;
-		while (true)
-		{
-			size_t end = new_text.find('\n', start);
-			if (end == std::string::npos)
-				end = new_text.size();
-
-			text_lines[cursor_pos.y] = text_lines[cursor_pos.y].substr(0, cursor_pos.x) + new_text.substr(start, end - start) + text_lines[cursor_pos.y].substr(cursor_pos.x);
-			cursor_pos.x += end - start;
+		document.insert(document.offset(cursor_pos), new_text);
 
-			if (end == new_text.size())
-				break;
-			start = end + 1;
-
-			text_lines.insert(text_lines.begin() + cursor_pos.y + 1, text_lines[cursor_pos.y].substr(cursor_pos.x));
-			text_lines[cursor_pos.y].resize(cursor_pos.x);
-			cursor_pos = Vec2i(0, cursor_pos.y + 1);
+		size_t last_line_feed = new_text.rfind('\n');
+		if (last_line_feed == std::string::npos)
+		{
+			lines_changed(cursor_pos.y, false);
+			cursor_pos.x += new_text.size();
+		}
+		else
+		{
+			lines_changed(cursor_pos.y, true);
+			cursor_pos.y += std::count(new_text.begin(), new_text.end(), '\n');
+			cursor_pos.x = new_text.size() - last_line_feed - 1;
 		}
 
 		textfield->set_needs_render();
@@ -971,82 +973,78 @@ namespace clan
 
 	std::string TextViewImpl::get_all_selected_text() const
 	{
-		Vec2i start = selection.start();
-		Vec2i end = selection.end();
-
-		if (start.y == end.y)
-		{
-			return text_lines[start.y].substr(start.x, end.x - start.x);
-		}
-		else
-		{
-			size_t length = text_lines[start.y].length() - start.x + text_lines[end.y].length() - end.x + 1;
-			for (auto y = start.y + 1; y < end.y; y++)
-				length += text_lines[y].length() + 1;
-
-			std::string result;
-			result.reserve(length);
-			result += text_lines[start.y].substr(start.x);
-			result.push_back('\n');
-			for (auto y = start.y + 1; y < end.y; y++)
-			{
-				result += text_lines[y];
-				result.push_back('\n');
-			}
-			result += text_lines[end.y].substr(0, end.x);
-			return result;
-		}
+		size_t start = document.offset(selection.start());
+		size_t end = document.offset(selection.end());
+		return document.text(start, end - start);
 	}
 
-	std::string TextViewImpl::get_text_before_selection(size_t line_index) const
+	void TextViewImpl::get_selection_range(size_t line_index, int line_length, int &begin, int &end) const
 	{
 		Vec2i start = selection.start();
+		Vec2i stop = selection.end();
 
 		if ((size_t)start.y == line_index)
-			return text_lines[line_index].substr(0, start.x);
-		else if ((size_t)start.y > line_index)
-			return text_lines[line_index];
+			begin = std::min(start.x, line_length);
 		else
-			return std::string();
-	}
+			begin = (size_t)start.y < line_index ? 0 : line_length;
 
-	std::string TextViewImpl::get_selected_text(size_t line_index) const
-	{
-		Vec2i start = selection.start();
-		Vec2i end = selection.end();
-
-		if (start.y == line_index && end.y == line_index)
-			return text_lines[line_index].substr(start.x, end.x - start.x);
-		else if ((size_t)start.y > line_index || (size_t)end.y < line_index)
-			return std::string();
-		else if (start.y == line_index)
-			return text_lines[line_index].substr(start.x);
-		else if (end.y == line_index)
-			return text_lines[line_index].substr(0, end.x);
+		if ((size_t)stop.y == line_index)
+			end = std::min(stop.x, line_length);
 		else
-			return text_lines[line_index];
+			end = (size_t)stop.y > line_index ? line_length : 0;
+
+		end = std::max(begin, end);
 	}
 
-	std::string TextViewImpl::get_text_after_selection(size_t line_index) const
+	TextViewLine &TextViewImpl::measure_line(Canvas &canvas, size_t line_index)
 	{
-		Vec2i end = selection.end();
+		auto it = measured_lines.find(line_index);
+		if (it != measured_lines.end())
+			return it->second;
 
-		if ((size_t)end.y == line_index)
-			return text_lines[line_index].substr(end.x);
-		else if ((size_t)end.y < line_index)
-			return text_lines[line_index];
-		else
-			return std::string();
+		TextViewLine &line = measured_lines[line_index];
+		line.text = document.line(line_index);
+
+		std::vector<Rectf> glyphs = get_font(canvas).get_character_indices(canvas, line.text);
+		line.advances.reserve(line.text.size() + 1);
+
+		float x = 0.0f;
+		size_t glyph = 0;
+		UTF8_Reader utf8_reader(line.text.data(), line.text.length());
+		while (!utf8_reader.is_end())
+		{
+			if (glyph < glyphs.size())
+				x = glyphs[glyph].left;
+
+			size_t char_start = utf8_reader.get_position();
+			utf8_reader.next();
+			line.advances.resize(line.advances.size() + utf8_reader.get_position() - char_start, x);
+
+			if (glyph < glyphs.size())
+				x = glyphs[glyph].right;
+			glyph++;
+		}
+		line.advances.resize(line.text.size() + 1, x);
+
+		return line;
+	}
+
+	void TextViewImpl::lines_changed(size_t line_index, bool lines_moved)
+	{
+		auto begin = measured_lines.lower_bound(line_index);
+		auto end = lines_moved ? measured_lines.end() : measured_lines.upper_bound(line_index);
+		measured_lines.erase(begin, end);
 	}
 
 	int TextViewImpl::find_next_break_character(int search_start, int line) const
 	{
-		if (search_start == text_lines[line].size())
+		std::string text = document.line(line);
+		if (search_start == (int)text.size())
 			return search_start;
 
-		size_t pos = text_lines[line].find_first_of(break_characters, search_start + 1);
+		size_t pos = text.find_first_of(break_characters, search_start + 1);
 		if (pos == std::string::npos)
-			return text_lines[line].size();
+			return text.size();
 		return pos;
 	}
 
@@ -1054,7 +1052,7 @@ namespace clan
 	{
 		if (search_start == 0)
 			return 0;
-		size_t pos = text_lines[line].find_last_of(break_characters, search_start - 1);
+		size_t pos = document.line(line).find_last_of(break_characters, search_start - 1);
 		if (pos == std::string::npos)
 			return 0;
 		return pos;
@@ -1062,20 +1060,28 @@ namespace clan
 
 	Vec2i TextViewImpl::get_character_index(const Pointf &pos)
 	{
-		return Vec2i();
-		/*
-		if (last_measured_rects.empty())
+		if (line_height <= 0.0f)
 			return Vec2i();
 
-		for (unsigned int cnt = 0; cnt < last_measured_rects.size(); cnt++)
+		int last_line = document.line_count() - 1;
+		int line_index = std::max(std::min((int)std::floor((pos.y + scroll_pos.y) / line_height), last_line), 0);
+
+		auto it = measured_lines.find(line_index);
+		if (it == measured_lines.end())
+			return Vec2i(0, line_index);
+
+		// Pick the character boundary closest to the pointer
+		const TextViewLine &line = it->second;
+		float x = pos.x + scroll_pos.x;
+		UTF8_Reader utf8_reader(line.text.data(), line.text.length());
+		while (!utf8_reader.is_end())
 		{
-			if ((last_measured_rects[cnt].left <= pos.x) && (last_measured_rects[cnt].right > pos.x))
-				return cnt + 1;
+			int char_start = utf8_reader.get_position();
+			utf8_reader.next();
+			if (x < (line.advance(char_start) + line.advance(utf8_reader.get_position())) * 0.5f)
+				return Vec2i(char_start, line_index);
 		}
-		if (last_measured_rects[0].left >= pos.x)
-			return 0;
-		return last_measured_rects.size();
-		*/
+		return Vec2i(line.text.size(), line_index);
 	}
 
 	const std::string TextViewImpl::break_characters = " ::;,.-";
@@ -0,0 +1,210 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "UI/precomp.h"
+#include "text_view_document.h"
+#include <algorithm>
+#include <cstring>
+
+namespace clan
+{
+	void TextViewDocument::set_text(const std::string &text)
+	{
+		original_text = text;
+		original_line_feeds.clear();
+		const char *data = original_text.data();
+		const char *end = data + original_text.size();
+		for (const char *pos = data; (pos = (const char *)memchr(pos, '\n', end - pos)) != nullptr; pos++)
+			original_line_feeds.push_back(pos - data);
+
+		added_text.clear();
+		added_line_feeds.clear();
+
+		pieces.clear();
+		if (!original_text.empty())
+			pieces.push_back(create_piece(false, 0, original_text.size()));
+		update_index(0);
+	}
+
+	std::string TextViewDocument::text() const
+	{
+		return text(0, total_length);
+	}
+
+	std::string TextViewDocument::text(size_t offset, size_t length) const
+	{
+		length = std::min(length, total_length - std::min(offset, total_length));
+
+		std::string result;
+		result.reserve(length);
+		for (size_t index = find_piece(offset); length > 0; index++)
+		{
+			const Piece &piece = pieces[index];
+			size_t skip = offset - piece_offsets[index];
+			size_t count = std::min(piece.length - skip, length);
+			result.append(buffer(piece), piece.start + skip, count);
+			offset += count;
+			length -= count;
+		}
+		return result;
+	}
+
+	size_t TextViewDocument::line_start(size_t line) const
+	{
+		if (line == 0)
+			return 0;
+
+		// Find the piece holding the line feed ending the previous line
+		size_t line_feed = line - 1;
+		size_t index = std::upper_bound(piece_lines.begin(), piece_lines.end(), line_feed) - piece_lines.begin() - 1;
+		const Piece &piece = pieces[index];
+		size_t pos = line_feeds(piece)[piece.first_line_feed + line_feed - piece_lines[index]];
+		return piece_offsets[index] + pos - piece.start + 1;
+	}
+
+	size_t TextViewDocument::line_length(size_t line) const
+	{
+		size_t end = line < total_line_feeds ? line_start(line + 1) - 1 : total_length;
+		return end - line_start(line);
+	}
+
+	std::string TextViewDocument::line(size_t line) const
+	{
+		size_t start = line_start(line);
+		size_t end = line < total_line_feeds ? line_start(line + 1) - 1 : total_length;
+		return text(start, end - start);
+	}
+
+	void TextViewDocument::insert(size_t offset, const std::string &text)
+	{
+		if (text.empty())
+			return;
+
+		size_t start = added_text.size();
+		added_text += text;
+		for (size_t pos = text.find('\n'); pos != std::string::npos; pos = text.find('\n', pos + 1))
+			added_line_feeds.push_back(start + pos);
+
+		size_t index = find_piece(offset);
+		if (index == pieces.size() || piece_offsets[index] == offset)
+		{
+			// Typing keeps appending to the piece ending at the cursor
+			if (index > 0 && pieces[index - 1].added && pieces[index - 1].start + pieces[index - 1].length == start)
+			{
+				Piece &piece = pieces[index - 1];
+				piece = create_piece(true, piece.start, piece.length + text.size());
+				update_index(index - 1);
+			}
+			else
+			{
+				pieces.insert(pieces.begin() + index, create_piece(true, start, text.size()));
+				update_index(index);
+			}
+		}
+		else
+		{
+			Piece piece = pieces[index];
+			size_t split = offset - piece_offsets[index];
+			Piece inserted[] =
+			{
+				create_piece(true, start, text.size()),
+				create_piece(piece.added, piece.start + split, piece.length - split)
+			};
+			pieces[index] = create_piece(piece.added, piece.start, split);
+			pieces.insert(pieces.begin() + index + 1, inserted, inserted + 2);
+			update_index(index);
+		}
+	}
+
+	void TextViewDocument::erase(size_t offset, size_t length)
+	{
+		if (offset >= total_length)
+			return;
+		length = std::min(length, total_length - offset);
+		if (length == 0)
+			return;
+
+		size_t first = find_piece(offset);
+		size_t last = find_piece(offset + length - 1);
+
+		std::vector<Piece> remaining;
+		const Piece &first_piece = pieces[first];
+		if (offset > piece_offsets[first])
+			remaining.push_back(create_piece(first_piece.added, first_piece.start, offset - piece_offsets[first]));
+
+		const Piece &last_piece = pieces[last];
+		size_t skip = offset + length - piece_offsets[last];
+		if (skip < last_piece.length)
+			remaining.push_back(create_piece(last_piece.added, last_piece.start + skip, last_piece.length - skip));
+
+		pieces.erase(pieces.begin() + first, pieces.begin() + last + 1);
+		pieces.insert(pieces.begin() + first, remaining.begin(), remaining.end());
+		update_index(first);
+	}
+
+	TextViewDocument::Piece TextViewDocument::create_piece(bool added, size_t start, size_t length) const
+	{
+		const std::vector<size_t> &feeds = added ? added_line_feeds : original_line_feeds;
+		auto first = std::lower_bound(feeds.begin(), feeds.end(), start);
+		auto last = std::lower_bound(first, feeds.end(), start + length);
+
+		Piece piece;
+		piece.added = added;
+		piece.start = start;
+		piece.length = length;
+		piece.first_line_feed = first - feeds.begin();
+		piece.line_feeds = last - first;
+		return piece;
+	}
+
+	size_t TextViewDocument::find_piece(size_t offset) const
+	{
+		if (offset >= total_length)
+			return pieces.size();
+		return std::upper_bound(piece_offsets.begin(), piece_offsets.end(), offset) - piece_offsets.begin() - 1;
+	}
+
+	void TextViewDocument::update_index(size_t index)
+	{
+		piece_offsets.resize(pieces.size());
+		piece_lines.resize(pieces.size());
+
+		size_t offset = index > 0 ? piece_offsets[index - 1] + pieces[index - 1].length : 0;
+		size_t lines = index > 0 ? piece_lines[index - 1] + pieces[index - 1].line_feeds : 0;
+		for (size_t i = index; i < pieces.size(); i++)
+		{
+			piece_offsets[i] = offset;
+			piece_lines[i] = lines;
+			offset += pieces[i].length;
+			lines += pieces[i].line_feeds;
+		}
+
+		total_length = offset;
+		total_line_feeds = lines;
+	}
+}
@@ -0,0 +1,113 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/Math/vec2.h"
+#include <string>
+#include <vector>
+
+namespace clan
+{
+	/// Piece table holding the text of a TextView
+	///
+	/// The text is never copied on edits. Pieces point into the text given to
+	/// set_text or into an append only buffer of inserted text. The position of
+	/// every line feed in both buffers is indexed, so a line is found with two
+	/// binary searches no matter how large the document is.
+	class TextViewDocument
+	{
+	public:
+		TextViewDocument() { }
+
+		/// Replaces the whole document
+		void set_text(const std::string &text);
+
+		/// Returns the whole document
+		std::string text() const;
+
+		/// Returns length bytes starting at offset
+		std::string text(size_t offset, size_t length) const;
+
+		/// Document length in bytes
+		size_t length() const { return total_length; }
+
+		/// Number of lines. An empty document has one line.
+		size_t line_count() const { return total_line_feeds + 1; }
+
+		/// Offset of the first byte of a line
+		size_t line_start(size_t line) const;
+
+		/// Length of a line in bytes, not including its line feed
+		size_t line_length(size_t line) const;
+
+		/// Returns the text of a line without its line feed
+		std::string line(size_t line) const;
+
+		/// Converts a position (byte in line, line) to a document offset
+		size_t offset(const Vec2i &pos) const { return line_start(pos.y) + pos.x; }
+
+		/// Inserts text at offset
+		void insert(size_t offset, const std::string &text);
+
+		/// Removes length bytes starting at offset
+		void erase(size_t offset, size_t length);
+
+	private:
+		struct Piece
+		{
+			bool added;
+			size_t start;
+			size_t length;
+			size_t first_line_feed; // Index into the line feeds of the buffer
+			size_t line_feeds;
+		};
+
+		Piece create_piece(bool added, size_t start, size_t length) const;
+		const std::string &buffer(const Piece &piece) const { return piece.added ? added_text : original_text; }
+		const std::vector<size_t> &line_feeds(const Piece &piece) const { return piece.added ? added_line_feeds : original_line_feeds; }
+
+		/// Returns the piece containing offset, or the number of pieces if offset is at the end of the document
+		size_t find_piece(size_t offset) const;
+
+		/// Recalculates the piece offsets after an edit at piece index
+		void update_index(size_t index);
+
+		std::string original_text;
+		std::string added_text;
+		std::vector<size_t> original_line_feeds;
+		std::vector<size_t> added_line_feeds;
+
+		std::vector<Piece> pieces;
+		std::vector<size_t> piece_offsets; // Document offset of each piece
+		std::vector<size_t> piece_lines; // Line feeds before each piece
+
+		size_t total_length = 0;
+		size_t total_line_feeds = 0;
+	};
+}
@@ -32,6 +32,9 @@
 #include "API/UI/Events/key_event.h"
 #include "API/Display/System/timer.h"
 #include "API/Display/Font/font.h"
+#include "text_view_document.h"
+#include <algorithm>
+#include <map>
 
 namespace clan
 {
@@ -80,6 +83,18 @@ namespace clan
 		Vec2i selection_tail;
 	};
 
+	/// Text and glyph positions of a line, measured when it was last rendered
+	class TextViewLine
+	{
+	public:
+		std::string text;
+
+		/// Horizontal position of each byte offset in text, followed by the end of the line
+		std::vector<float> advances;
+
+		float advance(int x) const { return advances[std::max(std::min(x, (int)advances.size() - 1), 0)]; }
+	};
+
 	class TextViewImpl
 	{
 	public:
@@ -120,7 +135,7 @@ namespace clan
 		Font font; // Do not use directly. Use get_font.
 
 		Size preferred_size = Size(20, 5);
-		std::vector<std::string> text_lines;
+		TextViewDocument document;
 		std::string placeholder;
 
 		Signal<void(KeyEvent &)> sig_before_edit_changed;
@@ -131,7 +146,7 @@ namespace clan
 		bool cursor_drawing_enabled_when_parent_focused = false;
 
 		TextViewSelection selection;
-		Vec2f cursor_pos;
+		Vec2i cursor_pos;
 
 		Vec2f scroll_pos;
 
@@ -156,13 +171,19 @@ namespace clan
 
 		static const std::string break_characters;
 
-		std::vector<Rectf> last_measured_rects;
+		/// Lines measured by the last render, by line index
+		std::map<size_t, TextViewLine> measured_lines;
+		float line_height = 0.0f;
+
+		TextViewLine &measure_line(Canvas &canvas, size_t line_index);
+
+		/// Drops the measurements of an edited line, and of all lines after it if lines were added or removed
+		void lines_changed(size_t line_index, bool lines_moved);
 
 		std::string get_all_selected_text() const;
 
-		std::string get_text_before_selection(size_t line_index) const;
-		std::string get_selected_text(size_t line_index) const;
-		std::string get_text_after_selection(size_t line_index) const;
+		/// Returns the selected byte range of a line
+		void get_selection_range(size_t line_index, int line_length, int &begin, int &end) const;
 
 		int find_next_break_character(int search_start, int line) const;
 		int find_previous_break_character(int search_start, int line) const;
@@ -30,10 +30,16 @@
 #include "API/UI/StandardViews/scroll_view.h"
 #include "API/UI/StandardViews/scrollbar_view.h"
 #include "API/UI/Events/pointer_event.h"
+#include "../View/view_impl.h"
 #include <algorithm>
 
 namespace clan
 {
+	namespace
+	{
+		const StylePropertyId prop_height("height");
+	}
+
 	class ScrollViewContentContainer : public View
 	{
 	public:
@@ -43,13 +49,15 @@ namespace clan
 			{
 				// To do: maybe we need a mode to specify if the X axis is locked or infinite
 				float width = geometry().content_width; //view->preferred_width(canvas);
-				float height = view->preferred_height(canvas, width);
+				// A fixed height is kept, as changes inside such a view don't ask the scroll view for a new layout
+				const StyleGetValue style_height = view->style_cascade().computed_value(prop_height);
+				float height = style_height.is_length() ? style_height.number() : view->preferred_height(canvas, width);
 				ViewGeometry geometry = ViewGeometry::from_content_box(style_cascade(), Rectf(0.0f, 0.0f, width, height));
 				geometry.content_x = 0.0f;
 				geometry.content_y = 0.0f;
 				view->set_geometry(geometry);
 
-				view->layout_children(canvas); // Maybe this should be handled in View?
+				ViewImpl::update_layout(view.get(), canvas);
 			}
 		}
 	};
@@ -65,6 +73,7 @@ namespace clan
 		ContentOverflow overflow_x = ContentOverflow::hidden;
 		ContentOverflow overflow_y = ContentOverflow::automatic;
 		Pointf content_offset;
+		Signal<void()> sig_content_offset_changed;
 	};
 
 	ScrollView::ScrollView() : impl(new ScrollViewImpl())
@@ -163,6 +172,24 @@ namespace clan
 		
 		impl->content_offset = offset;
 		impl->content->set_view_transform(Mat4f::translate(-offset.x, -offset.y, 0.0f));
+
+		if (impl->scroll_x->position() != offset.x)
+			impl->scroll_x->set_position(offset.x);
+		if (impl->scroll_y->position() != offset.y)
+			impl->scroll_y->set_position(offset.y);
+
+		impl->sig_content_offset_changed();
+	}
+
+	Sizef ScrollView::viewport_size() const
+	{
+		const ViewGeometry &geometry = impl->content_container->geometry();
+		return Sizef(geometry.content_width, geometry.content_height);
+	}
+
+	Signal<void()> &ScrollView::sig_content_offset_changed()
+	{
+		return impl->sig_content_offset_changed;
 	}
 	
 	void ScrollView::layout_children(Canvas &canvas)
@@ -216,9 +243,17 @@ namespace clan
 		
 		impl->content_container->set_geometry(ViewGeometry::from_margin_box(impl->content_container->style_cascade(), Rectf(0.0f, 0.0f, content_view_width, content_view_height)));
 
-		impl->scroll_x->layout_children(canvas);
-		impl->scroll_y->layout_children(canvas);
-		impl->content_container->layout_children(canvas);
+		// Content that shrank must not leave the view scrolled past its end
+		Pointf offset = impl->content_offset;
+		if (impl->overflow_x != ContentOverflow::hidden)
+			offset.x = clamp(offset.x, 0.0f, std::max(content_width - content_view_width, 0.0f));
+		if (impl->overflow_y != ContentOverflow::hidden)
+			offset.y = clamp(offset.y, 0.0f, std::max(content_height - content_view_height, 0.0f));
+		set_content_offset(offset);
+
+		ViewImpl::update_layout(impl->scroll_x.get(), canvas);
+		ViewImpl::update_layout(impl->scroll_y.get(), canvas);
+		ViewImpl::update_layout(impl->content_container.get(), canvas);
 	}
 	
 	float ScrollView::calculate_preferred_width(Canvas &canvas)
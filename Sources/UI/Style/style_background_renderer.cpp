@@ -42,6 +42,21 @@
 
 namespace clan
 {
+	namespace
+	{
+		const StylePropertyId prop_background_color("background-color");
+		const StylePropertyId prop_border_top_style("border-top-style");
+		const StylePropertyId prop_border_top_color("border-top-color");
+		const StylePropertyId prop_border_top_left_radius_x("border-top-left-radius-x");
+		const StylePropertyId prop_border_top_left_radius_y("border-top-left-radius-y");
+		const StylePropertyId prop_border_top_right_radius_x("border-top-right-radius-x");
+		const StylePropertyId prop_border_top_right_radius_y("border-top-right-radius-y");
+		const StylePropertyId prop_border_bottom_left_radius_x("border-bottom-left-radius-x");
+		const StylePropertyId prop_border_bottom_left_radius_y("border-bottom-left-radius-y");
+		const StylePropertyId prop_border_bottom_right_radius_x("border-bottom-right-radius-x");
+		const StylePropertyId prop_border_bottom_right_radius_y("border-bottom-right-radius-y");
+	}
+
 	StyleBackgroundRenderer::StyleBackgroundRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style) : canvas(canvas), geometry(geometry), style(style)
 	{
 	}
@@ -52,7 +67,7 @@ namespace clan
 
 		int num_layers = style.array_size("background-image");
 
-		StyleGetValue bg_color = style.computed_value("background-color");
+		StyleGetValue bg_color = style.computed_value(prop_background_color);
 		if (bg_color.is_color() && bg_color.color().a != 0.0f)
 		{
 			auto border_points = get_border_points();
@@ -301,10 +316,10 @@ namespace clan
 		if (!get_layer_clip(num_layers - 1).is_keyword("border-box"))
 			return;
 
-		StyleGetValue style_top = style.computed_value("border-top-style");
+		StyleGetValue style_top = style.computed_value(prop_border_top_style);
 		if (style_top.is_keyword("solid"))
 		{
-			Colorf color = style.computed_value("border-top-color").color();
+			Colorf color = style.computed_value(prop_border_top_color).color();
 			if (color.a > 0.0f)
 			{
 				auto border_points = get_border_points();
@@ -550,14 +565,14 @@ namespace clan
 
 	std::array<Pointf, 2 * 4> StyleBackgroundRenderer::get_border_points()
 	{
-		float top_left_x = get_horizontal_radius(style.computed_value("border-top-left-radius-x"));
-		float top_left_y = get_vertical_radius(style.computed_value("border-top-left-radius-y"));
-		float top_right_x = get_horizontal_radius(style.computed_value("border-top-right-radius-x"));
-		float top_right_y = get_vertical_radius(style.computed_value("border-top-right-radius-y"));
-		float bottom_left_x = get_horizontal_radius(style.computed_value("border-bottom-left-radius-x"));
-		float bottom_left_y = get_vertical_radius(style.computed_value("border-bottom-left-radius-y"));
-		float bottom_right_x = get_horizontal_radius(style.computed_value("border-bottom-right-radius-x"));
-		float bottom_right_y = get_vertical_radius(style.computed_value("border-bottom-right-radius-y"));
+		float top_left_x = get_horizontal_radius(style.computed_value(prop_border_top_left_radius_x));
+		float top_left_y = get_vertical_radius(style.computed_value(prop_border_top_left_radius_y));
+		float top_right_x = get_horizontal_radius(style.computed_value(prop_border_top_right_radius_x));
+		float top_right_y = get_vertical_radius(style.computed_value(prop_border_top_right_radius_y));
+		float bottom_left_x = get_horizontal_radius(style.computed_value(prop_border_bottom_left_radius_x));
+		float bottom_left_y = get_vertical_radius(style.computed_value(prop_border_bottom_left_radius_y));
+		float bottom_right_x = get_horizontal_radius(style.computed_value(prop_border_bottom_right_radius_x));
+		float bottom_right_y = get_vertical_radius(style.computed_value(prop_border_bottom_right_radius_y));
 
 		Rectf border_box = geometry.border_box();
 
@@ -746,6 +761,29 @@ namespace clan
 		return border_path;
 	}
 
+	Rectf StyleBackgroundRenderer::get_render_box()
+	{
+		Rectf box = geometry.border_box();
+
+		int num_shadows = style.array_size("box-shadow-style");
+		for (int index = 0; index < num_shadows; index++)
+		{
+			if (!style.computed_value("box-shadow-style[" + StringHelp::int_to_text(index) + "]").is_keyword("outset"))
+				continue;
+
+			float offset_x = style.computed_value("box-shadow-horizontal-offset[" + StringHelp::int_to_text(index) + "]").number();
+			float offset_y = style.computed_value("box-shadow-vertical-offset[" + StringHelp::int_to_text(index) + "]").number();
+			float blur_radius = style.computed_value("box-shadow-blur-radius[" + StringHelp::int_to_text(index) + "]").number();
+
+			Rectf shadow_box = geometry.border_box();
+			shadow_box.translate(offset_x, offset_y);
+			shadow_box.expand(blur_radius);
+			box.bounding_rect(shadow_box);
+		}
+
+		return box;
+	}
+
 	void StyleBackgroundRenderer::render_box_shadow()
 	{
 		int num_shadows = style.array_size("box-shadow-style");
@@ -783,14 +821,14 @@ namespace clan
 
 			float kappa = 0.552228474f;
 
-			float top_left_x = get_horizontal_radius(style.computed_value("border-top-left-radius-x"));
-			float top_left_y = get_vertical_radius(style.computed_value("border-top-left-radius-y"));
-			float top_right_x = get_horizontal_radius(style.computed_value("border-top-right-radius-x"));
-			float top_right_y = get_vertical_radius(style.computed_value("border-top-right-radius-y"));
-			float bottom_left_x = get_horizontal_radius(style.computed_value("border-bottom-left-radius-x"));
-			float bottom_left_y = get_vertical_radius(style.computed_value("border-bottom-left-radius-y"));
-			float bottom_right_x = get_horizontal_radius(style.computed_value("border-bottom-right-radius-x"));
-			float bottom_right_y = get_vertical_radius(style.computed_value("border-bottom-right-radius-y"));
+			float top_left_x = get_horizontal_radius(style.computed_value(prop_border_top_left_radius_x));
+			float top_left_y = get_vertical_radius(style.computed_value(prop_border_top_left_radius_y));
+			float top_right_x = get_horizontal_radius(style.computed_value(prop_border_top_right_radius_x));
+			float top_right_y = get_vertical_radius(style.computed_value(prop_border_top_right_radius_y));
+			float bottom_left_x = get_horizontal_radius(style.computed_value(prop_border_bottom_left_radius_x));
+			float bottom_left_y = get_vertical_radius(style.computed_value(prop_border_bottom_left_radius_y));
+			float bottom_right_x = get_horizontal_radius(style.computed_value(prop_border_bottom_right_radius_x));
+			float bottom_right_y = get_vertical_radius(style.computed_value(prop_border_bottom_right_radius_y));
 
 			if (shadow_blur_radius != 0.0f)
 			{
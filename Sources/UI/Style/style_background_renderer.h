@@ -52,6 +52,9 @@ namespace clan
 		void render_background();
 		void render_border();
 
+		/// Area drawn into by render_background and render_border, including outset box shadows
+		Rectf get_render_box();
+
 	private:
 		void render_box_shadow();
 		void render_background_image(const StyleGetValue &layer_image, int index);
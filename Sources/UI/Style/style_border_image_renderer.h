@@ -46,6 +46,9 @@ namespace clan
 		StyleBorderImageRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style);
 		void render();
 
+		/// Area drawn into by render, which outsets can extend beyond the border box
+		Rectf get_render_box() const;
+
 	private:
 		struct TileRepeatInfo
 		{
@@ -29,6 +29,7 @@
 #include "UI/precomp.h"
 #include "API/UI/Style/style.h"
 #include "API/UI/Style/style_cascade.h"
+#include "API/UI/Style/style_property_id.h"
 #include "API/UI/View/view_geometry.h"
 #include "API/UI/UIThread/ui_thread.h"
 #include "API/Display/Font/font.h"
@@ -37,14 +38,32 @@
 #include "style_background_renderer.h"
 #include "style_border_image_renderer.h"
 #include "style_impl.h"
+#include <algorithm>
 
 namespace clan
 {
+	namespace
+	{
+		const StylePropertyId prop_font_size("font-size");
+		const StylePropertyId prop_line_height("line-height");
+		const StylePropertyId prop_font_weight("font-weight");
+		const StylePropertyId prop_font_style("font-style");
+		const StylePropertyId prop_font_rendering("-clan-font-rendering");
+		const StylePropertyId prop_font_family_name("font-family-names[0]");
+
+		unsigned int next_snapshot_generation = 0;
+	}
+
 	StyleGetValue StyleCascade::cascade_value(const char *property_name) const
+	{
+		return cascade_value(StylePropertyId(property_name));
+	}
+
+	StyleGetValue StyleCascade::cascade_value(const StylePropertyId &property) const
 	{
 		for (Style *style : cascade)
 		{
-			StyleGetValue value = style->declared_value(property_name);
+			StyleGetValue value = style->impl->declared_value(property.index());
 			if (!value.is_undefined())
 				return value;
 		}
@@ -53,15 +72,20 @@ namespace clan
 
 	StyleGetValue StyleCascade::specified_value(const char *property_name) const
 	{
-		StyleGetValue value = cascade_value(property_name);
-		bool inherit = (value.is_undefined() && StyleProperty::is_inherited(property_name)) || value.is_keyword("inherit");
+		return specified_value(StylePropertyId(property_name));
+	}
+
+	StyleGetValue StyleCascade::specified_value(const StylePropertyId &property) const
+	{
+		StyleGetValue value = cascade_value(property);
+		bool inherit = (value.is_undefined() && StyleProperty::is_inherited(property)) || value.is_keyword("inherit");
 		if (inherit && parent)
 		{
-			return parent->computed_value(property_name);
+			return parent->computed_value(property);
 		}
 		else if (value.is_undefined() || value.is_keyword("initial") || value.is_keyword("inherit"))
 		{
-			return StyleProperty::default_value(property_name);
+			return StyleProperty::default_value(property);
 		}
 		else
 		{
@@ -71,24 +95,134 @@ namespace clan
 
 	StyleGetValue StyleCascade::computed_value(const char *property_name) const
 	{
+		return computed_value(StylePropertyId(property_name));
+	}
+
+	StyleGetValue StyleCascade::computed_value(const StylePropertyId &property) const
+	{
+		update_snapshot();
+
+		size_t index = property.index();
+		if (index < snapshot_known.size() && snapshot_known[index])
+			return snapshot_values[index];
+
 		// To do: pass on to property compute functions
 
-		StyleGetValue specified = specified_value(property_name);
+		StyleGetValue computed;
+		StyleGetValue specified = specified_value(property);
 		switch (specified.type())
 		{
 		case StyleValueType::length:
-			return compute_length(specified);
+			// Relative font sizes are relative to the parent font size, as resolving them here would need this very value
+			if (property == prop_font_size && (specified.dimension() == StyleDimension::em || specified.dimension() == StyleDimension::ex))
+				computed = parent ? parent->compute_length(specified) : StyleProperty::default_value(property);
+			else
+				computed = compute_length(specified);
+			break;
 		case StyleValueType::angle:
-			return compute_angle(specified);
+			computed = compute_angle(specified);
+			break;
 		case StyleValueType::time:
-			return compute_time(specified);
+			computed = compute_time(specified);
+			break;
 		case StyleValueType::frequency:
-			return compute_frequency(specified);
+			computed = compute_frequency(specified);
+			break;
 		case StyleValueType::resolution:
-			return compute_resolution(specified);
+			computed = compute_resolution(specified);
+			break;
 		default:
-			return specified;
+			computed = specified;
+			break;
+		}
+
+		// Computing the value may have added other properties to the snapshot
+		if (index >= snapshot_known.size())
+		{
+			snapshot_values.resize(index + 1);
+			snapshot_known.resize(index + 1);
 		}
+		snapshot_values[index] = computed;
+		snapshot_known[index] = true;
+		return computed;
+	}
+
+	void StyleCascade::invalidate()
+	{
+		StyleImpl::change_counter++;
+		snapshot_generation = 0;
+	}
+
+	unsigned int StyleCascade::generation() const
+	{
+		update_snapshot();
+		return snapshot_generation;
+	}
+
+	unsigned int StyleCascade::layout_generation() const
+	{
+		update_snapshot();
+		return snapshot_layout_generation;
+	}
+
+	bool StyleCascade::affects_layout(const Style *style)
+	{
+		for (const auto &it : style->impl->prop_type)
+		{
+			if (!StylePropertyTable::info(it.first).paint_only)
+				return true;
+		}
+		return false;
+	}
+
+	void StyleCascade::update_snapshot() const
+	{
+		if (snapshot_checked == StyleImpl::change_counter && snapshot_generation != 0)
+			return;
+
+		bool changed = snapshot_generation == 0 || snapshot_styles.size() != cascade.size() || snapshot_parent != parent;
+		for (size_t i = 0; !changed && i < cascade.size(); i++)
+			changed = snapshot_styles[i].first != cascade[i] || snapshot_styles[i].second != cascade[i]->impl->version;
+
+		if (parent)
+		{
+			parent->update_snapshot();
+			changed = changed || snapshot_parent_generation != parent->snapshot_generation;
+		}
+
+		if (changed)
+		{
+			// Styles entering or leaving the cascade only affect layout if they declare layout properties
+			bool layout_changed = snapshot_layout_generation == 0 || snapshot_parent != parent || snapshot_parent_layout_generation != (parent ? parent->snapshot_layout_generation : 0);
+			for (size_t i = 0; !layout_changed && i < snapshot_styles.size(); i++)
+			{
+				if (snapshot_layout_styles[i] && std::find_if(cascade.begin(), cascade.end(), [&](Style *style) { return style == snapshot_styles[i].first && style->impl->version == snapshot_styles[i].second; }) == cascade.end())
+					layout_changed = true;
+			}
+			for (size_t i = 0; !layout_changed && i < cascade.size(); i++)
+			{
+				if (affects_layout(cascade[i]) && std::find(snapshot_styles.begin(), snapshot_styles.end(), std::make_pair((const Style *)cascade[i], cascade[i]->impl->version)) == snapshot_styles.end())
+					layout_changed = true;
+			}
+
+			snapshot_values.clear();
+			snapshot_known.clear();
+			snapshot_styles.clear();
+			snapshot_layout_styles.clear();
+			for (Style *style : cascade)
+			{
+				snapshot_styles.push_back({ style, style->impl->version });
+				snapshot_layout_styles.push_back(affects_layout(style));
+			}
+			snapshot_parent = parent;
+			snapshot_parent_generation = parent ? parent->snapshot_generation : 0;
+			snapshot_parent_layout_generation = parent ? parent->snapshot_layout_generation : 0;
+			snapshot_generation = ++next_snapshot_generation;
+			if (layout_changed)
+				snapshot_layout_generation = ++next_snapshot_generation;
+		}
+
+		snapshot_checked = StyleImpl::change_counter;
 	}
 
 	StyleGetValue StyleCascade::compute_length(const StyleGetValue &length) const
@@ -109,9 +243,9 @@ namespace clan
 		case StyleDimension::pc:
 			return StyleGetValue::from_length(length.number() * (float)(12.0 * 96.0 / 72.0));
 		case StyleDimension::em:
-			return StyleGetValue::from_length(computed_value("font-size").number() * length.number());
+			return StyleGetValue::from_length(computed_value(prop_font_size).number() * length.number());
 		case StyleDimension::ex:
-			return StyleGetValue::from_length(computed_value("font-size").number() * length.number() * 0.5f);
+			return StyleGetValue::from_length(computed_value(prop_font_size).number() * length.number() * 0.5f);
 		}
 	}
 
@@ -184,15 +318,24 @@ namespace clan
 		image_renderer.render();
 	}
 
+	Rectf StyleCascade::render_box(Canvas &canvas, const ViewGeometry &geometry) const
+	{
+		StyleBackgroundRenderer renderer(canvas, geometry, *this);
+		StyleBorderImageRenderer image_renderer(canvas, geometry, *this);
+		Rectf box = renderer.get_render_box();
+		box.bounding_rect(image_renderer.get_render_box());
+		return box;
+	}
+
 	Font StyleCascade::font(Canvas &canvas) const
 	{
-		auto font_size = computed_value("font-size");
-		auto line_height = computed_value("line-height");
-		auto font_weight = computed_value("font-weight");
-		auto font_style = computed_value("font-style");
+		auto font_size = computed_value(prop_font_size);
+		auto line_height = computed_value(prop_line_height);
+		auto font_weight = computed_value(prop_font_weight);
+		auto font_style = computed_value(prop_font_style);
 		//auto font_variant = computed_value("font-variant"); // To do: needs FontDescription support
-		auto font_rendering = computed_value("-clan-font-rendering");
-		auto font_family_name = computed_value("font-family-names[0]");
+		auto font_rendering = computed_value(prop_font_rendering);
+		auto font_family_name = computed_value(prop_font_family_name);
 
 		FontDescription font_desc;
 		font_desc.set_height(font_size.number());
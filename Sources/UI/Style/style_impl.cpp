@@ -28,14 +28,77 @@
 
 #include "UI/precomp.h"
 #include "API/UI/Style/style.h"
+#include "API/UI/Style/style_property_id.h"
 #include "API/Core/Text/string_help.h"
 #include "style_impl.h"
 
 namespace clan
 {
+	unsigned int StyleImpl::change_counter = 0;
+
+	StylePropertyTable &StylePropertyTable::instance()
+	{
+		static StylePropertyTable table;
+		return table;
+	}
+
+	int StylePropertyTable::intern(const StyleString &name)
+	{
+		auto &table = instance();
+		auto it = table.indexes.find(name);
+		if (it != table.indexes.end())
+			return it->second;
+
+		int index = (int)table.properties.size();
+		table.properties.push_back(StylePropertyInfo());
+		table.properties.back().name = name;
+		table.properties.back().paint_only = is_paint_only(name);
+		table.indexes[name] = index;
+		return index;
+	}
+
+	bool StylePropertyTable::is_paint_only(const StyleString &name)
+	{
+		static const char *prefixes[] = { "background-", "border-image-", "box-shadow", "outline-", "text-decoration-" };
+		std::string text = name.c_str();
+		for (const char *prefix : prefixes)
+		{
+			if (text.compare(0, strlen(prefix), prefix) == 0)
+				return true;
+		}
+
+		const std::string color_suffix = "-color";
+		bool color = text == "color" || (text.size() > color_suffix.size() && text.compare(text.size() - color_suffix.size(), color_suffix.size(), color_suffix) == 0);
+		bool radius = text.compare(0, 7, "border-") == 0 && text.find("-radius-") != std::string::npos;
+		return color || radius;
+	}
+
+	int StylePropertyTable::find(const StyleString &name)
+	{
+		auto &table = instance();
+		auto it = table.indexes.find(name);
+		return it != table.indexes.end() ? it->second : -1;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	StylePropertyId::StylePropertyId(const char *name) : _index(StylePropertyTable::intern(name))
+	{
+	}
+
+	const char *StylePropertyId::name() const
+	{
+		return StylePropertyTable::info(_index).name.c_str();
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
 	void StyleImpl::set_value(const std::string &name, const StyleSetValue &value)
 	{
-		auto type_it = prop_type.find(name);
+		int index = StylePropertyTable::intern(name);
+		version = ++change_counter;
+
+		auto type_it = prop_type.find(index);
 		if (type_it != prop_type.end() && type_it->second != value.type)
 		{
 			switch (type_it->second)
@@ -46,28 +109,28 @@ namespace clan
 			case StyleValueType::keyword:
 			case StyleValueType::string:
 			case StyleValueType::url:
-				prop_text.erase(prop_text.find(name));
+				prop_text.erase(prop_text.find(index));
 				break;
 			case StyleValueType::length:
 			case StyleValueType::angle:
 			case StyleValueType::time:
 			case StyleValueType::frequency:
 			case StyleValueType::resolution:
-				prop_dimension.erase(prop_dimension.find(name));
-				prop_number.erase(prop_number.find(name));
+				prop_dimension.erase(prop_dimension.find(index));
+				prop_number.erase(prop_number.find(index));
 				break;
 			case StyleValueType::percentage:
 			case StyleValueType::number:
-				prop_number.erase(prop_number.find(name));
+				prop_number.erase(prop_number.find(index));
 				break;
 			case StyleValueType::color:
-				prop_color.erase(prop_color.find(name));
+				prop_color.erase(prop_color.find(index));
 				break;
 			}
 		}
 
 		if (value.type != StyleValueType::undefined)
-			prop_type[name] = value.type;
+			prop_type[index] = value.type;
 		else if (type_it != prop_type.end())
 			prop_type.erase(type_it);
 
@@ -79,22 +142,22 @@ namespace clan
 		case StyleValueType::keyword:
 		case StyleValueType::string:
 		case StyleValueType::url:
-			prop_text[name] = value.text;
+			prop_text[index] = value.text;
 			break;
 		case StyleValueType::length:
 		case StyleValueType::angle:
 		case StyleValueType::time:
 		case StyleValueType::frequency:
 		case StyleValueType::resolution:
-			prop_dimension[name] = value.dimension;
-			prop_number[name] = value.number;
+			prop_dimension[index] = value.dimension;
+			prop_number[index] = value.number;
 			break;
 		case StyleValueType::percentage:
 		case StyleValueType::number:
-			prop_number[name] = value.number;
+			prop_number[index] = value.number;
 			break;
 		case StyleValueType::color:
-			prop_color[name] = value.color;
+			prop_color[index] = value.color;
 			break;
 		}
 	}
@@ -110,9 +173,47 @@ namespace clan
 		while (true)
 		{
 			auto index_name = name + "[" + StringHelp::int_to_text((int)i) + "]";
-			if (prop_type.find(index_name) == prop_type.end())
+			int index = StylePropertyTable::find(index_name);
+			if (index == -1 || prop_type.find(index) == prop_type.end())
 				break;
 			set_value(index_name, StyleSetValue());
 		}
 	}
+
+	StyleGetValue StyleImpl::declared_value(int property_index) const
+	{
+		const auto it = prop_type.find(property_index);
+		if (it != prop_type.end())
+		{
+			switch (it->second)
+			{
+				default:
+				case StyleValueType::undefined:
+					return StyleGetValue();
+				case StyleValueType::keyword:
+					return StyleGetValue::from_keyword(prop_text.find(property_index)->second.c_str());
+				case StyleValueType::string:
+					return StyleGetValue::from_string(prop_text.find(property_index)->second.c_str());
+				case StyleValueType::url:
+					return StyleGetValue::from_url(prop_text.find(property_index)->second.c_str());
+				case StyleValueType::length:
+					return StyleGetValue::from_length(prop_number.find(property_index)->second, prop_dimension.find(property_index)->second);
+				case StyleValueType::angle:
+					return StyleGetValue::from_angle(prop_number.find(property_index)->second, prop_dimension.find(property_index)->second);
+				case StyleValueType::time:
+					return StyleGetValue::from_time(prop_number.find(property_index)->second, prop_dimension.find(property_index)->second);
+				case StyleValueType::frequency:
+					return StyleGetValue::from_frequency(prop_number.find(property_index)->second, prop_dimension.find(property_index)->second);
+				case StyleValueType::resolution:
+					return StyleGetValue::from_resolution(prop_number.find(property_index)->second, prop_dimension.find(property_index)->second);
+				case StyleValueType::percentage:
+					return StyleGetValue::from_percentage(prop_number.find(property_index)->second);
+				case StyleValueType::number:
+					return StyleGetValue::from_number(prop_number.find(property_index)->second);
+				case StyleValueType::color:
+					return StyleGetValue::from_color(prop_color.find(property_index)->second);
+			}
+		}
+		return StyleGetValue();
+	}
 }
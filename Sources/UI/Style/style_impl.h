@@ -32,6 +32,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <deque>
 
 namespace clan
 {
@@ -138,16 +139,58 @@ namespace clan
 		mutable std::size_t _hash = 0;
 	};
 
+	class StylePropertyInfo
+	{
+	public:
+		StyleString name;
+		StyleGetValue default_value;
+		bool inherited = false;
+
+		/// True if the property is only used when rendering, so changing it never changes the layout
+		bool paint_only = false;
+	};
+
+	/// Interned property names and their defaults, indexed by StylePropertyId
+	class StylePropertyTable
+	{
+	public:
+		/// Returns the index of a property name, adding it if it has not been seen before
+		static int intern(const StyleString &name);
+
+		/// Returns the index of a property name, or -1 if it has not been seen before
+		static int find(const StyleString &name);
+
+		static StylePropertyInfo &info(int index) { return instance().properties[index]; }
+
+	private:
+		static StylePropertyTable &instance();
+		static bool is_paint_only(const StyleString &name);
+
+		std::unordered_map<StyleString, int, StyleString::hash> indexes;
+		std::deque<StylePropertyInfo> properties;
+	};
+
 	class StyleImpl : public StylePropertySetter
 	{
 	public:
+		StyleImpl() : version(++change_counter) { }
+
 		void set_value(const std::string &name, const StyleSetValue &value) override;
 		void set_value_array(const std::string &name, const std::vector<StyleSetValue> &value_array) override;
 
-		std::unordered_map<StyleString, StyleValueType, StyleString::hash> prop_type;
-		std::unordered_map<StyleString, std::string, StyleString::hash> prop_text;
-		std::unordered_map<StyleString, float, StyleString::hash> prop_number;
-		std::unordered_map<StyleString, StyleDimension, StyleString::hash> prop_dimension;
-		std::unordered_map<StyleString, Colorf, StyleString::hash> prop_color;
+		StyleGetValue declared_value(int property_index) const;
+
+		/// Values by property index
+		std::unordered_map<int, StyleValueType> prop_type;
+		std::unordered_map<int, std::string> prop_text;
+		std::unordered_map<int, float> prop_number;
+		std::unordered_map<int, StyleDimension> prop_dimension;
+		std::unordered_map<int, Colorf> prop_color;
+
+		/// Value of change_counter when the properties last changed. Unique for each change of any style.
+		unsigned int version;
+
+		/// Increased whenever a style is changed or a style cascade is rebuilt
+		static unsigned int change_counter;
 	};
 }
@@ -29,6 +29,7 @@
 #include "UI/precomp.h"
 #include "API/UI/Style/style_property_parser.h"
 #include "API/UI/Style/style.h"
+#include "API/UI/Style/style_property_id.h"
 #include "API/UI/Style/style_token.h"
 #include "API/Core/Text/string_help.h"
 #include "style_impl.h"
@@ -37,12 +38,6 @@
 
 namespace clan
 {
-	std::unordered_map<StyleString, std::pair<StyleGetValue, bool>, StyleString::hash> &style_defaults()
-	{
-		static std::unordered_map<StyleString, std::pair<StyleGetValue, bool>, StyleString::hash> defaults;
-		return defaults;
-	}
-
 	std::unordered_map<StyleString, StylePropertyParser *, StyleString::hash> &style_parsers()
 	{
 		static std::unordered_map<StyleString, StylePropertyParser *, StyleString::hash> parsers;
@@ -53,7 +48,9 @@ namespace clan
 
 	StylePropertyDefault::StylePropertyDefault(const std::string &name, const StyleGetValue &value, bool inherit)
 	{
-		style_defaults()[name] = { value, inherit };
+		auto &info = StylePropertyTable::info(StylePropertyTable::intern(name));
+		info.default_value = value;
+		info.inherited = inherit;
 	}
 
 	/////////////////////////////////////////////////////////////////////////
@@ -1064,23 +1061,21 @@ namespace clan
 
 	bool StyleProperty::is_inherited(const char *name)
 	{
-		auto it = style_defaults().find(name);
-		if (it != style_defaults().end())
-		{
-			return it->second.second;
-		}
-		else
-		{
-			return false;
-		}
+		int index = StylePropertyTable::find(name);
+		return index != -1 && StylePropertyTable::info(index).inherited;
+	}
+
+	bool StyleProperty::is_inherited(const StylePropertyId &property)
+	{
+		return StylePropertyTable::info(property.index()).inherited;
 	}
 	
 	const StyleGetValue &StyleProperty::default_value(const char *name)
 	{
-		auto it = style_defaults().find(name);
-		if (it != style_defaults().end())
+		int index = StylePropertyTable::find(name);
+		if (index != -1)
 		{
-			return it->second.first;
+			return StylePropertyTable::info(index).default_value;
 		}
 		else
 		{
@@ -1089,6 +1084,11 @@ namespace clan
 		}
 	}
 
+	const StyleGetValue &StyleProperty::default_value(const StylePropertyId &property)
+	{
+		return StylePropertyTable::info(property.index()).default_value;
+	}
+
 	void StyleProperty::parse(StylePropertySetter *setter, const std::string &properties)
 	{
 		StyleTokenizer tokenizer(properties);
@@ -71,7 +71,7 @@ namespace clan
 
 	void TextureWindow_Impl::update()
 	{
-		if (needs_render || always_render)
+		if (always_render)
 		{
 			ClipRectState cliprect_state(&canvas);
 			canvas.set_cliprect(canvas_rect);
@@ -87,6 +87,27 @@ namespace clan
 			needs_render = false;
 			window_view->render(canvas, canvas_rect);
 		}
+		else if (needs_render)
+		{
+			ClipRectState cliprect_state(&canvas);
+			canvas.set_cliprect(canvas_rect);
+
+			// The texture keeps its contents, so only the areas that changed are cleared and drawn again
+			needs_render = false;
+			if (clear_background_enable)
+			{
+				window_view->render_damaged(canvas, canvas_rect, [&](const Rectf &box)
+				{
+					canvas.set_blend_state(opaque_blend);
+					canvas.fill_rect(box, background_color);
+					canvas.reset_blend_state();
+				});
+			}
+			else
+			{
+				window_view->render_damaged(canvas, canvas_rect);
+			}
+		}
 	}
 	
 	void TextureWindow_Impl::on_lost_focus()
@@ -30,9 +30,10 @@
 #include "API/UI/TopLevel/view_tree.h"
 #include "API/UI/Events/event.h"
 #include "API/UI/Events/focus_change_event.h"
+#include "API/Display/2D/canvas.h"
 #include "../View/view_impl.h"
-#include "../View/positioned_layout.h"
 #include <algorithm>
+#include <cmath>
 
 namespace clan
 {
@@ -51,6 +52,21 @@ namespace clan
 
 		View *focus_view = nullptr;
 		std::shared_ptr<View> root;
+
+		/// Canvas areas to draw again. Overlapping areas are merged.
+		std::vector<Rectf> damage;
+
+		/// True if the entire canvas must be drawn again
+		bool damage_all = true;
+
+		/// True if set_needs_render was called since the last render
+		bool render_requested = false;
+
+		/// Views gathered by the last render, kept to reuse the allocation
+		std::vector<ViewRenderItem> render_items;
+
+		/// Damage beyond this many areas is merged into their bounding box
+		static const size_t max_damage_rects = 16;
 	};
 
 	ViewTree::ViewTree() : impl(new ViewTreeImpl)
@@ -104,21 +120,105 @@ namespace clan
 	}
 
 	void ViewTree::render(Canvas &canvas, const Rectf &margin_box)
+	{
+		impl->damage_all = true;
+		render_damaged(canvas, margin_box);
+	}
+
+	void ViewTree::render_damaged(Canvas &canvas, const Rectf &margin_box, const std::function<void(const Rectf &)> &clear)
 	{
 		View *view = impl->root.get();
 
 		view->set_geometry(ViewGeometry::from_margin_box(view->style_cascade(), margin_box));
 
-		if (view->needs_layout())
+		ViewImpl::update_layout(view, canvas);
+
+		Rectf clip = canvas.get_cliprect();
+
+		auto &items = impl->render_items;
+		items.clear();
+		view->impl->gather_render_items(view, this, canvas, canvas.get_transform(), clip, items);
+
+		// Layout and gathering damage the areas of views that moved, which this render already covers
+		impl->render_requested = false;
+
+		std::vector<Rectf> damage;
+		if (impl->damage_all)
+		{
+			damage.push_back(clip);
+		}
+		else
+		{
+			for (Rectf box : impl->damage)
+			{
+				if (box.is_overlapped(clip))
+					damage.push_back(box.overlap(clip));
+			}
+		}
+		impl->damage.clear();
+		impl->damage_all = false;
+
+		for (const Rectf &box : damage)
+		{
+			ClipRectStack cliprect_stack(&canvas);
+			cliprect_stack.push_cliprect(box);
+
+			if (clear)
+				clear(box);
+
+			for (ViewRenderLayer layer : { ViewRenderLayer::background, ViewRenderLayer::border, ViewRenderLayer::content })
+			{
+				for (const ViewRenderItem &item : items)
+				{
+					if (item.box.is_overlapped(box))
+						ViewImpl::render(item, canvas, layer);
+				}
+			}
+		}
+	}
+
+	void ViewTree::add_damage(const Rectf &box)
+	{
+		if (impl->damage_all || box.get_width() <= 0.0f || box.get_height() <= 0.0f)
+			return;
+
+		// Round out to whole pixels and include antialiased edges
+		Rectf rect(std::floor(box.left) - 1.0f, std::floor(box.top) - 1.0f, std::ceil(box.right) + 1.0f, std::ceil(box.bottom) + 1.0f);
+
+		auto &damage = impl->damage;
+		size_t i = 0;
+		while (i < damage.size())
 		{
-			view->layout_children(canvas);
-			PositionedLayout::layout_children(canvas, view);
+			if (damage[i].is_overlapped(rect))
+			{
+				rect.bounding_rect(damage[i]);
+				damage.erase(damage.begin() + i);
+				i = 0;
+			}
+			else
+			{
+				i++;
+			}
+		}
+		damage.push_back(rect);
+
+		if (damage.size() > ViewTreeImpl::max_damage_rects)
+		{
+			for (const Rectf &r : damage)
+				rect.bounding_rect(r);
+			damage.clear();
+			damage.push_back(rect);
 		}
-		view->impl->needs_layout = false;
+	}
 
-		view->impl->render(view, canvas, ViewRenderLayer::background);
-		view->impl->render(view, canvas, ViewRenderLayer::border);
-		view->impl->render(view, canvas, ViewRenderLayer::content);
+	void ViewTree::request_render()
+	{
+		// Many views change during an animation frame, but the window only needs to hear about it once
+		if (!impl->render_requested)
+		{
+			impl->render_requested = true;
+			set_needs_render();
+		}
 	}
 
 	void ViewTree::dispatch_activation_change(ActivationChangeType type)
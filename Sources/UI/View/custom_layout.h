@@ -29,6 +29,7 @@
 #pragma once
 
 #include "view_layout.h"
+#include "view_impl.h"
 
 namespace clan
 {
@@ -39,6 +40,6 @@ namespace clan
 		float preferred_height(Canvas &canvas, View *view, float width) override { return 0.0f; }
 		float first_baseline_offset(Canvas &canvas, View *view, float width) override { return 0.0f; }
 		float last_baseline_offset(Canvas &canvas, View *view, float width) override { return 0.0f; }
-		void layout_children(Canvas &canvas, View *view) override { for (const auto &child : view->children()) child->layout_children(canvas); }
+		void layout_children(Canvas &canvas, View *view) override { for (const auto &child : view->children()) ViewImpl::update_layout(child.get(), canvas); }
 	};
 }
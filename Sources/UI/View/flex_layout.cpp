@@ -29,11 +29,44 @@
 #include "UI/precomp.h"
 #include "API/Display/2D/canvas.h"
 #include "flex_layout.h"
+#include "view_impl.h"
 #include <algorithm>
 #include <cmath>
 
 namespace clan
 {
+	namespace
+	{
+		const StylePropertyId prop_flex_direction("flex-direction");
+		const StylePropertyId prop_flex_wrap("flex-wrap");
+		const StylePropertyId prop_width("width");
+		const StylePropertyId prop_height("height");
+		const StylePropertyId prop_min_width("min-width");
+		const StylePropertyId prop_max_width("max-width");
+		const StylePropertyId prop_min_height("min-height");
+		const StylePropertyId prop_max_height("max-height");
+		const StylePropertyId prop_margin_left("margin-left");
+		const StylePropertyId prop_border_left_width("border-left-width");
+		const StylePropertyId prop_padding_left("padding-left");
+		const StylePropertyId prop_padding_right("padding-right");
+		const StylePropertyId prop_border_right_width("border-right-width");
+		const StylePropertyId prop_margin_right("margin-right");
+		const StylePropertyId prop_margin_top("margin-top");
+		const StylePropertyId prop_border_top_width("border-top-width");
+		const StylePropertyId prop_padding_top("padding-top");
+		const StylePropertyId prop_padding_bottom("padding-bottom");
+		const StylePropertyId prop_border_bottom_width("border-bottom-width");
+		const StylePropertyId prop_margin_bottom("margin-bottom");
+		const StylePropertyId prop_flex_basis("flex-basis");
+		const StylePropertyId prop_flex_grow("flex-grow");
+		const StylePropertyId prop_flex_shrink("flex-shrink");
+		const StylePropertyId prop_align_self("align-self");
+		const StylePropertyId prop_align_items("align-items");
+		const StylePropertyId prop_align_content("align-content");
+		const StylePropertyId prop_visibility("visibility");
+		const StylePropertyId prop_justify_content("justify-content");
+	}
+
 	float FlexLayout::preferred_width(Canvas &canvas, View *view)
 	{
 		calculate_layout(canvas, view, FlexLayoutMode::preferred_width);
@@ -68,37 +101,50 @@ namespace clan
 
 	void FlexLayout::layout_children(Canvas &canvas, View *view)
 	{
-		calculate_layout(canvas, view);
+		// The child boxes only change with the style and size of the container, or the style and preferred sizes of the children
+		std::vector<LayoutInput> inputs;
+		inputs.reserve(view->children().size());
+		for (const std::shared_ptr<View> &child : view->children())
+			inputs.push_back(LayoutInput(child.get(), child->hidden(), child->style_cascade().layout_generation(), ViewImpl::layout_generation(child.get())));
 
-		if (direction == FlexDirection::row)
+		unsigned int style_generation = view->style_cascade().layout_generation();
+		Sizef container_size(view->geometry().content_width, view->geometry().content_height);
+
+		if (!cached_boxes_valid || cached_style_generation != style_generation || cached_container_size != container_size || cached_inputs != inputs)
 		{
+			calculate_layout(canvas, view);
+
+			cached_boxes.clear();
 			for (auto &line : lines)
 			{
 				for (auto &item : line)
 				{
-					auto tl = canvas.grid_fit(Pointf(item.used_main_pos, item.used_cross_pos));
-					auto br = canvas.grid_fit(Pointf(item.used_main_pos + item.used_main_size, item.used_cross_pos + item.used_cross_size));
-					Rectf box = Rectf(tl.x, tl.y, br.x, br.y);
-
-					item.view->set_geometry(ViewGeometry::from_content_box(item.view->style_cascade(), box));
-					item.view->layout_children(canvas);
+					Pointf tl, br;
+					if (direction == FlexDirection::row)
+					{
+						tl = canvas.grid_fit(Pointf(item.used_main_pos, item.used_cross_pos));
+						br = canvas.grid_fit(Pointf(item.used_main_pos + item.used_main_size, item.used_cross_pos + item.used_cross_size));
+					}
+					else
+					{
+						tl = canvas.grid_fit(Pointf(item.used_cross_pos, item.used_main_pos));
+						br = canvas.grid_fit(Pointf(item.used_cross_pos + item.used_cross_size, item.used_main_pos + item.used_main_size));
+					}
+					cached_boxes.push_back({ item.view, Rectf(tl.x, tl.y, br.x, br.y) });
 				}
 			}
+
+			cached_boxes_valid = true;
+			cached_style_generation = style_generation;
+			cached_container_size = container_size;
+			cached_inputs.swap(inputs);
 		}
-		else
-		{
-			for (auto &line : lines)
-			{
-				for (auto &item : line)
-				{
-					auto tl = canvas.grid_fit(Pointf(item.used_cross_pos, item.used_main_pos));
-					auto br = canvas.grid_fit(Pointf(item.used_cross_pos + item.used_cross_size, item.used_main_pos + item.used_main_size));
-					Rectf box = Rectf(tl.x, tl.y, br.x, br.y);
 
-					item.view->set_geometry(ViewGeometry::from_content_box(item.view->style_cascade(), box));
-					item.view->layout_children(canvas);
-				}
-			}
+		for (const auto &child_box : cached_boxes)
+		{
+			View *child = child_box.first;
+			child->set_geometry(ViewGeometry::from_content_box(child->style_cascade(), child_box.second));
+			ViewImpl::update_layout(child, canvas);
 		}
 	}
 
@@ -120,8 +166,8 @@ namespace clan
 	{
 		const auto &container_style = view->style_cascade();
 
-		auto computed_direction = container_style.computed_value("flex-direction");
-		auto computed_wrap = container_style.computed_value("flex-wrap");
+		auto computed_direction = container_style.computed_value(prop_flex_direction);
+		auto computed_wrap = container_style.computed_value(prop_flex_wrap);
 
 		direction = computed_direction.is_keyword("row") ? FlexDirection::row : FlexDirection::column;
 
@@ -172,94 +218,105 @@ namespace clan
 			if (!child->is_static_position_and_visible())
 				continue;
 
-			const auto &item_style = child->style_cascade();
-
 			FlexLayoutItem item;
-			item.view = child.get();
-
-			// Definite sizes:
+			if (!find_cached_item(child.get(), items.size(), item))
+			{
+				const auto &item_style = child->style_cascade();
 
-			item.definite_main_size = item_style.computed_value("width").is_length();
-			item.definite_cross_size = item_style.computed_value("height").is_length();
-			item.definite_min_main_size = item_style.computed_value("min-width").is_length();
-			item.definite_max_main_size = item_style.computed_value("max-width").is_length();
-			item.definite_min_cross_size = item_style.computed_value("min-height").is_length();
-			item.definite_max_cross_size = item_style.computed_value("max-height").is_length();
+				item.view = child.get();
 
-			if (item.definite_main_size)
-				item.main_size = item_style.computed_value("width").number();
-			if (item.definite_cross_size)
-				item.cross_size = item_style.computed_value("height").number();
-			if (item.definite_min_main_size)
-				item.min_main_size = item_style.computed_value("min-width").number();
-			if (item.definite_max_main_size)
-				item.max_main_size = item_style.computed_value("max-width").number();
-			if (item.definite_min_cross_size)
-				item.min_cross_size = item_style.computed_value("min-height").number();
-			if (item.definite_max_cross_size)
-				item.max_cross_size = item_style.computed_value("max-height").number();
+				// Definite sizes:
 
-			// Main axis auto min:
+				item.definite_main_size = item_style.computed_value(prop_width).is_length();
+				item.definite_cross_size = item_style.computed_value(prop_height).is_length();
+				item.definite_min_main_size = item_style.computed_value(prop_min_width).is_length();
+				item.definite_max_main_size = item_style.computed_value(prop_max_width).is_length();
+				item.definite_min_cross_size = item_style.computed_value(prop_min_height).is_length();
+				item.definite_max_cross_size = item_style.computed_value(prop_max_height).is_length();
 
-			if (item_style.computed_value("min-width").is_keyword("auto"))
-			{
-				float min_content_size = 0.0f; // item.view->min_content_width(); // shrink-to-fit in CSS 2.1
 				if (item.definite_main_size)
+					item.main_size = item_style.computed_value(prop_width).number();
+				if (item.definite_cross_size)
+					item.cross_size = item_style.computed_value(prop_height).number();
+				if (item.definite_min_main_size)
+					item.min_main_size = item_style.computed_value(prop_min_width).number();
+				if (item.definite_max_main_size)
+					item.max_main_size = item_style.computed_value(prop_max_width).number();
+				if (item.definite_min_cross_size)
+					item.min_cross_size = item_style.computed_value(prop_min_height).number();
+				if (item.definite_max_cross_size)
+					item.max_cross_size = item_style.computed_value(prop_max_height).number();
+
+				// Main axis auto min:
+
+				if (item_style.computed_value(prop_min_width).is_keyword("auto"))
 				{
-					float specified_size = item.main_size;
-					if (item.definite_max_main_size)
-						specified_size = std::min(specified_size, item.max_main_size);
-					item.min_main_size = std::min(specified_size, min_content_size);
-				}
-				else if (item.definite_cross_size /*&& item.view->intrinsic_aspect_ratio() != 0.0f*/)
-				{
-					float clamped_cross_size = item.cross_size;
+					float min_content_size = 0.0f; // item.view->min_content_width(); // shrink-to-fit in CSS 2.1
+					if (item.definite_main_size)
+					{
+						float specified_size = item.main_size;
+						if (item.definite_max_main_size)
+							specified_size = std::min(specified_size, item.max_main_size);
+						item.min_main_size = std::min(specified_size, min_content_size);
+					}
+					else if (item.definite_cross_size /*&& item.view->intrinsic_aspect_ratio() != 0.0f*/)
+					{
+						float clamped_cross_size = item.cross_size;
 
-					if (item.definite_min_cross_size)
-						clamped_cross_size = std::max(clamped_cross_size, item.min_cross_size);
+						if (item.definite_min_cross_size)
+							clamped_cross_size = std::max(clamped_cross_size, item.min_cross_size);
 
-					if (item.definite_max_cross_size)
-						clamped_cross_size = std::min(clamped_cross_size, item.max_cross_size);
+						if (item.definite_max_cross_size)
+							clamped_cross_size = std::min(clamped_cross_size, item.max_cross_size);
 
-					float aspect = 1.0f; // item.view->intrinsic_aspect_ratio();
-					float transfered_size = clamped_cross_size / aspect;
-					item.min_main_size = std::min(transfered_size, min_content_size);
-				}
-				else
-				{
-					item.min_main_size = min_content_size;
+						float aspect = 1.0f; // item.view->intrinsic_aspect_ratio();
+						float transfered_size = clamped_cross_size / aspect;
+						item.min_main_size = std::min(transfered_size, min_content_size);
+					}
+					else
+					{
+						item.min_main_size = min_content_size;
+					}
 				}
-			}
 
-			// Non-content sizes:
+				// Non-content sizes:
 
-			item.main_noncontent_start += child->style_cascade().computed_value("margin-left").number();
-			item.main_noncontent_start += child->style_cascade().computed_value("border-left-width").number();
-			item.main_noncontent_start += child->style_cascade().computed_value("padding-left").number();
-			item.main_noncontent_end += child->style_cascade().computed_value("padding-right").number();
-			item.main_noncontent_end += child->style_cascade().computed_value("border-right-width").number();
-			item.main_noncontent_end += child->style_cascade().computed_value("margin-right").number();
+				item.main_noncontent_start += child->style_cascade().computed_value(prop_margin_left).number();
+				item.main_noncontent_start += child->style_cascade().computed_value(prop_border_left_width).number();
+				item.main_noncontent_start += child->style_cascade().computed_value(prop_padding_left).number();
+				item.main_noncontent_end += child->style_cascade().computed_value(prop_padding_right).number();
+				item.main_noncontent_end += child->style_cascade().computed_value(prop_border_right_width).number();
+				item.main_noncontent_end += child->style_cascade().computed_value(prop_margin_right).number();
 
-			item.main_auto_margin_start = item_style.computed_value("margin-left").is_keyword("auto");
-			item.main_auto_margin_end = item_style.computed_value("margin-right").is_keyword("auto");
+				item.main_auto_margin_start = item_style.computed_value(prop_margin_left).is_keyword("auto");
+				item.main_auto_margin_end = item_style.computed_value(prop_margin_right).is_keyword("auto");
 
-			item.cross_noncontent_start += child->style_cascade().computed_value("margin-top").number();
-			item.cross_noncontent_start += child->style_cascade().computed_value("border-top-width").number();
-			item.cross_noncontent_start += child->style_cascade().computed_value("padding-top").number();
-			item.cross_noncontent_end += child->style_cascade().computed_value("padding-bottom").number();
-			item.cross_noncontent_end += child->style_cascade().computed_value("border-bottom-width").number();
-			item.cross_noncontent_end += child->style_cascade().computed_value("margin-bottom").number();
+				item.cross_noncontent_start += child->style_cascade().computed_value(prop_margin_top).number();
+				item.cross_noncontent_start += child->style_cascade().computed_value(prop_border_top_width).number();
+				item.cross_noncontent_start += child->style_cascade().computed_value(prop_padding_top).number();
+				item.cross_noncontent_end += child->style_cascade().computed_value(prop_padding_bottom).number();
+				item.cross_noncontent_end += child->style_cascade().computed_value(prop_border_bottom_width).number();
+				item.cross_noncontent_end += child->style_cascade().computed_value(prop_margin_bottom).number();
 
-			item.cross_auto_margin_start = item_style.computed_value("margin-top").is_keyword("auto");
-			item.cross_auto_margin_end = item_style.computed_value("margin-bottom").is_keyword("auto");
+				item.cross_auto_margin_start = item_style.computed_value(prop_margin_top).is_keyword("auto");
+				item.cross_auto_margin_end = item_style.computed_value(prop_margin_bottom).is_keyword("auto");
 
-			// Flex base size and hypothetical (preferred) main size:
+				// Flex base size and hypothetical (preferred) main size:
 
-			if (item.view->style_cascade().computed_value("flex-basis").is_length())
-				item.flex_base_size = item.view->style_cascade().computed_value("flex-basis").number();
-			else if (item.definite_main_size && item.view->style_cascade().computed_value("flex-basis").is_keyword("auto"))
-				item.flex_base_size = item.main_size;
-			else
+				if (item.view->style_cascade().computed_value(prop_flex_basis).is_length())
+					item.flex_base_size = item.view->style_cascade().computed_value(prop_flex_basis).number();
+				else if (item.definite_main_size && item.view->style_cascade().computed_value(prop_flex_basis).is_keyword("auto"))
+					item.flex_base_size = item.main_size;
+				else
+					item.content_flex_base_size = true;
+
+				item.flex_grow = item.view->style_cascade().computed_value(prop_flex_grow).number();
+				item.flex_shrink = item.view->style_cascade().computed_value(prop_flex_shrink).number();
+
+				store_cached_item(items.size(), item);
+			}
+
+			if (item.content_flex_base_size)
 				item.flex_base_size = item.view->preferred_width(canvas);
 
 			item.flex_preferred_main_size = item.flex_base_size;
@@ -270,9 +327,6 @@ namespace clan
 			if (item.definite_max_main_size)
 				item.flex_preferred_main_size = std::min(item.flex_preferred_main_size, item.max_main_size);
 
-			item.flex_grow = item.view->style_cascade().computed_value("flex-grow").number();
-			item.flex_shrink = item.view->style_cascade().computed_value("flex-shrink").number();
-
 			items.push_back(item);
 		}
 	}
@@ -311,98 +365,105 @@ namespace clan
 			if (!child->is_static_position_and_visible())
 				continue;
 
-			const auto &item_style = child->style_cascade();
-
 			FlexLayoutItem item;
-			item.view = child.get();
-
-			// Definite sizes:
+			if (!find_cached_item(child.get(), items.size(), item))
+			{
+				const auto &item_style = child->style_cascade();
 
-			item.definite_main_size = item_style.computed_value("height").is_length();
-			item.definite_cross_size = item_style.computed_value("width").is_length();
-			item.definite_min_main_size = item_style.computed_value("min-height").is_length();
-			item.definite_max_main_size = item_style.computed_value("max-height").is_length();
-			item.definite_min_cross_size = item_style.computed_value("min-width").is_length();
-			item.definite_max_cross_size = item_style.computed_value("max-width").is_length();
+				item.view = child.get();
 
-			if (item.definite_main_size)
-				item.main_size = item_style.computed_value("height").number();
-			if (item.definite_cross_size)
-				item.cross_size = item_style.computed_value("width").number();
-			if (item.definite_min_main_size)
-				item.min_main_size = item_style.computed_value("min-height").number();
-			if (item.definite_max_main_size)
-				item.max_main_size = item_style.computed_value("max-height").number();
-			if (item.definite_min_cross_size)
-				item.min_cross_size = item_style.computed_value("min-width").number();
-			if (item.definite_max_cross_size)
-				item.max_cross_size = item_style.computed_value("max-width").number();
+				// Definite sizes:
 
-			// Main axis auto min:
+				item.definite_main_size = item_style.computed_value(prop_height).is_length();
+				item.definite_cross_size = item_style.computed_value(prop_width).is_length();
+				item.definite_min_main_size = item_style.computed_value(prop_min_height).is_length();
+				item.definite_max_main_size = item_style.computed_value(prop_max_height).is_length();
+				item.definite_min_cross_size = item_style.computed_value(prop_min_width).is_length();
+				item.definite_max_cross_size = item_style.computed_value(prop_max_width).is_length();
 
-			if (item_style.computed_value("min-height").is_keyword("auto"))
-			{
-				float min_content_size = 0.0f; // item.view->preferred_height(canvas, item.view->min_content_width()); // shrink-to-fit in CSS 2.1
 				if (item.definite_main_size)
+					item.main_size = item_style.computed_value(prop_height).number();
+				if (item.definite_cross_size)
+					item.cross_size = item_style.computed_value(prop_width).number();
+				if (item.definite_min_main_size)
+					item.min_main_size = item_style.computed_value(prop_min_height).number();
+				if (item.definite_max_main_size)
+					item.max_main_size = item_style.computed_value(prop_max_height).number();
+				if (item.definite_min_cross_size)
+					item.min_cross_size = item_style.computed_value(prop_min_width).number();
+				if (item.definite_max_cross_size)
+					item.max_cross_size = item_style.computed_value(prop_max_width).number();
+
+				// Main axis auto min:
+
+				if (item_style.computed_value(prop_min_height).is_keyword("auto"))
 				{
-					float specified_size = item.main_size;
-					if (item.definite_max_main_size)
-						specified_size = std::min(specified_size, item.max_main_size);
-					item.min_main_size = std::min(specified_size, min_content_size);
-				}
-				else if (item.definite_cross_size /*&& item.view->intrinsic_aspect_ratio() != 0.0f*/)
-				{
-					float clamped_cross_size = item.cross_size;
+					float min_content_size = 0.0f; // item.view->preferred_height(canvas, item.view->min_content_width()); // shrink-to-fit in CSS 2.1
+					if (item.definite_main_size)
+					{
+						float specified_size = item.main_size;
+						if (item.definite_max_main_size)
+							specified_size = std::min(specified_size, item.max_main_size);
+						item.min_main_size = std::min(specified_size, min_content_size);
+					}
+					else if (item.definite_cross_size /*&& item.view->intrinsic_aspect_ratio() != 0.0f*/)
+					{
+						float clamped_cross_size = item.cross_size;
 
-					if (item.definite_min_cross_size)
-						clamped_cross_size = std::max(clamped_cross_size, item.min_cross_size);
+						if (item.definite_min_cross_size)
+							clamped_cross_size = std::max(clamped_cross_size, item.min_cross_size);
 
-					if (item.definite_max_cross_size)
-						clamped_cross_size = std::min(clamped_cross_size, item.max_cross_size);
+						if (item.definite_max_cross_size)
+							clamped_cross_size = std::min(clamped_cross_size, item.max_cross_size);
 
-					float aspect = 1.0f; // item.view->intrinsic_aspect_ratio();
-					float transfered_size = clamped_cross_size * aspect;
-					item.min_main_size = std::min(transfered_size, min_content_size);
-				}
-				else
-				{
-					item.min_main_size = min_content_size;
+						float aspect = 1.0f; // item.view->intrinsic_aspect_ratio();
+						float transfered_size = clamped_cross_size * aspect;
+						item.min_main_size = std::min(transfered_size, min_content_size);
+					}
+					else
+					{
+						item.min_main_size = min_content_size;
+					}
 				}
-			}
 
-			// Non-content sizes:
+				// Non-content sizes:
 
-			item.main_noncontent_start += child->style_cascade().computed_value("margin-top").number();
-			item.main_noncontent_start += child->style_cascade().computed_value("border-top-width").number();
-			item.main_noncontent_start += child->style_cascade().computed_value("padding-top").number();
-			item.main_noncontent_end += child->style_cascade().computed_value("padding-bottom").number();
-			item.main_noncontent_end += child->style_cascade().computed_value("border-bottom-width").number();
-			item.main_noncontent_end += child->style_cascade().computed_value("margin-bottom").number();
+				item.main_noncontent_start += child->style_cascade().computed_value(prop_margin_top).number();
+				item.main_noncontent_start += child->style_cascade().computed_value(prop_border_top_width).number();
+				item.main_noncontent_start += child->style_cascade().computed_value(prop_padding_top).number();
+				item.main_noncontent_end += child->style_cascade().computed_value(prop_padding_bottom).number();
+				item.main_noncontent_end += child->style_cascade().computed_value(prop_border_bottom_width).number();
+				item.main_noncontent_end += child->style_cascade().computed_value(prop_margin_bottom).number();
 
-			item.main_auto_margin_start = item_style.computed_value("margin-top").is_keyword("auto");
-			item.main_auto_margin_end = item_style.computed_value("margin-bottom").is_keyword("auto");
+				item.main_auto_margin_start = item_style.computed_value(prop_margin_top).is_keyword("auto");
+				item.main_auto_margin_end = item_style.computed_value(prop_margin_bottom).is_keyword("auto");
 
-			item.cross_noncontent_start += child->style_cascade().computed_value("margin-left").number();
-			item.cross_noncontent_start += child->style_cascade().computed_value("border-left-width").number();
-			item.cross_noncontent_start += child->style_cascade().computed_value("padding-left").number();
-			item.cross_noncontent_end += child->style_cascade().computed_value("padding-right").number();
-			item.cross_noncontent_end += child->style_cascade().computed_value("border-right-width").number();
-			item.cross_noncontent_end += child->style_cascade().computed_value("margin-right").number();
+				item.cross_noncontent_start += child->style_cascade().computed_value(prop_margin_left).number();
+				item.cross_noncontent_start += child->style_cascade().computed_value(prop_border_left_width).number();
+				item.cross_noncontent_start += child->style_cascade().computed_value(prop_padding_left).number();
+				item.cross_noncontent_end += child->style_cascade().computed_value(prop_padding_right).number();
+				item.cross_noncontent_end += child->style_cascade().computed_value(prop_border_right_width).number();
+				item.cross_noncontent_end += child->style_cascade().computed_value(prop_margin_right).number();
 
-			item.cross_auto_margin_start = item_style.computed_value("margin-left").is_keyword("auto");
-			item.cross_auto_margin_end = item_style.computed_value("margin-right").is_keyword("auto");
+				item.cross_auto_margin_start = item_style.computed_value(prop_margin_left).is_keyword("auto");
+				item.cross_auto_margin_end = item_style.computed_value(prop_margin_right).is_keyword("auto");
 
-			// Flex base size and hypothetical (preferred) main size:
+				// Flex base size and hypothetical (preferred) main size:
 
-			if (item.view->style_cascade().computed_value("flex-basis").is_length())
-			{
-				item.flex_base_size = item.view->style_cascade().computed_value("flex-basis").number();
-			}
-			else if (item.definite_main_size)
-			{
-				item.flex_base_size = item.main_size;
+				if (item.view->style_cascade().computed_value(prop_flex_basis).is_length())
+					item.flex_base_size = item.view->style_cascade().computed_value(prop_flex_basis).number();
+				else if (item.definite_main_size)
+					item.flex_base_size = item.main_size;
+				else
+					item.content_flex_base_size = true;
+
+				item.flex_grow = item.view->style_cascade().computed_value(prop_flex_grow).number();
+				item.flex_shrink = item.view->style_cascade().computed_value(prop_flex_shrink).number();
+
+				store_cached_item(items.size(), item);
 			}
-			else
+
+			if (item.content_flex_base_size)
 			{
 				float cross_size = 0.0f;
 				if (item.definite_cross_size)
@@ -431,13 +492,35 @@ namespace clan
 			if (item.definite_max_main_size)
 				item.flex_preferred_main_size = std::min(item.flex_preferred_main_size, item.max_main_size);
 
-			item.flex_grow = item.view->style_cascade().computed_value("flex-grow").number();
-			item.flex_shrink = item.view->style_cascade().computed_value("flex-shrink").number();
-
 			items.push_back(item);
 		}
 	}
 
+	bool FlexLayout::find_cached_item(View *child, size_t index, FlexLayoutItem &item)
+	{
+		if (index < cached_items.size())
+		{
+			const CachedItem &cached = cached_items[index];
+			if (cached.item.view == child && cached.direction == direction && cached.style_generation == child->style_cascade().layout_generation())
+			{
+				item = cached.item;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void FlexLayout::store_cached_item(size_t index, const FlexLayoutItem &item)
+	{
+		if (index >= cached_items.size())
+			cached_items.resize(index + 1);
+
+		CachedItem &cached = cached_items[index];
+		cached.style_generation = item.view->style_cascade().layout_generation();
+		cached.direction = direction;
+		cached.item = item;
+	}
+
 	void FlexLayout::create_lines(Canvas &canvas, View *view)
 	{
 		lines.clear();
@@ -764,10 +847,10 @@ namespace clan
 				{
 					auto &item_style = item.view->style_cascade();
 
-					auto align_self = item_style.computed_value("align-self");
+					auto align_self = item_style.computed_value(prop_align_self);
 					if (align_self.is_keyword("auto")) // To do: computed_value should have done this for us
 					{
-						align_self = view->style_cascade().computed_value("align-items");
+						align_self = view->style_cascade().computed_value(prop_align_items);
 					}
 
 					if (restarted_layout && item.collapsed)
@@ -796,7 +879,7 @@ namespace clan
 			}
 		}
 
-		if (view->style_cascade().computed_value("align-content").is_keyword("stretch") && known_container_cross_size && lines.size() > 0)
+		if (view->style_cascade().computed_value(prop_align_content).is_keyword("stretch") && known_container_cross_size && lines.size() > 0)
 		{
 			float total_cross_size = 0.0f;
 			for (auto &line : lines)
@@ -817,7 +900,7 @@ namespace clan
 		{
 			for (auto &item : line)
 			{
-				if (item.view->style_cascade().computed_value("visibility").is_keyword("collapse"))
+				if (item.view->style_cascade().computed_value(prop_visibility).is_keyword("collapse"))
 				{
 					item.collapsed = true;
 					item.strut_size = line.cross_size;
@@ -841,10 +924,10 @@ namespace clan
 			{
 				auto &item_style = item.view->style_cascade();
 
-				auto align_self = item_style.computed_value("align-self");
+				auto align_self = item_style.computed_value(prop_align_self);
 				if (align_self.is_keyword("auto")) // To do: computed_value should have done this for us
 				{
-					align_self = view->style_cascade().computed_value("align-items");
+					align_self = view->style_cascade().computed_value(prop_align_items);
 				}
 
 				if (align_self.is_keyword("stretch") && !item.definite_cross_size && !item.cross_auto_margin_start && !item.cross_auto_margin_end)
@@ -913,7 +996,7 @@ namespace clan
 				space_available = 0.0f;
 			}
 
-			auto justify_content = view->style_cascade().computed_value("justify-content");
+			auto justify_content = view->style_cascade().computed_value(prop_justify_content);
 			if (justify_content.is_keyword("flex-start") || ((item_count < 2 || space_available < 0.0f) && justify_content.is_keyword("space-between")))
 			{
 				float pos = 0.0f;
@@ -1036,10 +1119,10 @@ namespace clan
 				}
 				else
 				{
-					auto align_self = item.view->style_cascade().computed_value("align-self");
+					auto align_self = item.view->style_cascade().computed_value(prop_align_self);
 					if (align_self.is_keyword("auto")) // To do: computed_value should have done this for us
 					{
-						align_self = view->style_cascade().computed_value("align-items");
+						align_self = view->style_cascade().computed_value(prop_align_items);
 					}
 
 					if (align_self.is_keyword("flex-start") || (direction == FlexDirection::column && align_self.is_keyword("baseline")) || align_self.is_keyword("stretch"))
@@ -1069,10 +1152,10 @@ namespace clan
 					if (item.collapsed || item.cross_auto_margin_start || item.cross_auto_margin_end)
 						continue;
 
-					auto align_self = item.view->style_cascade().computed_value("align-self");
+					auto align_self = item.view->style_cascade().computed_value(prop_align_self);
 					if (align_self.is_keyword("auto")) // To do: computed_value should have done this for us
 					{
-						align_self = view->style_cascade().computed_value("align-items");
+						align_self = view->style_cascade().computed_value(prop_align_items);
 					}
 
 					if (align_self.is_keyword("baseline"))
@@ -1095,7 +1178,7 @@ namespace clan
 			float line_pos = 0.0f;
 			float line_extra = 0.0f;
 
-			auto align_content = view->style_cascade().computed_value("align-content");
+			auto align_content = view->style_cascade().computed_value(prop_align_content);
 			if (align_content.is_keyword("flex-start") || align_content.is_keyword("stretch") || (free_space < 0.0f && align_content.is_keyword("space-between")))
 			{
 			}
@@ -73,6 +73,7 @@ namespace clan
 		float cross_noncontent_start = 0.0f;
 		float cross_noncontent_end = 0.0f;
 
+		bool content_flex_base_size = false;
 		float flex_base_size = 0.0f;
 		float flex_preferred_main_size = 0.0f;
 		float flex_grow = 0.0f;
@@ -175,5 +176,44 @@ namespace clan
 		std::vector<FlexLayoutLine> lines;
 		
 		bool restarted_layout = false;
+
+		/// Item values resolved from the style of a child, kept while its computed style is unchanged
+		class CachedItem
+		{
+		public:
+			unsigned int style_generation = 0;
+			FlexDirection direction = FlexDirection::row;
+			FlexLayoutItem item;
+		};
+
+		/// Child state a layout was calculated from
+		class LayoutInput
+		{
+		public:
+			LayoutInput(View *view, bool hidden, unsigned int style_generation, unsigned int layout_generation) : view(view), hidden(hidden), style_generation(style_generation), layout_generation(layout_generation) { }
+
+			bool operator==(const LayoutInput &other) const { return view == other.view && hidden == other.hidden && style_generation == other.style_generation && layout_generation == other.layout_generation; }
+			bool operator!=(const LayoutInput &other) const { return !(*this == other); }
+
+			View *view;
+			bool hidden;
+			unsigned int style_generation;
+			unsigned int layout_generation;
+		};
+
+		bool find_cached_item(View *child, size_t index, FlexLayoutItem &item);
+		void store_cached_item(size_t index, const FlexLayoutItem &item);
+
+		/// Style derived values of the items in the last layout, in item order
+		std::vector<CachedItem> cached_items;
+
+		/// Container style, content size and children the cached child boxes were calculated from
+		unsigned int cached_style_generation = 0;
+		Sizef cached_container_size;
+		std::vector<LayoutInput> cached_inputs;
+		bool cached_boxes_valid = false;
+
+		/// Content boxes of the items from the last layout_children
+		std::vector<std::pair<View *, Rectf>> cached_boxes;
 	};
 }
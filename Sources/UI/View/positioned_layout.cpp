@@ -29,10 +29,22 @@
 #include "UI/precomp.h"
 #include "API/Display/2D/canvas.h"
 #include "positioned_layout.h"
+#include "view_impl.h"
 #include <algorithm>
 
 namespace clan
 {
+	namespace
+	{
+		const StylePropertyId prop_position("position");
+		const StylePropertyId prop_left("left");
+		const StylePropertyId prop_right("right");
+		const StylePropertyId prop_width("width");
+		const StylePropertyId prop_top("top");
+		const StylePropertyId prop_bottom("bottom");
+		const StylePropertyId prop_height("height");
+	}
+
 	void PositionedLayout::layout_children(Canvas &canvas, View *view)
 	{
 		for (const std::shared_ptr<View> &child : view->children())
@@ -41,12 +53,12 @@ namespace clan
 			{
 				continue;
 			}
-			else if (child->style_cascade().computed_value("position").is_keyword("absolute"))
+			else if (child->style_cascade().computed_value(prop_position).is_keyword("absolute"))
 			{
 				// To do: decide how we determine the containing box used for absolute positioning. For now, use the parent padding box.
 				layout_from_containing_box(canvas, child.get(), view->geometry().padding_box().translate(-view->geometry().content_pos()));
 			}
-			else if (child->style_cascade().computed_value("position").is_keyword("fixed"))
+			else if (child->style_cascade().computed_value(prop_position).is_keyword("fixed"))
 			{
 				Rectf offset_initial_containing_box;
 				View *current = view->parent();
@@ -63,6 +75,7 @@ namespace clan
 							offset_initial_containing_box.set_top_left(offset_initial_containing_box.get_top_left() - offset);
 							break;
 						}
+						current = parent;
 					}
 				}
 				else
@@ -72,20 +85,18 @@ namespace clan
 
 				layout_from_containing_box(canvas, child.get(), offset_initial_containing_box);
 			}
-
-			layout_children(canvas, child.get());
 		}
 	}
 
 	ViewGeometry PositionedLayout::get_geometry(Canvas &canvas, View *view, const Rectf &containing_box)
 	{
-		bool definite_left = !view->style_cascade().computed_value("left").is_keyword("auto");
-		bool definite_right = !view->style_cascade().computed_value("right").is_keyword("auto");
-		bool definite_width = !view->style_cascade().computed_value("width").is_keyword("auto");
+		bool definite_left = !view->style_cascade().computed_value(prop_left).is_keyword("auto");
+		bool definite_right = !view->style_cascade().computed_value(prop_right).is_keyword("auto");
+		bool definite_width = !view->style_cascade().computed_value(prop_width).is_keyword("auto");
 
-		float computed_left = resolve_percentage(view->style_cascade().computed_value("left"), containing_box.get_width());
-		float computed_right = resolve_percentage(view->style_cascade().computed_value("right"), containing_box.get_width());
-		float computed_width = resolve_percentage(view->style_cascade().computed_value("width"), containing_box.get_width());
+		float computed_left = resolve_percentage(view->style_cascade().computed_value(prop_left), containing_box.get_width());
+		float computed_right = resolve_percentage(view->style_cascade().computed_value(prop_right), containing_box.get_width());
+		float computed_width = resolve_percentage(view->style_cascade().computed_value(prop_width), containing_box.get_width());
 
 		float x = 0.0f;
 		float width = 0.0f;
@@ -121,7 +132,7 @@ namespace clan
 		else if (definite_width)
 		{
 			x = 0.0f;
-			width = view->style_cascade().computed_value("width").number();
+			width = view->style_cascade().computed_value(prop_width).number();
 		}
 		else
 		{
@@ -129,13 +140,13 @@ namespace clan
 			width = view->preferred_width(canvas);
 		}
 
-		bool definite_top = !view->style_cascade().computed_value("top").is_keyword("auto");
-		bool definite_bottom = !view->style_cascade().computed_value("bottom").is_keyword("auto");
-		bool definite_height = !view->style_cascade().computed_value("height").is_keyword("auto");
+		bool definite_top = !view->style_cascade().computed_value(prop_top).is_keyword("auto");
+		bool definite_bottom = !view->style_cascade().computed_value(prop_bottom).is_keyword("auto");
+		bool definite_height = !view->style_cascade().computed_value(prop_height).is_keyword("auto");
 
-		float computed_top = resolve_percentage(view->style_cascade().computed_value("top"), containing_box.get_height());
-		float computed_bottom = resolve_percentage(view->style_cascade().computed_value("bottom"), containing_box.get_height());
-		float computed_height = resolve_percentage(view->style_cascade().computed_value("height"), containing_box.get_height());
+		float computed_top = resolve_percentage(view->style_cascade().computed_value(prop_top), containing_box.get_height());
+		float computed_bottom = resolve_percentage(view->style_cascade().computed_value(prop_bottom), containing_box.get_height());
+		float computed_height = resolve_percentage(view->style_cascade().computed_value(prop_height), containing_box.get_height());
 
 		float y = 0.0f;
 		float height = 0.0f;
@@ -186,7 +197,7 @@ namespace clan
 		return ViewGeometry::from_content_box(view->style_cascade(), box);
 	}
 
-	float PositionedLayout::resolve_percentage(StyleGetValue &computed_value, float size)
+	float PositionedLayout::resolve_percentage(const StyleGetValue &computed_value, float size)
 	{
 		if (computed_value.is_percentage())
 			return computed_value.number() * size / 100.0f;
@@ -197,6 +208,6 @@ namespace clan
 	void PositionedLayout::layout_from_containing_box(Canvas &canvas, View *view, const Rectf &containing_box)
 	{
 		view->set_geometry(get_geometry(canvas, view, containing_box));
-		view->layout_children(canvas);
+		ViewImpl::update_layout(view, canvas);
 	}
 }
@@ -35,11 +35,12 @@ namespace clan
 	class PositionedLayout
 	{
 	public:
+		/// Lays out the absolute and fixed positioned children of the view
 		static void layout_children(Canvas &canvas, View *view);
 		static ViewGeometry get_geometry(Canvas &canvas, View *view, const Rectf &containing_box);
 
 	private:
 		static void layout_from_containing_box(Canvas &canvas, View *view, const Rectf &containing_box);
-		static float resolve_percentage(StyleGetValue &computed_value, float size);
+		static float resolve_percentage(const StyleGetValue &computed_value, float size);
 	};
 }
@@ -47,10 +47,22 @@
 #include "view_action_impl.h"
 #include "flex_layout.h"
 #include "custom_layout.h"
+#include "positioned_layout.h"
 #include <algorithm>
 
 namespace clan
 {
+	namespace
+	{
+		const StylePropertyId prop_position("position");
+		const StylePropertyId prop_layout("layout");
+		const StylePropertyId prop_width("width");
+		const StylePropertyId prop_height("height");
+		const StylePropertyId prop_flex_basis("flex-basis");
+	}
+
+	unsigned int ViewLayoutCache::next_generation = 0;
+
 	View::View() : impl(new ViewImpl())
 	{
 		//box_style.set_style_changed(bind_member(this, &View::set_needs_layout));
@@ -83,6 +95,7 @@ namespace clan
 
 		auto &style = impl->styles[state];
 		style = std::make_shared<Style>();
+		impl->update_style_rules();
 		impl->update_style_cascade();
 		return style;
 	}
@@ -98,22 +111,13 @@ namespace clan
 	
 	void View::set_state(const std::string &name, bool value)
 	{
-		if (impl->states[name].enabled != value)
-		{
-			impl->states[name] = ViewImpl::StyleState(false, value);
-			impl->update_style_cascade();
-			set_needs_layout();
-		}
+		impl->set_state(this, name, false, value);
 	}
+
 	void View::set_state_cascade(const std::string &name, bool value)
 	{
-		if (impl->states[name].enabled != value)
-		{
-			impl->states[name] = ViewImpl::StyleState(false, value);
-			impl->update_style_cascade();
-			set_needs_layout();
+		if (impl->set_state(this, name, false, value))
 			impl->set_state_cascade_siblings(name, value);
-		}
 	}
 
 	void ViewImpl::set_state_cascade_siblings(const std::string &name, bool value)
@@ -123,14 +127,35 @@ namespace clan
 			ViewImpl *impl = view->impl.get();
 			if (impl->states[name].inherited)
 			{
-				impl->states[name] = ViewImpl::StyleState(true, value);
-				impl->update_style_cascade();
-				view->set_needs_layout();
+				impl->set_state(view.get(), name, true, value);
 				impl->set_state_cascade_siblings(name, value);
 			}
 		}
 	}
 
+	bool ViewImpl::set_state(View *self, const std::string &name, bool inherited, bool value)
+	{
+		StyleState &state = states[name];
+		if (state.enabled == value)
+			return false;
+
+		state.inherited = inherited;
+		state.enabled = value;
+
+		// Only a change of the matching styles can change the layout
+		if (state.styled && update_style_cascade() == StyleChange::layout)
+		{
+			self->set_needs_layout();
+			if (_parent)
+				_parent->impl->set_children_need_layout(_parent);
+		}
+		else
+		{
+			self->set_needs_render();
+		}
+		return true;
+	}
+
 	View *View::parent() const
 	{
 		return impl->_parent;
@@ -148,10 +173,11 @@ namespace clan
 			view->remove_from_parent();
 
 			impl->_children.push_back(view);
+			impl->hit_index.clear();
 			view->impl->_parent = this;
 			view->impl->update_style_cascade();
 			view->set_needs_layout();
-			set_needs_layout();
+			impl->set_children_need_layout(this);
 
 			child_added(view);
 		}
@@ -169,10 +195,12 @@ namespace clan
 			auto it = std::find_if(super->impl->_children.begin(), super->impl->_children.end(), [&](const std::shared_ptr<View> &view) { return view.get() == this; });
 			if (it != super->impl->_children.end())
 				super->impl->_children.erase(it);
+			super->impl->hit_index.clear();
+			impl->clear_render_box(this, super->view_tree());
 			impl->_parent = nullptr;
 			impl->update_style_cascade();
 
-			super->set_needs_layout();
+			super->impl->set_children_need_layout(super);
 
 			child_removed(view_ptr);
 		}
@@ -203,13 +231,19 @@ namespace clan
 		if (value != impl->hidden)
 		{
 			impl->hidden = value;
+			if (parent())
+				parent()->impl->hit_index.clear();
+
+			// The parent must lay out again, even when this view has a fixed size
 			set_needs_layout();
+			if (parent())
+				parent()->impl->set_children_need_layout(parent());
 		}
 	}
 
 	bool View::is_static_position_and_visible() const
 	{
-		return style_cascade().computed_value("position").is_keyword("static") && !hidden();
+		return style_cascade().computed_value(prop_position).is_keyword("static") && !hidden();
 	}
 
 	bool View::needs_layout() const
@@ -219,14 +253,12 @@ namespace clan
 
 	void View::set_needs_layout()
 	{
-		impl->needs_layout = true;
-		impl->layout_cache.clear();
+		// Only the view itself is damaged. Views moved by the new layout are damaged when they are gathered for rendering.
+		ViewTree *tree = view_tree();
+		if (tree && impl->rendered)
+			tree->add_damage(impl->own_render_box);
 
-		View *super = parent();
-		if (super)
-			super->set_needs_layout();
-		else
-			set_needs_render();
+		impl->set_children_need_layout(this);
 	}
 
 	Canvas View::canvas() const
@@ -242,7 +274,10 @@ namespace clan
 	{
 		ViewTree *tree = view_tree();
 		if (tree)
-			tree->set_needs_render();
+		{
+			impl->damage_render_box(this);
+			tree->request_render();
+		}
 	}
 
 	const ViewGeometry &View::geometry() const
@@ -254,8 +289,25 @@ namespace clan
 	{
 		if (impl->_geometry.content_box() != geometry.content_box())
 		{
+			// Children are placed relative to the content box, so they only need a new layout if its size changed
+			bool resized = impl->_geometry.content_width != geometry.content_width || impl->_geometry.content_height != geometry.content_height;
+			float old_x = impl->_geometry.content_x;
+			float old_y = impl->_geometry.content_y;
+
+			set_needs_render();
 			impl->_geometry = geometry;
-			set_needs_layout();
+			if (parent())
+				parent()->impl->hit_index.clear();
+
+			if (resized)
+			{
+				impl->needs_layout = true;
+				impl->set_child_needs_layout();
+			}
+
+			// Fixed positioned views are placed relative to the root, so they move along with every ancestor
+			if (impl->fixed_descendants && (resized || impl->_geometry.content_x != old_x || impl->_geometry.content_y != old_y))
+				impl->set_fixed_descendants_need_layout();
 		}
 	}
 
@@ -363,7 +415,7 @@ namespace clan
 
 	void View::layout_children(Canvas &canvas)
 	{
-		return impl->active_layout(this)->layout_children(canvas, this);
+		impl->active_layout(this)->layout_children(canvas, this);
 	}
 
 	ViewTree *View::view_tree()
@@ -395,21 +447,38 @@ namespace clan
 
 	std::shared_ptr<View> View::find_view_at(const Pointf &pos) const
 	{
-		for (unsigned int cnt = impl->_children.size(); cnt > 0; --cnt)	// Search the children in reverse order, as we want to search the view that was "last drawn" first
+		const std::shared_ptr<View> *found = nullptr;
+		if (impl->_children.size() >= ViewHitIndex::min_children)
 		{
-			const std::shared_ptr<View> &child = impl->_children[cnt-1];
-			if (child->geometry().border_box().contains(pos) && !child->hidden())
+			int index = impl->hit_index.find(impl->_children, pos);
+			if (index != -1)
+				found = &impl->_children[index];
+		}
+		else
+		{
+			for (unsigned int cnt = impl->_children.size(); cnt > 0; --cnt)	// Search the children in reverse order, as we want to search the view that was "last drawn" first
 			{
-				Pointf child_content_pos(pos.x - child->geometry().content_x, pos.y - child->geometry().content_y);
-				child_content_pos = Vec2f(Mat4f::inverse(child->view_transform()) * Vec4f(child_content_pos, 0.0f, 1.0f));
-				std::shared_ptr<View> view = child->find_view_at(child_content_pos);
-				if (view)
-					return view;
-				else
-					return child;
+				const std::shared_ptr<View> &child = impl->_children[cnt-1];
+				if (child->geometry().border_box().contains(pos) && !child->hidden())
+				{
+					found = &child;
+					break;
+				}
 			}
 		}
 
+		if (found)
+		{
+			const std::shared_ptr<View> &child = *found;
+			Pointf child_content_pos(pos.x - child->geometry().content_x, pos.y - child->geometry().content_y);
+			child_content_pos = Vec2f(Mat4f::inverse(child->view_transform()) * Vec4f(child_content_pos, 0.0f, 1.0f));
+			std::shared_ptr<View> view = child->find_view_at(child_content_pos);
+			if (view)
+				return view;
+			else
+				return child;
+		}
+
 		return std::shared_ptr<View>();
 	}
 
@@ -724,7 +793,7 @@ namespace clan
 
 	ViewLayout *ViewImpl::active_layout(View *self)
 	{
-		if (self->style_cascade().computed_value("layout").is_keyword("flex"))
+		if (self->style_cascade().computed_value(prop_layout).is_keyword("flex"))
 		{
 			return &flex;
 		}
@@ -735,32 +804,92 @@ namespace clan
 		}
 	}
 
-	void ViewImpl::render(View *self, Canvas &canvas, ViewRenderLayer layer)
+	namespace
 	{
-		if (layer == ViewRenderLayer::background)
-			style_cascade.render_background(canvas, _geometry);
-		else if (layer == ViewRenderLayer::border)
-			style_cascade.render_border(canvas, _geometry);
+		// Note: this isn't correct for rotated transforms (plus canvas cliprect can only clip AABB)
+		Rectf transform_box(const Mat4f &transform, const Rectf &box)
+		{
+			Vec4f tl_point = transform * Vec4f(box.left, box.top, 0.0f, 1.0f);
+			Vec4f br_point = transform * Vec4f(box.right, box.bottom, 0.0f, 1.0f);
+			return Rectf(std::min(tl_point.x, br_point.x), std::min(tl_point.y, br_point.y), std::max(tl_point.x, br_point.x), std::max(tl_point.y, br_point.y));
+		}
+	}
+
+	void ViewImpl::gather_render_items(View *self, ViewTree *tree, Canvas &canvas, const Mat4f &transform, const Rectf &clip, std::vector<ViewRenderItem> &items)
+	{
+		Rectf local_box = style_cascade.render_box(canvas, _geometry);
+		local_box.bounding_rect(_geometry.border_box());
+
+		Rectf box = transform_box(transform, local_box);
+		if (!box.is_overlapped(clip))
+		{
+			clear_render_box(self, tree);
+			return;
+		}
+		box.overlap(clip);
+
+		if (!rendered || box != own_render_box)
+		{
+			if (rendered)
+				tree->add_damage(own_render_box);
+			tree->add_damage(box);
+		}
+		own_render_box = box;
+		render_box = box;
+		rendered = true;
+
+		ViewRenderItem item;
+		item.view = self;
+		item.transform = transform;
+		item.clip = clip;
+		item.box = box;
 
 		Pointf translate = _geometry.content_pos();
+		item.content_transform = transform * Mat4f::translate(translate.x, translate.y, 0) * view_transform;
+		item.content_clip = clip;
+		if (content_clipped)
+			item.content_clip.overlap(transform_box(item.content_transform, Rectf(0.0f, 0.0f, _geometry.content_width, _geometry.content_height)));
+
+		items.push_back(item);
+
+		for (std::shared_ptr<View> &view : _children)
+		{
+			if (view->hidden())
+			{
+				view->impl->clear_render_box(view.get(), tree);
+			}
+			else
+			{
+				view->impl->gather_render_items(view.get(), tree, canvas, item.content_transform, item.content_clip, items);
+				if (view->impl->rendered)
+					render_box.bounding_rect(view->impl->render_box);
+			}
+		}
+	}
+
+	void ViewImpl::render(const ViewRenderItem &item, Canvas &canvas, ViewRenderLayer layer)
+	{
+		View *self = item.view;
+		ViewImpl *impl = self->impl.get();
 
 		TransformState transform_state(&canvas);
 		ClipRectStack cliprect_stack(&canvas);
 
-		canvas.set_transform(transform_state.matrix * Mat4f::translate(translate.x, translate.y, 0) * view_transform);
-
-		bool clipped = content_clipped;
-		if (clipped)
+		if (layer == ViewRenderLayer::background || layer == ViewRenderLayer::border)
 		{
-			// Seems canvas cliprects are always in absolute coordinates - should this be changed?
-			// Note: this code isn't correct for rotated transforms (plus canvas cliprect can only clip AABB)
-			Vec4f tl_point = canvas.get_transform() * Vec4f(0.0f, 0.0f, 0.0f, 1.0f);
-			Vec4f br_point = canvas.get_transform() * Vec4f(_geometry.content_width, _geometry.content_height, 0.0f, 1.0f);
-			cliprect_stack.push_cliprect(Rectf(std::min(tl_point.x, br_point.x), std::min(tl_point.y, br_point.y), std::max(tl_point.x, br_point.x), std::max(tl_point.y, br_point.y)));
-		}
+			canvas.set_transform(item.transform);
+			cliprect_stack.push_cliprect(item.clip);
 
-		if (layer == ViewRenderLayer::content)
+			if (layer == ViewRenderLayer::background)
+				impl->style_cascade.render_background(canvas, impl->_geometry);
+			else
+				impl->style_cascade.render_border(canvas, impl->_geometry);
+		}
+		else
 		{
+			canvas.set_transform(item.content_transform);
+			cliprect_stack.push_cliprect(item.content_clip);
+
 			if (!self->render_exception_encountered())
 			{
 				bool success = UIThread::try_catch([&]
@@ -770,70 +899,226 @@ namespace clan
 
 				if (!success)
 				{
-					exception_encountered = true;
+					impl->exception_encountered = true;
 				}
 			}
 
 			if (self->render_exception_encountered())
 			{
-				canvas.set_transform(transform_state.matrix * Mat4f::translate(translate.x, translate.y, 0));
-				canvas.fill_rect(0.0f, 0.0f, _geometry.content_width, _geometry.content_height, Colorf(1.0f, 0.2f, 0.2f, 0.5f));
-				canvas.draw_line(0.0f, 0.0f, _geometry.content_width, _geometry.content_height, Colorf::black);
-				canvas.draw_line(_geometry.content_width, 0.0f, 0.0f, _geometry.content_height, Colorf::black);
+				Pointf translate = impl->_geometry.content_pos();
+				canvas.set_transform(item.transform * Mat4f::translate(translate.x, translate.y, 0));
+				canvas.fill_rect(0.0f, 0.0f, impl->_geometry.content_width, impl->_geometry.content_height, Colorf(1.0f, 0.2f, 0.2f, 0.5f));
+				canvas.draw_line(0.0f, 0.0f, impl->_geometry.content_width, impl->_geometry.content_height, Colorf::black);
+				canvas.draw_line(impl->_geometry.content_width, 0.0f, 0.0f, impl->_geometry.content_height, Colorf::black);
 			}
 		}
+	}
+
+	void ViewImpl::damage_render_box(View *self)
+	{
+		ViewTree *tree = self->view_tree();
+		if (tree && rendered)
+			tree->add_damage(render_box);
+	}
+
+	void ViewImpl::clear_render_box(View *self, ViewTree *tree)
+	{
+		if (!rendered)
+			return;
+
+		if (tree)
+			tree->add_damage(render_box);
+
+		rendered = false;
+		render_box = Rectf();
+		own_render_box = Rectf();
 
-		Rectf clip_box = canvas.get_cliprect();
+		// Children are inside our render box, so they need no further damage
 		for (std::shared_ptr<View> &view : _children)
+			view->impl->clear_render_box(view.get(), nullptr);
+	}
+
+	void ViewImpl::update_layout(View *view, Canvas &canvas)
+	{
+		ViewImpl *impl = view->impl.get();
+		if (impl->needs_layout || impl->positioned_needs_layout)
 		{
-			if (!view->hidden())
+			if (impl->needs_layout)
+				view->layout_children(canvas);
+
+			// Absolute and fixed positioned children are placed here rather than in View::layout_children, so overrides that skip it still get them
+			PositionedLayout::layout_children(canvas, view);
+			impl->needs_layout = false;
+			impl->positioned_needs_layout = false;
+			impl->child_needs_layout = true;
+		}
+
+		if (impl->child_needs_layout)
+		{
+			impl->child_needs_layout = false;
+			impl->fixed_descendants = false;
+			for (const std::shared_ptr<View> &child : impl->_children)
 			{
-				// Note: this code isn't correct for rotated transforms (plus canvas cliprect can only clip AABB)
-				Rect border_box = view->geometry().border_box();
-				Vec4f tl_point = canvas.get_transform() * Vec4f(border_box.left, border_box.top, 0.0f, 1.0f);
-				Vec4f br_point = canvas.get_transform() * Vec4f(border_box.right, border_box.bottom, 0.0f, 1.0f);
-				Rectf transformed_border_box(std::min(tl_point.x, br_point.x), std::min(tl_point.y, br_point.y), std::max(tl_point.x, br_point.x), std::max(tl_point.y, br_point.y));
-				if (clip_box.is_overlapped(transformed_border_box))
-				{
-					view->impl->render(view.get(), canvas, layer);
-				}
+				if (child->hidden())
+					continue;
+
+				// Children laid out directly by a layout_children override still have their flags set
+				ViewImpl *child_impl = child->impl.get();
+				if (child_impl->needs_layout || child_impl->child_needs_layout)
+					update_layout(child.get(), canvas);
+
+				if (child_impl->fixed_descendants || child->style_cascade().computed_value(prop_position).is_keyword("fixed"))
+					impl->fixed_descendants = true;
 			}
 		}
 	}
 
-	void ViewImpl::update_style_cascade() const
+	bool ViewImpl::has_fixed_size() const
 	{
-		std::vector<std::pair<Style *, size_t>> matches;
+		if (hidden)
+			return true;
+
+		const StyleGetValue flex_basis = style_cascade.computed_value(prop_flex_basis);
+		return style_cascade.computed_value(prop_width).is_length() && style_cascade.computed_value(prop_height).is_length() && (flex_basis.is_length() || flex_basis.is_keyword("auto"));
+	}
+
+	void ViewImpl::set_child_needs_layout()
+	{
+		for (View *view = _parent; view; view = view->impl->_parent)
+			view->impl->child_needs_layout = true;
+	}
 
-		for (auto it : styles)
+	void ViewImpl::set_children_need_layout(View *self)
+	{
+		// Ancestors lay out again up to the first one with a fixed size. Above it they only visit the changed children.
+		View *view = self;
+		while (view)
 		{
-			auto &style_list = it.first;
-			auto &style = it.second;
+			view->impl->needs_layout = true;
+			view->impl->layout_cache.clear();
+			if (view->impl->has_fixed_size())
+				break;
+			view = view->parent();
+		}
+		if (view)
+			view->impl->set_child_needs_layout();
 
-			auto style_classes = StringHelp::split_text(style_list, " ");
+		ViewTree *tree = self->view_tree();
+		if (tree)
+			tree->request_render();
+	}
 
+	void ViewImpl::set_fixed_descendants_need_layout()
+	{
+		for (const std::shared_ptr<View> &child : _children)
+		{
+			if (child->hidden())
+				continue;
+
+			ViewImpl *child_impl = child->impl.get();
+			if (child->style_cascade().computed_value(prop_position).is_keyword("fixed"))
+			{
+				positioned_needs_layout = true;
+				child_needs_layout = true;
+				set_child_needs_layout();
+			}
+
+			if (child_impl->fixed_descendants)
+				child_impl->set_fixed_descendants_need_layout();
+		}
+	}
+
+	void ViewImpl::update_style_rules()
+	{
+		for (auto &state : states)
+			state.second.styled = false;
+
+		style_rules.clear();
+		for (const auto &it : styles)
+		{
+			StyleRule rule;
+			rule.style = it.second.get();
+			for (const auto &name : StringHelp::split_text(it.first, " "))
+			{
+				StyleState &state = states[name];
+				state.styled = true;
+				rule.states.push_back(&state);
+			}
+			style_rules.push_back(std::move(rule));
+		}
+
+		std::stable_sort(style_rules.begin(), style_rules.end(), [](const StyleRule &a, const StyleRule &b) { return a.states.size() != b.states.size() ? a.states.size() > b.states.size() : a.style > b.style; });
+	}
+
+	ViewImpl::StyleChange ViewImpl::update_style_cascade() const
+	{
+		// The rules are already in cascade order, so the matches are compared against the current cascade as they are found
+		auto &cascade = style_cascade.cascade;
+		std::vector<Style *> previous;
+		bool matches_changed = false;
+		size_t count = 0;
+		for (const StyleRule &rule : style_rules)
+		{
 			bool match = true;
-			for (const auto &state : style_classes)
+			for (const StyleState *state : rule.states)
 			{
-				auto search_it = states.find(state);
-				if (search_it == states.end() || !search_it->second.enabled)
+				if (!state->enabled)
+				{
 					match = false;
+					break;
+				}
+			}
+
+			if (!match)
+				continue;
+
+			if (!matches_changed && count < cascade.size() && cascade[count] == rule.style)
+			{
+				count++;
+				continue;
 			}
 
-			if (match)
-				matches.push_back({ style.get(), style_classes.size() });
+			if (!matches_changed)
+			{
+				previous = cascade;
+				cascade.resize(count);
+				matches_changed = true;
+			}
+			cascade.push_back(rule.style);
+			count++;
+		}
+		if (!matches_changed && count != cascade.size())
+		{
+			previous = cascade;
+			cascade.resize(count);
+			matches_changed = true;
 		}
 
-		std::stable_sort(matches.begin(), matches.end(), [](const std::pair<Style *, size_t> &a, const std::pair<Style *, size_t> &b) { return a.second != b.second ? a.second > b.second : a.first > b.first; });
+		const StyleCascade *parent = _parent ? &_parent->style_cascade() : nullptr;
+		bool parent_changed = parent != style_cascade.parent;
 
-		if (_parent)
-			style_cascade.parent = &_parent->style_cascade();
-		else
-			style_cascade.parent = nullptr;
+		// State changes often leave the matching styles the same. Keep the computed values then.
+		if (!matches_changed && !parent_changed)
+			return StyleChange::none;
+
+		style_cascade.parent = parent;
+		style_cascade.invalidate();
+
+		if (parent_changed)
+			return StyleChange::layout;
 
-		style_cascade.cascade.clear();
-		for (auto &match : matches)
-			style_cascade.cascade.push_back(match.first);
+		// Hover and pressed styles usually only change colors. The layout stays valid unless a style entering or leaving the cascade can change it.
+		for (Style *style : previous)
+		{
+			if (std::find(cascade.begin(), cascade.end(), style) == cascade.end() && StyleCascade::affects_layout(style))
+				return StyleChange::layout;
+		}
+		for (Style *style : cascade)
+		{
+			if (std::find(previous.begin(), previous.end(), style) == previous.end() && StyleCascade::affects_layout(style))
+				return StyleChange::layout;
+		}
+		return StyleChange::render;
 	}
 
 	void ViewImpl::process_action(ViewAction *action, EventUI *e)
@@ -33,22 +33,38 @@
 
 namespace clan
 {
+	namespace
+	{
+		const StylePropertyId prop_margin_left("margin-left");
+		const StylePropertyId prop_margin_top("margin-top");
+		const StylePropertyId prop_margin_right("margin-right");
+		const StylePropertyId prop_margin_bottom("margin-bottom");
+		const StylePropertyId prop_border_left_width("border-left-width");
+		const StylePropertyId prop_border_top_width("border-top-width");
+		const StylePropertyId prop_border_right_width("border-right-width");
+		const StylePropertyId prop_border_bottom_width("border-bottom-width");
+		const StylePropertyId prop_padding_left("padding-left");
+		const StylePropertyId prop_padding_top("padding-top");
+		const StylePropertyId prop_padding_right("padding-right");
+		const StylePropertyId prop_padding_bottom("padding-bottom");
+	}
+
 	ViewGeometry::ViewGeometry(const StyleCascade &style_cascade)
 	{
-		margin_left = style_cascade.computed_value("margin-left").number();
-		margin_top = style_cascade.computed_value("margin-top").number();
-		margin_right = style_cascade.computed_value("margin-right").number();
-		margin_bottom = style_cascade.computed_value("margin-bottom").number();
-
-		border_left = style_cascade.computed_value("border-left-width").number();
-		border_top = style_cascade.computed_value("border-top-width").number();
-		border_right = style_cascade.computed_value("border-right-width").number();
-		border_bottom = style_cascade.computed_value("border-bottom-width").number();
-
-		padding_left = style_cascade.computed_value("padding-left").number();
-		padding_top = style_cascade.computed_value("padding-top").number();
-		padding_right = style_cascade.computed_value("padding-right").number();
-		padding_bottom = style_cascade.computed_value("padding-bottom").number();
+		margin_left = style_cascade.computed_value(prop_margin_left).number();
+		margin_top = style_cascade.computed_value(prop_margin_top).number();
+		margin_right = style_cascade.computed_value(prop_margin_right).number();
+		margin_bottom = style_cascade.computed_value(prop_margin_bottom).number();
+
+		border_left = style_cascade.computed_value(prop_border_left_width).number();
+		border_top = style_cascade.computed_value(prop_border_top_width).number();
+		border_right = style_cascade.computed_value(prop_border_right_width).number();
+		border_bottom = style_cascade.computed_value(prop_border_bottom_width).number();
+
+		padding_left = style_cascade.computed_value(prop_padding_left).number();
+		padding_top = style_cascade.computed_value(prop_padding_top).number();
+		padding_right = style_cascade.computed_value(prop_padding_right).number();
+		padding_bottom = style_cascade.computed_value(prop_padding_bottom).number();
 	}
 
 	ViewGeometry ViewGeometry::from_margin_box(const StyleCascade &style, const Rectf &box)
@@ -0,0 +1,135 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "UI/precomp.h"
+#include "view_hit_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace clan
+{
+	int ViewHitIndex::find(const std::vector<std::shared_ptr<View>> &children, const Pointf &pos)
+	{
+		if (!valid)
+			build(children);
+
+		if (columns == 0 || !bounds.contains(pos))
+			return -1;
+
+		int x = std::min((int)((pos.x - bounds.left) / cell_width), columns - 1);
+		int y = std::min((int)((pos.y - bounds.top) / cell_height), rows - 1);
+		int cell = x + y * columns;
+
+		// Search the children in reverse order, as we want the view that was "last drawn"
+		for (unsigned int i = cell_start[cell + 1]; i > cell_start[cell]; i--)
+		{
+			unsigned int index = cell_children[i - 1];
+			if (children[index]->geometry().border_box().contains(pos))
+				return index;
+		}
+		return -1;
+	}
+
+	void ViewHitIndex::build(const std::vector<std::shared_ptr<View>> &children)
+	{
+		valid = true;
+		columns = 0;
+		rows = 0;
+		cell_start.clear();
+		cell_children.clear();
+
+		int visible_count = 0;
+		for (const auto &child : children)
+		{
+			if (child->hidden())
+				continue;
+
+			Rectf box = child->geometry().border_box();
+			if (visible_count == 0)
+				bounds = box;
+			else
+				bounds.bounding_rect(box);
+			visible_count++;
+		}
+
+		if (visible_count == 0 || bounds.get_width() <= 0.0f || bounds.get_height() <= 0.0f)
+			return;
+
+		// Aim for about one child per cell, with cells following the aspect ratio of the bounds
+		float aspect = bounds.get_width() / bounds.get_height();
+		columns = clamp((int)std::ceil(std::sqrt(visible_count * aspect)), 1, visible_count);
+		rows = clamp((visible_count + columns - 1) / columns, 1, visible_count);
+		cell_width = bounds.get_width() / columns;
+		cell_height = bounds.get_height() / rows;
+
+		// Count the children overlapping each cell, then place them in child order
+		std::vector<int> ranges;
+		ranges.reserve(visible_count * 4);
+		cell_start.assign(columns * rows + 1, 0);
+		for (const auto &child : children)
+		{
+			if (child->hidden())
+				continue;
+
+			Rectf box = child->geometry().border_box();
+			int x0 = clamp((int)((box.left - bounds.left) / cell_width), 0, columns - 1);
+			int y0 = clamp((int)((box.top - bounds.top) / cell_height), 0, rows - 1);
+			int x1 = clamp((int)std::ceil((box.right - bounds.left) / cell_width), x0 + 1, columns);
+			int y1 = clamp((int)std::ceil((box.bottom - bounds.top) / cell_height), y0 + 1, rows);
+			ranges.push_back(x0);
+			ranges.push_back(y0);
+			ranges.push_back(x1);
+			ranges.push_back(y1);
+
+			for (int y = y0; y < y1; y++)
+			{
+				for (int x = x0; x < x1; x++)
+					cell_start[x + y * columns + 1]++;
+			}
+		}
+
+		for (size_t i = 1; i < cell_start.size(); i++)
+			cell_start[i] += cell_start[i - 1];
+
+		cell_children.resize(cell_start.back());
+		std::vector<unsigned int> cell_pos(cell_start.begin(), cell_start.end() - 1);
+		const int *range = ranges.data();
+		for (unsigned int index = 0; index < children.size(); index++)
+		{
+			if (children[index]->hidden())
+				continue;
+
+			for (int y = range[1]; y < range[3]; y++)
+			{
+				for (int x = range[0]; x < range[2]; x++)
+					cell_children[cell_pos[x + y * columns]++] = index;
+			}
+			range += 4;
+		}
+	}
+}
@@ -0,0 +1,67 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/UI/View/view.h"
+#include <vector>
+
+namespace clan
+{
+	/// Uniform grid over the border boxes of the children of a view
+	///
+	/// Used by View::find_view_at to test only the children near the pointer.
+	/// The index is rebuilt on the first hit test after it has been cleared.
+	class ViewHitIndex
+	{
+	public:
+		/// Views with fewer children are searched linearly
+		static const size_t min_children = 32;
+
+		/// Marks the index for a rebuild before the next hit test
+		void clear() { valid = false; }
+
+		/// Returns the index of the topmost visible child with a border box containing pos, or -1 if there is none
+		int find(const std::vector<std::shared_ptr<View>> &children, const Pointf &pos);
+
+	private:
+		void build(const std::vector<std::shared_ptr<View>> &children);
+
+		bool valid = false;
+
+		Rectf bounds;
+		int columns = 0;
+		int rows = 0;
+		float cell_width = 0.0f;
+		float cell_height = 0.0f;
+
+		/// Child indices of cell i are at cell_children[cell_start[i]] to cell_children[cell_start[i + 1]], in drawing order
+		std::vector<unsigned int> cell_start;
+		std::vector<unsigned int> cell_children;
+	};
+}
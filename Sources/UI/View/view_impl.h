@@ -26,6 +26,8 @@
 **    Magnus Norddahl
 */
 
+#pragma once
+
 #include "API/UI/View/view.h"
 #include "API/UI/View/focus_policy.h"
 #include "API/UI/Style/style.h"
@@ -35,6 +37,7 @@
 #include "../Animation/animation_group.h"
 #include "view_layout.h"
 #include "flex_layout.h"
+#include "view_hit_index.h"
 #include <map>
 
 namespace clan
@@ -44,6 +47,9 @@ namespace clan
 	class ViewLayoutCache
 	{
 	public:
+		/// Number identifying the cached values. It changes every time the cache is cleared.
+		unsigned int generation = ++next_generation;
+
 		bool preferred_width_calculated = false;
 		float preferred_width = 0.0f;
 		std::map<float, float> preferred_height;
@@ -52,12 +58,16 @@ namespace clan
 
 		void clear()
 		{
+			generation = ++next_generation;
 			preferred_width_calculated = false;
 			preferred_width = 0.0f;
 			preferred_height.clear();
 			first_baseline_offset.clear();
 			last_baseline_offset.clear();
 		}
+
+	private:
+		static unsigned int next_generation;
 	};
 
 	enum class ViewRenderLayer
@@ -67,15 +77,75 @@ namespace clan
 		content
 	};
 
+	/// View gathered for rendering, with the canvas state it is rendered with
+	class ViewRenderItem
+	{
+	public:
+		View *view = nullptr;
+
+		/// Transform and cliprect for the background and border
+		Mat4f transform;
+		Rectf clip;
+
+		/// Transform and cliprect for the content
+		Mat4f content_transform;
+		Rectf content_clip;
+
+		/// Canvas area the view draws into
+		Rectf box;
+	};
+
 	class ViewImpl
 	{
 	public:
 		ViewLayout *active_layout(View *self);
 
-		void render(View *self, Canvas &canvas, ViewRenderLayer layer);
+		/// Lays out the view and its positioned children if it needs it, then the children below it that still need it
+		static void update_layout(View *view, Canvas &canvas);
+
+		/// Generation of the layout cache of a view, which changes whenever its preferred sizes may have changed
+		static unsigned int layout_generation(const View *view) { return view->impl->layout_cache.generation; }
+
+		/// True if the size of the view doesn't depend on its content, so its parent needs no new layout when the content changes
+		bool has_fixed_size() const;
+
+		/// Marks the ancestors as having children that need layout
+		void set_child_needs_layout();
+
+		/// Lays out the view again without damaging its area, for when only its children were added, removed or resized
+		///
+		/// Children that move, appear or disappear damage their own areas when the tree is rendered.
+		void set_children_need_layout(View *self);
+
+		/// Asks the parents of the fixed positioned views below this one to place them again
+		void set_fixed_descendants_need_layout();
+
+		/// Adds the view and its visible children to items and damages the areas that changed since the last render
+		void gather_render_items(View *self, ViewTree *tree, Canvas &canvas, const Mat4f &transform, const Rectf &clip, std::vector<ViewRenderItem> &items);
+
+		/// Renders one layer of a gathered view
+		static void render(const ViewRenderItem &item, Canvas &canvas, ViewRenderLayer layer);
+
+		/// Marks the area covered by the view and its children to be rendered again
+		void damage_render_box(View *self);
+
+		/// Forgets the render boxes of a view and its children that are no longer rendered, damaging their areas
+		void clear_render_box(View *self, ViewTree *tree);
+
 		void process_event(View *self, EventUI *e, bool use_capture);
 		void process_action(ViewAction *action, EventUI *e);
-		void update_style_cascade() const;
+		enum class StyleChange
+		{
+			none,
+			render, // Only properties used when rendering may have changed
+			layout
+		};
+
+		/// Matches the styles against the enabled states and tells what the new cascade may have changed
+		StyleChange update_style_cascade() const;
+
+		/// Compiles the state lists of the styles into rules in cascade order
+		void update_style_rules();
 
 		unsigned int find_next_tab_index(unsigned int tab_index) const;
 		unsigned int find_prev_tab_index(unsigned int tab_index) const;
@@ -105,9 +175,23 @@ namespace clan
 			StyleState(bool is_inherited, bool is_enabled) : inherited(is_inherited), enabled(is_enabled){}
 			bool inherited = true;	// Set to true by set_state_cascade(), else false
 			bool enabled = false;
+			bool styled = false;	// True if a style of the view depends on the state
 		};
 
 		std::map<std::string, StyleState> states;
+
+		/// A style and the states it requires
+		struct StyleRule
+		{
+			Style *style = nullptr;
+			std::vector<const StyleState *> states; // Points into the states map. Its nodes never move.
+		};
+
+		/// Rules of the styles, most specific first
+		std::vector<StyleRule> style_rules;
+
+		/// Sets a state and updates the cascade if a style depends on it. Returns true if the state changed.
+		bool set_state(View *self, const std::string &name, bool inherited, bool value);
 		
 		ViewGeometry _geometry;
 		bool hidden = false;
@@ -119,6 +203,24 @@ namespace clan
 
 		bool needs_layout = true;
 
+		/// True if a view below this one needs layout
+		bool child_needs_layout = false;
+
+		/// True if the absolute and fixed positioned children must be placed again, even when the view needs no layout
+		bool positioned_needs_layout = false;
+
+		/// True if a view below this one had fixed positioning at the last layout
+		bool fixed_descendants = false;
+
+		/// Canvas area covered by the view and its children at the last render
+		Rectf render_box;
+
+		/// Canvas area covered by the view itself at the last render
+		Rectf own_render_box;
+
+		/// True if the view was rendered the last time the tree was rendered
+		bool rendered = false;
+
 		Signal<void(ActivationChangeEvent &)> _sig_activated[2];
 		Signal<void(ActivationChangeEvent &)> _sig_deactivated[2];
 		Signal<void(CloseEvent &)> _sig_close[2];
@@ -147,6 +249,9 @@ namespace clan
 
 		ViewLayoutCache layout_cache;
 
+		/// Spatial index over the children for find_view_at
+		ViewHitIndex hit_index;
+
 		FlexLayout flex;
 
 	private:
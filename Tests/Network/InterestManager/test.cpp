@@ -0,0 +1,368 @@
+// Test for NetGameInterestManager.
+//
+// Checks which observers the grid picks for an event, how observers enter and leave the
+// view of an entity as they move, and how tick() spends the budget of each observer.
+// Most checks look at the queued event counts. The delivery and budget checks send the
+// events to real clients, one of them connected through a NetworkSimulator relay that is
+// slow enough for events to pile up in the send buffer of its server connection.
+
+#include "../NetGameLoad/network_simulator.h"
+#include <algorithm>
+#include <chrono>
+
+#ifndef WIN32
+#include <signal.h>
+#endif
+
+using namespace clan;
+
+struct TestClient
+{
+	NetGameClient client;
+	SlotContainer slots;
+	std::vector<std::string> received;
+	bool connected = false;
+};
+
+class InterestManagerTest
+{
+public:
+	void run();
+
+private:
+	void connect_clients();
+	void test_grid();
+	void test_enter_leave();
+	void test_entity_replace();
+	void test_delivery();
+	void test_budget();
+	void test_unsent_budget();
+
+	void process_events();
+	void wait_for_events(TestClient &client, size_t count);
+	static void check(bool condition, const std::string &message);
+
+	NetGameServer server;
+	SlotContainer server_slots;
+	std::unique_ptr<NetworkSimulator> simulator;
+
+	// The last client connects through the simulator
+	enum { client_count = 4, slow_client = client_count - 1 };
+	TestClient clients[client_count];
+	NetGameConnection *connections[client_count] = {};
+};
+
+int main(int, char**)
+{
+#ifndef WIN32
+	signal(SIGPIPE, SIG_IGN);
+#endif
+
+	try
+	{
+		InterestManagerTest test;
+		test.run();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void InterestManagerTest::run()
+{
+	server_slots.connect(server.sig_event_received(), [this](NetGameConnection *connection, const NetGameEvent &e)
+	{
+		if (e.get_name() == "hello")
+			connections[e.get_argument(0).get_integer()] = connection;
+	});
+	server.start("127.0.0.1", "5420");
+
+	// About 16 kilobytes per second, so a few megabytes of events keep the link busy for the rest of the test
+	NetworkSimulatorSettings settings;
+	settings.bandwidth = 16 * 1024;
+	simulator.reset(new NetworkSimulator(SocketName("127.0.0.1", "5421"), SocketName("127.0.0.1", "5420"), settings));
+
+	connect_clients();
+
+	test_grid();
+	test_enter_leave();
+	test_entity_replace();
+	test_delivery();
+	test_budget();
+	test_unsent_budget();
+
+	for (auto &c : clients)
+		c.client.disconnect();
+	simulator.reset();
+	server.stop();
+}
+
+void InterestManagerTest::connect_clients()
+{
+	for (int i = 0; i < client_count; i++)
+	{
+		TestClient *c = &clients[i];
+		c->slots.connect(c->client.sig_connected(), [c, i]()
+		{
+			c->connected = true;
+			c->client.send_event(NetGameEvent("hello", { i }));
+		});
+		c->slots.connect(c->client.sig_event_received(), [c](const NetGameEvent &e) { c->received.push_back(e.get_name()); });
+		c->client.connect("127.0.0.1", i == slow_client ? "5421" : "5420");
+	}
+
+	uint64_t start_time = System::get_time();
+	while (std::count(connections, connections + client_count, nullptr) != 0)
+	{
+		if (System::get_time() - start_time > 5000)
+			throw Exception("Clients did not connect");
+		process_events();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void InterestManagerTest::test_grid()
+{
+	Console::write_line("--- Grid ---");
+
+	NetGameInterestManager interest(64.0f);
+	interest.add_observer(connections[0], Pointf(0.0f, 0.0f), 50.0f);
+	interest.add_observer(connections[1], Pointf(200.0f, 0.0f), 50.0f);
+	interest.add_observer(connections[2], Pointf(1000.0f, 1000.0f), 200.0f);
+	check(interest.get_observer_count() == 3, "Wrong observer count");
+
+	interest.send_event(1, Pointf(10.0f, 0.0f), NetGameEvent("near 0"));
+	interest.send_event(2, Pointf(190.0f, 0.0f), NetGameEvent("near 1"));
+	interest.send_event(3, Pointf(1150.0f, 1100.0f), NetGameEvent("near 2"));
+	interest.send_event(4, Pointf(500.0f, 500.0f), NetGameEvent("near nobody"));
+	check(interest.get_queued_event_count(connections[0]) == 1, "Observer 0 should see one entity");
+	check(interest.get_queued_event_count(connections[1]) == 1, "Observer 1 should see one entity");
+	check(interest.get_queued_event_count(connections[2]) == 1, "Observer 2 should see one entity");
+
+	// In a cell covered by the view area, but outside the view radius
+	interest.send_event(5, Pointf(40.0f, 40.0f), NetGameEvent("corner"));
+	check(interest.get_queued_event_count(connections[0]) == 1, "Observer 0 should not see an entity outside its radius");
+
+	// Negative coordinates land in their own cells
+	interest.send_event(6, Pointf(-45.0f, 0.0f), NetGameEvent("left of 0"));
+	interest.send_event(7, Pointf(0.0f, -45.0f), NetGameEvent("above 0"));
+	check(interest.get_queued_event_count(connections[0]) == 3, "Observer 0 should see entities at negative coordinates");
+
+	// Overlapping view areas both get the event
+	interest.add_observer(connections[3], Pointf(60.0f, 0.0f), 50.0f);
+	interest.send_event(8, Pointf(30.0f, 0.0f), NetGameEvent("between 0 and 3"));
+	check(interest.get_queued_event_count(connections[0]) == 4, "Observer 0 should see the shared entity");
+	check(interest.get_queued_event_count(connections[3]) == 1, "Observer 3 should see the shared entity");
+
+	interest.subscribe(connections[1], 7);
+	interest.subscribe(connections[2], 7);
+	interest.send_channel_event(7, NetGameEvent("chat"));
+	check(interest.get_queued_event_count(connections[1]) == 2, "Observer 1 should receive the channel event");
+	check(interest.get_queued_event_count(connections[2]) == 2, "Observer 2 should receive the channel event");
+	check(interest.get_queued_event_count(connections[0]) == 4, "Observer 0 is not subscribed to the channel");
+
+	interest.unsubscribe(connections[1], 7);
+	interest.send_channel_event(7, NetGameEvent("chat"));
+	check(interest.get_queued_event_count(connections[1]) == 2, "Observer 1 should no longer receive channel events");
+	check(interest.get_queued_event_count(connections[2]) == 3, "Observer 2 should still receive channel events");
+}
+
+void InterestManagerTest::test_enter_leave()
+{
+	Console::write_line("--- Enter and leave ---");
+
+	NetGameInterestManager interest(64.0f);
+	interest.add_observer(connections[0], Pointf(0.0f, 0.0f), 50.0f);
+
+	// Moving within the same cells
+	interest.set_observer_position(connections[0], Pointf(5.0f, 5.0f));
+	interest.send_event(1, Pointf(30.0f, 0.0f), NetGameEvent("visible"));
+	check(interest.get_queued_event_count(connections[0]) == 1, "Entity should be visible after a small move");
+
+	// Moving far away, across many cells
+	interest.set_observer_position(connections[0], Pointf(5000.0f, -3000.0f));
+	interest.send_event(2, Pointf(30.0f, 0.0f), NetGameEvent("left behind"));
+	check(interest.get_queued_event_count(connections[0]) == 1, "Entity should not be visible after leaving its area");
+	interest.send_event(3, Pointf(5020.0f, -3020.0f), NetGameEvent("entered"));
+	check(interest.get_queued_event_count(connections[0]) == 2, "Entity should be visible after entering its area");
+
+	// Growing the radius brings more cells into view
+	interest.send_event(4, Pointf(5300.0f, -3000.0f), NetGameEvent("far"));
+	check(interest.get_queued_event_count(connections[0]) == 2, "Entity should be outside the radius");
+	interest.set_observer_radius(connections[0], 400.0f);
+	interest.send_event(4, Pointf(5300.0f, -3000.0f), NetGameEvent("far"));
+	check(interest.get_queued_event_count(connections[0]) == 3, "Entity should be visible after growing the radius");
+
+	interest.set_observer_radius(connections[0], 10.0f);
+	interest.send_event(5, Pointf(5300.0f, -3000.0f), NetGameEvent("far"));
+	check(interest.get_queued_event_count(connections[0]) == 3, "Entity should not be visible after shrinking the radius");
+
+	// A removed observer receives nothing and is unknown
+	interest.add_observer(connections[1], Pointf(5000.0f, -3000.0f), 50.0f);
+	interest.remove_observer(connections[0]);
+	check(interest.get_observer_count() == 1, "Observer was not removed");
+	interest.send_event(6, Pointf(5000.0f, -3000.0f), NetGameEvent("after remove"));
+	check(interest.get_queued_event_count(connections[1]) == 1, "Remaining observer should still see the entity");
+
+	bool thrown = false;
+	try
+	{
+		interest.get_queued_event_count(connections[0]);
+	}
+	catch (Exception &)
+	{
+		thrown = true;
+	}
+	check(thrown, "A removed observer should be unknown");
+
+	interest.add_observer(connections[0], Pointf(5000.0f, -3000.0f), 50.0f);
+	check(interest.get_queued_event_count(connections[0]) == 0, "A re-added observer should start with an empty queue");
+}
+
+void InterestManagerTest::test_entity_replace()
+{
+	Console::write_line("--- Entity replace ---");
+
+	NetGameInterestManager interest(64.0f);
+	interest.add_observer(connections[0], Pointf(0.0f, 0.0f), 50.0f);
+
+	for (int i = 0; i < 5; i++)
+		interest.send_event(1, Pointf(10.0f + i, 0.0f), NetGameEvent("moved"));
+	interest.send_event(-1, Pointf(10.0f, 0.0f), NetGameEvent("effect"));
+	interest.send_event(-1, Pointf(10.0f, 0.0f), NetGameEvent("effect"));
+	check(interest.get_queued_event_count(connections[0]) == 3, "Events for the same entity should replace each other");
+}
+
+void InterestManagerTest::test_delivery()
+{
+	Console::write_line("--- Delivery ---");
+
+	for (auto &c : clients)
+		c.received.clear();
+
+	NetGameInterestManager interest(64.0f);
+	interest.add_observer(connections[0], Pointf(0.0f, 0.0f), 50.0f);
+	interest.add_observer(connections[1], Pointf(200.0f, 0.0f), 50.0f);
+
+	interest.send_event(1, Pointf(10.0f, 0.0f), NetGameEvent("a"));
+	interest.send_event(2, Pointf(190.0f, 0.0f), NetGameEvent("b"));
+	interest.send_event(1, Pointf(12.0f, 0.0f), NetGameEvent("c"));
+	interest.tick();
+
+	wait_for_events(clients[0], 1);
+	wait_for_events(clients[1], 1);
+	check(clients[0].received == std::vector<std::string>{ "c" }, "Client 0 should only receive the newest state of entity 1");
+	check(clients[1].received == std::vector<std::string>{ "b" }, "Client 1 should only receive entity 2");
+	check(clients[2].received.empty(), "Client 2 is not an observer");
+	check(interest.get_queued_event_count(connections[0]) == 0, "Queue should be empty after a tick within budget");
+}
+
+void InterestManagerTest::test_budget()
+{
+	Console::write_line("--- Budget ---");
+
+	clients[0].received.clear();
+
+	NetGameInterestManager interest(64.0f, 4);
+	interest.add_observer(connections[0], Pointf(0.0f, 0.0f), 50.0f);
+
+	for (int i = 0; i < 10; i++)
+		interest.send_event(i, Pointf(0.0f, 0.0f), NetGameEvent("low"), 1.0f);
+	interest.send_event(100, Pointf(0.0f, 0.0f), NetGameEvent("high"), 20.0f);
+
+	interest.tick();
+	check(interest.get_queued_event_count(connections[0]) == 7, "A tick should send no more than the budget");
+	wait_for_events(clients[0], 4);
+	check(clients[0].received.size() == 4, "Client should receive exactly the budget");
+	check(std::find(clients[0].received.begin(), clients[0].received.end(), "high") != clients[0].received.end(), "Highest priority event should be sent first");
+
+	// Everything left over is eventually sent as its priority builds up
+	interest.set_observer_budget(connections[0], 3);
+	for (int i = 0; i < 3; i++)
+	{
+		wait_for_events(clients[0], clients[0].received.size());
+		interest.tick();
+	}
+	wait_for_events(clients[0], 11);
+	check(interest.get_queued_event_count(connections[0]) == 0, "Low priority events should eventually be sent");
+	check(clients[0].received.size() == 11, "Client should receive every event once");
+}
+
+void InterestManagerTest::test_unsent_budget()
+{
+	Console::write_line("--- Budget of a slow connection ---");
+
+	NetGameConnection *connection = connections[slow_client];
+
+	// Flood the connection until the relay and the socket buffers are full, so events are left in its send buffer
+	std::vector<NetGameEvent> flood(1000, NetGameEvent("flood", { std::string(1000, 'x') }));
+	uint64_t start_time = System::get_time();
+	int stalled_checks = 0;
+	while (stalled_checks < 10)
+	{
+		if (System::get_time() - start_time > 20000)
+			throw Exception("Slow connection never backed up");
+
+		// Only add more once the connection thread has taken the previous batch into its send buffer
+		NetGameConnectionStatistics statistics = connection->get_statistics();
+		if (statistics.send_queue_length == 0)
+		{
+			stalled_checks = 0;
+			connection->send_events(flood);
+		}
+		else if (statistics.send_buffer_bytes > 0)
+		{
+			stalled_checks++;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	}
+
+	NetGameConnectionStatistics statistics = connection->get_statistics();
+	Console::write_line("Send queue: %1 events, send buffer: %2 bytes, unsent: %3 events", statistics.send_queue_length, statistics.send_buffer_bytes, connection->get_send_queue_length());
+	check(connection->get_send_queue_length() > statistics.send_queue_length, "Events encoded into the send buffer should count as unsent");
+
+	// The relay keeps writing a little while the test runs, which can only free up budget
+	NetGameInterestManager interest(64.0f, connection->get_send_queue_length() - 5);
+	interest.add_observer(connection, Pointf(0.0f, 0.0f), 50.0f);
+	for (int i = 0; i < 10; i++)
+		interest.send_event(i, Pointf(0.0f, 0.0f), NetGameEvent("update"));
+	interest.tick();
+	check(interest.get_queued_event_count(connection) == 10, "Unsent events should use up the budget");
+
+	interest.set_observer_budget(connection, connection->get_send_queue_length() + 5);
+	interest.tick();
+	check(interest.get_queued_event_count(connection) <= 5, "Budget left over by unsent events should be used");
+}
+
+void InterestManagerTest::process_events()
+{
+	server.process_events();
+	for (auto &c : clients)
+		c.client.process_events();
+}
+
+void InterestManagerTest::wait_for_events(TestClient &client, size_t count)
+{
+	uint64_t start_time = System::get_time();
+	while (client.received.size() < count)
+	{
+		if (System::get_time() - start_time > 5000)
+			throw Exception("Timed out waiting for events");
+		process_events();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// Give any extra events a chance to show up too
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	process_events();
+}
+
+void InterestManagerTest::check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
@@ -0,0 +1,235 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "network_simulator.h"
+#include <algorithm>
+
+using namespace clan;
+
+NetworkSimulator::NetworkSimulator(const SocketName &listen_endpoint, const SocketName &server_endpoint, const NetworkSimulatorSettings &settings)
+	: server_endpoint(server_endpoint), settings(settings), listen(listen_endpoint, 1024),
+	stop_flag(false), link_count(0), segments_lost(0), listen_thread(&NetworkSimulator::listen_thread_main, this)
+{
+}
+
+NetworkSimulator::~NetworkSimulator()
+{
+	stop_flag = true;
+	listen_wakeup.notify();
+	listen_thread.join();
+
+	for (auto &worker : workers)
+	{
+		worker->wakeup.notify();
+		worker->thread.join();
+	}
+}
+
+void NetworkSimulator::listen_thread_main()
+{
+	std::mutex mutex;
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (!stop_flag)
+	{
+		NetworkEvent *events[] = { &listen };
+		listen_wakeup.wait(lock, 1, events, 100);
+
+		while (true)
+		{
+			SocketName peer;
+			TCPConnection client = listen.accept(peer);
+			if (client.is_null())
+				break;
+
+			std::unique_ptr<Link> link(new Link());
+			try
+			{
+				link->client = client;
+				link->server = TCPConnection(server_endpoint);
+			}
+			catch (Exception &)
+			{
+				client.close();
+				continue;
+			}
+
+			// Fill up one worker before starting the next
+			size_t worker_index = links_accepted++ / links_per_worker;
+			if (worker_index == workers.size())
+			{
+				workers.push_back(std::unique_ptr<Worker>(new Worker(settings.seed + (unsigned int)worker_index)));
+				workers.back()->thread = std::thread(&NetworkSimulator::worker_main, this, workers.back().get());
+			}
+
+			Worker *worker = workers[worker_index].get();
+			std::unique_lock<std::mutex> worker_lock(worker->mutex);
+			worker->new_links.push_back(std::move(link));
+			worker_lock.unlock();
+			worker->wakeup.notify();
+			link_count++;
+		}
+	}
+}
+
+void NetworkSimulator::worker_main(Worker *worker)
+{
+	std::unique_lock<std::mutex> lock(worker->mutex);
+	std::vector<NetworkEvent *> events;
+
+	while (!stop_flag)
+	{
+		for (auto &link : worker->new_links)
+			worker->links.push_back(std::move(link));
+		worker->new_links.clear();
+		lock.unlock();
+
+		uint64_t now = System::get_microseconds();
+		uint64_t next_delivery = now + 100000;
+		events.clear();
+
+		for (auto &link : worker->links)
+		{
+			try
+			{
+				pump(worker, link->client, link->server, link->upstream, now);
+				pump(worker, link->server, link->client, link->downstream, now);
+			}
+			catch (Exception &)
+			{
+				link->closed = true;
+			}
+
+			// Close both ends once one side has hung up and everything it sent has been delivered
+			bool upstream_done = link->upstream.end_of_stream && link->upstream.segments.empty();
+			bool downstream_done = link->downstream.end_of_stream && link->downstream.segments.empty();
+			if (link->closed || upstream_done || downstream_done)
+			{
+				link->client.close();
+				link->server.close();
+				link->closed = true;
+				link_count--;
+				continue;
+			}
+
+			if (!link->upstream.segments.empty())
+				next_delivery = std::min(next_delivery, link->upstream.segments.front().deliver_time);
+			if (!link->downstream.segments.empty())
+				next_delivery = std::min(next_delivery, link->downstream.segments.front().deliver_time);
+
+			// Only wait for sockets that can be read from or that have data waiting to be written to them
+			if (link->upstream.queued_bytes < max_queued_bytes || !link->downstream.segments.empty())
+				events.push_back(&link->client);
+			if (link->downstream.queued_bytes < max_queued_bytes || !link->upstream.segments.empty())
+				events.push_back(&link->server);
+		}
+
+		worker->links.erase(std::remove_if(worker->links.begin(), worker->links.end(), [](const std::unique_ptr<Link> &link) { return link->closed; }), worker->links.end());
+
+		now = System::get_microseconds();
+		int timeout = next_delivery > now ? (int)((next_delivery - now + 999) / 1000) : 0;
+
+		lock.lock();
+		if (worker->new_links.empty() && !stop_flag)
+			worker->wakeup.wait(lock, (int)events.size(), events.data(), timeout);
+	}
+}
+
+void NetworkSimulator::pump(Worker *worker, TCPConnection &source, TCPConnection &destination, Direction &direction, uint64_t now)
+{
+	while (!direction.end_of_stream && direction.queued_bytes < max_queued_bytes)
+	{
+		int bytes = source.read(worker->read_buffer.data(), (int)worker->read_buffer.size());
+		if (bytes == -1)
+			break;
+
+		if (bytes == 0)
+		{
+			direction.end_of_stream = true;
+			break;
+		}
+
+		for (int pos = 0; pos < bytes; pos += segment_size)
+			queue_segment(worker, direction, worker->read_buffer.data() + pos, std::min((int)segment_size, bytes - pos), now);
+	}
+
+	while (!direction.segments.empty())
+	{
+		Segment &segment = direction.segments.front();
+		if (segment.deliver_time > now)
+			break;
+
+		int bytes = destination.write(segment.data.data() + segment.pos, (int)segment.data.size() - segment.pos);
+		if (bytes == -1)
+			break;
+
+		segment.pos += bytes;
+		if (segment.pos == (int)segment.data.size())
+		{
+			direction.queued_bytes -= (int)segment.data.size();
+			direction.segments.pop_front();
+		}
+	}
+}
+
+void NetworkSimulator::queue_segment(Worker *worker, Direction &direction, const char *data, int size, uint64_t now)
+{
+	uint64_t ready_time = now;
+	if (settings.bandwidth > 0)
+	{
+		direction.link_free_time = std::max(direction.link_free_time, now) + (uint64_t)size * 1000000 / settings.bandwidth;
+		ready_time = direction.link_free_time;
+	}
+
+	uint64_t deliver_time = ready_time + random_delay(worker);
+
+	if (settings.loss > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(worker->random) < settings.loss)
+	{
+		deliver_time += (uint64_t)settings.retransmit_timeout * 1000;
+		segments_lost++;
+	}
+
+	// A TCP stream is delivered in order, so a segment can never overtake the one before it
+	deliver_time = std::max(deliver_time, direction.last_deliver_time);
+	direction.last_deliver_time = deliver_time;
+
+	Segment segment;
+	segment.deliver_time = deliver_time;
+	segment.pos = 0;
+	segment.data.assign(data, size);
+	direction.segments.push_back(std::move(segment));
+	direction.queued_bytes += size;
+}
+
+uint64_t NetworkSimulator::random_delay(Worker *worker)
+{
+	int64_t delay = (int64_t)settings.latency * 1000;
+	if (settings.jitter > 0)
+		delay += std::uniform_int_distribution<int64_t>(-settings.jitter * 1000, settings.jitter * 1000)(worker->random);
+	return (uint64_t)std::max(delay, (int64_t)0);
+}
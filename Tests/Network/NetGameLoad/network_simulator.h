@@ -0,0 +1,142 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <random>
+#include <thread>
+
+/// \brief Link conditions applied by the NetworkSimulator
+struct NetworkSimulatorSettings
+{
+	/// \brief One way delay added to every segment, in milliseconds
+	int latency = 0;
+
+	/// \brief Random variation of the one way delay (+/-), in milliseconds
+	int jitter = 0;
+
+	/// \brief Chance that a segment is lost, from 0 to 1
+	///
+	/// TCP never loses bytes, so a lost segment is delivered after retransmit_timeout instead.
+	/// As the stream is ordered, everything queued behind it is held back too.
+	double loss = 0.0;
+
+	/// \brief Time before a lost segment is delivered, in milliseconds
+	int retransmit_timeout = 200;
+
+	/// \brief Bandwidth of each direction of each link, in bytes per second. 0 is unlimited.
+	int bandwidth = 0;
+
+	/// \brief Seed for the random generator, so that runs are reproducible
+	unsigned int seed = 1;
+};
+
+/// \brief TCP relay that adds latency, jitter, loss and bandwidth limits to loopback connections
+///
+/// Clients connect to the listen endpoint instead of the server. Every accepted
+/// connection is paired with a new connection to the server and all data is
+/// relayed from one socket to the other in segments of at most segment_size bytes.
+/// The links are spread over worker threads, links_per_worker at a time, as every
+/// wakeup of a worker polls all of its sockets.
+class NetworkSimulator
+{
+public:
+	NetworkSimulator(const clan::SocketName &listen_endpoint, const clan::SocketName &server_endpoint, const NetworkSimulatorSettings &settings);
+	~NetworkSimulator();
+
+	/// \brief Returns the number of open links
+	int get_link_count() const { return link_count; }
+
+	/// \brief Returns the number of segments that were held back for a retransmit
+	int get_segments_lost() const { return segments_lost; }
+
+	enum { segment_size = 1460, max_queued_bytes = 256 * 1024, links_per_worker = 32 };
+
+private:
+	struct Segment
+	{
+		uint64_t deliver_time;
+		int pos;
+		std::string data;
+	};
+
+	struct Direction
+	{
+		std::deque<Segment> segments;
+		int queued_bytes = 0;
+		uint64_t link_free_time = 0;
+		uint64_t last_deliver_time = 0;
+		bool end_of_stream = false;
+	};
+
+	struct Link
+	{
+		clan::TCPConnection client;
+		clan::TCPConnection server;
+		Direction upstream;
+		Direction downstream;
+		bool closed = false;
+	};
+
+	struct Worker
+	{
+		Worker(unsigned int seed) : read_buffer(64 * 1024), random(seed) { }
+
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Link>> new_links;
+		clan::NetworkConditionVariable wakeup;
+
+		std::vector<std::unique_ptr<Link>> links;
+		std::vector<char> read_buffer;
+		std::mt19937 random;
+		std::thread thread;
+	};
+
+	void listen_thread_main();
+	void worker_main(Worker *worker);
+	void pump(Worker *worker, clan::TCPConnection &source, clan::TCPConnection &destination, Direction &direction, uint64_t now);
+	void queue_segment(Worker *worker, Direction &direction, const char *data, int size, uint64_t now);
+	uint64_t random_delay(Worker *worker);
+
+	clan::SocketName server_endpoint;
+	NetworkSimulatorSettings settings;
+	clan::TCPListen listen;
+	std::vector<std::unique_ptr<Worker>> workers;
+	int links_accepted = 0;
+
+	std::atomic_bool stop_flag;
+	std::atomic_int link_count;
+	std::atomic_int segments_lost;
+	clan::NetworkConditionVariable listen_wakeup;
+	std::thread listen_thread;
+};
@@ -0,0 +1,352 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+// Load test for NetGameServer and NetGameClient.
+//
+// Starts a server and a number of clients in the same process and lets each client send ping
+// events at a fixed rate, which the server echoes back. The traffic passes through a
+// NetworkSimulator relay on loopback that adds latency, jitter, loss and bandwidth limits.
+//
+// Usage: netgameload [--clients 1000] [--duration 10] [--rate 10] [--payload 32]
+//                    [--latency 0] [--jitter 0] [--loss 0] [--bandwidth 0] [--direct]
+//
+// Latency and jitter are in milliseconds, loss is in percent and bandwidth is in kilobytes per
+// second per direction per client. --direct connects the clients to the server without the relay.
+//
+// Each client uses about eight file descriptors between its own connection, the server end and
+// the relay, so the hard RLIMIT_NOFILE limit caps the number of clients.
+
+#include "network_simulator.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#ifndef WIN32
+#include <signal.h>
+#include <sys/resource.h>
+#endif
+
+using namespace clan;
+
+struct LoadTestSettings
+{
+	int clients = 1000;
+	int duration = 10;
+	int rate = 10;
+	int payload = 32;
+	bool direct = false;
+	NetworkSimulatorSettings network;
+};
+
+struct LoadClient
+{
+	NetGameClient client;
+	SlotContainer slots;
+	std::deque<uint64_t> send_times;
+	bool connected = false;
+	bool disconnected = false;
+	uint64_t next_send_time = 0;
+	unsigned int sequence = 0;
+};
+
+class LoadTest
+{
+public:
+	LoadTest(const LoadTestSettings &settings) : settings(settings)
+	{
+	}
+
+	void run();
+
+private:
+	void connect_clients();
+	void send_pings(uint64_t now);
+	void process_events();
+	void print_report(uint64_t start_time, uint64_t end_time);
+
+	static uint64_t get_resident_memory();
+
+	LoadTestSettings settings;
+	NetGameServer server;
+	SlotContainer server_slots;
+	std::unique_ptr<NetworkSimulator> simulator;
+	std::vector<std::unique_ptr<LoadClient>> clients;
+	std::vector<uint32_t> latencies;
+	uint64_t events_sent = 0;
+	uint64_t events_received = 0;
+	uint64_t connect_time = 0;
+	uint64_t memory_per_client = 0;
+};
+
+bool parse_arguments(int argc, char **argv, LoadTestSettings &settings);
+
+int main(int argc, char **argv)
+{
+	LoadTestSettings settings;
+	if (!parse_arguments(argc, argv, settings))
+		return 1;
+
+#ifndef WIN32
+	signal(SIGPIPE, SIG_IGN);
+
+	// Every client uses a handful of descriptors for itself, its server connection and the relay
+	rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+#endif
+
+	try
+	{
+		LoadTest test(settings);
+		test.run();
+		return 0;
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Error: %1", e.message);
+		return 1;
+	}
+}
+
+bool parse_arguments(int argc, char **argv, LoadTestSettings &settings)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string name = argv[i];
+		if (name == "--direct")
+		{
+			settings.direct = true;
+			continue;
+		}
+
+		if (i + 1 == argc)
+		{
+			Console::write_line("Missing value for %1", name);
+			return false;
+		}
+		std::string value = argv[++i];
+
+		if (name == "--clients")
+			settings.clients = StringHelp::text_to_int(value);
+		else if (name == "--duration")
+			settings.duration = StringHelp::text_to_int(value);
+		else if (name == "--rate")
+			settings.rate = StringHelp::text_to_int(value);
+		else if (name == "--payload")
+			settings.payload = StringHelp::text_to_int(value);
+		else if (name == "--latency")
+			settings.network.latency = StringHelp::text_to_int(value);
+		else if (name == "--jitter")
+			settings.network.jitter = StringHelp::text_to_int(value);
+		else if (name == "--loss")
+			settings.network.loss = StringHelp::text_to_double(value) / 100.0;
+		else if (name == "--bandwidth")
+			settings.network.bandwidth = StringHelp::text_to_int(value) * 1024;
+		else
+		{
+			Console::write_line("Unknown option %1", name);
+			return false;
+		}
+	}
+
+	settings.clients = std::max(settings.clients, 1);
+	settings.rate = std::max(settings.rate, 1);
+	return true;
+}
+
+void LoadTest::run()
+{
+	server_slots.connect(server.sig_event_received(), [](NetGameConnection *connection, const NetGameEvent &e)
+	{
+		if (e.get_name() == "ping")
+			connection->send_event(NetGameEvent("echo", { e.get_argument(0), e.get_argument(1) }));
+	});
+	server.start("127.0.0.1", "5400");
+
+	if (!settings.direct)
+		simulator.reset(new NetworkSimulator(SocketName("127.0.0.1", "5401"), SocketName("127.0.0.1", "5400"), settings.network));
+
+	connect_clients();
+
+	Console::write_line("Sending %1 events per second from each client for %2 seconds", settings.rate, settings.duration);
+
+	uint64_t start_time = System::get_microseconds();
+	uint64_t interval = 1000000 / settings.rate;
+	for (size_t i = 0; i < clients.size(); i++)
+		clients[i]->next_send_time = start_time + interval * i / clients.size();
+
+	uint64_t end_time = start_time + (uint64_t)settings.duration * 1000000;
+	while (System::get_microseconds() < end_time)
+	{
+		send_pings(System::get_microseconds());
+		process_events();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// Give the echoes that are still in flight a chance to arrive
+	uint64_t drain_end_time = System::get_microseconds() + 5000000;
+	while (events_received < events_sent && System::get_microseconds() < drain_end_time)
+	{
+		process_events();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	print_report(start_time, end_time);
+
+	clients.clear();
+	simulator.reset();
+	server.stop();
+}
+
+void LoadTest::connect_clients()
+{
+	Console::write_line("Connecting %1 clients %2", settings.clients, settings.direct ? "directly" : "through the network simulator");
+
+	uint64_t memory_before = get_resident_memory();
+	uint64_t start_time = System::get_microseconds();
+
+	std::string port = settings.direct ? "5400" : "5401";
+	int connected = 0;
+	for (int i = 0; i < settings.clients; i++)
+	{
+		std::unique_ptr<LoadClient> load_client(new LoadClient());
+		LoadClient *c = load_client.get();
+		c->slots.connect(c->client.sig_connected(), [c, &connected]() { c->connected = true; connected++; });
+		c->slots.connect(c->client.sig_disconnected(), [c]() { c->disconnected = true; });
+		c->slots.connect(c->client.sig_event_received(), [this, c](const NetGameEvent &e)
+		{
+			if (e.get_name() == "echo" && !c->send_times.empty())
+			{
+				latencies.push_back((uint32_t)(System::get_microseconds() - c->send_times.front()));
+				c->send_times.pop_front();
+				events_received++;
+			}
+		});
+		c->client.connect("127.0.0.1", port);
+		clients.push_back(std::move(load_client));
+
+		// Do not overrun the listen backlog of the server
+		if (i % 100 == 99)
+			process_events();
+	}
+
+	uint64_t timeout = System::get_microseconds() + 60000000;
+	while (connected < settings.clients && System::get_microseconds() < timeout)
+	{
+		process_events();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	if (connected < settings.clients)
+		throw Exception(string_format("Only %1 of %2 clients connected", connected, settings.clients));
+
+	connect_time = System::get_microseconds() - start_time;
+	memory_per_client = (get_resident_memory() - memory_before) / settings.clients;
+}
+
+void LoadTest::send_pings(uint64_t now)
+{
+	uint64_t interval = 1000000 / settings.rate;
+	std::string payload(settings.payload, 'x');
+
+	for (auto &c : clients)
+	{
+		if (c->disconnected)
+			continue;
+
+		while (c->next_send_time <= now)
+		{
+			c->client.send_event(NetGameEvent("ping", { c->sequence++, payload }));
+			c->send_times.push_back(System::get_microseconds());
+			c->next_send_time += interval;
+			events_sent++;
+		}
+	}
+}
+
+void LoadTest::process_events()
+{
+	server.process_events();
+	for (auto &c : clients)
+		c->client.process_events();
+}
+
+void LoadTest::print_report(uint64_t start_time, uint64_t end_time)
+{
+	double seconds = (end_time - start_time) / 1000000.0;
+	NetGameServerStatistics statistics = server.get_statistics();
+
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [this](double p) -> std::string
+	{
+		if (latencies.empty())
+			return "-";
+		size_t index = std::min(latencies.size() - 1, (size_t)(p * latencies.size()));
+		return StringHelp::double_to_text(latencies[index] / 1000.0, 2);
+	};
+
+	int disconnected = 0;
+	for (auto &c : clients)
+	{
+		if (c->disconnected)
+			disconnected++;
+	}
+
+	Console::write_line("");
+	Console::write_line("Clients:              %1 (%2 disconnected)", (int)clients.size(), disconnected);
+	Console::write_line("Connect time:         %1 ms", (int)(connect_time / 1000));
+	Console::write_line("Memory per client:    %1 KB", (int)(memory_per_client / 1024));
+	Console::write_line("Events sent:          %1", (int)events_sent);
+	Console::write_line("Events echoed:        %1 (%2 missing)", (int)events_received, (int)(events_sent - events_received));
+	Console::write_line("Throughput:           %1 events/s", (int)(events_received / seconds));
+	Console::write_line("Server bytes in:      %1 KB/s", (int)(statistics.totals.bytes_received / seconds / 1024));
+	Console::write_line("Server bytes out:     %1 KB/s", (int)(statistics.totals.bytes_sent / seconds / 1024));
+	Console::write_line("Latency p50:          %1 ms", percentile(0.5));
+	Console::write_line("Latency p90:          %1 ms", percentile(0.9));
+	Console::write_line("Latency p99:          %1 ms", percentile(0.99));
+	Console::write_line("Latency p99.9:        %1 ms", percentile(0.999));
+	Console::write_line("Latency max:          %1 ms", percentile(1.0));
+	if (simulator)
+		Console::write_line("Segments lost:        %1", simulator->get_segments_lost());
+}
+
+uint64_t LoadTest::get_resident_memory()
+{
+	// Only available on Linux
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, 6, "VmRSS:") == 0)
+			return StringHelp::text_to_uint(StringHelp::trim(line.substr(6, line.length() - 6 - 3))) * (uint64_t)1024;
+	}
+	return 0;
+}
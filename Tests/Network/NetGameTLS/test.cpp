@@ -0,0 +1,214 @@
+// Loopback test for NetGameClient over TLS.
+//
+// Runs the TLS test server of the TLSConnection test as a TLS terminating proxy in
+// front of a NetGameServer, which is how NetGameClient::connect expects use_tls to
+// be deployed. Checks that events flow both ways, that a client that stops
+// processing events is throttled without losing any, and that every event sent
+// right before disconnect() reaches the server before the client closes the
+// connection with a close_notify alert.
+
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include "../TLSConnection/tls_test_server.h"
+#include <atomic>
+#include <thread>
+
+#ifndef WIN32
+#include <signal.h>
+#endif
+
+using namespace clan;
+
+class TLSGame
+{
+public:
+	TLSGame();
+
+	/// \brief Connects the client through the proxy and waits for the server to see it
+	void connect();
+
+	/// \brief Processes the events of the server, and of the client unless told not to, until done returns true or the time runs out
+	void run(const std::function<bool()> &done, int max_duration_ms, bool process_client = true);
+
+	TLSTestServer proxy;
+	NetGameServer server;
+	NetGameClient client;
+	SlotContainer slots;
+
+	NetGameConnection *server_connection = nullptr;
+	bool server_disconnected = false;
+	std::vector<NetGameEvent> server_events;
+	std::vector<NetGameEvent> client_events;
+};
+
+void test_exchange(TLSGame &game);
+void test_throttling(TLSGame &game);
+void test_disconnect(TLSGame &game);
+void check(bool condition, const std::string &message);
+
+int main(int, char**)
+{
+#ifndef WIN32
+	signal(SIGPIPE, SIG_IGN);
+#endif
+
+	try
+	{
+		TLSGame game;
+		test_exchange(game);
+		test_throttling(game);
+		test_disconnect(game);
+
+		check(game.proxy.get_handshakes_completed() == 3, "Proxy did not complete every handshake");
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+TLSGame::TLSGame() : proxy(SocketName("127.0.0.1", "4434"), SocketName("127.0.0.1", "4435"))
+{
+	slots.connect(server.sig_client_connected(), [this](NetGameConnection *connection)
+	{
+		server_connection = connection;
+		server_disconnected = false;
+	});
+	slots.connect(server.sig_client_disconnected(), [this](NetGameConnection *connection, const std::string &)
+	{
+		server_connection = nullptr;
+		server_disconnected = true;
+	});
+	slots.connect(server.sig_event_received(), [this](NetGameConnection *connection, const NetGameEvent &e)
+	{
+		server_events.push_back(e);
+		if (e.get_name() == "ping")
+		{
+			connection->send_event(NetGameEvent("pong", { e.get_argument(0) }));
+		}
+		else if (e.get_name() == "flood")
+		{
+			std::vector<NetGameEvent> events;
+			for (int i = 0; i < e.get_argument(0).get_integer(); i++)
+				events.push_back(NetGameEvent("item", { i }));
+			connection->send_events(events);
+		}
+	});
+	slots.connect(client.sig_event_received(), [this](const NetGameEvent &e) { client_events.push_back(e); });
+
+	server.start("127.0.0.1", "4435");
+}
+
+void TLSGame::connect()
+{
+	server_events.clear();
+	client_events.clear();
+	client.connect("127.0.0.1", "4434", true);
+	run([this]() { return server_connection != nullptr; }, 5000);
+	check(server_connection != nullptr, "Server did not see the client connect through the proxy");
+}
+
+void TLSGame::run(const std::function<bool()> &done, int max_duration_ms, bool process_client)
+{
+	uint64_t end_time = System::get_time() + max_duration_ms;
+	while (!done() && System::get_time() < end_time)
+	{
+		server.process_events();
+		if (process_client)
+			client.process_events();
+		System::sleep(1);
+	}
+}
+
+void test_exchange(TLSGame &game)
+{
+	Console::write_line("--- Events both ways ---");
+
+	game.connect();
+
+	const int count = 100;
+	for (int i = 0; i < count; i++)
+		game.client.send_event(NetGameEvent("ping", { i }));
+
+	uint64_t start_time = System::get_microseconds();
+	game.run([&]() { return (int)game.client_events.size() == count; }, 5000);
+	check((int)game.client_events.size() == count, string_format("Client received %1 of %2 replies", (int)game.client_events.size(), count));
+	for (int i = 0; i < count; i++)
+		check(game.client_events[i].get_name() == "pong" && game.client_events[i].get_argument(0).get_integer() == i, "Replies arrived out of order");
+	Console::write_line("%1 round trips in %2 ms", count, (System::get_microseconds() - start_time) / 1000.0);
+
+	game.client.disconnect();
+	game.run([&]() { return game.server_disconnected; }, 5000);
+	check(game.server_disconnected, "Server did not see the client disconnect");
+}
+
+void test_throttling(TLSGame &game)
+{
+	Console::write_line("--- Client not processing events ---");
+
+	game.connect();
+
+	const int count = 20000;
+	game.client.send_event(NetGameEvent("flood", { count }));
+
+	// Leave the client events alone until the connection stops reading
+	game.run([&]() { return game.client.get_statistics().events_pending >= 1024; }, 5000, false);
+	System::sleep(200);
+	game.run([]() { return false; }, 100, false);
+	int pending = game.client.get_statistics().events_pending;
+	check(pending >= 1024 && pending < count, string_format("%1 events were waiting for a client that processes none", pending));
+	Console::write_line("Connection stopped reading with %1 events waiting", pending);
+
+	game.run([&]() { return (int)game.client_events.size() == count; }, 10000);
+	check((int)game.client_events.size() == count, string_format("Client received %1 of %2 events after it caught up", (int)game.client_events.size(), count));
+	for (int i = 0; i < count; i++)
+		check(game.client_events[i].get_argument(0).get_integer() == i, "Events arrived out of order after throttling");
+
+	game.client.disconnect();
+	game.run([&]() { return game.server_disconnected; }, 5000);
+	check(game.server_disconnected, "Server did not see the client disconnect");
+}
+
+void test_disconnect(TLSGame &game)
+{
+	Console::write_line("--- Disconnect right after a burst ---");
+
+	game.connect();
+	int close_notifies = game.proxy.get_close_notifies_received();
+
+	// More than the socket buffers hold, so the end of the burst is still in the client when it disconnects
+	const int count = 5000;
+	std::string payload(1000, 'x');
+	for (int i = 0; i < count; i++)
+		game.client.send_event(NetGameEvent("burst", { i, payload }));
+
+	// disconnect() waits for the events to be sent, which needs the server to keep taking them
+	std::atomic_bool disconnected(false);
+	std::thread server_thread([&]()
+	{
+		while (!disconnected)
+		{
+			game.server.process_events();
+			System::sleep(1);
+		}
+	});
+	game.client.disconnect();
+	disconnected = true;
+	server_thread.join();
+
+	game.run([&]() { return game.server_disconnected; }, 10000);
+	check(game.server_disconnected, "Server did not see the client disconnect");
+	check((int)game.server_events.size() == count, string_format("Server received %1 of %2 events sent before disconnect", (int)game.server_events.size(), count));
+	for (int i = 0; i < count; i++)
+		check(game.server_events[i].get_argument(0).get_integer() == i && game.server_events[i].get_argument(1).get_string() == payload, "Events sent before disconnect arrived damaged or out of order");
+	check(game.proxy.get_close_notifies_received() == close_notifies + 1, "Client did not send close_notify");
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
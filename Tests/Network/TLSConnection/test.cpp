@@ -0,0 +1,144 @@
+// Loopback test for TLSConnection.
+//
+// Runs its own TLS server (see tls_test_server.h) on a background thread and checks
+// that the handshake completes and that data of various sizes is echoed back intact.
+
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include "tls_test_server.h"
+
+using namespace clan;
+
+void test_handshake();
+void test_echo(int line_count, int line_length);
+
+int main(int, char**)
+{
+	try
+	{
+		TLSTestServer server(SocketName("127.0.0.1", "4433"));
+
+		test_handshake();
+		test_echo(10, 16);
+		test_echo(1000, 1000);
+		test_echo(10, 100000);
+
+		if (server.get_handshakes_completed() != 4)
+			throw Exception("Server did not complete every handshake");
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void test_handshake()
+{
+	Console::write_line("--- Handshake ---");
+
+	TLSConnection connection(SocketName("127.0.0.1", "4433"));
+
+	NetworkConditionVariable wait_condition;
+	std::mutex mutex;
+	std::unique_lock<std::mutex> lock(mutex);
+
+	uint64_t start_time = System::get_time();
+	while (true)
+	{
+		char buffer[1];
+		if (connection.read(buffer, 0) == 0)
+			throw Exception("Server closed the connection during the handshake");
+
+		if (connection.is_handshake_complete())
+			break;
+
+		if (System::get_time() - start_time > 5000)
+			throw Exception("Handshake timed out");
+
+		NetworkEvent *events[] = { &connection };
+		wait_condition.wait(lock, 1, events, 1000);
+	}
+
+	Console::write_line("Handshake completed in %1 ms", (int)(System::get_time() - start_time));
+}
+
+void test_echo(int line_count, int line_length)
+{
+	Console::write_line("--- Echo %1 lines of %2 bytes ---", line_count, line_length);
+
+	TLSConnection connection(SocketName("127.0.0.1", "4433"));
+
+	std::string data;
+	for (int i = 0; i < line_count; i++)
+	{
+		std::string line;
+		for (int j = 0; j < line_length; j++)
+			line.push_back('a' + (i + j) % 26);
+		data += line + "\n";
+	}
+
+	NetworkConditionVariable wait_condition;
+	std::mutex mutex;
+	std::unique_lock<std::mutex> lock(mutex);
+
+	uint64_t start_time = System::get_microseconds();
+
+	// Write and read at the same time, as the server stops reading once its own send buffer is full
+	size_t write_pos = 0;
+	std::string received;
+	int lines_received = 0;
+	while (lines_received < line_count)
+	{
+		bool idle = true;
+
+		if (write_pos < data.length())
+		{
+			int bytes_written = connection.write(data.data() + write_pos, data.length() - write_pos);
+			if (bytes_written > 0)
+			{
+				write_pos += bytes_written;
+				idle = false;
+			}
+		}
+		else
+		{
+			// Flush what is left of the encrypted output
+			connection.write(nullptr, 0);
+		}
+
+		char buffer[16 * 1024];
+		int bytes_read = connection.read(buffer, sizeof(buffer));
+		if (bytes_read == 0)
+			throw Exception("Server closed the connection");
+
+		if (bytes_read > 0)
+		{
+			received.append(buffer, bytes_read);
+			idle = false;
+		}
+
+		size_t end;
+		while ((end = received.find('\n')) != std::string::npos)
+		{
+			std::string expected = data.substr(lines_received * (line_length + 1), line_length);
+			if (received.substr(0, end) != expected)
+				throw Exception(string_format("Line %1 was not echoed correctly", lines_received));
+			received.erase(0, end + 1);
+			lines_received++;
+		}
+
+		if (idle)
+		{
+			NetworkEvent *events[] = { &connection };
+			wait_condition.wait(lock, 1, events, 100);
+		}
+	}
+
+	uint64_t end_time = System::get_microseconds();
+
+	double megabytes = data.length() / (1024.0 * 1024.0);
+	Console::write_line("Round trip of %1 bytes took %2 ms (%3 MB/s)", (int)data.length(), (end_time - start_time) / 1000.0, megabytes * 2 * 1000000.0 / (end_time - start_time));
+}
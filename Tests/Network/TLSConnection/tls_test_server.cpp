@@ -0,0 +1,610 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "tls_test_server.h"
+#include <cstring>
+#include <mutex>
+
+using namespace clan;
+
+namespace
+{
+	enum
+	{
+		content_change_cipher_spec = 20,
+		content_alert = 21,
+		content_handshake = 22,
+		content_application_data = 23,
+
+		handshake_client_hello = 1,
+		handshake_server_hello = 2,
+		handshake_certificate = 11,
+		handshake_server_hello_done = 14,
+		handshake_client_key_exchange = 16,
+		handshake_finished = 20,
+
+		mac_size = SHA1::hash_size,
+		key_size = AES128_Encrypt::key_size,
+		iv_size = AES128_Encrypt::iv_size,
+		verify_data_size = 12
+	};
+
+	typedef std::vector<unsigned char> Bytes;
+
+	Bytes bytes(const char *text)
+	{
+		return Bytes(text, text + strlen(text));
+	}
+
+	Bytes der(unsigned char tag, const Bytes &content)
+	{
+		Bytes result;
+		result.push_back(tag);
+		if (content.size() < 128)
+		{
+			result.push_back(content.size());
+		}
+		else if (content.size() < 256)
+		{
+			result.push_back(0x81);
+			result.push_back(content.size());
+		}
+		else
+		{
+			result.push_back(0x82);
+			result.push_back(content.size() >> 8);
+			result.push_back(content.size());
+		}
+		result.insert(result.end(), content.begin(), content.end());
+		return result;
+	}
+
+	Bytes der(unsigned char tag, std::initializer_list<Bytes> parts)
+	{
+		Bytes content;
+		for (const Bytes &part : parts)
+			content.insert(content.end(), part.begin(), part.end());
+		return der(tag, content);
+	}
+
+	Bytes der_integer(const DataBuffer &value)
+	{
+		const unsigned char *data = reinterpret_cast<const unsigned char *>(value.get_data());
+		Bytes content(data, data + value.get_size());
+		if (content.empty() || content[0] & 0x80)
+			content.insert(content.begin(), 0);
+		return der(0x02, content);
+	}
+
+	// P_hash from RFC 2246 (5), xor'ed into out
+	template<typename Hash>
+	void p_hash(const unsigned char *secret, int secret_size, const Bytes &seed, unsigned char *out, int size)
+	{
+		Hash hash;
+		unsigned char a[Hash::hash_size];
+		unsigned char block[Hash::hash_size];
+
+		hash.set_hmac(secret, secret_size);
+		hash.add(seed.data(), seed.size());
+		hash.calculate();
+		hash.get_hash(a);
+
+		for (int pos = 0; pos < size; pos += Hash::hash_size)
+		{
+			hash.set_hmac(secret, secret_size);
+			hash.add(a, Hash::hash_size);
+			hash.add(seed.data(), seed.size());
+			hash.calculate();
+			hash.get_hash(block);
+
+			for (int i = 0; i < Hash::hash_size && pos + i < size; i++)
+				out[pos + i] ^= block[i];
+
+			hash.set_hmac(secret, secret_size);
+			hash.add(a, Hash::hash_size);
+			hash.calculate();
+			hash.get_hash(a);
+		}
+	}
+
+	Bytes prf(const unsigned char *secret, int secret_size, const char *label, const Bytes &seed, int size)
+	{
+		Bytes label_seed = bytes(label);
+		label_seed.insert(label_seed.end(), seed.begin(), seed.end());
+
+		Bytes out(size, 0);
+		int half = (secret_size + 1) / 2;
+		p_hash<MD5>(secret, half, label_seed, out.data(), size);
+		p_hash<SHA1>(secret + secret_size - half, half, label_seed, out.data(), size);
+		return out;
+	}
+
+	Bytes concat(const Bytes &a, const Bytes &b)
+	{
+		Bytes result = a;
+		result.insert(result.end(), b.begin(), b.end());
+		return result;
+	}
+}
+
+class TLSTestServer::Session
+{
+public:
+	Session(TCPConnection &connection, std::atomic_bool &stop_flag) : connection(connection), stop_flag(stop_flag), lock(mutex) { }
+
+	/// \brief Reads and decrypts the next record if all of it has arrived. Sets closed when the client closed the connection.
+	bool try_read_record(int &type, Bytes &payload, bool &closed)
+	{
+		while (true)
+		{
+			if (input.size() >= 5)
+			{
+				size_t length = input[3] << 8 | input[4];
+				if (input.size() >= 5 + length)
+				{
+					type = input[0];
+					payload.assign(input.begin() + 5, input.begin() + 5 + length);
+					input.erase(input.begin(), input.begin() + 5 + length);
+					if (read_encrypted)
+						decrypt(type, payload);
+					read_sequence++;
+					return true;
+				}
+			}
+
+			unsigned char buffer[16 * 1024];
+			int bytes_read = connection.read(buffer, sizeof(buffer));
+			if (bytes_read <= 0)
+			{
+				closed = bytes_read == 0;
+				return false;
+			}
+			input.insert(input.end(), buffer, buffer + bytes_read);
+		}
+	}
+
+	/// \brief Reads and decrypts the next record. Returns false when the client closed the connection.
+	bool read_record(int &type, Bytes &payload)
+	{
+		while (true)
+		{
+			bool closed = false;
+			if (try_read_record(type, payload, closed))
+				return true;
+			if (closed || stop_flag)
+				return false;
+			wait();
+		}
+	}
+
+	/// \brief Waits for the client connection, and the other connection if there is one, to change
+	void wait(NetworkEvent *other = nullptr)
+	{
+		NetworkEvent *events[] = { &connection, other };
+		wait_condition.wait(lock, other ? 2 : 1, events, 100);
+	}
+
+	/// \brief Reads a handshake message of the given type and returns its body
+	Bytes read_handshake(int handshake_type)
+	{
+		int type;
+		Bytes payload;
+		if (!read_record(type, payload))
+			throw Exception("Client closed the connection during the handshake");
+		if (type != content_handshake || payload.size() < 4 || payload[0] != handshake_type)
+			throw Exception(string_format("Expected handshake message %1", handshake_type));
+
+		// The finished messages are hashed by the caller, as they include the hash of everything before them
+		if (handshake_type != handshake_finished)
+			handshake_messages.insert(handshake_messages.end(), payload.begin(), payload.end());
+
+		return Bytes(payload.begin() + 4, payload.end());
+	}
+
+	void write_handshake(int handshake_type, const Bytes &body)
+	{
+		Bytes message;
+		message.push_back(handshake_type);
+		message.push_back(body.size() >> 16);
+		message.push_back(body.size() >> 8);
+		message.push_back(body.size());
+		message.insert(message.end(), body.begin(), body.end());
+		handshake_messages.insert(handshake_messages.end(), message.begin(), message.end());
+		write_record(content_handshake, message.data(), message.size());
+	}
+
+	void write_record(int type, const unsigned char *data, int size)
+	{
+		Bytes record = { (unsigned char)type, 3, 1, 0, 0 };
+		if (write_encrypted)
+		{
+			unsigned char mac[mac_size];
+			calculate_mac(server_mac_secret, write_sequence, type, data, size, mac);
+
+			AES128_Encrypt encrypt;
+			encrypt.set_padding(true, false, 0);
+			encrypt.set_iv(server_iv);
+			encrypt.set_key(server_key);
+			encrypt.add(data, size);
+			encrypt.add(mac, mac_size);
+			encrypt.calculate();
+			DataBuffer encrypted = encrypt.get_data();
+			memcpy(server_iv, encrypted.get_data() + encrypted.get_size() - iv_size, iv_size);
+			record.insert(record.end(), encrypted.get_data(), encrypted.get_data() + encrypted.get_size());
+		}
+		else
+		{
+			record.insert(record.end(), data, data + size);
+		}
+		record[3] = (record.size() - 5) >> 8;
+		record[4] = record.size() - 5;
+		write_sequence++;
+
+		size_t pos = 0;
+		while (pos < record.size())
+		{
+			int bytes_written = connection.write(record.data() + pos, record.size() - pos);
+			if (bytes_written > 0)
+			{
+				pos += bytes_written;
+			}
+			else
+			{
+				if (stop_flag)
+					throw Exception("Server stopped");
+				wait();
+			}
+		}
+	}
+
+	/// \brief MD5 and SHA1 hashes of the handshake messages so far, the seed of the finished messages
+	Bytes handshake_hash()
+	{
+		Bytes result(MD5::hash_size + SHA1::hash_size);
+		MD5 md5;
+		md5.add(handshake_messages.data(), handshake_messages.size());
+		md5.calculate();
+		md5.get_hash(result.data());
+		SHA1 sha1;
+		sha1.add(handshake_messages.data(), handshake_messages.size());
+		sha1.calculate();
+		sha1.get_hash(result.data() + MD5::hash_size);
+		return result;
+	}
+
+	void set_keys(const Bytes &key_block)
+	{
+		const unsigned char *pos = key_block.data();
+		memcpy(client_mac_secret, pos, mac_size); pos += mac_size;
+		memcpy(server_mac_secret, pos, mac_size); pos += mac_size;
+		memcpy(client_key, pos, key_size); pos += key_size;
+		memcpy(server_key, pos, key_size); pos += key_size;
+		memcpy(client_iv, pos, iv_size); pos += iv_size;
+		memcpy(server_iv, pos, iv_size);
+	}
+
+	Bytes handshake_messages;
+
+	bool read_encrypted = false;
+	bool write_encrypted = false;
+	uint64_t read_sequence = 0;
+	uint64_t write_sequence = 0;
+
+private:
+	void decrypt(int type, Bytes &payload)
+	{
+		if (payload.size() < iv_size || payload.size() % iv_size)
+			throw Exception("Encrypted record is not a whole number of blocks");
+
+		AES128_Decrypt decrypt;
+		decrypt.set_padding(true, false);
+		decrypt.set_iv(client_iv);
+		decrypt.set_key(client_key);
+		decrypt.add(payload.data(), payload.size());
+		if (!decrypt.calculate())
+			throw Exception("Bad record padding");
+		memcpy(client_iv, payload.data() + payload.size() - iv_size, iv_size);
+
+		DataBuffer decrypted = decrypt.get_data();
+		if (decrypted.get_size() < mac_size)
+			throw Exception("Record is too short for its MAC");
+		int size = decrypted.get_size() - mac_size;
+		const unsigned char *data = reinterpret_cast<const unsigned char *>(decrypted.get_data());
+
+		unsigned char mac[mac_size];
+		calculate_mac(client_mac_secret, read_sequence, type, data, size, mac);
+		if (memcmp(mac, data + size, mac_size))
+			throw Exception("Bad record MAC");
+
+		payload.assign(data, data + size);
+	}
+
+	static void calculate_mac(const unsigned char *secret, uint64_t sequence, int type, const unsigned char *data, int size, unsigned char *out_mac)
+	{
+		unsigned char header[13];
+		for (int i = 0; i < 8; i++)
+			header[i] = sequence >> (56 - i * 8);
+		header[8] = type;
+		header[9] = 3;
+		header[10] = 1;
+		header[11] = size >> 8;
+		header[12] = size;
+
+		SHA1 sha1;
+		sha1.set_hmac(secret, mac_size);
+		sha1.add(header, sizeof(header));
+		sha1.add(data, size);
+		sha1.calculate();
+		sha1.get_hash(out_mac);
+	}
+
+	TCPConnection &connection;
+	std::atomic_bool &stop_flag;
+	Bytes input;
+
+	NetworkConditionVariable wait_condition;
+	std::mutex mutex;
+	std::unique_lock<std::mutex> lock;
+
+	unsigned char client_mac_secret[mac_size];
+	unsigned char server_mac_secret[mac_size];
+	unsigned char client_key[key_size];
+	unsigned char server_key[key_size];
+	unsigned char client_iv[iv_size];
+	unsigned char server_iv[iv_size];
+};
+
+TLSTestServer::TLSTestServer(const SocketName &endpoint) : listen(endpoint), stop_flag(false), handshakes_completed(0), close_notifies_received(0)
+{
+	create_certificate();
+	thread = std::thread(&TLSTestServer::thread_main, this);
+}
+
+TLSTestServer::TLSTestServer(const SocketName &endpoint, const SocketName &forward_endpoint)
+	: listen(endpoint), forward(true), forward_endpoint(forward_endpoint), stop_flag(false), handshakes_completed(0), close_notifies_received(0)
+{
+	create_certificate();
+	thread = std::thread(&TLSTestServer::thread_main, this);
+}
+
+TLSTestServer::~TLSTestServer()
+{
+	stop_flag = true;
+	thread.join();
+}
+
+void TLSTestServer::thread_main()
+{
+	NetworkConditionVariable wait_condition;
+	std::mutex mutex;
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (!stop_flag)
+	{
+		SocketName peer;
+		TCPConnection connection = listen.accept(peer);
+		if (connection.is_null())
+		{
+			NetworkEvent *events[] = { &listen };
+			wait_condition.wait(lock, 1, events, 100);
+			continue;
+		}
+
+		try
+		{
+			serve(connection);
+		}
+		catch (Exception &e)
+		{
+			Console::write_line("TLS test server: %1", e.message);
+		}
+		connection.close();
+	}
+}
+
+void TLSTestServer::serve(TCPConnection &connection)
+{
+	Session session(connection, stop_flag);
+
+	// ClientHello: version, random, session id, cipher suites, compression methods
+	Bytes client_hello = session.read_handshake(handshake_client_hello);
+	if (client_hello.size() < 35)
+		throw Exception("Client hello is too short");
+	Bytes client_random(client_hello.begin() + 2, client_hello.begin() + 34);
+
+	size_t pos = 35 + client_hello[34];
+	if (pos + 2 > client_hello.size())
+		throw Exception("Client hello is too short");
+	size_t suites_end = pos + 2 + (client_hello[pos] << 8 | client_hello[pos + 1]);
+	bool suite_offered = false;
+	for (pos += 2; pos + 1 < suites_end && pos + 1 < client_hello.size(); pos += 2)
+		suite_offered = suite_offered || (client_hello[pos] == 0x00 && client_hello[pos + 1] == 0x2F);
+	if (!suite_offered)
+		throw Exception("Client did not offer TLS_RSA_WITH_AES_128_CBC_SHA");
+
+	Bytes server_random(32);
+	random.get_random_bytes(server_random.data(), server_random.size());
+
+	Bytes server_hello = { 3, 1 };
+	server_hello.insert(server_hello.end(), server_random.begin(), server_random.end());
+	server_hello.insert(server_hello.end(), { 0, 0x00, 0x2F, 0 });
+	session.write_handshake(handshake_server_hello, server_hello);
+
+	Bytes certificate_list;
+	for (size_t length : { certificate.size() + 3, certificate.size() })
+		certificate_list.insert(certificate_list.end(), { (unsigned char)(length >> 16), (unsigned char)(length >> 8), (unsigned char)length });
+	certificate_list.insert(certificate_list.end(), certificate.begin(), certificate.end());
+	session.write_handshake(handshake_certificate, certificate_list);
+
+	session.write_handshake(handshake_server_hello_done, Bytes());
+
+	// ClientKeyExchange: the premaster secret encrypted with our public key
+	Bytes key_exchange = session.read_handshake(handshake_client_key_exchange);
+	if (key_exchange.size() < 2 || (int)key_exchange.size() != 2 + (key_exchange[0] << 8 | key_exchange[1]))
+		throw Exception("Invalid client key exchange");
+	Secret pre_master_secret = RSA::decrypt(private_exponent, modulus, DataBuffer(key_exchange.data() + 2, key_exchange.size() - 2));
+	if (pre_master_secret.get_size() != 48)
+		throw Exception("Invalid premaster secret");
+
+	Bytes master_secret = prf(pre_master_secret.get_data(), pre_master_secret.get_size(), "master secret", concat(client_random, server_random), 48);
+	session.set_keys(prf(master_secret.data(), master_secret.size(), "key expansion", concat(server_random, client_random), 2 * (mac_size + key_size + iv_size)));
+
+	int type;
+	Bytes payload;
+	if (!session.read_record(type, payload) || type != content_change_cipher_spec || payload != Bytes(1, 1))
+		throw Exception("Expected change cipher spec");
+	session.read_encrypted = true;
+	session.read_sequence = 0;
+
+	Bytes expected_verify_data = prf(master_secret.data(), master_secret.size(), "client finished", session.handshake_hash(), verify_data_size);
+	Bytes client_finished = session.read_handshake(handshake_finished);
+	if (client_finished != expected_verify_data)
+		throw Exception("Client finished verify data failed");
+	session.handshake_messages.insert(session.handshake_messages.end(), { handshake_finished, 0, 0, verify_data_size });
+	session.handshake_messages.insert(session.handshake_messages.end(), client_finished.begin(), client_finished.end());
+
+	unsigned char change_cipher_spec = 1;
+	session.write_record(content_change_cipher_spec, &change_cipher_spec, 1);
+	session.write_encrypted = true;
+	session.write_sequence = 0;
+
+	session.write_handshake(handshake_finished, prf(master_secret.data(), master_secret.size(), "server finished", session.handshake_hash(), verify_data_size));
+	handshakes_completed++;
+
+	if (forward)
+		proxy(session);
+	else
+		echo(session);
+}
+
+void TLSTestServer::echo(Session &session)
+{
+	// Echo application data until the client closes the connection
+	int type;
+	Bytes payload;
+	while (session.read_record(type, payload))
+	{
+		if (type == content_application_data)
+		{
+			session.write_record(content_application_data, payload.data(), payload.size());
+		}
+		else if (type == content_alert)
+		{
+			if (payload.size() == 2 && payload[1] == 0)
+				close_notifies_received++;
+			break;
+		}
+	}
+}
+
+void TLSTestServer::proxy(Session &session)
+{
+	TCPConnection backend(forward_endpoint);
+
+	// Stop reading from the client while the backend is behind, so the backpressure reaches the client
+	const size_t max_pending = 64 * 1024;
+	Bytes pending;
+	bool client_closed = false;
+
+	while (!stop_flag)
+	{
+		bool idle = true;
+
+		int type;
+		Bytes payload;
+		while (!client_closed && pending.size() < max_pending && session.try_read_record(type, payload, client_closed))
+		{
+			idle = false;
+			if (type == content_application_data)
+			{
+				pending.insert(pending.end(), payload.begin(), payload.end());
+			}
+			else if (type == content_alert)
+			{
+				if (payload.size() == 2 && payload[1] == 0)
+					close_notifies_received++;
+				client_closed = true;
+			}
+		}
+
+		if (!pending.empty())
+		{
+			int bytes_written = backend.write(pending.data(), pending.size());
+			if (bytes_written > 0)
+			{
+				pending.erase(pending.begin(), pending.begin() + bytes_written);
+				idle = false;
+			}
+		}
+		else if (client_closed)
+		{
+			break;
+		}
+
+		if (!client_closed)
+		{
+			unsigned char buffer[16 * 1024];
+			int bytes_read = backend.read(buffer, sizeof(buffer));
+			if (bytes_read == 0)
+				break;
+			if (bytes_read > 0)
+			{
+				session.write_record(content_application_data, buffer, bytes_read);
+				idle = false;
+			}
+		}
+
+		if (idle)
+			session.wait(&backend);
+	}
+
+	backend.close();
+}
+
+void TLSTestServer::create_certificate()
+{
+	RSA::create_keypair(random, private_exponent, public_exponent, modulus, 1024);
+
+	// The TLSClient only reads the public key and the names, and does not check the signature
+	const Bytes oid_rsa_encryption = { 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01 };
+	const Bytes oid_sha1_with_rsa_encryption = { 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x05 };
+	const Bytes oid_common_name = { 0x55, 0x04, 0x03 };
+
+	Bytes public_key(1, 0);
+	Bytes rsa_public_key = der(0x30, { der_integer(modulus), der_integer(public_exponent) });
+	public_key.insert(public_key.end(), rsa_public_key.begin(), rsa_public_key.end());
+
+	Bytes signature_algorithm = der(0x30, { der(0x06, oid_sha1_with_rsa_encryption), der(0x05, Bytes()) });
+	Bytes name = der(0x30, { der(0x31, { der(0x30, { der(0x06, oid_common_name), der(0x13, bytes("localhost")) }) }) });
+	Bytes validity = der(0x30, { der(0x17, bytes("000101000000Z")), der(0x17, bytes("491231235959Z")) });
+	Bytes subject_public_key_info = der(0x30, { der(0x30, { der(0x06, oid_rsa_encryption), der(0x05, Bytes()) }), der(0x03, public_key) });
+
+	Bytes tbs_certificate = der(0x30, { der(0x02, Bytes(1, 1)), signature_algorithm, name, validity, name, subject_public_key_info });
+	Bytes signature(1 + modulus.get_size(), 0);
+	certificate = der(0x30, { tbs_certificate, signature_algorithm, der(0x03, signature) });
+}
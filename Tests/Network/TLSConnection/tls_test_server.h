@@ -0,0 +1,82 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/// \brief Minimal TLS 1.0 server for testing TLSConnection without an external server
+///
+/// Speaks just enough TLS for the ClanLib TLSClient: RSA key exchange with TLS_RSA_WITH_AES_128_CBC_SHA,
+/// one handshake message per record and a self-signed certificate that nobody verifies. Every byte of
+/// application data received is sent straight back, or forwarded to a plain TCP server when the server
+/// is used as a TLS terminating proxy. Connections are served one at a time on a background thread.
+class TLSTestServer
+{
+public:
+	/// \brief Echo server
+	TLSTestServer(const clan::SocketName &endpoint);
+
+	/// \brief Proxy passing the decrypted data on to a server at forward_endpoint, and its replies back
+	TLSTestServer(const clan::SocketName &endpoint, const clan::SocketName &forward_endpoint);
+
+	~TLSTestServer();
+
+	/// \brief Number of connections that completed the handshake
+	int get_handshakes_completed() const { return handshakes_completed; }
+
+	/// \brief Number of connections the client closed with a close_notify alert
+	int get_close_notifies_received() const { return close_notifies_received; }
+
+private:
+	class Session;
+
+	void thread_main();
+	void serve(clan::TCPConnection &connection);
+	void echo(Session &session);
+	void proxy(Session &session);
+	void create_certificate();
+
+	clan::TCPListen listen;
+	bool forward = false;
+	clan::SocketName forward_endpoint;
+	std::thread thread;
+	std::atomic_bool stop_flag;
+	std::atomic_int handshakes_completed;
+	std::atomic_int close_notifies_received;
+
+	clan::Random random;
+	clan::Secret private_exponent;
+	clan::DataBuffer public_exponent;
+	clan::DataBuffer modulus;
+	std::vector<unsigned char> certificate;
+};
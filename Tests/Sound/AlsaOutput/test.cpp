@@ -0,0 +1,75 @@
+// Playback test for the ALSA sound output.
+//
+// Plays a tone on an ALSA device for a few seconds and prints the output
+// latency and the underrun count reported by the sound output. The device defaults to "null", so the test runs without sound
+// hardware. Pass another PCM name to try real devices or the file plugin:
+//
+//   alsaoutput hw:0,0
+//   alsaoutput "file:'/tmp/alsa_test.raw',raw"
+//
+// Passing a second argument loads the mixer thread with extra work, which
+// provokes underruns so the adaptive period can be watched growing.
+
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <cmath>
+#include <vector>
+
+using namespace clan;
+
+SoundBuffer create_tone(float frequency, int mixing_frequency);
+
+class BusyFilter : public SoundFilterProvider
+{
+public:
+	void filter(float **sample_data, int num_samples, int channels) override
+	{
+		// Hold the mixer thread long enough that the device runs dry now and then
+		System::sleep(30);
+	}
+};
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		const int frequency = 44100;
+		SoundOutput_Description desc;
+		desc.set_mixing_frequency(frequency);
+		desc.set_mixing_latency(20);
+		desc.set_device_name(argc > 1 ? argv[1] : "null");
+		SoundOutput output(desc);
+
+		SoundBuffer tone = create_tone(440.0f, frequency);
+		SoundBuffer_Session session = tone.prepare(true, &output);
+		session.play();
+
+		SoundFilter busy(new BusyFilter());
+		if (argc > 2)
+			output.add_filter(busy);
+
+		for (int i = 0; i < 10; i++)
+		{
+			System::sleep(500);
+			Console::write_line("Output latency: %1 ms, underruns: %2",
+				StringHelp::float_to_text(output.get_output_latency(), 1), output.get_underrun_count());
+		}
+
+		session.stop();
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+SoundBuffer create_tone(float frequency, int mixing_frequency)
+{
+	const float pi = 3.14159265f;
+	std::vector<short> data;
+	for (int i = 0; i < mixing_frequency; i++)
+		data.push_back((short)(std::sin(2.0f * pi * frequency * i / mixing_frequency) * 0.25f * 32767.0f));
+	return SoundBuffer(new SoundProvider_Raw(data.data(), mixing_frequency, 2, false, mixing_frequency));
+}
@@ -0,0 +1,242 @@
+// Benchmark and sanity checks for the DSP sound filters.
+//
+// Runs ten seconds of stereo noise through each filter and reports the CPU time
+// spent per second of audio, and how much of one core the filter would use when
+// playing in real time. Before that, each filter is checked against a simple
+// reference: the frequency response of the biquads, the position of delayed
+// impulses, the peak level after limiting and a direct convolution.
+//
+// Usage: filterbenchmark
+
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+#include <vector>
+
+using namespace clan;
+
+void test_biquad();
+void test_delay();
+void test_compressor();
+void test_reverb();
+void test_convolution();
+void benchmark(const std::string &name, SoundFilter filter);
+void run_filter(SoundFilter &filter, std::vector<float> &left, std::vector<float> &right, int block_size);
+float sine_gain(SoundFilter filter, float frequency);
+void check(bool condition, const std::string &message);
+
+const int sample_rate = 44100;
+const float pi = 3.14159265f;
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		test_biquad();
+		test_delay();
+		test_compressor();
+		test_reverb();
+		test_convolution();
+
+		benchmark("Biquad low pass", BiquadFilter(cl_biquad_lowpass, 2000.0f));
+		benchmark("Biquad peaking EQ", BiquadFilter(cl_biquad_peaking, 1000.0f, 1.0f, 6.0f));
+
+		DelayFilter delay;
+		delay.add_tap(125.0f, 0.5f);
+		delay.add_tap(250.3f, 0.25f);
+		delay.add_tap(375.7f, 0.125f);
+		delay.set_feedback(0.3f);
+		benchmark("Delay, 3 taps", delay);
+
+		benchmark("Reverb", ReverbFilter());
+		benchmark("Compressor", CompressorFilter());
+
+		std::vector<float> impulse_response(sample_rate * 2);
+		for (size_t i = 0; i < impulse_response.size(); i++)
+			impulse_response[i] = (std::rand() / (float)RAND_MAX - 0.5f) * std::exp(-3.0f * i / sample_rate) * 0.05f;
+		benchmark("Convolution reverb, 2 s", ConvolutionReverbFilter(impulse_response));
+
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void test_biquad()
+{
+	float pass = sine_gain(BiquadFilter(cl_biquad_lowpass, 1000.0f), 100.0f);
+	float stop = sine_gain(BiquadFilter(cl_biquad_lowpass, 1000.0f), 10000.0f);
+	check(std::abs(20.0f * std::log10(pass)) < 0.5f, "Low pass filter changes the passband");
+	check(20.0f * std::log10(stop) < -30.0f, "Low pass filter does not attenuate the stopband");
+
+	float high_pass = sine_gain(BiquadFilter(cl_biquad_highpass, 1000.0f), 100.0f);
+	check(20.0f * std::log10(high_pass) < -30.0f, "High pass filter does not attenuate low frequencies");
+
+	float peak = sine_gain(BiquadFilter(cl_biquad_peaking, 1000.0f, 1.0f, 6.0f), 1000.0f);
+	check(std::abs(20.0f * std::log10(peak) - 6.0f) < 0.1f, "Peaking filter does not boost its center frequency by its gain");
+
+	float shelf = sine_gain(BiquadFilter(cl_biquad_lowshelf, 500.0f, 0.707f, -12.0f), 50.0f);
+	check(std::abs(20.0f * std::log10(shelf) + 12.0f) < 0.2f, "Low shelf filter does not cut low frequencies by its gain");
+
+	Console::write_line("Biquad filter: low pass %1 dB at 100 Hz, %2 dB at 10 kHz", StringHelp::float_to_text(20.0f * std::log10(pass), 2), StringHelp::float_to_text(20.0f * std::log10(stop), 2));
+}
+
+void test_delay()
+{
+	DelayFilter delay(100.0f);
+	delay.add_tap(10.0f, 0.5f);
+	delay.add_tap(20.0f + 500.0f / sample_rate, 0.25f);
+	delay.set_dry_level(0.0f);
+
+	std::vector<float> left(4000, 0.0f), right(4000, 0.0f);
+	left[100] = 1.0f;
+	right[100] = 1.0f;
+	run_filter(delay, left, right, 300);
+
+	// 10 ms is 441 samples. The second tap is halfway between two samples.
+	check(std::abs(left[541] - 0.5f) < 0.0001f, "Delay tap is not at its position");
+	check(std::abs(left[982] - 0.125f) < 0.0001f && std::abs(left[983] - 0.125f) < 0.0001f, "Fractional delay tap is not interpolated");
+	check(std::abs(left[100]) < 0.0001f && std::abs(right[541] - 0.5f) < 0.0001f, "Delay filter does not handle both channels alike");
+	Console::write_line("Delay filter: taps found at the expected positions");
+}
+
+void test_compressor()
+{
+	// A limiter with instant attack may not let any sample above the threshold
+	CompressorFilter limiter(-6.0f, std::numeric_limits<float>::infinity(), 0.0f, 50.0f);
+	std::vector<float> left(sample_rate), right(sample_rate);
+	for (int i = 0; i < sample_rate; i++)
+	{
+		left[i] = std::sin(2.0f * pi * 440.0f * i / sample_rate) * 2.0f;
+		right[i] = left[i] * 0.5f;
+	}
+	run_filter(limiter, left, right, 512);
+
+	float threshold = std::pow(10.0f, -6.0f / 20.0f);
+	float peak = 0.0f;
+	for (int i = 0; i < sample_rate; i++)
+		peak = std::max(peak, std::max(std::abs(left[i]), std::abs(right[i])));
+	check(peak <= threshold * 1.001f, "Limiter lets peaks through");
+	check(peak > threshold * 0.99f, "Limiter reduces the level too much");
+
+	// Levels below the threshold must not be touched at all
+	CompressorFilter compressor(-6.0f, 4.0f);
+	std::vector<float> quiet_left(1000, 0.25f), quiet_right(1000, -0.25f);
+	run_filter(compressor, quiet_left, quiet_right, 1000);
+	check(quiet_left[999] == 0.25f && quiet_right[999] == -0.25f, "Compressor changes levels below the threshold");
+
+	Console::write_line("Compressor filter: peak %1 dB with a -6 dB limiter", StringHelp::float_to_text(20.0f * std::log10(peak), 2));
+}
+
+void test_reverb()
+{
+	ReverbFilter reverb;
+	reverb.set_dry_level(0.0f);
+
+	std::vector<float> left(sample_rate * 4, 0.0f), right(sample_rate * 4, 0.0f);
+	left[0] = 1.0f;
+	right[0] = 1.0f;
+	run_filter(reverb, left, right, 1024);
+
+	float early = 0.0f, late = 0.0f;
+	for (int i = 0; i < sample_rate / 2; i++)
+		early += left[i] * left[i] + right[i] * right[i];
+	for (int i = sample_rate * 3; i < sample_rate * 4; i++)
+	{
+		check(std::isfinite(left[i]) && std::isfinite(right[i]), "Reverb output is not finite");
+		late += left[i] * left[i] + right[i] * right[i];
+	}
+	check(early > 0.0f, "Reverb has no tail");
+	check(late < early * 0.001f, "Reverb tail does not decay");
+	Console::write_line("Reverb filter: tail decays by %1 dB after 3 seconds", StringHelp::float_to_text(10.0f * std::log10(late / early), 1));
+}
+
+void test_convolution()
+{
+	std::vector<float> impulse_response(3000);
+	for (auto & elem : impulse_response)
+		elem = std::rand() / (float)RAND_MAX - 0.5f;
+
+	std::vector<float> left(8000), right(8000);
+	for (size_t i = 0; i < left.size(); i++)
+	{
+		left[i] = std::rand() / (float)RAND_MAX - 0.5f;
+		right[i] = std::rand() / (float)RAND_MAX - 0.5f;
+	}
+	std::vector<float> input_left = left, input_right = right;
+
+	ConvolutionReverbFilter convolution(impulse_response, 128);
+	convolution.set_dry_level(0.0f);
+	run_filter(convolution, left, right, 300);
+
+	int latency = convolution.get_latency();
+	float max_error = 0.0f;
+	for (int i = latency; i < (int)left.size(); i++)
+	{
+		double expected_left = 0.0, expected_right = 0.0;
+		for (int j = 0; j < (int)impulse_response.size() && j <= i - latency; j++)
+		{
+			expected_left += impulse_response[j] * input_left[i - latency - j];
+			expected_right += impulse_response[j] * input_right[i - latency - j];
+		}
+		max_error = std::max(max_error, (float)std::abs(left[i] - expected_left));
+		max_error = std::max(max_error, (float)std::abs(right[i] - expected_right));
+	}
+	check(max_error < 0.001f, "Convolution does not match direct convolution");
+	Console::write_line("Convolution reverb filter: largest difference from direct convolution %1", StringHelp::float_to_text(max_error, 6));
+}
+
+void benchmark(const std::string &name, SoundFilter filter)
+{
+	const int seconds = 10;
+	std::vector<float> left(sample_rate * seconds), right(sample_rate * seconds);
+	for (size_t i = 0; i < left.size(); i++)
+	{
+		left[i] = (std::rand() / (float)RAND_MAX - 0.5f) * 0.5f;
+		right[i] = (std::rand() / (float)RAND_MAX - 0.5f) * 0.5f;
+	}
+
+	std::clock_t start_clock = std::clock();
+	run_filter(filter, left, right, 1024);
+	double cpu_us = (std::clock() - start_clock) * 1000000.0 / CLOCKS_PER_SEC;
+
+	Console::write_line("%1: %2 us CPU per second of stereo audio, %3% of one core", name, (int)(cpu_us / seconds), StringHelp::float_to_text((float)(cpu_us / seconds / 10000.0), 3));
+}
+
+void run_filter(SoundFilter &filter, std::vector<float> &left, std::vector<float> &right, int block_size)
+{
+	int num_samples = (int)left.size();
+	for (int pos = 0; pos < num_samples; pos += block_size)
+	{
+		float *channels[2] = { left.data() + pos, right.data() + pos };
+		filter.filter(channels, std::min(block_size, num_samples - pos), 2);
+	}
+}
+
+float sine_gain(SoundFilter filter, float frequency)
+{
+	std::vector<float> left(sample_rate), right(sample_rate);
+	for (int i = 0; i < sample_rate; i++)
+		left[i] = right[i] = std::sin(2.0f * pi * frequency * i / sample_rate);
+	run_filter(filter, left, right, 1000);
+
+	// Skip the first half second, where the filter settles
+	double sum = 0.0;
+	for (int i = sample_rate / 2; i < sample_rate; i++)
+		sum += left[i] * left[i];
+	return (float)std::sqrt(sum / (sample_rate / 2) * 2.0);
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
@@ -0,0 +1,114 @@
+// Benchmark for mixing many sound sessions, serially and on a worker pool.
+//
+// Plays a few hundred looping voices at a frequency that needs resampling into
+// an offline sound output and reports how many voices can be mixed per
+// millisecond of CPU time, ie. how many voices one core could keep up with in
+// real time. One voice mixed for 1 ms of audio counts as one voice-ms. The
+// parallel result is also compared against the serial one.
+//
+// Usage: mixbenchmark [voices] [threads]
+
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+using namespace clan;
+
+std::vector<float> run_benchmark(int num_voices, int num_threads);
+void check(bool condition, const std::string &message);
+
+const int mixing_frequency = 48000;
+const int source_frequency = 44100;
+const int render_seconds = 4;
+const int fragment_size = 1024;
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int num_voices = argc > 1 ? std::atoi(argv[1]) : 256;
+		int num_threads = argc > 2 ? std::atoi(argv[2]) : 0;
+		if (num_threads <= 0)
+			num_threads = std::max((int)std::thread::hardware_concurrency(), 2);
+
+		std::vector<float> serial = run_benchmark(num_voices, 1);
+		std::vector<float> parallel = run_benchmark(num_voices, num_threads);
+
+		// Floats are summed in another order when mixing in parallel, so allow a tiny difference
+		float max_difference = 0.0f;
+		for (size_t i = 0; i < serial.size(); i++)
+			max_difference = std::max(max_difference, std::abs(serial[i] - parallel[i]));
+		Console::write_line("Largest difference between serial and parallel mix: %1", StringHelp::float_to_text(max_difference, 7));
+		check(max_difference < 0.0001f, "Parallel mixing does not produce the same output as serial mixing");
+
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+std::vector<float> run_benchmark(int num_voices, int num_threads)
+{
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(mixing_frequency);
+	desc.set_mixing_threads(num_threads);
+	desc.set_offline();
+	SoundOutput output(desc);
+
+	// One buffer per voice, so each session has its own tone
+	const float pi = 3.14159265f;
+	std::vector<SoundBuffer_Session> sessions;
+	for (int voice = 0; voice < num_voices; voice++)
+	{
+		float frequency = 100.0f + voice * 10.0f;
+		std::vector<short> data;
+		for (int i = 0; i < source_frequency; i++)
+			data.push_back((short)(std::sin(2.0f * pi * frequency * i / source_frequency) * 32767.0f));
+
+		SoundBuffer buffer(new SoundProvider_Raw(data.data(), source_frequency, 2, false, source_frequency));
+		SoundBuffer_Session session = buffer.prepare(true, &output);
+		session.set_volume(1.0f / num_voices);
+		session.set_pan((voice % 3) - 1.0f);
+		session.play();
+		sessions.push_back(session);
+	}
+
+	std::vector<float> samples(mixing_frequency * render_seconds * 2);
+	int num_samples = (int)samples.size() / 2;
+
+	uint64_t start_time = System::get_microseconds();
+	std::clock_t start_clock = std::clock();
+
+	for (int pos = 0; pos < num_samples; pos += fragment_size)
+		output.render(samples.data() + pos * 2, std::min(fragment_size, num_samples - pos));
+
+	double cpu_ms = (std::clock() - start_clock) * 1000.0 / CLOCKS_PER_SEC;
+	double wall_ms = (System::get_microseconds() - start_time) / 1000.0;
+	double audio_ms = render_seconds * 1000.0;
+
+	Console::write_line("%1 voices, %2 threads: %3 ms CPU, %4 ms wall time for %5 ms of audio", num_voices, num_threads, (int)cpu_ms, (int)wall_ms, (int)audio_ms);
+	Console::write_line("    %1 voice-ms per ms of CPU, %2 voices in real time", (int)(num_voices * audio_ms / cpu_ms), (int)(num_voices * audio_ms / wall_ms));
+
+	// The mixer applies the stops at the start of the next fragment
+	for (auto & session : sessions)
+		session.stop();
+	std::vector<float> silence(fragment_size * 2);
+	output.render(silence.data(), fragment_size);
+
+	return samples;
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
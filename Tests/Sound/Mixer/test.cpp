@@ -0,0 +1,226 @@
+// Offline render test for the sound mixing graph.
+//
+// Mixes a few generated tones through nested submix buses into a 7.1 offline
+// sound output, checks which speakers received sound and lets the output write
+// the result to mixer_test.wav (WAVE_FORMAT_EXTENSIBLE, 32 bit float) for
+// listening. The file and the offline callback are checked against the samples
+// returned by SoundOutput::render. Finally queues more session changes than
+// the command queue holds before rendering, which must not wait for a mixer.
+
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace clan;
+
+SoundBuffer create_tone(float left_frequency, float right_frequency, bool stereo, int mixing_frequency);
+void render(SoundOutput &output, std::vector<float> &samples, int sample_count, float *peaks);
+void mix_graph(std::vector<float> &samples, std::vector<float> &callback_samples);
+void queue_before_render();
+void check_wav(const std::string &filename, const std::vector<float> &samples);
+void check(bool condition, const std::string &message);
+
+const float amplitude = 0.25f;
+const int frequency = 48000;
+const int num_channels = 8;
+const char *channel_names[num_channels] = { "FL", "FR", "FC", "LFE", "BL", "BR", "SL", "SR" };
+
+int main(int, char**)
+{
+	try
+	{
+		std::vector<float> samples, callback_samples;
+		mix_graph(samples, callback_samples);
+		check(callback_samples == samples, "Offline callback did not receive the rendered samples");
+
+		// The output wrote its sizes into the wave header when it was destroyed
+		check_wav("mixer_test.wav", samples);
+		Console::write_line("Wrote %1 samples to mixer_test.wav", (int)(samples.size() / num_channels));
+
+		queue_before_render();
+
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void mix_graph(std::vector<float> &samples, std::vector<float> &callback_samples)
+{
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(frequency);
+	desc.set_speakers(cl_speakers_7_1);
+	desc.set_offline();
+	desc.set_offline_output(File("mixer_test.wav", File::create_always, File::access_write), true);
+	desc.set_offline_callback([&](const float *data, int sample_count)
+	{
+		callback_samples.insert(callback_samples.end(), data, data + sample_count * num_channels);
+	});
+	SoundOutput output(desc);
+	check(output.get_speakers() == cl_speakers_7_1, "Offline output did not use the requested speakers");
+
+	// effects -> master, dialog -> effects, music -> master
+	SoundBus effects(output);
+	SoundBus dialog(output, effects);
+	SoundBus music(output);
+	dialog.set_volume(0.25f);
+	music.set_volume(0.5f);
+
+	SoundBuffer effect_tone = create_tone(440.0f, 440.0f, false, frequency);
+	SoundBuffer dialog_tone = create_tone(220.0f, 220.0f, false, frequency);
+	SoundBuffer music_tone = create_tone(660.0f, 880.0f, true, frequency);
+
+	SoundBuffer_Session effect_session = effect_tone.prepare(true, &output);
+	effect_session.set_pan(-1.0f);
+	effect_session.set_bus(effects);
+	effect_session.play();
+
+	SoundBuffer_Session dialog_session = dialog_tone.prepare(true, &output);
+	dialog_session.set_bus(dialog);
+	dialog_session.play();
+
+	SoundBuffer_Session music_session = music_tone.prepare(true, &output);
+	music_session.set_bus(music);
+	music_session.play();
+
+	float peaks[num_channels];
+
+	Console::write_line("--- All buses ---");
+	render(output, samples, frequency, peaks);
+	check(peaks[0] > amplitude * 1.2f, "Front left is missing a source");
+	check(peaks[1] > amplitude * 0.5f && peaks[1] < amplitude * 0.76f, "Front right should only hold the music and dialog buses");
+	for (int i = 2; i < num_channels; i++)
+		check(peaks[i] == 0.0f, std::string("Mono and stereo sources should not reach ") + channel_names[i]);
+
+	Console::write_line("--- Music bus muted ---");
+	music.set_volume(0.0f);
+	render(output, samples, frequency / 2, peaks);
+	check(peaks[1] > amplitude * 0.24f && peaks[1] < amplitude * 0.26f, "Front right should only hold the dialog bus");
+
+	Console::write_line("--- Dialog moved to master ---");
+	SoundBus master;
+	dialog_session.set_bus(master);
+	render(output, samples, frequency / 2, peaks);
+	check(peaks[1] > amplitude * 0.99f && peaks[1] < amplitude * 1.01f, "Dialog did not play at full volume on the master bus");
+
+	Console::write_line("--- Global pan to the right ---");
+	output.set_global_pan(1.0f);
+	render(output, samples, frequency / 4, peaks);
+	check(peaks[0] == 0.0f && peaks[1] > 0.0f, "Global pan was not applied to the left speakers");
+	output.set_global_pan(0.0f);
+
+	// Sessions are released by the mixer when it applies the stops, at the start of the next fragment
+	effect_session.stop();
+	dialog_session.stop();
+	music_session.stop();
+	size_t start = samples.size();
+	samples.resize(start + frequency / 10 * num_channels);
+	output.render(samples.data() + start, frequency / 10);
+}
+
+void queue_before_render()
+{
+	Console::write_line("--- Commands queued before render ---");
+
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(frequency);
+	desc.set_speakers(cl_speakers_7_1);
+	desc.set_offline();
+	SoundOutput output(desc);
+
+	SoundBuffer tone = create_tone(440.0f, 440.0f, false, frequency);
+	SoundBuffer_Session session = tone.prepare(true, &output);
+	session.play();
+
+	// Nothing drains the queue of an offline output until it renders
+	for (int i = 0; i < 20000; i++)
+		session.set_volume(i % 2 ? 0.5f : 0.75f);
+	for (int i = 0; i < 5000; i++)
+	{
+		session.stop();
+		session.play();
+	}
+
+	std::vector<float> samples;
+	float peaks[num_channels];
+	render(output, samples, frequency / 2, peaks);
+	check(session.is_playing(), "Session did not play after the queued commands");
+	check(peaks[0] > amplitude * 0.49f && peaks[0] < amplitude * 0.51f, "Last queued volume was not applied");
+}
+
+SoundBuffer create_tone(float left_frequency, float right_frequency, bool stereo, int mixing_frequency)
+{
+	const float pi = 3.14159265f;
+	int num_samples = mixing_frequency;
+	std::vector<short> data;
+	for (int i = 0; i < num_samples; i++)
+	{
+		data.push_back((short)(std::sin(2.0f * pi * left_frequency * i / mixing_frequency) * amplitude * 32767.0f));
+		if (stereo)
+			data.push_back((short)(std::sin(2.0f * pi * right_frequency * i / mixing_frequency) * amplitude * 32767.0f));
+	}
+	return SoundBuffer(new SoundProvider_Raw(data.data(), num_samples, 2, stereo, mixing_frequency));
+}
+
+void render(SoundOutput &output, std::vector<float> &samples, int sample_count, float *peaks)
+{
+	size_t start = samples.size();
+	samples.resize(start + sample_count * num_channels);
+
+	// Render in uneven blocks to exercise the fragment handling of the offline output
+	int pos = 0;
+	while (pos < sample_count)
+	{
+		int count = std::min(sample_count - pos, 1000);
+		output.render(samples.data() + start + pos * num_channels, count);
+		pos += count;
+	}
+
+	// Volume changes fade in over the first fragment, so leave it out of the peaks
+	size_t settled = start + frequency / 10 * num_channels;
+
+	for (int i = 0; i < num_channels; i++)
+		peaks[i] = 0.0f;
+	for (size_t i = settled; i < samples.size(); i++)
+		peaks[i % num_channels] = std::max(peaks[i % num_channels], std::abs(samples[i]));
+
+	for (int i = 0; i < num_channels; i++)
+		Console::write_line("%1 peak: %2", channel_names[i], StringHelp::float_to_text(peaks[i], 4));
+}
+
+void check_wav(const std::string &filename, const std::vector<float> &samples)
+{
+	unsigned int data_size = samples.size() * sizeof(float);
+
+	File file(filename, File::open_existing, File::access_read);
+	file.set_little_endian_mode();
+	char id[4];
+	file.read(id, 4);
+	check(memcmp(id, "RIFF", 4) == 0, "Wave file has no RIFF header");
+	check(file.read_uint32() == 4 + 8 + 40 + 8 + data_size, "Wave file has the wrong RIFF size");
+	file.seek(20);
+	check(file.read_uint16() == 0xfffe, "Float wave file is not WAVE_FORMAT_EXTENSIBLE");
+	check(file.read_uint16() == num_channels, "Wave file has the wrong channel count");
+	file.seek(40);
+	check(file.read_uint32() == cl_speakers_7_1, "Wave file has the wrong channel mask");
+	file.seek(60);
+	file.read(id, 4);
+	check(memcmp(id, "data", 4) == 0 && file.read_uint32() == data_size, "Wave file has the wrong data size");
+
+	std::vector<float> data(samples.size());
+	file.read(data.data(), data_size);
+	check(data == samples, "Wave file does not hold the rendered samples");
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
@@ -0,0 +1,103 @@
+// Offline render test for the sound session resampler.
+//
+// Plays a 1 kHz tone recorded at various frequencies into a 48 kHz offline
+// sound output with each resample quality, and checks the pitch, amplitude and
+// signal to noise ratio of the result.
+
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <cmath>
+#include <vector>
+
+using namespace clan;
+
+void measure_tone(const std::vector<float> &samples, float &amplitude, float &snr);
+void check(bool condition, const std::string &message);
+
+const double pi = 3.14159265358979;
+const double tone_frequency = 1000.0;
+const int mixing_frequency = 48000;
+
+int main(int, char**)
+{
+	try
+	{
+		SoundOutput_Description desc;
+		desc.set_mixing_frequency(mixing_frequency);
+		desc.set_offline();
+		SoundOutput output(desc);
+
+		const int source_frequencies[] = { 22050, 44100, 48000, 96000 };
+		const char *quality_names[] = { "nearest", "linear", "cubic", "sinc" };
+		const float min_snr[] = { 15.0f, 45.0f, 65.0f, 85.0f };
+
+		for (int source_frequency : source_frequencies)
+		{
+			// One second of the tone holds a whole number of periods, so it loops seamlessly
+			std::vector<short> data;
+			for (int i = 0; i < source_frequency; i++)
+				data.push_back((short)(std::sin(2.0 * pi * tone_frequency * i / source_frequency) * 0.5 * 32767.0));
+			SoundBuffer tone(new SoundProvider_Raw(data.data(), source_frequency, 2, false, source_frequency));
+
+			for (int quality = cl_resample_nearest; quality <= cl_resample_sinc; quality++)
+			{
+				SoundBuffer_Session session = tone.prepare(true, &output);
+				session.set_resample_quality((SoundResampleQuality)quality);
+				session.play();
+
+				std::vector<float> samples(mixing_frequency * 2 * 2);
+				uint64_t start_time = System::get_microseconds();
+				output.render(samples.data(), mixing_frequency * 2);
+				uint64_t render_time = System::get_microseconds() - start_time;
+				session.stop();
+
+				float amplitude, snr;
+				measure_tone(samples, amplitude, snr);
+				Console::write_line("%1 Hz %2: amplitude %3, SNR %4 dB, %5 us", source_frequency, quality_names[quality], StringHelp::float_to_text(amplitude, 4), StringHelp::float_to_text(snr, 1), (int)render_time);
+
+				check(std::abs(amplitude - 0.5f) < 0.01f, "Resampled tone has the wrong amplitude");
+				check(snr > min_snr[quality], "Resampled tone is too noisy");
+			}
+		}
+
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void measure_tone(const std::vector<float> &samples, float &amplitude, float &snr)
+{
+	// Fit a 1 kHz sine to the left channel. A wrong pitch shows up as a low amplitude and SNR.
+	int start = mixing_frequency / 10;
+	int count = (int)samples.size() / 2 - start;
+	double sin_part = 0.0, cos_part = 0.0;
+	for (int i = start; i < start + count; i++)
+	{
+		sin_part += samples[i * 2] * std::sin(2.0 * pi * tone_frequency * i / mixing_frequency);
+		cos_part += samples[i * 2] * std::cos(2.0 * pi * tone_frequency * i / mixing_frequency);
+	}
+	sin_part *= 2.0 / count;
+	cos_part *= 2.0 / count;
+
+	double signal = 0.0, noise = 0.0;
+	for (int i = start; i < start + count; i++)
+	{
+		double expected = sin_part * std::sin(2.0 * pi * tone_frequency * i / mixing_frequency) + cos_part * std::cos(2.0 * pi * tone_frequency * i / mixing_frequency);
+		signal += expected * expected;
+		noise += (samples[i * 2] - expected) * (samples[i * 2] - expected);
+	}
+
+	amplitude = (float)std::sqrt(sin_part * sin_part + cos_part * cos_part);
+	snr = (float)(10.0 * std::log10(signal / noise));
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
@@ -0,0 +1,272 @@
+// Spatialization test for AudioWorld.
+//
+// Places a looping tone around the listener and renders it through offline
+// sound outputs. On 7.1 the tone must come out of the speakers in its
+// direction, on stereo it must be panned by the ear angle. Also checks
+// occlusion and the Doppler shift of a moving object, and times
+// AudioWorld::update with thousands of objects.
+
+#include <ClanLib/core.h>
+#include <ClanLib/sound.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace clan;
+
+void test_surround();
+void test_stereo();
+void test_doppler();
+void benchmark();
+SoundBuffer create_tone(int mixing_frequency);
+void render_peaks(SoundOutput &output, int num_channels, float *peaks);
+void check(bool condition, const std::string &message);
+
+const int frequency = 48000;
+const char *channel_names[8] = { "FL", "FR", "FC", "LFE", "BL", "BR", "SL", "SR" };
+
+int main(int, char**)
+{
+	try
+	{
+		test_surround();
+		test_stereo();
+		test_doppler();
+		benchmark();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void test_surround()
+{
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(frequency);
+	desc.set_speakers(cl_speakers_7_1);
+	desc.set_offline();
+	SoundOutput output(desc);
+
+	ResourceManager resources;
+	AudioWorld world(resources);
+	world.set_listener(Vec3f(0.0f, 0.0f, 0.0f), Quaternionf());
+
+	AudioObject object(world);
+	object.set_sound(create_tone(frequency));
+	object.set_looping(true);
+	object.set_attenuation_begin(1.0f);
+	object.set_attenuation_end(1000.0f);
+	object.set_position(Vec3f(0.0f, 0.0f, 10.0f));
+	object.play();
+
+	// Silent objects fill an SSE block, so the object is spatialized by the SIMD path
+	std::vector<AudioObject> silent;
+	for (int i = 0; i < 3; i++)
+		silent.push_back(AudioObject(world));
+
+	struct Direction { Vec3f position; int loudest; int second; const char *name; };
+	Direction directions[] =
+	{
+		{ Vec3f(0.0f, 0.0f, 10.0f), 2, -1, "front" },
+		{ Vec3f(10.0f, 0.0f, 0.0f), 7, -1, "right" },
+		{ Vec3f(-10.0f, 0.0f, 0.0f), 6, -1, "left" },
+		{ Vec3f(-10.0f, 0.0f, -10.0f), 4, -1, "back left" },
+		{ Vec3f(0.0f, 0.0f, -10.0f), 4, 5, "behind" }
+	};
+
+	float peaks[8];
+	for (auto & direction : directions)
+	{
+		object.set_position(direction.position);
+		world.update();
+		render_peaks(output, 8, peaks);
+
+		int loudest = std::max_element(peaks, peaks + 8) - peaks;
+		Console::write_line("%1: loudest speaker %2", direction.name, channel_names[loudest]);
+		if (direction.second == -1)
+		{
+			check(loudest == direction.loudest, std::string("Object ") + direction.name + " came from the wrong speaker");
+			for (int i = 0; i < 8; i++)
+				check(i == loudest || peaks[i] < peaks[loudest] * 0.01f, std::string("Object ") + direction.name + " leaked into " + channel_names[i]);
+		}
+		else
+		{
+			check(std::abs(peaks[direction.loudest] - peaks[direction.second]) < peaks[direction.loudest] * 0.01f, std::string("Object ") + direction.name + " was not centered between two speakers");
+		}
+	}
+
+	object.stop();
+	render_peaks(output, 8, peaks);
+}
+
+void test_stereo()
+{
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(frequency);
+	desc.set_offline();
+	SoundOutput output(desc);
+
+	ResourceManager resources;
+	AudioWorld world(resources);
+
+	AudioObject object(world);
+	object.set_sound(create_tone(frequency));
+	object.set_looping(true);
+	object.set_attenuation_begin(1.0f);
+	object.set_attenuation_end(1000.0f);
+	object.set_position(Vec3f(10.0f, 0.0f, 0.0f));
+	object.play();
+
+	float peaks[2];
+	world.update();
+	render_peaks(output, 2, peaks);
+	check(peaks[0] == 0.0f && peaks[1] > 0.0f, "Object to the right was heard in the left speaker");
+
+	// Behind the listener stereo only pans, so the object is as loud as in front
+	object.set_position(Vec3f(0.0f, 0.0f, -10.0f));
+	world.update();
+	float behind[2];
+	render_peaks(output, 2, behind);
+	object.set_position(Vec3f(0.0f, 0.0f, 10.0f));
+	world.update();
+	render_peaks(output, 2, peaks);
+	check(std::abs(behind[0] - peaks[0]) < 0.001f && std::abs(behind[1] - peaks[1]) < 0.001f, "Stereo output used the front to back position");
+
+	object.set_occlusion(0.5f);
+	world.update();
+	render_peaks(output, 2, behind);
+	check(std::abs(behind[0] - peaks[0] * 0.5f) < 0.001f, "Occlusion did not halve the volume");
+
+	object.stop();
+	render_peaks(output, 2, peaks);
+}
+
+void test_doppler()
+{
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(frequency);
+	desc.set_offline();
+	SoundOutput output(desc);
+
+	ResourceManager resources;
+	AudioWorld world(resources);
+	world.set_doppler_factor(1.0f);
+
+	AudioObject object(world);
+	object.set_sound(create_tone(frequency));
+	object.set_looping(true);
+	object.set_attenuation_begin(1.0f);
+	object.set_attenuation_end(1000.0f);
+	object.set_position(Vec3f(0.0f, 0.0f, 100.0f));
+
+	// Coming straight at the listener at a tenth of the speed of sound
+	object.set_velocity(Vec3f(0.0f, 0.0f, -34.33f));
+	object.play();
+
+	std::vector<AudioObject> silent;
+	for (int i = 0; i < 3; i++)
+		silent.push_back(AudioObject(world));
+	world.update();
+
+	// Count rising zero crossings over one second after the first fragment
+	std::vector<float> samples(frequency * 2 + frequency / 10 * 2);
+	output.render(samples.data(), frequency + frequency / 10);
+	int crossings = 0;
+	for (size_t i = frequency / 10 * 2; i + 2 < samples.size(); i += 2)
+	{
+		if (samples[i] < 0.0f && samples[i + 2] >= 0.0f)
+			crossings++;
+	}
+
+	float expected = 440.0f * 343.3f / (343.3f - 34.33f);
+	Console::write_line("Doppler shifted 440 Hz to %1 Hz, expected %2 Hz", crossings, StringHelp::float_to_text(expected, 1));
+	check(std::abs(crossings - expected) < 2.0f, "Doppler shift was wrong");
+
+	object.stop();
+	float peaks[2];
+	render_peaks(output, 2, peaks);
+}
+
+void benchmark()
+{
+	SoundOutput_Description desc;
+	desc.set_mixing_frequency(frequency);
+	desc.set_speakers(cl_speakers_5_1);
+	desc.set_max_voices(64);
+	desc.set_offline();
+	SoundOutput output(desc);
+
+	ResourceManager resources;
+	AudioWorld world(resources);
+	SoundBuffer tone = create_tone(frequency);
+
+	const int num_objects = 10000;
+	const int num_playing = 1000;
+	std::vector<AudioObject> objects;
+	for (int i = 0; i < num_objects; i++)
+	{
+		AudioObject object(world);
+		object.set_sound(tone);
+		object.set_looping(true);
+		object.set_attenuation_begin(1.0f);
+		object.set_attenuation_end(50.0f);
+		objects.push_back(object);
+	}
+
+	std::vector<float> samples(frequency / 20 * 6);
+	for (int i = 0; i < num_playing; i++)
+		objects[i].play();
+	output.render(samples.data(), frequency / 20);
+
+	uint64_t total = 0;
+	const int iterations = 100;
+	for (int frame = 0; frame < iterations; frame++)
+	{
+		for (int i = 0; i < num_objects; i++)
+			objects[i].set_position(Vec3f(std::sin(i + frame * 0.1f) * 40.0f, 0.0f, std::cos(i * 0.7f + frame * 0.1f) * 40.0f));
+
+		uint64_t start = System::get_microseconds();
+		world.update();
+		total += System::get_microseconds() - start;
+
+		output.render(samples.data(), frequency / 20);
+	}
+
+	Console::write_line("AudioWorld::update with %1 objects, %2 playing: %3 us", num_objects, num_playing, (int)(total / iterations));
+
+	for (int i = 0; i < num_playing; i++)
+		objects[i].stop();
+	output.render(samples.data(), frequency / 20);
+	objects.clear();
+}
+
+SoundBuffer create_tone(int mixing_frequency)
+{
+	const float pi = 3.14159265f;
+	std::vector<short> data;
+	for (int i = 0; i < mixing_frequency; i++)
+		data.push_back((short)(std::sin(2.0f * pi * 440.0f * i / mixing_frequency) * 0.25f * 32767.0f));
+	return SoundBuffer(new SoundProvider_Raw(data.data(), mixing_frequency, 2, false, mixing_frequency));
+}
+
+void render_peaks(SoundOutput &output, int num_channels, float *peaks)
+{
+	// Volume changes fade in over the first fragment, so leave it out of the peaks
+	std::vector<float> samples(frequency / 5 * num_channels);
+	output.render(samples.data(), frequency / 5);
+
+	for (int i = 0; i < num_channels; i++)
+		peaks[i] = 0.0f;
+	for (size_t i = frequency / 10 * num_channels; i < samples.size(); i++)
+		peaks[i % num_channels] = std::max(peaks[i % num_channels], std::abs(samples[i]));
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
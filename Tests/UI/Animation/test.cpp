@@ -0,0 +1,212 @@
+// Test and benchmark for view animations.
+//
+// Animates 300 views at once and checks that they are stepped from one shared
+// timer: the number of timer wakeups and render requests follows the number of
+// frames rather than the number of views, all views have the same value in
+// every frame, and nothing wakes up once the animations are over. Also checks
+// chained animations, stop_animations called from a setter, and a view removed
+// and destroyed by the animation of another view.
+//
+// Timer callbacks reach the main thread through RunLoop::main_thread_async. This
+// test defines that function itself, so that it can run the queued callbacks in
+// its own loop without a display.
+
+#include "../Headless/headless_view_tree.h"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+using namespace clan;
+
+namespace
+{
+	std::mutex queue_mutex;
+	std::deque<std::function<void()>> queue;
+}
+
+void RunLoop::main_thread_async(std::function<void()> func)
+{
+	std::lock_guard<std::mutex> lock(queue_mutex);
+	queue.push_back(func);
+}
+
+struct AnimationLoop
+{
+	/// Runs queued timer callbacks and renders frames until done returns true or the time runs out
+	void run(HeadlessViewTree &tree, int max_duration_ms, const std::function<bool()> &done);
+
+	int wakeups = 0;
+	int frames = 0;
+	int render_requests = 0;
+	uint64_t last_wakeup_time = 0;
+	std::function<void()> after_wakeup;
+};
+
+void test_shared_timer();
+void test_callbacks();
+void check(bool condition, const std::string &message);
+
+int main(int, char**)
+{
+	try
+	{
+		test_shared_timer();
+		test_callbacks();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void AnimationLoop::run(HeadlessViewTree &tree, int max_duration_ms, const std::function<bool()> &done)
+{
+	uint64_t end_time = System::get_time() + max_duration_ms;
+	while (!done() && System::get_time() < end_time)
+	{
+		std::deque<std::function<void()>> callbacks;
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			callbacks.swap(queue);
+		}
+
+		for (const auto &callback : callbacks)
+		{
+			callback();
+			wakeups++;
+			last_wakeup_time = System::get_time();
+		}
+		if (!callbacks.empty() && after_wakeup)
+			after_wakeup();
+
+		if (tree.render_requests > 0)
+		{
+			render_requests += tree.render_requests;
+			tree.frame();
+			frames++;
+		}
+		System::sleep(1);
+	}
+}
+
+void test_shared_timer()
+{
+	Console::write_line("--- 300 views animating together ---");
+
+	HeadlessViewTree tree(Rectf(0.0f, 0.0f, 800.0f, 6000.0f));
+	tree.root_view()->style()->set("flex-direction: column");
+	const int count = 300;
+	const int duration = 500;
+	std::vector<float> values(count);
+	std::vector<std::shared_ptr<View>> views;
+	for (int i = 0; i < count; i++)
+	{
+		views.push_back(std::make_shared<View>());
+		views.back()->style()->set("flex: none; height: 20px");
+		tree.add_child(views.back());
+	}
+	tree.frame();
+	tree.render_requests = 0;
+
+	int ended = 0;
+	for (int i = 0; i < count; i++)
+	{
+		View *view = views[i].get();
+		view->animate(0.0f, 100.0f, [&values, view, i](float value) { values[i] = value; view->set_needs_render(); }, duration, Easing::linear, [&]() { ended++; });
+	}
+
+	AnimationLoop loop;
+	float max_spread = 0.0f;
+	loop.after_wakeup = [&]()
+	{
+		auto range = std::minmax_element(values.begin(), values.end());
+		max_spread = std::max(max_spread, *range.second - *range.first);
+	};
+	uint64_t start_time = System::get_time();
+	loop.run(tree, 5000, [&]() { return ended == count; });
+	check(ended == count, string_format("Only %1 of %2 animations ended", ended, count));
+	uint64_t animation_time = System::get_time() - start_time;
+
+	// Nothing should wake up once the animations are over
+	int wakeups = loop.wakeups;
+	loop.run(tree, 200, []() { return false; });
+	check(loop.wakeups == wakeups, "Timer kept running after the animations ended");
+
+	for (float value : values)
+		check(value == 100.0f, "Animation did not end at its final value");
+	check(max_spread == 0.0f, string_format("Views were out of lockstep by up to %1", max_spread));
+
+	// One wakeup per frame interval, with plenty of room for a loaded machine
+	int max_wakeups = (int)animation_time / 16 * 2 + 10;
+	check(loop.wakeups <= max_wakeups, string_format("%1 timer wakeups for %2 ms of animation", loop.wakeups, (int)animation_time));
+	check(loop.render_requests <= loop.wakeups + 1, string_format("%1 render requests for %2 wakeups", loop.render_requests, loop.wakeups));
+	Console::write_line("%1 animations of %2 ms: %3 timer wakeups, %4 render requests, %5 frames", count, duration, loop.wakeups, loop.render_requests, loop.frames);
+}
+
+void test_callbacks()
+{
+	Console::write_line("--- Animations changed from animation callbacks ---");
+
+	HeadlessViewTree tree;
+	tree.frame();
+
+	// Each animation starts the next one when it ends
+	int chained = 0;
+	auto chain = std::make_shared<View>();
+	tree.add_child(chain);
+	std::function<void()> next = [&]()
+	{
+		if (++chained < 3)
+			chain->animate(0.0f, 1.0f, [](float) { }, 100, Easing::linear, next);
+	};
+	chain->animate(0.0f, 1.0f, [](float) { }, 100, Easing::linear, next);
+
+	// Removed and destroyed halfway through its own animation by the animation of another view
+	std::weak_ptr<View> doomed_ref;
+	{
+		auto doomed = std::make_shared<View>();
+		doomed_ref = doomed;
+		tree.add_child(doomed);
+		doomed->animate(0.0f, 1.0f, [](float) { }, 1000);
+	}
+	auto killer = std::make_shared<View>();
+	tree.add_child(killer);
+	killer->animate(0.0f, 1.0f, [&](float value)
+	{
+		auto doomed = doomed_ref.lock();
+		if (value > 0.5f && doomed)
+			doomed->remove_from_parent();
+	}, 200);
+
+	// Stops its own animations from a setter, including one that was still running
+	auto stopper = std::make_shared<View>();
+	tree.add_child(stopper);
+	float stopped_value = -1.0f;
+	float other_value = -1.0f;
+	stopper->animate(0.0f, 1.0f, [&](float value)
+	{
+		stopped_value = value;
+		if (value > 0.3f)
+			stopper->stop_animations();
+	}, 200);
+	stopper->animate(0.0f, 1.0f, [&](float value) { other_value = value; }, 200);
+
+	AnimationLoop loop;
+	loop.run(tree, 5000, [&]() { return chained == 3 && doomed_ref.expired() && stopped_value > 0.3f; });
+	float other_value_when_stopped = other_value;
+	loop.run(tree, 300, []() { return false; });
+
+	check(chained == 3, "Chained animations did not all run");
+	check(doomed_ref.expired(), "View removed by another animation was not destroyed");
+	check(stopped_value > 0.3f && stopped_value < 1.0f, "Animation stopped from its setter did not stop");
+	check(other_value == other_value_when_stopped && other_value < 1.0f, "Animation of a stopped view kept running");
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
@@ -0,0 +1,197 @@
+// Test for rendering only the damaged areas of a view tree.
+//
+// Renders a row of boxes with ViewTree::render_damaged and records which areas
+// are cleared and which views are drawn each frame. Checks that an idle frame
+// draws nothing, that set_needs_render, hiding, moving and removing views only
+// redraw the areas they touched, and that the window is told about every change
+// made after a frame, including frames that did layout.
+
+#include "../Headless/headless_view_tree.h"
+#include <algorithm>
+
+using namespace clan;
+
+class Box : public View
+{
+public:
+	Box(const std::string &name, float width, float height) : name(name) { style()->set("flex: none; margin: 5px; width: %1px; height: %2px", width, height); }
+
+	void render_content(Canvas &canvas) override { drawn.push_back(name); }
+
+	std::string name;
+	static std::vector<std::string> drawn;
+};
+
+std::vector<std::string> Box::drawn;
+
+class DamageTree : public HeadlessViewTree
+{
+public:
+	DamageTree() : HeadlessViewTree(Rectf(0.0f, 0.0f, 800.0f, 600.0f)) { root_view()->style()->set("flex-direction: row; align-items: flex-start"); }
+
+	void damaged_frame()
+	{
+		Canvas canvas;
+		Box::drawn.clear();
+		cleared.clear();
+		render_requests = 0;
+		render_damaged(canvas, Rectf(0.0f, 0.0f, 800.0f, 600.0f), [&](const Rectf &box) { cleared.push_back(box); });
+	}
+
+	bool was_drawn(const std::string &name) const { return std::find(Box::drawn.begin(), Box::drawn.end(), name) != Box::drawn.end(); }
+
+	bool was_cleared(const Rectf &box) const
+	{
+		for (const Rectf &area : cleared)
+		{
+			if (area.left <= box.left && area.top <= box.top && area.right >= box.right && area.bottom >= box.bottom)
+				return true;
+		}
+		return false;
+	}
+
+	std::vector<Rectf> cleared;
+};
+
+void test_idle_frame();
+void test_needs_render();
+void test_hide_and_move();
+void test_many_areas();
+void check(bool condition, const std::string &message);
+
+int main(int, char**)
+{
+	try
+	{
+		test_idle_frame();
+		test_needs_render();
+		test_hide_and_move();
+		test_many_areas();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void test_idle_frame()
+{
+	Console::write_line("--- Idle frame ---");
+
+	DamageTree tree;
+	auto a = std::make_shared<Box>("a", 100.0f, 50.0f);
+	tree.add_child(a);
+	tree.damaged_frame();
+	check(tree.was_drawn("a") && tree.was_cleared(Rectf(5.0f, 5.0f, 105.0f, 55.0f)), "First frame did not draw the views");
+
+	tree.damaged_frame();
+	check(tree.cleared.empty() && Box::drawn.empty(), "Idle frame drew something");
+	check(tree.render_requests == 0, "Idle frame asked for another render");
+}
+
+void test_needs_render()
+{
+	Console::write_line("--- Views asking for a render ---");
+
+	DamageTree tree;
+	auto a = std::make_shared<Box>("a", 100.0f, 50.0f);
+	auto b = std::make_shared<Box>("b", 100.0f, 50.0f);
+	auto c = std::make_shared<Box>("c", 100.0f, 50.0f);
+	auto inner = std::make_shared<Box>("inner", 20.0f, 20.0f);
+	tree.add_child(a);
+	tree.add_child(b);
+	tree.add_child(c);
+	b->add_child(inner);
+
+	// The first frame lays out and moves every view, which must not hide the requests made after it
+	tree.damaged_frame();
+	check(tree.render_requests == 0, "Views moved by the layout of a frame asked for another render");
+	inner->set_needs_render();
+	check(tree.render_requests == 1, "Window was not told about a view asking for a render after a layout frame");
+	inner->set_needs_render();
+	c->set_needs_render();
+	check(tree.render_requests == 1, "Window was told more than once before the next frame");
+
+	tree.damaged_frame();
+	check(tree.was_drawn("inner") && tree.was_drawn("b") && tree.was_drawn("c"), "Damaged views were not drawn");
+	check(!tree.was_drawn("a"), "View outside the damaged areas was drawn");
+	check(tree.was_cleared(Rectf(120.0f, 10.0f, 140.0f, 30.0f)) && tree.was_cleared(Rectf(225.0f, 5.0f, 325.0f, 55.0f)), "Damaged areas were not cleared");
+	check(!tree.was_cleared(Rectf(5.0f, 5.0f, 105.0f, 55.0f)), "Area of an unchanged view was cleared");
+
+	// Only the children are inside the area of the view asking for a render
+	b->set_needs_render();
+	tree.damaged_frame();
+	check(tree.was_drawn("b") && tree.was_drawn("inner") && !tree.was_drawn("a") && !tree.was_drawn("c"), "Render of a parent did not draw exactly it and its children");
+}
+
+void test_hide_and_move()
+{
+	Console::write_line("--- Hidden, moved and removed views ---");
+
+	DamageTree tree;
+	auto a = std::make_shared<Box>("a", 100.0f, 50.0f);
+	auto b = std::make_shared<Box>("b", 100.0f, 50.0f);
+	auto c = std::make_shared<Box>("c", 100.0f, 50.0f);
+	auto d = std::make_shared<Box>("d", 100.0f, 50.0f);
+	tree.add_child(a);
+	tree.add_child(b);
+	tree.add_child(c);
+	tree.add_child(d);
+	tree.damaged_frame();
+
+	// Hiding b moves c and d left into its place, 110 pixels apart with the margins
+	b->set_hidden(true);
+	check(tree.render_requests == 1, "Hiding a view did not ask for a render");
+	tree.damaged_frame();
+	check(tree.was_cleared(Rectf(115.0f, 5.0f, 215.0f, 55.0f)) && tree.was_cleared(Rectf(225.0f, 5.0f, 325.0f, 55.0f)) && tree.was_cleared(Rectf(335.0f, 5.0f, 435.0f, 55.0f)), "Areas left by the hidden and moved views were not cleared");
+	check(tree.was_drawn("c") && tree.was_drawn("d") && !tree.was_drawn("b"), "Moved views were not drawn at their new position");
+	check(!tree.was_drawn("a"), "View that did not move was drawn");
+
+	b->set_hidden(false);
+	tree.damaged_frame();
+	check(tree.was_drawn("b") && tree.was_drawn("c") && tree.was_drawn("d") && !tree.was_drawn("a"), "Showing a view did not draw it and the views it moved");
+
+	// Removing the last view only clears its area
+	d->remove_from_parent();
+	tree.damaged_frame();
+	check(tree.was_cleared(Rectf(335.0f, 5.0f, 435.0f, 55.0f)), "Area of the removed view was not cleared");
+	check(Box::drawn.empty(), "Removing the last view drew other views");
+}
+
+void test_many_areas()
+{
+	Console::write_line("--- Many damaged areas ---");
+
+	DamageTree tree;
+	tree.root_view()->style()->set("flex-wrap: wrap");
+	std::vector<std::shared_ptr<Box>> boxes;
+	for (int i = 0; i < 100; i++)
+	{
+		boxes.push_back(std::make_shared<Box>("box" + StringHelp::int_to_text(i), 40.0f, 40.0f));
+		tree.add_child(boxes.back());
+	}
+	tree.damaged_frame();
+
+	// Boxes far enough apart to give separate areas, more than the limit where they are merged
+	for (int i = 0; i < 100; i += 3)
+		boxes[i]->set_needs_render();
+	tree.damaged_frame();
+	check(tree.cleared.size() <= 16, string_format("%1 damaged areas were drawn separately", (int)tree.cleared.size()));
+	for (int i = 0; i < 100; i += 3)
+		check(tree.was_cleared(boxes[i]->geometry().border_box()), "Merged areas do not cover the damaged views");
+
+	boxes[0]->set_needs_render();
+	boxes[10]->set_needs_render();
+	tree.damaged_frame();
+	check(tree.cleared.size() == 2, "Two separate damaged views were not drawn as two areas");
+	check(Box::drawn.size() == 2 && tree.was_drawn("box0") && tree.was_drawn("box10"), "Views outside two small areas were drawn");
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
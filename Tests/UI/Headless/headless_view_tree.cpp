@@ -0,0 +1,105 @@
+#include "headless_view_tree.h"
+#include <cmath>
+#include <vector>
+
+using namespace clan;
+
+int HeadlessCounters::fills = 0;
+int HeadlessCounters::draw_text = 0;
+int HeadlessCounters::measure_text = 0;
+
+namespace
+{
+	Mat4f transform = Mat4f::identity();
+	std::vector<Rectf> cliprects;
+}
+
+void HeadlessViewTree::frame()
+{
+	Canvas canvas;
+	render_requests = 0;
+	render_damaged(canvas, viewport);
+}
+
+float GraphicContext::get_pixel_ratio() const
+{
+	return 1.0f;
+}
+
+Pointf Canvas::grid_fit(const Pointf &pos)
+{
+	return Pointf(std::round(pos.x), std::round(pos.y));
+}
+
+Rectf Canvas::get_cliprect() const
+{
+	return cliprects.empty() ? Rectf(0.0f, 0.0f, 1.0e6f, 1.0e6f) : cliprects.back();
+}
+
+void Canvas::push_cliprect(const Rectf &rect)
+{
+	Rectf cliprect = get_cliprect();
+	cliprect.overlap(rect);
+	cliprects.push_back(cliprect);
+}
+
+void Canvas::pop_cliprect()
+{
+	cliprects.pop_back();
+}
+
+const Mat4f &Canvas::get_transform() const
+{
+	return transform;
+}
+
+void Canvas::set_transform(const Mat4f &matrix)
+{
+	transform = matrix;
+}
+
+void Path::fill(Canvas &canvas, const Brush &brush)
+{
+	HeadlessCounters::fills++;
+}
+
+void Path::stroke(Canvas &canvas, const Pen &pen)
+{
+}
+
+Font StyleCascade::font(Canvas &canvas) const
+{
+	return Font();
+}
+
+FontMetrics Font::get_font_metrics(Canvas &canvas) const
+{
+	return FontMetrics(16.0f, 12.0f, 4.0f, 0.0f, 0.0f, 16.0f, 1.0f);
+}
+
+void Font::draw_text(Canvas &canvas, const Pointf &position, const std::string &text, const Colorf &color)
+{
+	HeadlessCounters::draw_text++;
+}
+
+GlyphMetrics Font::measure_text(Canvas &canvas, const std::string &text) const
+{
+	HeadlessCounters::measure_text++;
+	float width = 8.0f * StringHelp::utf8_length(text);
+	return GlyphMetrics(Pointf(), Sizef(width, 16.0f), Sizef(width, 0.0f));
+}
+
+std::vector<Rectf> Font::get_character_indices(Canvas &canvas, const std::string &text) const
+{
+	HeadlessCounters::measure_text++;
+	std::vector<Rectf> rects;
+	UTF8_Reader reader(text.data(), text.length());
+	float x = 0.0f;
+	while (!reader.is_end())
+	{
+		rects.push_back(Rectf(x, -12.0f, x + 8.0f, 4.0f));
+		x += 8.0f;
+		reader.next();
+	}
+	return rects;
+}
@@ -0,0 +1,51 @@
+// Support for running the UI tests without a display.
+//
+// headless_view_tree.cpp defines the few clanDisplay functions that layout and
+// rendering call which need a graphic context: canvas transforms and clipping,
+// path filling and the font functions. Definitions in the executable take the
+// place of the ones in the shared library, so this only works where symbols
+// can be interposed that way, such as Linux. Fonts become an 8 pixel wide
+// monospace font that is 16 pixels high, and nothing is drawn.
+
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <ClanLib/ui.h>
+
+/// \brief View tree that renders into the headless canvas
+class HeadlessViewTree : public clan::ViewTree
+{
+public:
+	HeadlessViewTree(const clan::Rectf &viewport = clan::Rectf(0.0f, 0.0f, 800.0f, 600.0f)) : viewport(viewport) { }
+
+	clan::DisplayWindow display_window() override { return clan::DisplayWindow(); }
+	clan::Canvas canvas() const override { return clan::Canvas(); }
+
+	/// \brief Lays out and renders the views covering the areas changed since the last frame
+	void frame();
+
+	/// \brief Sets the canvas area the tree is rendered into
+	void set_viewport(const clan::Rectf &new_viewport) { viewport = new_viewport; }
+
+	/// \brief Number of set_needs_render calls since the last frame
+	int render_requests = 0;
+
+protected:
+	void set_needs_render() override { render_requests++; }
+	clan::Pointf client_to_screen_pos(const clan::Pointf &pos) override { return pos; }
+	clan::Pointf screen_to_client_pos(const clan::Pointf &pos) override { return pos; }
+
+private:
+	clan::Rectf viewport;
+};
+
+/// \brief Counts of the calls that would have reached the graphic context
+struct HeadlessCounters
+{
+	static int fills;
+	static int draw_text;
+	static int measure_text;
+
+	static void reset() { fills = 0; draw_text = 0; measure_text = 0; }
+};
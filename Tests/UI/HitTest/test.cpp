@@ -0,0 +1,207 @@
+// Test and benchmark for pointer hit testing.
+//
+// View::find_view_at uses a spatial index for views with many children. This
+// compares it against a plain linear search of the children, in reverse drawing
+// order, at random points over trees with overlapping, hidden, moved and
+// transformed children. It then times both on views with 10,000 children.
+
+#include "../Headless/headless_view_tree.h"
+#include <random>
+
+using namespace clan;
+
+void test_overlapping();
+void test_transformed();
+void test_changes();
+void benchmark();
+void compare(View *root, const Rectf &area, const std::string &name);
+std::shared_ptr<View> linear_find_view_at(const View *view, const Pointf &pos);
+std::shared_ptr<View> add_box(View *parent, float x, float y, float width, float height);
+void check(bool condition, const std::string &message);
+
+int main(int, char**)
+{
+	try
+	{
+		test_overlapping();
+		test_transformed();
+		test_changes();
+		benchmark();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void test_overlapping()
+{
+	Console::write_line("--- Overlapping children ---");
+
+	HeadlessViewTree tree(Rectf(0.0f, 0.0f, 1000.0f, 1000.0f));
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-50.0f, 950.0f);
+	std::uniform_real_distribution<float> size(0.0f, 250.0f);
+	for (int i = 0; i < 2000; i++)
+	{
+		auto box = add_box(tree.root_view().get(), position(random), position(random), size(random), size(random));
+		if (i % 7 == 0)
+			box->set_hidden(true);
+	}
+	tree.frame();
+
+	compare(tree.root_view().get(), Rectf(-100.0f, -100.0f, 1300.0f, 1300.0f), "overlapping children");
+}
+
+void test_transformed()
+{
+	Console::write_line("--- Transformed children ---");
+
+	HeadlessViewTree tree(Rectf(0.0f, 0.0f, 1000.0f, 1000.0f));
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float> position(0.0f, 900.0f);
+	std::uniform_real_distribution<float> size(10.0f, 200.0f);
+
+	// Containers with enough children of their own to get an index, drawn with rotations, scaling and offsets
+	for (int i = 0; i < 40; i++)
+	{
+		auto container = add_box(tree.root_view().get(), position(random), position(random), 300.0f, 300.0f);
+		for (int j = 0; j < 50; j++)
+			add_box(container.get(), position(random) / 3.0f, position(random) / 3.0f, size(random), size(random));
+
+		if (i % 3 == 0)
+			container->set_view_transform(Mat4f::rotate(Angle((float)(i * 10), angle_degrees), 0.0f, 0.0f, 1.0f, false));
+		else if (i % 3 == 1)
+			container->set_view_transform(Mat4f::scale(2.0f, 0.5f, 1.0f) * Mat4f::translate(-30.0f, 40.0f, 0.0f));
+	}
+	tree.frame();
+
+	compare(tree.root_view().get(), Rectf(-100.0f, -100.0f, 1300.0f, 1300.0f), "transformed children");
+}
+
+void test_changes()
+{
+	Console::write_line("--- Children changed after the index was built ---");
+
+	HeadlessViewTree tree(Rectf(0.0f, 0.0f, 1000.0f, 1000.0f));
+	std::vector<std::shared_ptr<View>> boxes;
+	for (int i = 0; i < 100; i++)
+		boxes.push_back(add_box(tree.root_view().get(), (float)(i % 10) * 100.0f, (float)(i / 10) * 100.0f, 100.0f, 100.0f));
+	tree.frame();
+	View *root = tree.root_view().get();
+
+	check(root->find_view_at(Pointf(150.0f, 50.0f)) == boxes[1], "Wrong view found in the grid");
+
+	boxes[1]->set_hidden(true);
+	check(root->find_view_at(Pointf(150.0f, 50.0f)) == nullptr, "Hidden view was found");
+	boxes[1]->set_hidden(false);
+	check(root->find_view_at(Pointf(150.0f, 50.0f)) == boxes[1], "View shown again was not found");
+
+	boxes[2]->style()->set("left: 2000px; top: 2000px");
+	tree.frame();
+	check(root->find_view_at(Pointf(250.0f, 50.0f)) == nullptr, "View was found where it was before it moved");
+	check(root->find_view_at(Pointf(2050.0f, 2050.0f)) == boxes[2], "Moved view was not found at its new position");
+
+	auto top = add_box(root, 140.0f, 40.0f, 20.0f, 20.0f);
+	tree.frame();
+	check(root->find_view_at(Pointf(150.0f, 50.0f)) == top, "Added view is not found above the views drawn before it");
+	top->remove_from_parent();
+	check(root->find_view_at(Pointf(150.0f, 50.0f)) == boxes[1], "Removed view was found");
+
+	compare(root, Rectf(-100.0f, -100.0f, 2200.0f, 2200.0f), "changed children");
+}
+
+void benchmark()
+{
+	Console::write_line("--- Hit testing 10,000 children ---");
+
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> coordinate(0.0f, 2000.0f);
+	std::vector<Pointf> points;
+	for (int i = 0; i < 20000; i++)
+		points.push_back(Pointf(coordinate(random), coordinate(random)));
+
+	for (int layout = 0; layout < 3; layout++)
+	{
+		HeadlessViewTree tree(Rectf(0.0f, 0.0f, 2000.0f, 2000.0f));
+		View *root = tree.root_view().get();
+		std::string name = layout == 0 ? "grid" : layout == 1 ? "random overlapping boxes" : "thin columns";
+		std::uniform_real_distribution<float> size(1.0f, 300.0f);
+		for (int i = 0; i < 10000; i++)
+		{
+			if (layout == 0)
+				add_box(root, (float)(i % 100) * 20.0f, (float)(i / 100) * 20.0f, 18.0f, 18.0f);
+			else if (layout == 1)
+				add_box(root, coordinate(random), coordinate(random), size(random), size(random));
+			else
+				add_box(root, (float)(i % 2000), 0.0f, 1.0f, 2000.0f);
+		}
+		tree.frame();
+		root->find_view_at(Pointf());
+
+		int hits = 0;
+		uint64_t start_time = System::get_microseconds();
+		for (const auto &point : points)
+			hits += root->find_view_at(point) ? 1 : 0;
+		uint64_t indexed_time = System::get_microseconds() - start_time;
+
+		start_time = System::get_microseconds();
+		for (const auto &point : points)
+			hits -= linear_find_view_at(root, point) ? 1 : 0;
+		uint64_t linear_time = System::get_microseconds() - start_time;
+
+		check(hits == 0, "Hit count differs from a linear search for " + name);
+		Console::write_line("%1: %2 us per lookup, linear search %3 us", name, indexed_time / (double)points.size(), linear_time / (double)points.size());
+	}
+}
+
+void compare(View *root, const Rectf &area, const std::string &name)
+{
+	std::mt19937 random(4);
+	std::uniform_real_distribution<float> x(area.left, area.right);
+	std::uniform_real_distribution<float> y(area.top, area.bottom);
+	int hits = 0;
+	for (int i = 0; i < 20000; i++)
+	{
+		Pointf pos(x(random), y(random));
+		std::shared_ptr<View> found = root->find_view_at(pos);
+		check(found == linear_find_view_at(root, pos), string_format("Hit test for %1 differs from a linear search at %2, %3", name, pos.x, pos.y));
+		hits += found ? 1 : 0;
+	}
+	check(hits > 1000, "Too few points hit a view for " + name);
+}
+
+// View::find_view_at without the index
+std::shared_ptr<View> linear_find_view_at(const View *view, const Pointf &pos)
+{
+	const auto &children = view->children();
+	for (size_t i = children.size(); i > 0; i--)
+	{
+		const std::shared_ptr<View> &child = children[i - 1];
+		if (child->hidden() || !child->geometry().border_box().contains(pos))
+			continue;
+
+		Pointf child_content_pos(pos.x - child->geometry().content_x, pos.y - child->geometry().content_y);
+		child_content_pos = Vec2f(Mat4f::inverse(child->view_transform()) * Vec4f(child_content_pos, 0.0f, 1.0f));
+		std::shared_ptr<View> found = linear_find_view_at(child.get(), child_content_pos);
+		return found ? found : child;
+	}
+	return std::shared_ptr<View>();
+}
+
+std::shared_ptr<View> add_box(View *parent, float x, float y, float width, float height)
+{
+	auto box = std::make_shared<View>();
+	box->style()->set("position: absolute; left: %1px; top: %2px; width: %3px; height: %4px", x, y, width, height);
+	parent->add_child(box);
+	return box;
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
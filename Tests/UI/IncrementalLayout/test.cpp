@@ -0,0 +1,246 @@
+// Test for incremental layout.
+//
+// Builds a deep tree of boxes, changes the size of one leaf and checks that the
+// next frame gives the same geometry as laying out an identical tree from
+// scratch, while the views outside the changed branch are not laid out again.
+// Also checks that absolute and fixed positioned views are placed when they sit
+// below a layout_children override that lays out its children by itself, and
+// that fixed positioned views follow an ancestor that only moved.
+
+#include "../Headless/headless_view_tree.h"
+#include <cstdlib>
+
+using namespace clan;
+
+class Box : public View
+{
+public:
+	Box(const std::string &style_text) { style()->set(style_text); }
+
+	void layout_children(Canvas &canvas) override
+	{
+		layout_count++;
+		View::layout_children(canvas);
+	}
+
+	float calculate_preferred_width(Canvas &canvas) override { return View::calculate_preferred_width(canvas) + extra; }
+	float calculate_preferred_height(Canvas &canvas, float width) override { return View::calculate_preferred_height(canvas, width) + extra; }
+
+	int layout_count = 0;
+	float extra = 0.0f;
+};
+
+// Lays out its children without calling View::layout_children, like many custom views do
+class StackBox : public Box
+{
+public:
+	StackBox() : Box("flex: none; height: 60px") { }
+
+	void layout_children(Canvas &canvas) override
+	{
+		layout_count++;
+		float y = 0.0f;
+		for (const auto &child : children())
+		{
+			if (!child->is_static_position_and_visible())
+				continue;
+
+			float height = child->preferred_height(canvas, geometry().content_width);
+			child->set_geometry(ViewGeometry::from_margin_box(child->style_cascade(), Rectf(0.0f, y, geometry().content_width, y + height)));
+			child->layout_children(canvas);
+			y += height;
+		}
+	}
+};
+
+struct TestTree
+{
+	TestTree();
+
+	HeadlessViewTree tree;
+	std::vector<std::vector<std::shared_ptr<Box>>> branches;
+	std::shared_ptr<Box> fixed;
+	std::shared_ptr<StackBox> stack;
+	std::shared_ptr<Box> stack_absolute;
+	std::shared_ptr<Box> stack_fixed;
+};
+
+void test_leaf_change();
+void test_custom_layout();
+void test_moved_ancestor();
+void compare_geometry(View *view, View *expected, const std::string &path);
+int layout_count(View *view);
+void check(bool condition, const std::string &message);
+
+const int branch_count = 20;
+const int branch_depth = 12;
+
+int main(int, char**)
+{
+	try
+	{
+		test_leaf_change();
+		test_custom_layout();
+		test_moved_ancestor();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+TestTree::TestTree() : tree(Rectf(0.0f, 0.0f, 800.0f, 100000.0f))
+{
+	tree.root_view()->style()->set("flex-direction: column");
+
+	// Each branch is a chain of nested boxes with a sized leaf at the bottom and a small sibling at every level
+	for (int i = 0; i < branch_count; i++)
+	{
+		std::vector<std::shared_ptr<Box>> chain;
+		std::shared_ptr<View> parent = tree.root_view();
+		for (int depth = 0; depth < branch_depth; depth++)
+		{
+			auto box = std::make_shared<Box>(depth % 2 ? "flex: none; flex-direction: row; padding: 1px" : "flex: none; flex-direction: column; padding: 1px");
+			parent->add_child(box);
+			parent->add_child(std::make_shared<Box>("flex: none; width: 5px; height: 5px"));
+			chain.push_back(box);
+			parent = box;
+		}
+		chain.back()->extra = 10.0f;
+		branches.push_back(chain);
+	}
+
+	// Placed relative to the root, but inside the last branch
+	fixed = std::make_shared<Box>("position: fixed; left: 10px; top: 20px; width: 30px; height: 40px");
+	branches.back()[branch_depth / 2]->add_child(fixed);
+
+	stack = std::make_shared<StackBox>();
+	tree.root_view()->add_child(stack);
+	auto stack_child = std::make_shared<Box>("flex: none; height: 30px");
+	stack->add_child(stack_child);
+	stack_absolute = std::make_shared<Box>("position: absolute; left: 5px; top: 6px; width: 7px; height: 8px");
+	stack_child->add_child(stack_absolute);
+	stack_fixed = std::make_shared<Box>("position: fixed; left: 1px; top: 2px; width: 3px; height: 4px");
+	stack_child->add_child(stack_fixed);
+
+	tree.frame();
+}
+
+void test_leaf_change()
+{
+	Console::write_line("--- Leaf change in a deep tree ---");
+
+	TestTree incremental;
+	const int changed_branch = 3;
+	std::shared_ptr<Box> leaf = incremental.branches[changed_branch].back();
+
+	int count_before = layout_count(incremental.tree.root_view().get());
+	incremental.tree.frame();
+	check(layout_count(incremental.tree.root_view().get()) == count_before, "An idle frame should lay out nothing");
+
+	std::vector<int> counts_before;
+	for (const auto &chain : incremental.branches)
+		counts_before.push_back(layout_count(chain.front().get()));
+
+	uint64_t start_time = System::get_microseconds();
+	leaf->extra = 25.0f;
+	leaf->set_needs_layout();
+	incremental.tree.frame();
+	uint64_t incremental_time = System::get_microseconds() - start_time;
+
+	// Reference tree with the same change made before its first layout
+	start_time = System::get_microseconds();
+	TestTree full;
+	uint64_t full_time = System::get_microseconds() - start_time;
+	full.branches[changed_branch].back()->extra = 25.0f;
+	full.branches[changed_branch].back()->set_needs_layout();
+	full.tree.frame();
+
+	compare_geometry(incremental.tree.root_view().get(), full.tree.root_view().get(), "root");
+
+	for (int i = 0; i < branch_count; i++)
+	{
+		int laid_out = layout_count(incremental.branches[i].front().get()) - counts_before[i];
+		if (i == changed_branch)
+			check(laid_out == branch_depth, string_format("Changed branch should lay out its %1 boxes once, laid out %2", branch_depth, laid_out));
+		else
+			check(laid_out == 0, string_format("Branch %1 outside the change was laid out %2 times", i, laid_out));
+	}
+	check(incremental.fixed->geometry().content_box() == full.fixed->geometry().content_box(), "Fixed view in a moved branch is not where a full layout puts it");
+
+	Console::write_line("Incremental frame: %1 us, full layout of a new tree: %2 us", (int)incremental_time, (int)full_time);
+}
+
+void test_custom_layout()
+{
+	Console::write_line("--- Positioned views below a custom layout ---");
+
+	TestTree test;
+	Rectf absolute_box = test.stack_absolute->geometry().content_box();
+	check(absolute_box == Rectf(5.0f, 6.0f, 12.0f, 14.0f), "Absolute view below a custom layout was not placed");
+
+	// The fixed view sits at the top left of the root, whatever the stack box offset is
+	Pointf offset;
+	for (View *view = test.stack_fixed->parent(); view; view = view->parent())
+		offset += Pointf(view->geometry().content_x, view->geometry().content_y);
+	Rectf fixed_box = test.stack_fixed->geometry().content_box();
+	fixed_box.translate(offset);
+	check(fixed_box == Rectf(1.0f, 2.0f, 4.0f, 6.0f), "Fixed view below a custom layout was not placed");
+
+	// Layout flags below the custom layout must be cleared, or every frame lays them out again
+	test.stack->set_needs_layout();
+	test.tree.frame();
+	check(!test.stack_absolute->needs_layout() && !test.stack_absolute->parent()->needs_layout(), "Views below a custom layout still need layout after a frame");
+	int count = layout_count(test.stack.get());
+	test.tree.frame();
+	check(layout_count(test.stack.get()) == count, "Views below a custom layout are laid out again by an idle frame");
+}
+
+void test_moved_ancestor()
+{
+	Console::write_line("--- Fixed view below a moved ancestor ---");
+
+	TestTree test;
+	Rectf before = test.fixed->geometry().content_box();
+
+	// Growing the first branch only moves the branches after it
+	test.branches.front().back()->extra = 50.0f;
+	test.branches.front().back()->set_needs_layout();
+	test.tree.frame();
+
+	Pointf offset;
+	for (View *view = test.fixed->parent(); view; view = view->parent())
+		offset += Pointf(view->geometry().content_x, view->geometry().content_y);
+	Rectf fixed_box = test.fixed->geometry().content_box();
+	fixed_box.translate(offset);
+	check(fixed_box == Rectf(10.0f, 20.0f, 40.0f, 60.0f), "Fixed view did not stay in place when its ancestors moved");
+	check(test.fixed->geometry().content_box() != before, "Fixed view should move relative to its moved parent");
+}
+
+void compare_geometry(View *view, View *expected, const std::string &path)
+{
+	check(view->geometry().content_box() == expected->geometry().content_box(), "Geometry differs from a full layout at " + path);
+	check(view->children().size() == expected->children().size(), "Tree shape differs at " + path);
+	for (size_t i = 0; i < view->children().size(); i++)
+		compare_geometry(view->children()[i].get(), expected->children()[i].get(), path + "/" + StringHelp::int_to_text((int)i));
+}
+
+int layout_count(View *view)
+{
+	int count = 0;
+	Box *box = dynamic_cast<Box *>(view);
+	if (box)
+		count += box->layout_count;
+	for (const auto &child : view->children())
+		count += layout_count(child.get());
+	return count;
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
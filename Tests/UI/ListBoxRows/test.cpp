@@ -0,0 +1,215 @@
+// Test and benchmark for ListBoxView with on demand rows.
+//
+// Shows 50,000 items in a list box and scrolls through them with a frame per
+// step. Checks that only the rows around the visible area exist, that every
+// visible item has exactly one row placed at its position, that recycled rows
+// do not keep the selected state of their previous item, and that changing the
+// item count and going back to item views work. Prints the time per frame.
+
+#include "../Headless/headless_view_tree.h"
+#include <set>
+
+using namespace clan;
+
+class Row : public View
+{
+public:
+	Row() { style()->set("height: 20px"); }
+
+	int index = -1;
+};
+
+struct ListTest
+{
+	ListTest(int item_count);
+
+	void check_rows();
+	int row_count() const;
+
+	HeadlessViewTree tree;
+	std::shared_ptr<ListBoxView> list;
+	std::vector<Row *> rows;
+	int updates = 0;
+};
+
+void test_scrolling();
+void test_selection();
+void test_item_count();
+void check(bool condition, const std::string &message);
+
+const float row_height = 20.0f;
+const int overscan = 2;
+
+int main(int, char**)
+{
+	try
+	{
+		test_scrolling();
+		test_selection();
+		test_item_count();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+ListTest::ListTest(int item_count) : tree(Rectf(0.0f, 0.0f, 200.0f, 400.0f))
+{
+	list = std::make_shared<ListBoxView>();
+	list->style()->set("flex: auto");
+	tree.add_child(list);
+
+	list->set_items(item_count, [this]()
+	{
+		auto row = std::make_shared<Row>();
+		rows.push_back(row.get());
+		return row;
+	},
+	[this](const std::shared_ptr<View> &row, int index)
+	{
+		static_cast<Row *>(row.get())->index = index;
+		updates++;
+	});
+
+	tree.frame();
+}
+
+// Checks that each item in view has one row at its position, with the state of the item
+void ListTest::check_rows()
+{
+	float viewport_height = list->viewport_size().height;
+	int first = (int)(list->content_offset().y / row_height);
+	int last = std::min((int)std::ceil((list->content_offset().y + viewport_height) / row_height), list->item_count());
+
+	std::set<int> shown;
+	for (Row *row : rows)
+	{
+		if (row->hidden())
+			continue;
+
+		check(row->index >= 0 && row->index < list->item_count(), string_format("Row is bound to item %1, which does not exist", row->index));
+		check(shown.insert(row->index).second, string_format("Item %1 has two rows", row->index));
+		check(row->geometry().margin_box().top == row->index * row_height, string_format("Row for item %1 is at the wrong position", row->index));
+		check(row->state("selected") == (row->index == list->selected_item()), string_format("Row for item %1 has the wrong selected state", row->index));
+	}
+
+	for (int index = first; index < last; index++)
+		check(shown.count(index) == 1, string_format("Item %1 is in view but has no row", index));
+
+	// Rows are only moved once the view leaves the window of items they were laid out for, which includes the overscan
+	int window = (int)std::ceil(viewport_height / row_height) + 1 + 2 * overscan;
+	check(shown.empty() || *shown.rbegin() - *shown.begin() < window, string_format("Rows for items %1 to %2 exist while items %3 to %4 are in view", *shown.begin(), *shown.rbegin(), first, last));
+}
+
+int ListTest::row_count() const
+{
+	return (int)rows.size();
+}
+
+void test_scrolling()
+{
+	Console::write_line("--- Scrolling 50,000 items ---");
+
+	ListTest test(50000);
+	int rows_in_view = (int)std::ceil(test.list->viewport_size().height / row_height) + 1;
+	check(test.row_count() <= rows_in_view + 2 * overscan, string_format("%1 rows were created for %2 rows in view", test.row_count(), rows_in_view));
+	check(test.list->scrollbar_y_view()->max_position() == 50000 * row_height - test.list->viewport_size().height, "Scroll range does not cover all items");
+	test.check_rows();
+
+	// Scroll down by less than a row at a time, so each item enters the window once
+	const int frames = 5000;
+	test.updates = 0;
+	uint64_t start_time = System::get_microseconds();
+	for (int i = 1; i <= frames; i++)
+	{
+		test.list->set_content_offset(Pointf(0.0f, i * 7.0f));
+		test.tree.frame();
+	}
+	uint64_t scroll_time = System::get_microseconds() - start_time;
+	test.check_rows();
+
+	int items_scrolled = (int)(frames * 7.0f / row_height);
+	check(test.row_count() <= rows_in_view + 2 * overscan, string_format("Scrolling created %1 rows", test.row_count()));
+	check(test.updates <= items_scrolled + rows_in_view + 2 * overscan, string_format("%1 row updates for %2 items scrolled into view", test.updates, items_scrolled));
+	Console::write_line("scrolling: %1 us per frame, %2 rows", scroll_time / (double)frames, test.row_count());
+
+	// Jumps far down the list reuse the same rows
+	start_time = System::get_microseconds();
+	for (int i = 0; i < 100; i++)
+	{
+		test.list->set_content_offset(Pointf(0.0f, (float)((i * 7919) % 50000) * row_height));
+		test.tree.frame();
+		test.check_rows();
+	}
+	check(test.row_count() <= rows_in_view + 2 * overscan, "Jumping through the list created rows");
+	Console::write_line("jumping: %1 us per frame", (System::get_microseconds() - start_time) / 100.0);
+
+	// An idle frame must not touch the rows
+	test.updates = 0;
+	test.tree.frame();
+	check(test.updates == 0, "Idle frame updated rows");
+}
+
+void test_selection()
+{
+	Console::write_line("--- Selection ---");
+
+	ListTest test(50000);
+	test.list->set_selected_item(40000);
+	check(test.list->selected_item() == 40000, "Item was not selected");
+	check(test.list->content_offset().y == 40001 * row_height - test.list->viewport_size().height, "Selected item was not scrolled into view");
+	test.tree.frame();
+	test.check_rows();
+
+	// The row of the selected item goes back to the pool and is bound to items that are not selected
+	for (int i = 0; i < 50; i++)
+	{
+		test.list->set_content_offset(Pointf(0.0f, (39000.0f + i * 40.0f) * row_height));
+		test.tree.frame();
+		test.check_rows();
+	}
+
+	test.list->set_selected_item(3);
+	check(test.list->content_offset().y == 3 * row_height, "Selected item above the view was not scrolled into view");
+	test.tree.frame();
+	test.check_rows();
+}
+
+void test_item_count()
+{
+	Console::write_line("--- Item count changes ---");
+
+	ListTest test(50000);
+	test.list->set_selected_item(100);
+	test.tree.frame();
+
+	test.list->set_item_count(10);
+	test.tree.frame();
+	check(test.list->item_count() == 10, "Item count did not change");
+	check(test.list->selected_item() == -1, "Selection of an item that no longer exists was kept");
+	check(test.list->content_offset().y == 0.0f, "List is scrolled past its items");
+	test.check_rows();
+
+	test.list->set_item_count(0);
+	test.tree.frame();
+	for (Row *row : test.rows)
+		check(row->hidden(), "Row is shown without any items");
+
+	std::vector<std::shared_ptr<View>> items;
+	for (int i = 0; i < 5; i++)
+		items.push_back(std::make_shared<View>());
+	test.list->set_items(items);
+	test.tree.frame();
+	check(test.list->item_count() == 5, "Item views were not used after on demand rows");
+	check(items[4]->parent() == test.list->content_view().get(), "Item views were not added to the list");
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
@@ -0,0 +1,232 @@
+// Test and benchmark for StyleCascade.
+//
+// Checks inheritance, em lengths following font-size changes at any level of
+// the chain, edits to styles and cascades, the generation numbers used by the
+// layout caches, and that lookups by StylePropertyId agree with lookups by
+// name. Then times computed_value lookups on a deep chain of cascades.
+
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <ClanLib/ui.h>
+
+using namespace clan;
+
+void test_inheritance();
+void test_em_lengths();
+void test_cascade_edits();
+void test_generations();
+void test_property_ids();
+void benchmark();
+void check(bool condition, const std::string &message);
+
+int main(int, char**)
+{
+	try
+	{
+		test_inheritance();
+		test_em_lengths();
+		test_cascade_edits();
+		test_generations();
+		test_property_ids();
+		benchmark();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void test_inheritance()
+{
+	Console::write_line("--- Inheritance ---");
+
+	Style root_style, child_style;
+	root_style.set("color: red; width: 10px; font-size: 20px");
+	StyleCascade root({ &root_style });
+	StyleCascade child({ &child_style }, &root);
+	StyleCascade grandchild({ &child_style }, &child);
+
+	check(grandchild.computed_value("color").color() == Colorf(1.0f, 0.0f, 0.0f), "Color was not inherited through two levels");
+	check(child.computed_value("width").is_keyword("auto"), "Width was inherited");
+	check(grandchild.computed_value("font-size").number() == 20.0f, "Font size was not inherited");
+
+	child_style.set("color: blue");
+	check(grandchild.computed_value("color").color() == Colorf(0.0f, 0.0f, 1.0f), "Inherited color did not follow a change in the middle of the chain");
+	check(root.computed_value("color").color() == Colorf(1.0f, 0.0f, 0.0f), "Change to a child style reached the parent");
+
+	child_style.set("color: inherit");
+	check(grandchild.computed_value("color").color() == Colorf(1.0f, 0.0f, 0.0f), "Explicit inherit did not use the parent value");
+
+	root_style.set("width: inherit");
+	check(root.computed_value("width").is_keyword("auto"), "Inherit without a parent did not give the initial value");
+}
+
+void test_em_lengths()
+{
+	Console::write_line("--- Em lengths ---");
+
+	Style root_style, child_style;
+	root_style.set("font-size: 20px");
+	child_style.set("padding-left: 2em");
+	StyleCascade root({ &root_style });
+	StyleCascade child({ &child_style }, &root);
+
+	check(child.computed_value("padding-left").number() == 40.0f, "Em length did not use the inherited font size");
+
+	root_style.set("font-size: 10px");
+	check(child.computed_value("padding-left").number() == 20.0f, "Em length did not follow the parent font size");
+
+	child_style.set("font-size: 5px");
+	check(child.computed_value("padding-left").number() == 10.0f, "Em length did not follow the own font size");
+
+	child_style.set("font-size: 3em");
+	check(child.computed_value("font-size").number() == 30.0f, "Em font size was not relative to the parent font size");
+	check(child.computed_value("padding-left").number() == 60.0f, "Em length did not use an em font size");
+
+	root_style.set("font-size: 4px");
+	check(child.computed_value("padding-left").number() == 24.0f, "Em length did not follow a change two levels up");
+}
+
+void test_cascade_edits()
+{
+	Console::write_line("--- Cascade edits ---");
+
+	Style root_style, normal, hot, other_root_style;
+	root_style.set("font-size: 10px");
+	other_root_style.set("font-size: 30px");
+	normal.set("padding-left: 1em; background-color: white");
+	hot.set("padding-left: 3px");
+	StyleCascade root({ &root_style });
+	StyleCascade other_root({ &other_root_style });
+	StyleCascade child({ &normal }, &root);
+
+	check(child.computed_value("padding-left").number() == 10.0f, "Wrong value before the cascade changed");
+
+	child.cascade.insert(child.cascade.begin(), &hot);
+	child.invalidate();
+	check(child.computed_value("padding-left").number() == 3.0f, "Style added in front of the cascade did not win");
+	check(child.computed_value("background-color").color() == Colorf::white, "Style later in the cascade was not used for other properties");
+
+	child.cascade.erase(child.cascade.begin());
+	child.invalidate();
+	check(child.computed_value("padding-left").number() == 10.0f, "Removed style was still used");
+
+	child.parent = &other_root;
+	child.invalidate();
+	check(child.computed_value("padding-left").number() == 30.0f, "New parent was not used for the font size");
+
+	normal.set("padding-left: 2px");
+	check(child.computed_value("padding-left").number() == 2.0f, "Change to a style in the cascade was not seen without invalidate");
+}
+
+void test_generations()
+{
+	Console::write_line("--- Generations ---");
+
+	Style root_style, layout_style, paint_style;
+	root_style.set("font-size: 10px");
+	layout_style.set("width: 10px");
+	paint_style.set("background-color: red");
+	StyleCascade root({ &root_style });
+	StyleCascade child({ &paint_style, &layout_style }, &root);
+	child.computed_value("width");
+
+	unsigned int generation = child.generation();
+	unsigned int layout_generation = child.layout_generation();
+	check(child.generation() == generation && child.layout_generation() == layout_generation, "Generations changed without any change");
+
+	paint_style.set("background-color: blue");
+	check(child.generation() != generation, "Generation did not change with a paint property");
+	check(child.layout_generation() == layout_generation, "Layout generation changed with a paint property");
+	check(child.computed_value("background-color").color() == Colorf(0.0f, 0.0f, 1.0f), "Paint property change was not seen");
+
+	generation = child.generation();
+	layout_style.set("width: 20px");
+	check(child.generation() != generation && child.layout_generation() != layout_generation, "Generations did not change with a layout property");
+
+	layout_generation = child.layout_generation();
+	root_style.set("font-size: 20px");
+	check(child.layout_generation() != layout_generation, "Layout generation did not change with the parent font size");
+
+	check(!StyleCascade::affects_layout(&paint_style), "Background color counted as a layout property");
+	check(StyleCascade::affects_layout(&layout_style), "Width did not count as a layout property");
+}
+
+void test_property_ids()
+{
+	Console::write_line("--- Property ids ---");
+
+	StylePropertyId padding_left("padding-left");
+	check(StylePropertyId(std::string("padding-left")) == padding_left, "Same name gave two ids");
+	check(StylePropertyId("padding-right") != padding_left, "Different names gave the same id");
+	check(std::string(padding_left.name()) == "padding-left", "Id did not keep its name");
+
+	Style root_style, child_style;
+	root_style.set("font-size: 12px; color: rgb(10,20,30); border: 2px solid black");
+	child_style.set("padding: 1em 2px; margin-left: 50%; flex: 2 1 auto");
+	StyleCascade root({ &root_style });
+	StyleCascade child({ &child_style }, &root);
+
+	const char *names[] =
+	{
+		"padding-left", "padding-top", "margin-left", "color", "font-size", "flex-grow", "flex-shrink",
+		"flex-basis", "border-left-width", "border-left-style", "width", "position", "background-color"
+	};
+	for (const char *name : names)
+	{
+		StyleGetValue by_name = child.computed_value(name);
+		StyleGetValue by_id = child.computed_value(StylePropertyId(name));
+		check(by_name.type() == by_id.type() && by_name.number() == by_id.number() && by_name.text() == by_id.text() && by_name.color() == by_id.color(), string_format("Lookup of %1 by id differs from lookup by name", name));
+	}
+
+	check(child.computed_value("padding-top").number() == 12.0f && child.computed_value("padding-left").number() == 2.0f, "Shorthand with an em length gave the wrong values");
+	check(child.computed_value("no-such-property").is_undefined(), "Unknown property was defined");
+}
+
+void benchmark()
+{
+	Console::write_line("--- Lookups on a chain of 31 cascades ---");
+
+	Style root_style, child_style;
+	root_style.set("color: red; font-size: 16px");
+	child_style.set("padding-left: 1em");
+	std::vector<std::unique_ptr<StyleCascade>> chain;
+	chain.emplace_back(new StyleCascade({ &root_style }));
+	for (int i = 0; i < 30; i++)
+		chain.emplace_back(new StyleCascade({ &child_style }, chain.back().get()));
+
+	const int lookups = 1000000;
+	StylePropertyId color("color");
+	float sum = 0.0f;
+	uint64_t start_time = System::get_microseconds();
+	for (int i = 0; i < lookups; i++)
+		sum += chain[i % chain.size()]->computed_value(color).color().r;
+	uint64_t id_time = System::get_microseconds() - start_time;
+
+	start_time = System::get_microseconds();
+	for (int i = 0; i < lookups; i++)
+		sum -= chain[i % chain.size()]->computed_value("color").color().r;
+	uint64_t name_time = System::get_microseconds() - start_time;
+	check(sum == 0.0f, "Lookups by id and by name gave different colors");
+
+	// Every lookup after a change to the root style recomputes the chain
+	start_time = System::get_microseconds();
+	for (int i = 0; i < 1000; i++)
+	{
+		root_style.set(i % 2 ? "font-size: 16px" : "font-size: 17px");
+		sum += chain.back()->computed_value("padding-left").number();
+	}
+	uint64_t change_time = System::get_microseconds() - start_time;
+
+	Console::write_line("inherited lookup by id: %1 ns, by name: %2 ns", id_time * 1000.0 / lookups, name_time * 1000.0 / lookups);
+	Console::write_line("em length after a root font size change: %1 us", change_time / 1000.0);
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
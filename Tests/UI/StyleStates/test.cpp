@@ -0,0 +1,157 @@
+// Test and benchmark for style state changes.
+//
+// Checks that a state whose styles only change paint properties renders the
+// view again without asking for a new layout, while a state that changes a
+// layout property still lays out the view and its parent. Then toggles states
+// on 10,000 styled views and prints the time per view and per frame.
+
+#include "../Headless/headless_view_tree.h"
+
+using namespace clan;
+
+void test_paint_only_state();
+void test_layout_state();
+void benchmark();
+std::shared_ptr<View> add_styled_view(View *parent);
+void check(bool condition, const std::string &message);
+
+int main(int, char**)
+{
+	try
+	{
+		test_paint_only_state();
+		test_layout_state();
+		benchmark();
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void test_paint_only_state()
+{
+	Console::write_line("--- Paint only state change ---");
+
+	HeadlessViewTree tree;
+	tree.root_view()->style()->set("flex-direction: row; flex-wrap: wrap");
+	auto view = add_styled_view(tree.root_view().get());
+	tree.frame();
+	Colorf normal_color = view->style_cascade().computed_value("background-color").color();
+
+	tree.render_requests = 0;
+	view->set_state("hot", true);
+	check(!view->needs_layout() && !tree.root_view()->needs_layout(), "Changing the background color asked for a new layout");
+	check(tree.render_requests > 0, "Changing the background color did not ask for a render");
+	check(view->style_cascade().computed_value("background-color").color() != normal_color, "Background color did not follow the hot state");
+
+	view->set_state("pressed", true);
+	check(!view->needs_layout(), "Changing the border color asked for a new layout");
+	check(view->style_cascade().computed_value("border-top-color").color() == Colorf(0, 0, 0), "Border color did not follow the hot pressed state");
+	view->set_state("pressed", false);
+	view->set_state("hot", false);
+	check(!view->needs_layout(), "Going back to the normal style asked for a new layout");
+	check(view->style_cascade().computed_value("background-color").color() == normal_color, "Background color did not go back to normal");
+
+	// No style refers to this state
+	tree.frame();
+	view->set_state("selected", true);
+	check(!view->needs_layout(), "Setting an unstyled state asked for a new layout");
+	check(tree.render_requests > 0, "Setting an unstyled state did not ask for a render");
+}
+
+void test_layout_state()
+{
+	Console::write_line("--- Layout state change ---");
+
+	HeadlessViewTree tree;
+	tree.root_view()->style()->set("flex-direction: row; flex-wrap: wrap");
+	auto view = add_styled_view(tree.root_view().get());
+	auto next = add_styled_view(tree.root_view().get());
+	tree.frame();
+	float next_x = next->geometry().content_x;
+
+	view->set_state("big", true);
+	check(view->needs_layout() && tree.root_view()->needs_layout(), "Changing the width did not ask for a new layout");
+	tree.frame();
+	check(view->geometry().content_width == 40.0f, "Width did not follow the big state");
+	check(next->geometry().content_x > next_x, "Sibling was not moved by the wider view");
+
+	view->set_state("big", false);
+	check(view->needs_layout(), "Going back to the normal width did not ask for a new layout");
+	tree.frame();
+	check(next->geometry().content_x == next_x, "Sibling did not move back");
+}
+
+void benchmark()
+{
+	Console::write_line("--- Toggling states on 10,000 views ---");
+
+	HeadlessViewTree tree(Rectf(0.0f, 0.0f, 2000.0f, 2000.0f));
+	tree.root_view()->style()->set("flex-direction: row; flex-wrap: wrap");
+	std::vector<std::shared_ptr<View>> views;
+	for (int i = 0; i < 10000; i++)
+		views.push_back(add_styled_view(tree.root_view().get()));
+	tree.frame();
+
+	struct Toggle { const char *description; const char *state; bool value; };
+	Toggle toggles[] =
+	{
+		{ "hot on, paint only", "hot", true },
+		{ "hot off, paint only", "hot", false },
+		{ "unstyled state on", "selected", true },
+		{ "styled state with the same matches", "focused", true },
+		{ "big on, width changes", "big", true },
+		{ "big off, width changes", "big", false }
+	};
+
+	for (const auto &toggle : toggles)
+	{
+		uint64_t start_time = System::get_microseconds();
+		for (const auto &view : views)
+			view->set_state(toggle.state, toggle.value);
+		uint64_t state_time = System::get_microseconds() - start_time;
+
+		bool layout = tree.root_view()->needs_layout();
+		start_time = System::get_microseconds();
+		tree.frame();
+		uint64_t frame_time = System::get_microseconds() - start_time;
+
+		Console::write_line("%1: %2 us per view, frame %3 ms%4", toggle.description, state_time / (double)views.size(), frame_time / 1000.0, layout ? ", with layout" : "");
+	}
+
+	// Hover moving over the views, one frame per move
+	const int moves = 1000;
+	uint64_t start_time = System::get_microseconds();
+	for (int i = 1; i <= moves; i++)
+	{
+		views[i - 1]->set_state("hot", false);
+		views[i]->set_state("hot", true);
+		check(!tree.root_view()->needs_layout(), "Hover asked for a new layout");
+		tree.frame();
+	}
+	Console::write_line("hover move with a frame: %1 us", (System::get_microseconds() - start_time) / (double)moves);
+}
+
+std::shared_ptr<View> add_styled_view(View *parent)
+{
+	auto view = std::make_shared<View>();
+	view->style()->set("width: 18px; height: 18px; margin: 1px; flex: none; background: rgb(240,240,240); border: 1px solid rgb(100,100,100)");
+	view->style("hot")->set("background: rgb(220,220,255)");
+	view->style("pressed")->set("background: rgb(180,180,255)");
+	view->style("hot pressed")->set("border-color: rgb(0,0,0)");
+	view->style("disabled")->set("background: rgb(200,200,200)");
+	view->style("focused disabled")->set("border-color: rgb(0,0,255)");
+	view->style("big")->set("width: 40px");
+	parent->add_child(view);
+	return view;
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}
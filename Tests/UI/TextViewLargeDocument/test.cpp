@@ -0,0 +1,140 @@
+// Benchmark for TextView with very large documents.
+//
+// Loads a document with a million lines, then types in the middle of it and
+// scrolls through it a page at a time, rendering a frame after every key. Prints
+// the time per key and per frame, and checks that each frame only measures and
+// draws the lines that are visible, and that the edits end up in the text.
+
+#include "../Headless/headless_view_tree.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace clan;
+
+void press_key(TextView *view, Key key, const std::string &text = std::string());
+void check(bool condition, const std::string &message);
+
+int main(int argc, char **argv)
+{
+	try
+	{
+		int line_count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+		HeadlessViewTree tree(Rectf(0.0f, 0.0f, 800.0f, 600.0f));
+		tree.root_view()->style()->set("flex-direction: column");
+		auto text_view = std::make_shared<TextView>();
+		text_view->style()->set("flex: auto");
+		tree.add_child(text_view);
+
+		// Visible lines of the 16 pixel high headless font, plus a partly visible one at each end
+		const int max_lines_per_frame = 600 / 16 + 2;
+
+		std::string text;
+		for (int i = 0; i < line_count; i++)
+		{
+			if (i > 0)
+				text += '\n';
+			text += "2016-10-18 12:00:00 [info] log line " + StringHelp::int_to_text(i);
+		}
+
+		uint64_t start_time = System::get_microseconds();
+		text_view->set_text(text);
+		uint64_t set_text_time = System::get_microseconds() - start_time;
+
+		HeadlessCounters::reset();
+		start_time = System::get_microseconds();
+		tree.frame();
+		uint64_t first_frame_time = System::get_microseconds() - start_time;
+		check(HeadlessCounters::draw_text <= max_lines_per_frame, string_format("First frame drew %1 lines", HeadlessCounters::draw_text));
+
+		Console::write_line("%1 lines, %2 MB", line_count, text.size() / 1048576.0);
+		Console::write_line("set_text: %1 ms", set_text_time / 1000.0);
+		Console::write_line("first frame: %1 ms", first_frame_time / 1000.0);
+
+		// Type in the middle of the document with a frame after each key
+		const int middle = line_count / 2;
+		const int key_count = 200;
+		const int backspace_count = 10;
+		text_view->set_selection(Vec2i(10, middle), Vec2i(10, middle));
+		tree.frame();
+
+		std::string typed;
+		HeadlessCounters::reset();
+		start_time = System::get_microseconds();
+		for (int i = 0; i < key_count; i++)
+		{
+			press_key(text_view.get(), Key::x, "x");
+			typed += 'x';
+			if (i % 20 == 19)
+			{
+				press_key(text_view.get(), Key::key_return);
+				typed += '\n';
+			}
+			tree.frame();
+		}
+		for (int i = 0; i < backspace_count; i++)
+		{
+			press_key(text_view.get(), Key::backspace);
+			tree.frame();
+		}
+		uint64_t typing_time = System::get_microseconds() - start_time;
+		typed.resize(typed.size() - backspace_count);
+
+		int keys = key_count + key_count / 20 + backspace_count;
+		check(HeadlessCounters::draw_text <= max_lines_per_frame * (key_count + backspace_count), "Typing drew lines outside the view");
+		Console::write_line("typing: %1 us per key, %2 lines measured per key", typing_time / (double)keys, HeadlessCounters::measure_text / (double)keys);
+
+		int typed_lines = (int)std::count(typed.begin(), typed.end(), '\n');
+		check(text_view->cursor_pos() == Vec2i((int)(typed.size() - typed.rfind('\n') - 1), middle + typed_lines), "Cursor is not after the typed text");
+		text_view->set_selection(Vec2i(10, middle), text_view->cursor_pos());
+		check(text_view->selection() == typed, "Typed text was not inserted at the cursor");
+
+		// Jump around the document and scroll down a page one line at a time
+		const int jumps = 200;
+		const int lines_per_jump = 40;
+		HeadlessCounters::reset();
+		start_time = System::get_microseconds();
+		for (int i = 0; i < jumps; i++)
+		{
+			int line = (int)((long long)i * 7919 % line_count);
+			text_view->set_selection(Vec2i(0, line), Vec2i(0, line));
+			tree.frame();
+			for (int j = 0; j < lines_per_jump; j++)
+			{
+				press_key(text_view.get(), Key::down);
+				tree.frame();
+			}
+			check(text_view->cursor_pos().y == std::min(line + lines_per_jump, line_count + typed_lines - 1), "Cursor did not move down a line per key");
+		}
+		uint64_t scrolling_time = System::get_microseconds() - start_time;
+
+		int frames = jumps * (lines_per_jump + 1);
+		check(HeadlessCounters::draw_text <= max_lines_per_frame * frames, "Scrolling drew lines outside the view");
+		Console::write_line("scrolling: %1 us per frame, %2 lines drawn per frame", scrolling_time / (double)frames, HeadlessCounters::draw_text / (double)frames);
+
+		text_view->select_all();
+		check(text_view->selection().size() == text.size() + typed.size(), "Document has the wrong size after the edits");
+		text_view->delete_selected_text();
+		check(text_view->text().empty(), "Document is not empty after deleting everything");
+
+		Console::write_line("All tests passed");
+		return 0;
+	}
+	catch (Exception e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+}
+
+void press_key(TextView *view, Key key, const std::string &text)
+{
+	KeyEvent e(KeyEventType::press, key, 1, text, Pointf(), false, false, false, false);
+	view->sig_key_press()(e);
+}
+
+void check(bool condition, const std::string &message)
+{
+	if (!condition)
+		throw Exception(message);
+}